@@ -0,0 +1,17 @@
+-- Queries of the shape BI tools generate against the driver, one per line.
+-- Used by sql_parser_bench; every query must be accepted by both parsers.
+SELECT * FROM sales.orders
+SELECT ALL * FROM sales.orders WHERE status = "shipped"
+SELECT DISTINCT region FROM sales.orders
+SELECT orders.region, orders.product, orders.quantity FROM sales.orders WHERE orders.quantity > 0
+SELECT region, product, quantity, price, discount FROM sales.orders WHERE region = "EMEA" AND product <> "sample" AND quantity >= 1
+SELECT customer, total FROM sales.invoices WHERE total > 1000 OR customer = "ACME" OR customer = "Initech"
+SELECT * FROM sales.invoices WHERE issued >= 20130101 AND issued < 20130201 AND NOT status = "void"
+SELECT id, name, email FROM crm.contacts WHERE owner = ? AND stage <> ? AND score >= ?
+SELECT * FROM crm.contacts WHERE country = "US" AND state = "CA" OR country = "US" AND state = "NY" OR country = "CA" AND state = "ON"
+SELECT sku, warehouse, onhand FROM inventory.stock WHERE onhand <= reorder AND active = 1 AND NOT discontinued = 1
+SELECT * FROM web.sessions WHERE duration > 30 AND pages >= 2 AND source <> "bot" AND campaign = "spring" AND device = "mobile" AND browser <> "legacy"
+SELECT a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12 FROM warehouse.fact WHERE k1 = 1 AND k2 = 2 AND k3 = 3 AND k4 = 4
+SELECT * FROM warehouse.fact WHERE d1 = "2013-01-01" OR d1 = "2013-01-02" OR d1 = "2013-01-03" OR d1 = "2013-01-04" OR d1 = "2013-01-05" OR d1 = "2013-01-06" OR d1 = "2013-01-07"
+SELECT fact.store, fact.day, fact.revenue FROM warehouse.fact WHERE fact.store = ? AND fact.day >= ? AND fact.day <= ?
+SELECT * FROM hr.employees WHERE NOT department = "sales" AND NOT department = "support" AND salary > 50000
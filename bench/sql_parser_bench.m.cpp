@@ -0,0 +1,219 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+// Compares the Spirit grammar with 'SQLFastParser'.  Each query of the
+// corpus, and generated queries with long WHERE clauses, are parsed by both;
+// the statements must print identically.  'cached' is the cost of a plan
+// cache hit: normalizing the text, the lookup and binding the literals.
+// No server is needed.
+//
+// usage: sql_parser_bench [iterations] [corpus]
+
+#include "plan_cache.h"
+#include "query_plan.h"
+#include "sql_fast_parser.h"
+#include "sql_parser.h"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+class Timer {
+    boost::posix_time::ptime _start;
+
+  public:
+    Timer()
+        : _start(boost::posix_time::microsec_clock::universal_time())
+    {
+    }
+
+    // microseconds since construction
+    double elapsed() const
+    {
+        return (boost::posix_time::microsec_clock::universal_time() - _start)
+            .total_microseconds();
+    }
+};
+
+bool spiritParse(const std::string& query, mongoodbc::SQLStatement *stmt)
+{
+    std::string::const_iterator begin = query.begin();
+    std::string::const_iterator end = query.end();
+    return boost::spirit::qi::phrase_parse(begin,
+                                           end,
+                                           mongoodbc::sharedSQLParser(),
+                                           boost::spirit::ascii::space,
+                                           *stmt)
+        && begin == end;
+}
+
+bool fastParse(const std::string& query, mongoodbc::SQLStatement *stmt)
+{
+    return 0 == mongoodbc::SQLFastParser::parse(query, stmt, 0);
+}
+
+// plans are compiled by the fast parser, as for a connection using it
+int planParse(const std::string& query, mongoodbc::SQLStatement *stmt)
+{
+    return mongoodbc::SQLFastParser::parse(query, stmt, 0);
+}
+
+// large enough for every plan of the benchmark
+mongoodbc::PlanCache s_planCache(64 * 1024 * 1024);
+
+bool cachedParse(const std::string& query, mongoodbc::SQLStatement *stmt)
+{
+    std::string key;
+    std::vector<mongoodbc::SQLToken> literals;
+    if (0 != mongoodbc::PlanCache::normalize(query, &key, &literals)) {
+        return false;
+    }
+    boost::shared_ptr<const mongoodbc::QueryPlan> plan = s_planCache.lookup(key);
+    if (!plan) {
+        plan = mongoodbc::QueryPlan::compile(query, literals, planParse);
+        if (!plan) {
+            return false;
+        }
+        s_planCache.insert(key, plan);
+    }
+    return 0 == plan->bind(literals, stmt);
+}
+
+std::string toString(const mongoodbc::SQLStatement& stmt)
+{
+    std::ostringstream str;
+    str << stmt;
+    return str.str();
+}
+
+/*
+* Returns a query whose WHERE clause has 'predicates' comparisons, joined
+* mostly by AND with an OR every tenth.
+*/
+std::string generateQuery(int predicates)
+{
+    std::ostringstream str;
+    str << "SELECT c0, c1, c2 FROM warehouse.fact WHERE";
+    for (int i = 0; i < predicates; ++i) {
+        if (i) {
+            str << (i % 10 ? " AND" : " OR");
+        }
+        str << " c" << i << (i % 2 ? " >= " : " = ") << i;
+    }
+    return str.str();
+}
+
+/*
+* Times 'iterations' passes of 'parse' over 'queries'.
+* @return microseconds per query, or a negative value if a query failed
+*/
+double timeParser(bool (*parse)(const std::string&, mongoodbc::SQLStatement *),
+                  const std::vector<std::string>& queries,
+                  int iterations)
+{
+    Timer timer;
+    for (int i = 0; i < iterations; ++i) {
+        for (size_t q = 0; q < queries.size(); ++q) {
+            mongoodbc::SQLStatement stmt;
+            if (!parse(queries[q], &stmt)) {
+                return -1;
+            }
+        }
+    }
+    return timer.elapsed() / (iterations * queries.size());
+}
+
+/*
+* Checks that both parsers agree on 'queries', then times them.
+* @return 0 on success, non-zero if the parsers disagree
+*/
+int run(const char *name, const std::vector<std::string>& queries, int iterations)
+{
+    for (size_t q = 0; q < queries.size(); ++q) {
+        mongoodbc::SQLStatement spiritStmt;
+        mongoodbc::SQLStatement fastStmt;
+        mongoodbc::SQLStatement cachedStmt;
+        if (!spiritParse(queries[q], &spiritStmt)
+            || !fastParse(queries[q], &fastStmt)
+            || !cachedParse(queries[q], &cachedStmt)
+            || toString(spiritStmt) != toString(fastStmt)
+            || toString(spiritStmt) != toString(cachedStmt)) {
+            std::cerr << name << ": parsers disagree on '" << queries[q] << "'" << std::endl;
+            return 1;
+        }
+    }
+
+    double spirit = timeParser(&spiritParse, queries, iterations);
+    double fast = timeParser(&fastParse, queries, iterations);
+    double cached = timeParser(&cachedParse, queries, iterations);
+    std::cout << name
+              << ": spirit "
+              << spirit
+              << " us/query, fast "
+              << fast
+              << " us/query, cached "
+              << cached
+              << " us/query, speedup "
+              << spirit / fast
+              << "x ("
+              << queries.size()
+              << " queries, "
+              << iterations
+              << " iterations)"
+              << std::endl;
+    return 0;
+}
+
+} // close unnamed namespace
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 100;
+    const char *corpusFile = argc > 2 ? argv[2] : "bench/bi_queries.sql";
+    std::ifstream corpusStream(corpusFile);
+    if (iterations <= 0 || !corpusStream) {
+        std::cerr << "usage: " << argv[0] << " [iterations] [corpus]" << std::endl;
+        return 1;
+    }
+
+    // one query per line, '--' starts a comment line
+    std::vector<std::string> corpus;
+    std::string line;
+    while (std::getline(corpusStream, line)) {
+        if (!line.empty() && 0 != line.compare(0, 2, "--")) {
+            corpus.push_back(line);
+        }
+    }
+
+    int rc = run("corpus", corpus, iterations);
+
+    const int predicates[] = { 10, 100, 500 };
+    for (size_t i = 0; i < sizeof(predicates) / sizeof(predicates[0]); ++i) {
+        std::vector<std::string> queries(1, generateQuery(predicates[i]));
+        std::ostringstream name;
+        name << predicates[i] << " predicates";
+        rc |= run(name.str().c_str(), queries, iterations);
+    }
+
+    return rc;
+}
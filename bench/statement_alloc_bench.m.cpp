@@ -0,0 +1,119 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+// Measures the cost of allocating statement handles.  Statements used to
+// build their own SQL grammar; 'grammar construction' shows that cost per
+// statement, 'SQLAllocHandle' the cost now that the grammar is shared.
+// No server is needed.
+//
+// usage: statement_alloc_bench [iterations]
+
+#include "odbcintf.h"
+#include "sql_parser.h"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <sql.h>
+#include <sqlext.h>
+
+namespace {
+
+class Timer {
+    boost::posix_time::ptime _start;
+
+  public:
+    Timer()
+        : _start(boost::posix_time::microsec_clock::universal_time())
+    {
+    }
+
+    // microseconds since construction
+    double elapsed() const
+    {
+        return (boost::posix_time::microsec_clock::universal_time() - _start)
+            .total_microseconds();
+    }
+};
+
+void report(const char *name, double micros, int iterations)
+{
+    std::cout << name
+              << ": "
+              << micros / iterations
+              << " us/op ("
+              << iterations
+              << " iterations)"
+              << std::endl;
+}
+
+} // close unnamed namespace
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 1000;
+    if (iterations <= 0) {
+        std::cerr << "usage: " << argv[0] << " [iterations]" << std::endl;
+        return 1;
+    }
+
+    {
+        Timer timer;
+        for (int i = 0; i < iterations; ++i) {
+            mongoodbc::SQLParser<std::string::const_iterator> parser;
+        }
+        report("grammar construction (before)", timer.elapsed(), iterations);
+    }
+
+    SQLHENV envHandle;
+    SQLHDBC dbHandle;
+    SQLAllocHandle(SQL_HANDLE_ENV, SQL_NULL_HANDLE, &envHandle);
+    SQLSetEnvAttr(envHandle, SQL_ATTR_ODBC_VERSION, (void *) SQL_OV_ODBC3, 0);
+    SQLAllocHandle(SQL_HANDLE_DBC, envHandle, &dbHandle);
+
+    {
+        Timer timer;
+        for (int i = 0; i < iterations; ++i) {
+            SQLHSTMT stmtHandle;
+            SQLAllocHandle(SQL_HANDLE_STMT, dbHandle, &stmtHandle);
+            SQLFreeHandle(SQL_HANDLE_STMT, stmtHandle);
+        }
+        report("SQLAllocHandle/SQLFreeHandle (after)", timer.elapsed(), iterations);
+    }
+
+    SQLFreeHandle(SQL_HANDLE_DBC, dbHandle);
+    SQLFreeHandle(SQL_HANDLE_ENV, envHandle);
+
+    {
+        const std::string query("SELECT * FROM db.collection WHERE a > 2 AND b < 13");
+        Timer timer;
+        for (int i = 0; i < iterations; ++i) {
+            mongoodbc::SQLStatement stmt;
+            std::string::const_iterator begin = query.begin();
+            boost::spirit::qi::phrase_parse(begin,
+                                            query.end(),
+                                            mongoodbc::sharedSQLParser(),
+                                            boost::spirit::ascii::space,
+                                            stmt);
+        }
+        report("parse with shared grammar", timer.elapsed(), iterations);
+    }
+
+    return 0;
+}
@@ -0,0 +1,261 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "aggregate_function.h"
+
+#include "sort_key.h"
+
+#include <algorithm>
+
+#include <limits.h>
+#include <string.h>
+
+namespace {
+
+using mongoodbc::AggregateState;
+using mongoodbc::ExpressionValue;
+using mongoodbc::SQLElementExpression;
+using mongoodbc::SQLElementExpression_Primary;
+using mongoodbc::SQLElementExpression_Term;
+
+// whole doubles up to 2^53 are exact
+const double MAX_EXACT = 9007199254740992.0;
+
+bool hasAggregate(const SQLElementExpression_Primary& primary);
+
+bool hasAggregate(const SQLElementExpression_Term& term)
+{
+    return (!term._term.empty() && hasAggregate(term._term[0].get()))
+           || hasAggregate(term._factor._primary);
+}
+
+bool hasAggregate(const SQLElementExpression_Primary& primary)
+{
+    return primary._function
+           || (!primary._expr.empty() && mongoodbc::hasAggregate(primary._expr[0].get()));
+}
+
+/*
+* Stores the integer value of 'value' in 'result' if it has one: a column
+* of an integer type or a whole computed number.
+*/
+bool integerValue(const ExpressionValue& value, long long *result)
+{
+    if (!value._elem.eoo()) {
+        if (mongo::NumberInt != value._elem.type() && mongo::NumberLong != value._elem.type()) {
+            return false;
+        }
+        *result = value._elem.numberLong();
+        return true;
+    }
+    if (value._num != (double)(long long)value._num
+        || value._num > MAX_EXACT || value._num < -MAX_EXACT) {
+        return false;
+    }
+    *result = (long long)value._num;
+    return true;
+}
+
+void addToSum(const ExpressionValue& value, AggregateState *state)
+{
+    ++state->_count;
+    long long integer;
+    if (!state->_isDouble && integerValue(value, &integer)) {
+        long long sum = state->_intSum;
+        if ((integer > 0 && sum > LLONG_MAX - integer)
+            || (integer < 0 && sum < LLONG_MIN - integer)) {
+            state->_isDouble = true;
+            state->_sum = (double)sum + (double)integer;
+        } else {
+            state->_intSum = sum + integer;
+        }
+        return;
+    }
+    if (!state->_isDouble) {
+        state->_isDouble = true;
+        state->_sum = (double)state->_intSum;
+    }
+    state->_sum += value._num;
+}
+
+/*
+* Replaces the value of 'state' with 'value' if it sorts after it for MAX,
+* before it for MIN.  'key' is scratch space for the encoding of 'value'.
+* @return the change of the memory held by 'state'
+*/
+long long replaceIfBetter(const ExpressionValue& value, bool max, std::string *key, AggregateState *state)
+{
+    key->clear();
+    mongoodbc::encodeValue(value, key);
+    if (!state->_value.isEmpty()) {
+        int cmp = memcmp(key->data(), state->_key.data(), std::min(key->size(), state->_key.size()));
+        if (0 == cmp) {
+            cmp = key->size() < state->_key.size() ? -1 : (key->size() > state->_key.size() ? 1 : 0);
+        }
+        if (max ? cmp <= 0 : cmp >= 0) {
+            return 0;
+        }
+    }
+    long long before = state->size();
+    mongo::BSONObjBuilder builder;
+    value.append("v", &builder);
+    state->_value = builder.obj();
+    state->_key = *key;
+    return (long long)state->size() - before;
+}
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+int AggregateFunction::parse(const SQLElementExpression& expr,
+                             AggregateFunction *fn,
+                             std::string *errmsg)
+{
+    const SQLElementExpression_Primary& primary = expr._term._factor._primary;
+    if (!expr._expr.empty() || !expr._term._term.empty() || expr._term._factor._op
+        || !primary._function) {
+        return 1;
+    }
+
+    const std::string& name = *primary._function;
+    if ("COUNT" == name) {
+        fn->_kind = COUNT;
+    } else if ("SUM" == name) {
+        fn->_kind = SUM;
+    } else if ("AVG" == name) {
+        fn->_kind = AVG;
+    } else if ("MIN" == name) {
+        fn->_kind = MIN;
+    } else if ("MAX" == name) {
+        fn->_kind = MAX;
+    } else {
+        *errmsg = "unknown aggregate function " + name;
+        return -1;
+    }
+
+    fn->_hasArg = !primary._expr.empty();
+    if (!fn->_hasArg && COUNT != fn->_kind) {
+        *errmsg = name + "(*) is not allowed";
+        return -1;
+    }
+    if (fn->_hasArg) {
+        fn->_arg = primary._expr[0].get();
+        if (hasAggregate(fn->_arg)) {
+            *errmsg = "aggregate functions cannot be nested";
+            return -1;
+        }
+    }
+    fn->_name = expressionLabel(expr);
+    return 0;
+}
+
+bool hasAggregate(const SQLElementExpression& expr)
+{
+    return (!expr._expr.empty() && hasAggregate(expr._expr[0].get()))
+           || ::hasAggregate(expr._term);
+}
+
+AggregateState::AggregateState()
+    : _count(0)
+    , _isDouble(false)
+    , _intSum(0)
+    , _sum(0)
+{
+}
+
+size_t AggregateState::size() const
+{
+    return sizeof(*this) + (_value.isEmpty() ? 0 : _value.objsize()) + _key.capacity();
+}
+
+long long updateStates(const AggregateFunction& fn,
+                       const std::vector<ExpressionValue>& values,
+                       const std::vector<AggregateState *>& states)
+{
+    long long delta = 0;
+    std::string key;
+    size_t numRows = states.size();
+    switch(fn._kind) {
+      case AggregateFunction::COUNT: {
+        if (!fn._hasArg) {
+            for (size_t i = 0; i < numRows; ++i) {
+                ++states[i]->_count;
+            }
+            break;
+        }
+        for (size_t i = 0; i < numRows; ++i) {
+            states[i]->_count += ExpressionValue::NONE != values[i]._type;
+        }
+      } break;
+      case AggregateFunction::SUM:
+      case AggregateFunction::AVG: {
+        for (size_t i = 0; i < numRows; ++i) {
+            if (ExpressionValue::NUMBER == values[i]._type) {
+                addToSum(values[i], states[i]);
+            }
+        }
+      } break;
+      case AggregateFunction::MIN:
+      case AggregateFunction::MAX: {
+        bool max = AggregateFunction::MAX == fn._kind;
+        for (size_t i = 0; i < numRows; ++i) {
+            if (ExpressionValue::NONE != values[i]._type) {
+                delta += replaceIfBetter(values[i], max, &key, states[i]);
+            }
+        }
+      } break;
+    }
+    return delta;
+}
+
+void appendResult(const AggregateFunction& fn,
+                  const AggregateState& state,
+                  mongo::BSONObjBuilder *builder)
+{
+    switch(fn._kind) {
+      case AggregateFunction::COUNT: {
+        builder->append(fn._name, state._count);
+      } break;
+      case AggregateFunction::SUM: {
+        if (0 == state._count) {
+            builder->appendNull(fn._name);
+        } else if (state._isDouble) {
+            builder->append(fn._name, state._sum);
+        } else {
+            builder->append(fn._name, state._intSum);
+        }
+      } break;
+      case AggregateFunction::AVG: {
+        if (0 == state._count) {
+            builder->appendNull(fn._name);
+        } else {
+            double sum = state._isDouble ? state._sum : (double)state._intSum;
+            builder->append(fn._name, sum / state._count);
+        }
+      } break;
+      case AggregateFunction::MIN:
+      case AggregateFunction::MAX: {
+        if (state._value.isEmpty()) {
+            builder->appendNull(fn._name);
+        } else {
+            builder->appendAs(state._value.firstElement(), fn._name);
+        }
+      } break;
+    }
+}
+
+} // close mongoodbc namespace
@@ -0,0 +1,107 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_AGGREGATE_FUNCTION_H_
+#define MONGOODBC_AGGREGATE_FUNCTION_H_
+
+#include "expression_evaluator.h"
+#include "sql_element_expression.h"
+
+#include <mongo/bson/bsonobj.h>
+
+#include <string>
+#include <vector>
+
+namespace mongoodbc {
+
+/*
+* An aggregate function call of a select list: 'COUNT(*)', or COUNT, SUM,
+* AVG, MIN or MAX of an expression.
+*/
+struct AggregateFunction {
+    enum Kind {
+        COUNT,
+        SUM,
+        AVG,
+        MIN,
+        MAX
+    };
+
+    Kind _kind;
+    // false for 'COUNT(*)'
+    bool _hasArg;
+    SQLElementExpression _arg;
+    // label of the call, which names its result
+    std::string _name;
+
+    /*
+    * Reads the call 'expr' into 'fn'.
+    * @return 1 if 'expr' is not an aggregate function call, 0 on success,
+    *         -1 with a description in 'errmsg' if the call is invalid
+    */
+    static int parse(const SQLElementExpression& expr, AggregateFunction *fn, std::string *errmsg);
+};
+
+/*
+* Returns true if 'expr' calls an aggregate function anywhere.
+*/
+bool hasAggregate(const SQLElementExpression& expr);
+
+/*
+* Running state of one aggregate function over the rows of one group.
+*/
+struct AggregateState {
+    // rows for 'COUNT(*)', values otherwise
+    long long _count;
+    // SUM and AVG, an integer while every value is one and the sum fits
+    bool _isDouble;
+    long long _intSum;
+    double _sum;
+    // MIN and MAX, the best value so far as the only field of a document,
+    // empty if none, and its 'encodeValue' encoding
+    mongo::BSONObj _value;
+    std::string _key;
+
+    AggregateState();
+
+    /*
+    * Returns the approximate memory held by the state, in bytes.
+    */
+    size_t size() const;
+};
+
+/*
+* Updates '*states[i]' with 'values[i]' for each row i of a batch, where
+* 'states[i]' is the state of the row's group.  The function is dispatched
+* once per batch, so each update loop only does one kind of work.  Values
+* are ignored for 'COUNT(*)'.
+* @return the change of the memory held by the states, in bytes
+*/
+long long updateStates(const AggregateFunction& fn,
+                       const std::vector<ExpressionValue>& values,
+                       const std::vector<AggregateState *>& states);
+
+/*
+* Appends the result of 'fn' for 'state' to 'builder' as 'fn._name'.  SUM,
+* AVG, MIN and MAX of no values are NULL.
+*/
+void appendResult(const AggregateFunction& fn,
+                  const AggregateState& state,
+                  mongo::BSONObjBuilder *builder);
+
+} // close mongoodbc namespace
+
+#endif
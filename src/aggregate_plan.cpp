@@ -0,0 +1,183 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "aggregate_plan.h"
+
+#include "expression_evaluator.h"
+
+#include <set>
+
+namespace {
+
+std::string stripThis(const std::string& name)
+{
+    return 0 == name.compare(0, 5, "this.") ? name.substr(5) : name;
+}
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+bool AggregatePlan::isAggregate(const SQLSelectStatement& stmt)
+{
+    if (!stmt._groupBy.empty()) {
+        return true;
+    }
+    for (size_t i = 0; i < stmt._selectList.size(); ++i) {
+        if (hasAggregate(stmt._selectList[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int AggregatePlan::init(const SQLSelectStatement& stmt, std::string *errmsg)
+{
+    _keys.clear();
+    _keyNames.clear();
+    _aggregates.clear();
+    _columns.clear();
+
+    if (stmt._selectList.empty()) {
+        *errmsg = "SELECT * cannot be grouped";
+        return -1;
+    }
+
+    for (size_t i = 0; i < stmt._groupBy.size(); ++i) {
+        if (hasAggregate(stmt._groupBy[i])) {
+            *errmsg = "aggregate functions are not allowed in GROUP BY";
+            return -1;
+        }
+        _keys.push_back(stmt._groupBy[i]);
+        _keyNames.push_back(expressionLabel(stmt._groupBy[i]));
+    }
+
+    for (size_t i = 0; i < stmt._selectList.size(); ++i) {
+        const SQLElementExpression& item = stmt._selectList[i];
+        Column column;
+        column._name = expressionLabel(item);
+
+        AggregateFunction fn;
+        int rc = AggregateFunction::parse(item, &fn, errmsg);
+        if (rc < 0) {
+            return -1;
+        }
+        if (0 == rc) {
+            column._isKey = false;
+            for (column._index = 0; column._index < _aggregates.size(); ++column._index) {
+                if (_aggregates[column._index]._name == fn._name) {
+                    break;
+                }
+            }
+            if (column._index == _aggregates.size()) {
+                _aggregates.push_back(fn);
+            }
+        } else if (hasAggregate(item)) {
+            *errmsg = "aggregate function calls must be whole select items: " + column._name;
+            return -1;
+        } else {
+            column._isKey = true;
+            for (column._index = 0; column._index < _keyNames.size(); ++column._index) {
+                if (_keyNames[column._index] == column._name) {
+                    break;
+                }
+            }
+            if (column._index == _keyNames.size()) {
+                *errmsg = column._name + " must appear in GROUP BY or in an aggregate function";
+                return -1;
+            }
+        }
+        _columns.push_back(column);
+    }
+    return 0;
+}
+
+mongo::BSONObj AggregatePlan::resultRow(const mongo::BSONObj& keyValues,
+                                        const AggregateState *states) const
+{
+    std::vector<mongo::BSONElement> keys;
+    mongo::BSONObj::iterator it = keyValues.begin();
+    while (it.more()) {
+        keys.push_back(it.next());
+    }
+
+    mongo::BSONObjBuilder builder;
+    for (size_t i = 0; i < _columns.size(); ++i) {
+        const Column& column = _columns[i];
+        if (column._isKey) {
+            builder.appendAs(keys[column._index], column._name);
+        } else {
+            appendResult(_aggregates[column._index], states[column._index], &builder);
+        }
+    }
+    return builder.obj();
+}
+
+int AggregatePlan::keyFields(std::vector<std::string> *fields) const
+{
+    fields->clear();
+    for (size_t i = 0; i < _keys.size(); ++i) {
+        const SQLElementExpression& expr = _keys[i];
+        const SQLElementExpression_Factor& factor = expr._term._factor;
+        if (!expr._expr.empty() || !expr._term._term.empty() || factor._op
+            || !factor._primary._columnName) {
+            return -1;
+        }
+        fields->push_back(stripThis(factor._primary._columnName->_columnName));
+    }
+    return 0;
+}
+
+int AggregatePlan::indexOrder(const std::vector<mongo::BSONObj>& indexKeys,
+                              mongo::BSONObj *sortPattern,
+                              mongo::BSONObj *hint) const
+{
+    std::vector<std::string> fields;
+    if (_keys.empty() || 0 != keyFields(&fields)) {
+        return -1;
+    }
+    std::set<std::string> grouped(fields.begin(), fields.end());
+
+    int best = -1;
+    for (size_t i = 0; i < indexKeys.size(); ++i) {
+        if (-1 != best && indexKeys[i].nFields() >= indexKeys[best].nFields()) {
+            continue;
+        }
+        // hashed, text and geo indexes do not order their fields
+        std::set<std::string> leading;
+        mongo::BSONObjBuilder pattern;
+        mongo::BSONObj::iterator it = indexKeys[i].begin();
+        while (it.more() && leading.size() < grouped.size()) {
+            mongo::BSONElement elem = it.next();
+            if (!elem.isNumber() || !grouped.count(elem.fieldName())) {
+                break;
+            }
+            leading.insert(elem.fieldName());
+            pattern.append(elem.fieldName(), elem.number() < 0 ? -1 : 1);
+        }
+        if (leading == grouped) {
+            best = (int)i;
+            *sortPattern = pattern.obj();
+        }
+    }
+    if (-1 == best) {
+        return -1;
+    }
+    *hint = indexKeys[best];
+    return 0;
+}
+
+} // close mongoodbc namespace
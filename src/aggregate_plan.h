@@ -0,0 +1,102 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_AGGREGATE_PLAN_H_
+#define MONGOODBC_AGGREGATE_PLAN_H_
+
+#include "aggregate_function.h"
+#include "sql_element_expression.h"
+#include "sql_select_statement.h"
+
+#include <mongo/bson/bsonobj.h>
+
+#include <string>
+#include <vector>
+
+namespace mongoodbc {
+
+/*
+* What a SELECT with GROUP BY or aggregate functions computes: the group
+* keys, the distinct aggregate function calls, and how the select list is
+* made of them.  Result rows have one field per select item, named by its
+* label, so ORDER BY can refer to keys and aggregates alike.
+*/
+class AggregatePlan {
+  public:
+    struct Column {
+        std::string _name;
+        // a group key, else an aggregate
+        bool _isKey;
+        // index in 'keys' or 'aggregates'
+        size_t _index;
+    };
+
+  private:
+    std::vector<SQLElementExpression> _keys;
+    std::vector<std::string> _keyNames;
+    std::vector<AggregateFunction> _aggregates;
+    std::vector<Column> _columns;
+
+  public:
+    /*
+    * Returns true if 'stmt' groups rows or calls an aggregate function.
+    */
+    static bool isAggregate(const SQLSelectStatement& stmt);
+
+    /*
+    * Plans the aggregation of 'stmt'.  Each select item must be a GROUP BY
+    * expression, written alike, or an aggregate function call.
+    * @return 0 on success, -1 with a description in 'errmsg' otherwise
+    */
+    int init(const SQLSelectStatement& stmt, std::string *errmsg);
+
+    const std::vector<SQLElementExpression>& keys() const { return _keys; }
+
+    const std::vector<std::string>& keyNames() const { return _keyNames; }
+
+    const std::vector<AggregateFunction>& aggregates() const { return _aggregates; }
+
+    const std::vector<Column>& columns() const { return _columns; }
+
+    /*
+    * Returns the result row of a group from its key values, a document with
+    * one field per key in order, and the states of its aggregates.
+    */
+    mongo::BSONObj resultRow(const mongo::BSONObj& keyValues, const AggregateState *states) const;
+
+    /*
+    * Stores in 'fields' the fields grouped by if every key is a plain
+    * column.
+    * @return 0 on success, -1 if a key is an expression
+    */
+    int keyFields(std::vector<std::string> *fields) const;
+
+    /*
+    * Finds among 'indexKeys', the key patterns of a collection's indexes,
+    * one whose leading fields are exactly the fields grouped by, so that
+    * reading through it brings the rows of each group together.  The
+    * index with the fewest fields is preferred.  Stores its leading fields
+    * with their directions in 'sortPattern' and its key pattern in 'hint'.
+    * @return 0 on success, -1 if no index fits
+    */
+    int indexOrder(const std::vector<mongo::BSONObj>& indexKeys,
+                   mongo::BSONObj *sortPattern,
+                   mongo::BSONObj *hint) const;
+};
+
+} // close mongoodbc namespace
+
+#endif
@@ -0,0 +1,89 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "aggregation.h"
+#include "connection_handle.h"
+
+#include <stdexcept>
+
+namespace mongoodbc {
+
+AggregationRowSource::AggregationRowSource(ConnectionHandle *connHandle,
+                                           const std::string& ns,
+                                           const mongo::BSONObj& pipeline,
+                                           const BatchSizer& batchSizer,
+                                           const mongo::BSONObj& options)
+    : _conn(new ScopedConnection(connHandle))
+    , _firstBatchIdx(0)
+{
+    if (!_conn->get()) {
+        throw std::runtime_error("not connected");
+    }
+
+    BatchSizer sizer(batchSizer);
+    mongo::BSONObj reply;
+    int queryOptions;
+    if (0 != connHandle->aggregate(_conn->get(),
+                                   ns,
+                                   pipeline,
+                                   sizer.initialBatchSize(),
+                                   options,
+                                   &reply,
+                                   &queryOptions)) {
+        throw std::runtime_error("aggregate failed: " + reply.toString());
+    }
+
+    mongo::BSONObj cursor = reply.getObjectField("cursor");
+    std::vector<mongo::BSONElement> batch = cursor["firstBatch"].Array();
+    for (size_t i = 0; i < batch.size(); ++i) {
+        _firstBatch.push_back(batch[i].Obj().getOwned());
+    }
+
+    long long cursorId = cursor["id"].numberLong();
+    if (cursorId) {
+        std::auto_ptr<mongo::DBClientCursor> more(
+            new mongo::DBClientCursor(_conn->get(),
+                                      cursor.getStringField("ns"),
+                                      cursorId,
+                                      0,
+                                      queryOptions));
+        _cursor.reset(new CursorRowSource(more, sizer));
+    }
+}
+
+AggregationRowSource::~AggregationRowSource()
+{
+    // the cursor goes before its connection
+    _cursor.reset();
+}
+
+bool AggregationRowSource::more()
+{
+    if (_firstBatchIdx < _firstBatch.size()) {
+        return true;
+    }
+    return _cursor.get() && _cursor->more();
+}
+
+mongo::BSONObj AggregationRowSource::next()
+{
+    if (_firstBatchIdx < _firstBatch.size()) {
+        return _firstBatch[_firstBatchIdx++];
+    }
+    return _cursor->next();
+}
+
+} // close mongoodbc namespace
@@ -0,0 +1,67 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_AGGREGATION_H_
+#define MONGOODBC_AGGREGATION_H_
+
+#include "batch_sizer.h"
+#include "row_source.h"
+
+#include <mongo/bson/bsonobj.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mongoodbc {
+
+class ConnectionHandle;
+class ScopedConnection;
+
+/*
+* Row source returning the results of an aggregation pipeline, read through
+* the command's cursor over a connection of its own.
+*/
+class AggregationRowSource : public RowSource {
+    std::auto_ptr<ScopedConnection> _conn;
+    // rows returned with the command itself
+    std::vector<mongo::BSONObj> _firstBatch;
+    size_t _firstBatchIdx;
+    // null if the first batch held every row
+    std::auto_ptr<RowSource> _cursor;
+
+  public:
+    /*
+    * Runs 'pipeline', an array of stages, over the collection 'ns', with
+    * the command options 'options', e.g. '{ maxTimeMS: 500 }'.  Throws
+    * std::runtime_error if the server rejects the pipeline.
+    */
+    AggregationRowSource(ConnectionHandle *connHandle,
+                         const std::string& ns,
+                         const mongo::BSONObj& pipeline,
+                         const BatchSizer& batchSizer,
+                         const mongo::BSONObj& options = mongo::BSONObj());
+
+    ~AggregationRowSource();
+
+    virtual bool more();
+
+    virtual mongo::BSONObj next();
+};
+
+} // close mongoodbc namespace
+
+#endif
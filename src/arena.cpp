@@ -0,0 +1,130 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "arena.h"
+
+#include <new>
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace mongoodbc {
+
+Arena::Arena(size_t blockSize)
+    : _blocks(0)
+    , _free(0)
+    , _freeCount(0)
+    , _blockSize(blockSize)
+    , _pos(0)
+    , _end(0)
+{
+}
+
+Arena::~Arena()
+{
+    reset();
+    while (_free) {
+        Header *next = _free->_block._next;
+        free(_free);
+        _free = next;
+    }
+}
+
+void *Arena::allocate(size_t size, size_t align)
+{
+    // blocks start aligned, so aligning the offset aligns the address
+    size_t misalign = (size_t)_pos & (align - 1);
+    char *start = misalign ? _pos + align - misalign : _pos;
+    if (start && size <= (size_t)(_end - start)) {
+        _pos = start + size;
+        return start;
+    }
+    return allocateBlock(size);
+}
+
+void *Arena::allocateBlock(size_t size)
+{
+    Header *block;
+    if (size <= _blockSize && _free) {
+        block = _free;
+        _free = _free->_block._next;
+        --_freeCount;
+    } else {
+        size_t blockSize = size > _blockSize ? size : _blockSize;
+        block = (Header *)malloc(sizeof(Header) + blockSize);
+        if (!block) {
+            throw std::bad_alloc();
+        }
+        block->_block._size = blockSize;
+    }
+
+    char *data = (char *)(block + 1);
+    if (block->_block._size > _blockSize) {
+        // an oversized block holds a single allocation; keep filling the
+        // current block afterwards
+        if (_blocks) {
+            block->_block._next = _blocks->_block._next;
+            _blocks->_block._next = block;
+        } else {
+            block->_block._next = 0;
+            _blocks = block;
+            _pos = _end = data + block->_block._size;
+        }
+        return data;
+    }
+
+    block->_block._next = _blocks;
+    _blocks = block;
+    _pos = data + size;
+    _end = data + block->_block._size;
+    return data;
+}
+
+StringRef Arena::copy(const char *str, size_t len)
+{
+    char *data = (char *)allocate(len + 1, 1);
+    memcpy(data, str, len);
+    data[len] = '\0';
+    return StringRef(data, len);
+}
+
+void Arena::reset()
+{
+    while (_blocks) {
+        Header *next = _blocks->_block._next;
+        if (_blockSize == _blocks->_block._size && _freeCount < MAX_RETAINED_BLOCKS) {
+            _blocks->_block._next = _free;
+            _free = _blocks;
+            ++_freeCount;
+        } else {
+            free(_blocks);
+        }
+        _blocks = next;
+    }
+    _pos = 0;
+    _end = 0;
+}
+
+size_t Arena::blockCount() const
+{
+    size_t count = 0;
+    for (Header *block = _blocks; block; block = block->_block._next) {
+        ++count;
+    }
+    return count;
+}
+
+} // close mongoodbc namespace
@@ -0,0 +1,104 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_ARENA_H_
+#define MONGOODBC_ARENA_H_
+
+#include "string_ref.h"
+
+#include <boost/noncopyable.hpp>
+
+#include <string>
+
+#include <stddef.h>
+
+namespace mongoodbc {
+
+/*
+* Bump allocator for memory that lives until the next 'reset', e.g. the
+* strings describing one statement execution.  Memory is handed out from
+* blocks of 'blockSize' bytes; requests larger than that get a block of
+* their own.  'reset' releases everything at once and keeps up to
+* 'MAX_RETAINED_BLOCKS' standard blocks, so a statement that is executed
+* repeatedly stops calling malloc after the first execution.
+*
+* Destructors of objects placed in the arena are never run.
+*/
+class Arena : boost::noncopyable {
+  public:
+    enum {
+        DEFAULT_BLOCK_SIZE = 4096,
+        MAX_RETAINED_BLOCKS = 16
+    };
+
+  private:
+    union Header {
+        struct {
+            Header *_next;
+            size_t _size;
+        } _block;
+        // forces the data after the header to the strictest alignment
+        double _double;
+        long long _longLong;
+        void *_pointer;
+    };
+
+    // blocks in use, most recent first
+    Header *_blocks;
+    // blocks kept by 'reset' for reuse
+    Header *_free;
+    size_t _freeCount;
+    size_t _blockSize;
+    // free space of the most recent block
+    char *_pos;
+    char *_end;
+
+    // Returns 'size' bytes at the start of a new block, which is aligned
+    // for any type
+    void *allocateBlock(size_t size);
+
+  public:
+    explicit Arena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+
+    ~Arena();
+
+    /*
+    * Returns 'size' bytes aligned to 'align', which must be a power of two
+    * not greater than 'sizeof(double)'.
+    */
+    void *allocate(size_t size, size_t align = sizeof(double));
+
+    /*
+    * Copies 'len' characters of 'str' into the arena, followed by a NUL.
+    */
+    StringRef copy(const char *str, size_t len);
+
+    StringRef copy(const std::string& str) { return copy(str.data(), str.size()); }
+
+    /*
+    * Releases all memory handed out since the last reset.
+    */
+    void reset();
+
+    /*
+    * Returns the number of blocks in use.
+    */
+    size_t blockCount() const;
+};
+
+} // close mongoodbc namespace
+
+#endif
@@ -0,0 +1,89 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "arena.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using mongoodbc::Arena;
+using mongoodbc::StringRef;
+
+TEST(Arena, Alignment)
+{
+    Arena arena(64);
+    arena.allocate(1, 1);
+    void *p = arena.allocate(8);
+    EXPECT_EQ(0u, (size_t)p % sizeof(double));
+    arena.allocate(3, 1);
+    p = arena.allocate(4, 4);
+    EXPECT_EQ(0u, (size_t)p % 4);
+}
+
+TEST(Arena, Copy)
+{
+    Arena arena;
+    std::string str("collection");
+    StringRef ref = arena.copy(str);
+    str[0] = 'x';
+    EXPECT_EQ("collection", ref.str());
+    EXPECT_EQ('\0', ref.data()[ref.size()]);
+    EXPECT_TRUE(StringRef("collection") == ref);
+    EXPECT_TRUE(arena.copy("", 0).empty());
+}
+
+TEST(Arena, Blocks)
+{
+    Arena arena(64);
+    EXPECT_EQ(0u, arena.blockCount());
+    char *a = (char *)arena.allocate(40);
+    char *b = (char *)arena.allocate(40);
+    EXPECT_EQ(2u, arena.blockCount());
+    memset(a, 'a', 40);
+    memset(b, 'b', 40);
+    EXPECT_EQ('a', a[39]);
+
+    // oversized requests get a block of their own and do not waste the
+    // space left in the current block
+    char *big = (char *)arena.allocate(1000);
+    memset(big, 'c', 1000);
+    EXPECT_EQ(3u, arena.blockCount());
+    char *c = (char *)arena.allocate(8);
+    EXPECT_EQ(b + 40, c);
+}
+
+TEST(Arena, ResetReusesBlocks)
+{
+    Arena arena(64);
+    void *first = arena.allocate(40);
+    arena.allocate(40);
+    arena.allocate(1000);
+    arena.reset();
+    EXPECT_EQ(0u, arena.blockCount());
+
+    // the standard blocks are kept, the oversized one was released
+    void *p = arena.allocate(40);
+    void *q = arena.allocate(40);
+    EXPECT_EQ(2u, arena.blockCount());
+    EXPECT_TRUE(p == first || q == first);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,206 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "array_table.h"
+#include "connection_handle.h"
+
+#include <mongo/client/dbclient.h>
+
+#include <string.h>
+
+#include <iostream>
+
+namespace {
+
+/*
+* Adds the conjuncts of 'filter', a single comparison or '$and' of
+* filters, to 'conjuncts'.
+*/
+void conjuncts(const mongo::BSONObj& filter, std::vector<mongo::BSONObj> *conjuncts)
+{
+    if (1 == filter.nFields() && 0 == strcmp("$and", filter.firstElementFieldName())
+        && mongo::Array == filter.firstElement().type()) {
+        mongo::BSONObjIterator termIt(filter.firstElement().embeddedObject());
+        while (termIt.more()) {
+            mongo::BSONElement term = termIt.next();
+            if (mongo::Object == term.type()) {
+                conjuncts(term.embeddedObject(), conjuncts);
+            }
+        }
+        return;
+    }
+    if (!filter.isEmpty()) {
+        conjuncts->push_back(filter);
+    }
+}
+
+/*
+* Returns whether 'field' is 'path' or a document holding it.
+*/
+bool holds(const std::string& field, const std::string& path)
+{
+    return 0 == path.compare(0, field.size(), field)
+        && (path.size() == field.size() || '.' == path[field.size()]);
+}
+
+/*
+* Returns the first document of 'ns', empty if there is none.
+*/
+mongo::BSONObj firstDocument(mongoodbc::ConnectionHandle *connHandle, const std::string& ns)
+{
+    mongoodbc::ScopedConnection conn(connHandle);
+    try {
+        std::auto_ptr<mongo::DBClientCursor> cursor =
+            connHandle->query(conn.get(), ns, mongo::Query(), 1);
+        if (cursor.get() && cursor->more()) {
+            return cursor->next().getOwned();
+        }
+    } catch (const mongo::DBException& e) {
+        std::cerr << "Reading a document of " << ns << " failed: " << e.what() << std::endl;
+    }
+    return mongo::BSONObj();
+}
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+ArrayTable::ArrayTable()
+{
+}
+
+ArrayTable::ArrayTable(const std::string& ns, const std::string& path)
+    : _ns(ns)
+    , _path(path)
+{
+}
+
+std::string ArrayTable::indexColumn() const
+{
+    std::string column(_path);
+    for (size_t i = 0; i < column.size(); ++i) {
+        if ('.' == column[i]) {
+            column[i] = '_';
+        }
+    }
+    return column + "_idx";
+}
+
+std::string ArrayTable::tableName(const std::string& collection, const std::string& path)
+{
+    std::string name(collection + "_" + path);
+    for (size_t i = collection.size(); i < name.size(); ++i) {
+        if ('.' == name[i]) {
+            name[i] = '_';
+        }
+    }
+    return name;
+}
+
+void ArrayTable::arrayPaths(const mongo::BSONObj& doc, std::vector<std::string> *paths)
+{
+    mongo::BSONObjIterator fieldIt(doc);
+    while (fieldIt.more()) {
+        mongo::BSONElement elem = fieldIt.next();
+        if (mongo::Array == elem.type()) {
+            paths->push_back(elem.fieldName());
+        } else if (mongo::Object == elem.type()) {
+            std::vector<std::string> embedded;
+            arrayPaths(elem.embeddedObject(), &embedded);
+            for (size_t i = 0; i < embedded.size(); ++i) {
+                paths->push_back(std::string(elem.fieldName()) + "." + embedded[i]);
+            }
+        }
+    }
+}
+
+void ArrayTable::pipeline(const mongo::BSONObj& filter, mongo::BSONObj *pipeline) const
+{
+    // conditions on one element's fields, and on the document's fields,
+    // hold before unwinding too
+    std::vector<mongo::BSONObj> terms;
+    conjuncts(filter, &terms);
+    std::string prefix = _path + ".";
+    std::string index = indexColumn();
+    mongo::BSONArrayBuilder elementTerms;
+    mongo::BSONArrayBuilder documentTerms;
+    int numElementTerms = 0;
+    int numDocumentTerms = 0;
+    for (size_t i = 0; i < terms.size(); ++i) {
+        if (1 != terms[i].nFields() || mongo::Object != terms[i].firstElement().type()) {
+            continue;
+        }
+        mongo::BSONElement term = terms[i].firstElement();
+        std::string field = term.fieldName();
+        if (0 == field.compare(0, prefix.size(), prefix)) {
+            elementTerms.append(BSON(field.substr(prefix.size()) << term.embeddedObject()));
+            ++numElementTerms;
+        } else if ('$' != field[0] && index != field && !holds(field, _path)) {
+            // neither the array nor a document holding it, so a field of
+            // the document
+            documentTerms.append(terms[i]);
+            ++numDocumentTerms;
+        }
+    }
+    if (numElementTerms) {
+        documentTerms.append(BSON(_path << BSON("$elemMatch" << BSON("$and" << elementTerms.arr()))));
+        ++numDocumentTerms;
+    }
+
+    mongo::BSONArrayBuilder stages;
+    if (numDocumentTerms) {
+        stages.append(BSON("$match" << BSON("$and" << documentTerms.arr())));
+    }
+    stages.append(BSON("$unwind" << BSON("path" << "$" + _path
+                                         << "includeArrayIndex" << index)));
+    if (!filter.isEmpty()) {
+        stages.append(BSON("$match" << filter));
+    }
+    stages.append(BSON("$project" << BSON("_id" << 1 << _path << 1 << index << 1)));
+    *pipeline = stages.arr();
+}
+
+int ArrayTable::resolve(ConnectionHandle *connHandle, const std::string& ns, ArrayTable *table)
+{
+    size_t dot = ns.find('.');
+    if (std::string::npos == dot || std::string::npos == ns.find('_', dot)) {
+        return -1;
+    }
+    std::string db = ns.substr(0, dot);
+    std::string name = ns.substr(dot + 1);
+    if (!firstDocument(connHandle, ns).isEmpty()) {
+        // a collection of its own
+        return -1;
+    }
+
+    // the collection is the longest prefix before a '_' holding the arrays
+    for (size_t end = name.rfind('_'); std::string::npos != end && end > 0;
+         end = name.rfind('_', end - 1)) {
+        std::string collection = name.substr(0, end);
+        mongo::BSONObj doc = firstDocument(connHandle, db + "." + collection);
+        std::vector<std::string> paths;
+        arrayPaths(doc, &paths);
+        for (size_t i = 0; i < paths.size(); ++i) {
+            if (tableName(collection, paths[i]) == name) {
+                *table = ArrayTable(db + "." + collection, paths[i]);
+                return 0;
+            }
+        }
+    }
+    return -1;
+}
+
+} // close mongoodbc namespace
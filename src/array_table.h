@@ -0,0 +1,93 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_ARRAY_TABLE_H_
+#define MONGOODBC_ARRAY_TABLE_H_
+
+#include <mongo/bson/bsonobj.h>
+
+#include <string>
+#include <vector>
+
+namespace mongoodbc {
+
+class ConnectionHandle;
+
+/*
+* An array of a collection's documents exposed as a table of its own,
+* named '<collection>_<path>' with the dots of the path replaced by '_',
+* e.g. 'orders_items' for the arrays 'items' of 'orders'.
+*
+* Each element is a row joined to its document by the columns '_id', the
+* document's, and '<path>_idx', the element's index.  The element is the
+* column '<path>', or columns '<path>.<field>' if it is a document.  The
+* rows are produced by the server: the collection is read through an
+* aggregation that '$unwind's the array.
+*/
+class ArrayTable {
+    // namespace of the collection holding the arrays
+    std::string _ns;
+    // dotted path of the arrays in its documents
+    std::string _path;
+
+  public:
+    ArrayTable();
+
+    ArrayTable(const std::string& ns, const std::string& path);
+
+    const std::string& ns() const { return _ns; }
+
+    const std::string& path() const { return _path; }
+
+    /*
+    * Returns the column holding the index of an element.
+    */
+    std::string indexColumn() const;
+
+    /*
+    * Returns the name of the table of the arrays at 'path' of 'collection'.
+    */
+    static std::string tableName(const std::string& collection, const std::string& path);
+
+    /*
+    * Adds the paths of the arrays in 'doc' and its embedded documents to
+    * 'paths'.  Arrays within arrays are not tables.
+    */
+    static void arrayPaths(const mongo::BSONObj& doc, std::vector<std::string> *paths);
+
+    /*
+    * Sets 'pipeline' to the aggregation stages, an array, returning the
+    * rows of this table that match 'filter', a query filter on its columns
+    * such as 'nativeFilter' builds.  Conditions on fields of the elements
+    * that must all hold are also applied with '$elemMatch' before the
+    * arrays are unwound, so that only documents with a matching element
+    * are read and an index on the array can be used.
+    */
+    void pipeline(const mongo::BSONObj& filter, mongo::BSONObj *pipeline) const;
+
+    /*
+    * Sets 'table' to the array table named by the namespace 'ns', e.g.
+    * 'db.orders_items', if 'ns' is not a collection of its own but
+    * '<collection>_<path>' for arrays at 'path' in the first document of
+    * a collection.
+    * @return 0 if 'ns' names an array table, -1 otherwise
+    */
+    static int resolve(ConnectionHandle *connHandle, const std::string& ns, ArrayTable *table);
+};
+
+} // close mongoodbc namespace
+
+#endif
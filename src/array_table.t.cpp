@@ -0,0 +1,105 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "array_table.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using mongoodbc::ArrayTable;
+
+TEST(ArrayTable, Names)
+{
+    EXPECT_EQ("orders_items", ArrayTable::tableName("orders", "items"));
+    EXPECT_EQ("my.orders_ship_to_lines", ArrayTable::tableName("my.orders", "ship_to.lines"));
+
+    EXPECT_EQ("items_idx", ArrayTable("db.orders", "items").indexColumn());
+    EXPECT_EQ("ship_to_lines_idx", ArrayTable("db.orders", "ship_to.lines").indexColumn());
+}
+
+TEST(ArrayTable, ArrayPaths)
+{
+    mongo::BSONObj doc = BSON("_id" << 1
+                              << "tags" << BSON_ARRAY("a" << "b")
+                              << "address" << BSON("city" << "x"
+                                                   << "lines" << BSON_ARRAY(BSON("n" << 1)))
+                              << "matrix" << BSON_ARRAY(BSON_ARRAY(1 << 2)));
+    std::vector<std::string> paths;
+    ArrayTable::arrayPaths(doc, &paths);
+    ASSERT_EQ(3U, paths.size());
+    EXPECT_EQ("tags", paths[0]);
+    EXPECT_EQ("address.lines", paths[1]);
+    // arrays within arrays are not tables
+    EXPECT_EQ("matrix", paths[2]);
+}
+
+TEST(ArrayTable, Pipeline)
+{
+    ArrayTable table("db.orders", "items");
+    mongo::BSONObj filter = BSON("$and" << BSON_ARRAY(BSON("items.price" << BSON("$gt" << 5))
+                                                      << BSON("status" << BSON("$eq" << "A"))
+                                                      << BSON("items_idx" << BSON("$eq" << 0))
+                                                      << BSON("items" << BSON("$ne" << 1))));
+    mongo::BSONObj pipeline;
+    table.pipeline(filter, &pipeline);
+
+    mongo::BSONObj elemMatch = BSON("$elemMatch" << BSON("$and" << BSON_ARRAY(BSON("price" << BSON("$gt" << 5)))));
+    mongo::BSONObj expected = BSON_ARRAY(
+        BSON("$match" << BSON("$and" << BSON_ARRAY(BSON("status" << BSON("$eq" << "A"))
+                                                   << BSON("items" << elemMatch))))
+        << BSON("$unwind" << BSON("path" << "$items" << "includeArrayIndex" << "items_idx"))
+        << BSON("$match" << filter)
+        << BSON("$project" << BSON("_id" << 1 << "items" << 1 << "items_idx" << 1)));
+    EXPECT_EQ(expected.toString(), pipeline.toString());
+}
+
+TEST(ArrayTable, PipelineWithoutFilter)
+{
+    ArrayTable table("db.orders", "address.lines");
+    mongo::BSONObj pipeline;
+    table.pipeline(mongo::BSONObj(), &pipeline);
+
+    mongo::BSONObj expected = BSON_ARRAY(
+        BSON("$unwind" << BSON("path" << "$address.lines"
+                               << "includeArrayIndex" << "address_lines_idx"))
+        << BSON("$project" << BSON("_id" << 1 << "address.lines" << 1
+                                   << "address_lines_idx" << 1)));
+    EXPECT_EQ(expected.toString(), pipeline.toString());
+}
+
+TEST(ArrayTable, PipelineDisjunction)
+{
+    // only conditions that must hold are applied before unwinding
+    ArrayTable table("db.orders", "items");
+    mongo::BSONObj filter = BSON("$or" << BSON_ARRAY(BSON("items.price" << BSON("$gt" << 5))
+                                                     << BSON("status" << BSON("$eq" << "A"))));
+    mongo::BSONObj pipeline;
+    table.pipeline(filter, &pipeline);
+
+    mongo::BSONObj expected = BSON_ARRAY(
+        BSON("$unwind" << BSON("path" << "$items" << "includeArrayIndex" << "items_idx"))
+        << BSON("$match" << filter)
+        << BSON("$project" << BSON("_id" << 1 << "items" << 1 << "items_idx" << 1)));
+    EXPECT_EQ(expected.toString(), pipeline.toString());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,118 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "batch_sizer.h"
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <algorithm>
+
+namespace {
+
+// weight given to the newest sample in the running averages
+const double SMOOTHING = 0.5;
+
+// a batch should last the consumer roughly this long
+const double TARGET_BATCH_SECONDS = 1.0;
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+BatchSizer::BatchSizer(int fixedBatchSize,
+                       long long memoryBudget,
+                       int floor)
+    : _fixedBatchSize(fixedBatchSize)
+    , _memoryBudget(memoryBudget > 0 ? memoryBudget : (long long)DEFAULT_MEMORY_BUDGET)
+    , _floor(std::min(std::max(floor, 0), (int)MAX_BATCH_SIZE))
+    , _current(0)
+    , _avgDocSize(0)
+    , _fetchRate(0)
+    , _docsSeen(0)
+    , _docsInBatch(0)
+{
+}
+
+int BatchSizer::initialBatchSize()
+{
+    _batchStart = boost::posix_time::microsec_clock::universal_time();
+    _docsInBatch = 0;
+    if (_fixedBatchSize > 0) {
+        _current = _fixedBatchSize;
+    } else {
+        _current = std::max((int)INITIAL_BATCH_SIZE, _floor);
+    }
+    return _current;
+}
+
+void BatchSizer::observe(int objSize)
+{
+    if (0 == _docsSeen) {
+        _avgDocSize = objSize;
+    } else {
+        _avgDocSize = SMOOTHING * objSize + (1 - SMOOTHING) * _avgDocSize;
+    }
+    ++_docsSeen;
+    ++_docsInBatch;
+}
+
+int BatchSizer::nextBatchSize()
+{
+    boost::posix_time::ptime now =
+        boost::posix_time::microsec_clock::universal_time();
+    double elapsed = (now - _batchStart).total_microseconds() / 1e6;
+    int next = nextBatchSize(elapsed);
+    _batchStart = now;
+    return next;
+}
+
+int BatchSizer::nextBatchSize(double elapsedSeconds)
+{
+    int docsInBatch = _docsInBatch;
+    _docsInBatch = 0;
+
+    if (_fixedBatchSize > 0) {
+        return _fixedBatchSize;
+    }
+
+    if (docsInBatch > 0 && elapsedSeconds > 0) {
+        double rate = docsInBatch / elapsedSeconds;
+        _fetchRate = (0 == _fetchRate)
+                   ? rate
+                   : SMOOTHING * rate + (1 - SMOOTHING) * _fetchRate;
+    }
+
+    double next = (double)std::max(_current, 1) * GROWTH_FACTOR;
+
+    // never buffer more than the memory budget allows
+    if (_avgDocSize > 0) {
+        next = std::min(next, _memoryBudget / _avgDocSize);
+    }
+
+    // a slow consumer gains nothing from batches it won't drain soon
+    if (_fetchRate > 0) {
+        next = std::min(next, std::max(_fetchRate * TARGET_BATCH_SECONDS,
+                                       (double)_current));
+    }
+
+    next = std::min(next, (double)MAX_BATCH_SIZE);
+    next = std::max(next, (double)std::max((int)MIN_BATCH_SIZE, _floor));
+
+    _current = (int)next;
+    return _current;
+}
+
+} // close mongoodbc namespace
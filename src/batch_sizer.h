@@ -0,0 +1,96 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_BATCH_SIZER_H_
+#define MONGOODBC_BATCH_SIZER_H_
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+namespace mongoodbc {
+
+/*
+* Class choosing the number of documents requested per cursor batch.
+*
+* The first batch is kept small so the first row reaches the application
+* quickly.  Every following batch grows geometrically, bounded by how many
+* documents of the observed average size fit in the memory budget and by how
+* fast the application actually consumes rows.  A fixed batch size disables
+* the adaptation entirely.
+*/
+class BatchSizer {
+  public:
+    enum {
+        INITIAL_BATCH_SIZE = 16,
+        MIN_BATCH_SIZE = 2,
+        MAX_BATCH_SIZE = 100000,
+        GROWTH_FACTOR = 4,
+        DEFAULT_MEMORY_BUDGET = 16 * 1024 * 1024
+    };
+
+  private:
+    // fixed batch size requested by the application, 0 when adaptive
+    int _fixedBatchSize;
+    // maximum number of bytes a single batch should occupy
+    long long _memoryBudget;
+    // lower bound for every batch, e.g. the ODBC row array size
+    int _floor;
+
+    // the batch size most recently handed out
+    int _current;
+
+    // running averages over the documents consumed so far
+    double _avgDocSize;
+    double _fetchRate;
+    long long _docsSeen;
+    int _docsInBatch;
+
+    boost::posix_time::ptime _batchStart;
+
+  public:
+    BatchSizer(int fixedBatchSize = 0,
+               long long memoryBudget = DEFAULT_MEMORY_BUDGET,
+               int floor = 0);
+
+    /*
+    * Returns the batch size to use for the initial query.
+    */
+    int initialBatchSize();
+
+    /*
+    * Records that a document of 'objSize' bytes was handed to the application.
+    */
+    void observe(int objSize);
+
+    /*
+    * Returns the batch size to request once the current batch is exhausted,
+    * measuring the consumer's fetch rate from the wall clock.
+    */
+    int nextBatchSize();
+
+    /*
+    * As above, with the time spent draining the last batch supplied by the
+    * caller.
+    */
+    int nextBatchSize(double elapsedSeconds);
+
+    double averageDocumentSize() const { return _avgDocSize; }
+
+    double fetchRate() const { return _fetchRate; }
+};
+
+} // close mongoodbc namespace
+
+#endif
@@ -0,0 +1,90 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "batch_sizer.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+void consume(mongoodbc::BatchSizer *sizer, int numDocs, int objSize)
+{
+    for (int i = 0; i < numDocs; ++i) {
+        sizer->observe(objSize);
+    }
+}
+
+} // close unnamed namespace
+
+TEST(BatchSizer, StartsSmall)
+{
+    mongoodbc::BatchSizer sizer;
+    EXPECT_EQ(mongoodbc::BatchSizer::INITIAL_BATCH_SIZE, sizer.initialBatchSize());
+}
+
+TEST(BatchSizer, GrowsForFastConsumer)
+{
+    mongoodbc::BatchSizer sizer;
+    int batch = sizer.initialBatchSize();
+    for (int i = 0; i < 4; ++i) {
+        consume(&sizer, batch, 100);
+        int next = sizer.nextBatchSize(0.001);
+        EXPECT_EQ(batch * mongoodbc::BatchSizer::GROWTH_FACTOR, next);
+        batch = next;
+    }
+}
+
+TEST(BatchSizer, BoundedByMemoryBudget)
+{
+    mongoodbc::BatchSizer sizer(0, 64 * 1024);
+    int batch = sizer.initialBatchSize();
+    for (int i = 0; i < 10; ++i) {
+        consume(&sizer, batch, 1024);
+        batch = sizer.nextBatchSize(0.0001);
+    }
+    EXPECT_EQ(64, batch);
+}
+
+TEST(BatchSizer, SlowConsumerDoesNotGrow)
+{
+    mongoodbc::BatchSizer sizer;
+    int batch = sizer.initialBatchSize();
+    // an interactive preview reading a few rows per second
+    consume(&sizer, batch, 100);
+    EXPECT_EQ(batch, sizer.nextBatchSize(batch / 2.0));
+}
+
+TEST(BatchSizer, FixedBatchSize)
+{
+    mongoodbc::BatchSizer sizer(500);
+    EXPECT_EQ(500, sizer.initialBatchSize());
+    consume(&sizer, 500, 100);
+    EXPECT_EQ(500, sizer.nextBatchSize(0.001));
+}
+
+TEST(BatchSizer, RowArraySizeFloor)
+{
+    mongoodbc::BatchSizer sizer(0, 1024, 1000);
+    EXPECT_EQ(1000, sizer.initialBatchSize());
+    consume(&sizer, 1000, 1024);
+    EXPECT_EQ(1000, sizer.nextBatchSize(0.001));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
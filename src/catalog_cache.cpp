@@ -0,0 +1,176 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#include "catalog_cache.h"
+#include "connection_handle.h"
+
+#include <mongo/client/dbclient.h>
+
+#include <boost/thread/locks.hpp>
+
+#include <iostream>
+
+namespace mongoodbc {
+
+CollectionInfo::CollectionInfo()
+    : _count(0)
+    , _storageSize(0)
+{
+}
+
+long long CollectionInfo::pages() const
+{
+    return (_storageSize + PAGE_SIZE - 1) / PAGE_SIZE;
+}
+
+long long CollectionInfo::indexPages(const std::string& name) const
+{
+    mongo::BSONElement size = _indexSizes[name];
+    if (!size.isNumber()) {
+        return -1;
+    }
+    return (size.numberLong() + PAGE_SIZE - 1) / PAGE_SIZE;
+}
+
+bool CollectionInfo::uniqueIndex(const mongo::BSONObj& index)
+{
+    return std::string("_id_") == index.getStringField("name") || index["unique"].trueValue();
+}
+
+bool CollectionInfo::hashedIndex(const mongo::BSONObj& index)
+{
+    mongo::BSONObjIterator keyIt(index.getObjectField("key"));
+    while (keyIt.more()) {
+        mongo::BSONElement key = keyIt.next();
+        if (mongo::String == key.type() && "hashed" == key.str()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void CollectionInfo::fromStats(const mongo::BSONObj& stats,
+                               const std::vector<mongo::BSONObj>& indexes,
+                               CollectionInfo *info)
+{
+    info->_indexes = indexes;
+    info->_count = stats["count"].numberLong();
+    info->_storageSize = stats["storageSize"].numberLong();
+    info->_indexSizes = stats.getObjectField("indexSizes").getOwned();
+}
+
+int CollectionInfo::load(ConnectionHandle *connHandle,
+                         const std::string& ns,
+                         CollectionInfo *info)
+{
+    size_t periodIdx = ns.find('.');
+    if (std::string::npos == periodIdx) {
+        return -1;
+    }
+    mongo::BSONObjBuilder collStats;
+    collStats.append("collStats", ns.substr(periodIdx + 1));
+    mongo::BSONObj stats;
+    if (0 != connHandle->runCommand(ns.substr(0, periodIdx), collStats.obj(), &stats)) {
+        return -1;
+    }
+
+    std::vector<mongo::BSONObj> indexes;
+    ScopedConnection conn(connHandle);
+    if (!conn.get()) {
+        return -1;
+    }
+    try {
+        std::auto_ptr<mongo::DBClientCursor> cursor = conn.get()->getIndexes(ns);
+        while (cursor.get() && cursor->more()) {
+            indexes.push_back(cursor->next().getOwned());
+        }
+    } catch (const mongo::DBException& e) {
+        std::cerr << "Listing the indexes of " << ns << " failed: " << e.what() << std::endl;
+        return -1;
+    }
+    fromStats(stats, indexes, info);
+    return 0;
+}
+
+CatalogCache::CatalogCache(time_t maxAgeSeconds)
+    : _maxAge(maxAgeSeconds)
+{
+}
+
+int CatalogCache::lookup(const std::string& ns, time_t now, CollectionInfo *info)
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    std::map<std::string, Entry>::iterator it = _entries.find(ns);
+    if (_entries.end() == it) {
+        return -1;
+    }
+    if (now - it->second._loaded > _maxAge || now < it->second._loaded) {
+        _entries.erase(it);
+        return -1;
+    }
+    *info = it->second._info;
+    return 0;
+}
+
+void CatalogCache::insert(const std::string& ns, const CollectionInfo& info, time_t now)
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    Entry& entry = _entries[ns];
+    entry._info = info;
+    entry._loaded = now;
+}
+
+int CatalogCache::lookupCount(const std::string& key, time_t now, long long *count)
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    std::map<std::string, CountEntry>::iterator it = _counts.find(key);
+    if (_counts.end() == it) {
+        return -1;
+    }
+    if (now - it->second._loaded > _maxAge || now < it->second._loaded) {
+        _counts.erase(it);
+        return -1;
+    }
+    *count = it->second._count;
+    return 0;
+}
+
+void CatalogCache::insertCount(const std::string& key, long long count, time_t now)
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    CountEntry& entry = _counts[key];
+    entry._count = count;
+    entry._loaded = now;
+}
+
+void CatalogCache::erase(const std::string& ns)
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    _entries.erase(ns);
+    std::string prefix(ns + " ");
+    std::map<std::string, CountEntry>::iterator it = _counts.lower_bound(prefix);
+    while (_counts.end() != it && 0 == it->first.compare(0, prefix.size(), prefix)) {
+        _counts.erase(it++);
+    }
+}
+
+void CatalogCache::clear()
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    _entries.clear();
+    _counts.clear();
+}
+
+} // close mongoodbc namespace
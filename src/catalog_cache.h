@@ -0,0 +1,162 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_CATALOG_CACHE_H_
+#define MONGOODBC_CATALOG_CACHE_H_
+
+#include <mongo/bson/bsonobj.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <time.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace mongoodbc {
+
+class ConnectionHandle;
+
+/*
+* What the driver knows of a collection's indexes and size, as reported by
+* 'getIndexes' and 'collStats'.
+*/
+struct CollectionInfo {
+    enum {
+        // bytes per page reported by 'SQLStatistics'
+        PAGE_SIZE = 4096
+    };
+
+    // index specifications, e.g. '{ name: "a_1", key: { a: 1 } }'
+    std::vector<mongo::BSONObj> _indexes;
+    // documents in the collection
+    long long _count;
+    // bytes allocated to the documents
+    long long _storageSize;
+    // bytes allocated to each index, by index name
+    mongo::BSONObj _indexSizes;
+
+    CollectionInfo();
+
+    /*
+    * Returns the pages holding the documents.
+    */
+    long long pages() const;
+
+    /*
+    * Returns the pages holding the index named 'name', -1 if unknown.
+    */
+    long long indexPages(const std::string& name) const;
+
+    /*
+    * Returns whether the index specified by 'index' admits one document per
+    * key, as '_id_' and unique indexes do.
+    */
+    static bool uniqueIndex(const mongo::BSONObj& index);
+
+    /*
+    * Returns whether the index specified by 'index' hashes its key.
+    */
+    static bool hashedIndex(const mongo::BSONObj& index);
+
+    /*
+    * Sets 'info' from the 'collStats' reply 'stats' and the index
+    * specifications 'indexes'.
+    */
+    static void fromStats(const mongo::BSONObj& stats,
+                          const std::vector<mongo::BSONObj>& indexes,
+                          CollectionInfo *info);
+
+    /*
+    * Reads 'info' for 'ns' from the server over connections checked out
+    * from 'connHandle'.
+    * @return 0 on success, -1 otherwise
+    */
+    static int load(ConnectionHandle *connHandle, const std::string& ns, CollectionInfo *info);
+};
+
+/*
+* 'CollectionInfo' by namespace, kept for 'maxAgeSeconds' after it was read
+* so that catalog functions and the planner do not ask the server for each
+* statement.  Counts of documents matching a statement's filter are kept
+* the same way, under keys starting with the namespace and a space.
+*/
+class CatalogCache : boost::noncopyable {
+  public:
+    enum {
+        DEFAULT_MAX_AGE_SECONDS = 60
+    };
+
+  private:
+    struct Entry {
+        CollectionInfo _info;
+        time_t _loaded;
+    };
+
+    struct CountEntry {
+        long long _count;
+        time_t _loaded;
+    };
+
+    boost::mutex _mutex;
+    std::map<std::string, Entry> _entries;
+    std::map<std::string, CountEntry> _counts;
+    time_t _maxAge;
+
+  public:
+    explicit CatalogCache(time_t maxAgeSeconds = DEFAULT_MAX_AGE_SECONDS);
+
+    /*
+    * Sets 'info' to the entry for 'ns' if it was read no more than the
+    * maximum age before 'now'.  Older entries are dropped.
+    * @return 0 if found, -1 otherwise
+    */
+    int lookup(const std::string& ns, time_t now, CollectionInfo *info);
+
+    /*
+    * Adds 'info', read at 'now', under 'ns', replacing any entry already
+    * there.
+    */
+    void insert(const std::string& ns, const CollectionInfo& info, time_t now);
+
+    /*
+    * Sets 'count' to the count cached under 'key' if it was read no more
+    * than the maximum age before 'now'.  Older counts are dropped.
+    * @return 0 if found, -1 otherwise
+    */
+    int lookupCount(const std::string& key, time_t now, long long *count);
+
+    /*
+    * Adds 'count', read at 'now', under 'key'.
+    */
+    void insertCount(const std::string& key, long long count, time_t now);
+
+    /*
+    * Removes the entry and the counts of 'ns'.
+    */
+    void erase(const std::string& ns);
+
+    /*
+    * Removes all entries.
+    */
+    void clear();
+};
+
+} // close mongoodbc namespace
+
+#endif
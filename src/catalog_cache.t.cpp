@@ -0,0 +1,103 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#include "catalog_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using mongoodbc::CatalogCache;
+using mongoodbc::CollectionInfo;
+
+TEST(CollectionInfo, FromStats)
+{
+    std::vector<mongo::BSONObj> indexes;
+    indexes.push_back(BSON("name" << "_id_" << "key" << BSON("_id" << 1)));
+    indexes.push_back(BSON("name" << "a_1_b_-1" << "key" << BSON("a" << 1 << "b" << -1)
+                           << "unique" << true));
+    indexes.push_back(BSON("name" << "c_hashed" << "key" << BSON("c" << "hashed")));
+    mongo::BSONObj stats = BSON("count" << 100 << "size" << 5000 << "storageSize" << 8193
+                                << "indexSizes" << BSON("_id_" << 4096 << "a_1_b_-1" << 100));
+
+    CollectionInfo info;
+    CollectionInfo::fromStats(stats, indexes, &info);
+    EXPECT_EQ(100, info._count);
+    EXPECT_EQ(3, info.pages());
+    EXPECT_EQ(1, info.indexPages("_id_"));
+    EXPECT_EQ(1, info.indexPages("a_1_b_-1"));
+    EXPECT_EQ(-1, info.indexPages("c_hashed"));
+    ASSERT_EQ(3U, info._indexes.size());
+
+    EXPECT_TRUE(CollectionInfo::uniqueIndex(info._indexes[0]));
+    EXPECT_TRUE(CollectionInfo::uniqueIndex(info._indexes[1]));
+    EXPECT_FALSE(CollectionInfo::uniqueIndex(info._indexes[2]));
+    EXPECT_FALSE(CollectionInfo::hashedIndex(info._indexes[0]));
+    EXPECT_TRUE(CollectionInfo::hashedIndex(info._indexes[2]));
+}
+
+TEST(CatalogCache, Expiry)
+{
+    CatalogCache cache(60);
+    CollectionInfo info;
+    info._count = 7;
+    cache.insert("db.t", info, 1000);
+
+    CollectionInfo found;
+    ASSERT_EQ(0, cache.lookup("db.t", 1060, &found));
+    EXPECT_EQ(7, found._count);
+    EXPECT_EQ(-1, cache.lookup("db.other", 1000, &found));
+
+    // expired entries are dropped
+    EXPECT_EQ(-1, cache.lookup("db.t", 1061, &found));
+    EXPECT_EQ(-1, cache.lookup("db.t", 1000, &found));
+
+    cache.insert("db.t", info, 2000);
+    cache.erase("db.t");
+    EXPECT_EQ(-1, cache.lookup("db.t", 2000, &found));
+
+    cache.insert("db.t", info, 2000);
+    cache.clear();
+    EXPECT_EQ(-1, cache.lookup("db.t", 2000, &found));
+}
+
+TEST(CatalogCache, Counts)
+{
+    CatalogCache cache(60);
+    CollectionInfo info;
+    cache.insert("db.t", info, 1000);
+    cache.insertCount("db.t { a: 1 } {} 0", 5, 1000);
+    cache.insertCount("db.tt {} {} 0", 6, 1000);
+
+    long long count = 0;
+    ASSERT_EQ(0, cache.lookupCount("db.t { a: 1 } {} 0", 1010, &count));
+    EXPECT_EQ(5, count);
+    EXPECT_EQ(-1, cache.lookupCount("db.t { a: 2 } {} 0", 1010, &count));
+    EXPECT_EQ(-1, cache.lookupCount("db.tt {} {} 0", 1061, &count));
+
+    // erasing a collection drops its counts, not those of others
+    cache.insertCount("db.tt {} {} 0", 6, 1000);
+    cache.erase("db.t");
+    EXPECT_EQ(-1, cache.lookupCount("db.t { a: 1 } {} 0", 1010, &count));
+    ASSERT_EQ(0, cache.lookupCount("db.tt {} {} 0", 1010, &count));
+    EXPECT_EQ(6, count);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
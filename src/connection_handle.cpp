@@ -17,19 +17,286 @@
 #include <connection_handle.h>
 #include <environment_handle.h>
 
+#include <boost/thread/locks.hpp>
+
+#include <stdexcept>
+
+#include <vector>
+
 namespace mongoodbc {
 
 ConnectionHandle::ConnectionHandle(EnvironmentHandle *envHandle)
     : _envHandle(envHandle)
+    , _conn(0)
+    , _pool(0)
+    , _generation(0)
+{
+}
+
+ConnectionHandle::~ConnectionHandle()
+{
+    disconnect();
+}
+
+mongo::DBClientBase *ConnectionHandle::newConnection(
+    const ConnectionString& connectString)
+{
+    const std::vector<ConnectionString::Host>& hosts = connectString.hosts();
+    std::string errmsg;
+
+    if (!connectString.replicaSet().empty()) {
+        std::vector<mongo::HostAndPort> seeds;
+        for (size_t i = 0; i < hosts.size(); ++i) {
+            seeds.push_back(mongo::HostAndPort(hosts[i]._name, hosts[i]._port));
+        }
+        std::auto_ptr<mongo::DBClientReplicaSet> conn(
+            new mongo::DBClientReplicaSet(connectString.replicaSet(),
+                                          seeds,
+                                          connectString.socketTimeout()));
+        if (!conn->connect()) {
+            std::cerr << "Connection to replica set "
+                      << connectString.replicaSet()
+                      << " failed"
+                      << std::endl;
+            return 0;
+        }
+        return conn.release();
+    }
+
+    // Without a replica set name the hosts are tried in order
+    for (size_t i = 0; i < hosts.size(); ++i) {
+        double timeout = connectString.connectTimeout();
+        if (0 == timeout) {
+            timeout = connectString.socketTimeout();
+        }
+        std::auto_ptr<mongo::DBClientConnection> conn(
+            new mongo::DBClientConnection(false, 0, timeout));
+        if (conn->connect(mongo::HostAndPort(hosts[i]._name, hosts[i]._port),
+                          errmsg)) {
+            conn->setSoTimeout(connectString.socketTimeout());
+            return conn.release();
+        }
+        std::cerr << "Connection to mongoDB at "
+                  << hosts[i].toString()
+                  << " failed: "
+                  << errmsg
+                  << std::endl;
+    }
+
+    return 0;
+}
+
+int ConnectionHandle::connect(const std::string& connectString)
+{
+    disconnect();
+
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    std::string errmsg;
+    if (_connectString.parse(connectString, &errmsg)) {
+        std::cerr << "Invalid connection string: " << errmsg << std::endl;
+        return -1;
+    }
+
+    _pool = _connectString.pooling() ? _envHandle->connectionPool() : 0;
+    _poolKey = _connectString.normalized();
+
+    _conn = openConnection(_pool, _poolKey, _connectString);
+    if (!_conn) {
+        return -1;
+    }
+
+    return 0;
+}
+
+void ConnectionHandle::disconnect()
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    ++_generation;
+    for (size_t i = 0; i < _statementConns.size(); ++i) {
+        closeConnection(_statementConns[i]);
+    }
+    _statementConns.clear();
+    _arrayTables.clear();
+    _catalogCache.clear();
+    if (_conn) {
+        closeConnection(_conn);
+        _conn = 0;
+    }
+}
+
+std::string ConnectionHandle::attribute(const std::string& key) const
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    return _connectString.attribute(key);
+}
+
+int ConnectionHandle::batchSize() const
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    return _connectString.batchSize();
+}
+
+long long ConnectionHandle::batchMemoryLimit() const
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    return _connectString.batchMemoryLimit();
+}
+
+long long ConnectionHandle::joinMemoryLimit() const
 {
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    return _connectString.joinMemoryLimit();
 }
 
-int ConnectionHandle::connect()
+long long ConnectionHandle::sortMemoryLimit() const
 {
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    return _connectString.sortMemoryLimit();
+}
+
+long long ConnectionHandle::aggregateMemoryLimit() const
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    return _connectString.aggregateMemoryLimit();
+}
+
+std::string ConnectionHandle::tempDirectory() const
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    return _connectString.tempDirectory();
+}
+
+bool ConnectionHandle::exactRowCount() const
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    return _connectString.exactRowCount();
+}
+
+bool ConnectionHandle::fastParser() const
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    return _connectString.fastParser();
+}
+
+PlanCache *ConnectionHandle::planCache()
+{
+    return _envHandle->planCache();
+}
+
+void ConnectionHandle::applyReadPreference(mongo::Query *query,
+                                           int *queryOptions) const
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    if (mongo::ReadPreference_PrimaryOnly == _connectString.readPreference()) {
+        return;
+    }
+
+    query->readPref(_connectString.readPreference(), mongo::BSONArray());
+    *queryOptions |= mongo::QueryOption_SlaveOk;
+}
+
+mongo::DBClientBase *ConnectionHandle::openConnection(
+    ConnectionPool *pool,
+    const std::string& poolKey,
+    const ConnectionString& connectString)
+{
+    if (pool) {
+        mongo::DBClientBase *conn = pool->checkout(poolKey);
+        if (conn) {
+            return conn;
+        }
+    }
+
+    return newConnection(connectString);
+}
+
+void ConnectionHandle::closeConnection(mongo::DBClientBase *conn)
+{
+    if (_pool) {
+        _pool->checkin(_poolKey, conn, _connectString.maxPoolSize());
+    } else {
+        delete conn;
+    }
+}
+
+mongo::DBClientBase *ConnectionHandle::acquireConnection()
+{
+    ConnectionPool *pool;
+    std::string poolKey;
+    ConnectionString connectString;
+    {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        pool = _pool;
+        poolKey = _poolKey;
+        connectString = _connectString;
+    }
+
+    // opening a connection may take a while, so done without the lock
+    return openConnection(pool, poolKey, connectString);
+}
+
+void ConnectionHandle::releaseConnection(mongo::DBClientBase *conn)
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    closeConnection(conn);
+}
+
+mongo::DBClientBase *ConnectionHandle::checkoutConnection(
+    unsigned int *generation)
+{
+    {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        if (!_conn) {
+            return 0;
+        }
+        *generation = _generation;
+        if (!_statementConns.empty()) {
+            mongo::DBClientBase *conn = _statementConns.back();
+            _statementConns.pop_back();
+            return conn;
+        }
+    }
+
+    return acquireConnection();
+}
+
+void ConnectionHandle::checkinConnection(mongo::DBClientBase *conn,
+                                         unsigned int generation)
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    if (generation != _generation || conn->isFailed()) {
+        // connected elsewhere since, or broken
+        delete conn;
+        return;
+    }
+    if (_statementConns.size() < MAX_IDLE_STATEMENT_CONNECTIONS) {
+        _statementConns.push_back(conn);
+        return;
+    }
+    closeConnection(conn);
+}
+
+int ConnectionHandle::runCommand(const std::string& db,
+                                 const mongo::BSONObj& cmd,
+                                 mongo::BSONObj *info)
+{
+    // over a statement connection, so '_mutex' is only held to check it
+    // out and in rather than for the round trip
+    ScopedConnection conn(this);
+    if (!conn.get()) {
+        return -1;
+    }
+
     try {
-        _conn.connect("localhost");
+        int queryOptions;
+        if (0 != runReadCommand(conn.get(), db, cmd, info, &queryOptions)) {
+            return -1;
+        }
     } catch (const mongo::DBException &e) {
-        std::cerr << "Connection to mongoDB failed" << std::endl;
+        std::cerr << "runCommand "
+                  << cmd.toString()
+                  << " failed"
+                  << std::endl;
         return -1;
     }
 
@@ -38,8 +305,13 @@ int ConnectionHandle::connect()
 
 int ConnectionHandle::getDbNames(std::list<std::string> *dbs)
 {
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    if (!_conn) {
+        return -1;
+    }
+
     try {
-        *dbs = _conn.getDatabaseNames();
+        *dbs = _conn->getDatabaseNames();
     } catch (const mongo::DBException &e) {
         std::cerr << "getDbNames failed" << std::endl;
         return -1;
@@ -51,8 +323,13 @@ int ConnectionHandle::getDbNames(std::list<std::string> *dbs)
 int ConnectionHandle::getCollectionNames(const std::string& db,
                                          std::list<std::string> *collections)
 {
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    if (!_conn) {
+        return -1;
+    }
+
     try {
-        *collections = _conn.getCollectionNames(db);
+        *collections = _conn->getCollectionNames(db);
     } catch (const mongo::DBException &e) {
         std::cerr << "getCollectionNames "
                   << " for db "
@@ -65,7 +342,49 @@ int ConnectionHandle::getCollectionNames(const std::string& db,
     return 0;
 }
 
+int ConnectionHandle::arrayTable(const std::string& ns, ArrayTable *table)
+{
+    {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        std::map<std::string, ArrayTable>::const_iterator it = _arrayTables.find(ns);
+        if (_arrayTables.end() != it) {
+            *table = it->second;
+            return it->second.path().empty() ? -1 : 0;
+        }
+    }
+
+    // resolving checks out connections, so runs without the lock
+    ArrayTable resolved;
+    int rc = ArrayTable::resolve(this, ns, &resolved);
+    if (0 != rc) {
+        resolved = ArrayTable();
+    }
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    _arrayTables[ns] = resolved;
+    *table = resolved;
+    return rc;
+}
+
+int ConnectionHandle::collectionInfo(const std::string& ns,
+                                     bool refresh,
+                                     CollectionInfo *info)
+{
+    time_t now = time(0);
+    if (!refresh && 0 == _catalogCache.lookup(ns, now, info)) {
+        return 0;
+    }
+    CollectionInfo loaded;
+    if (0 != CollectionInfo::load(this, ns, &loaded)) {
+        _catalogCache.erase(ns);
+        return -1;
+    }
+    _catalogCache.insert(ns, loaded, now);
+    *info = loaded;
+    return 0;
+}
+
 std::auto_ptr<mongo::DBClientCursor> ConnectionHandle::query(
+    mongo::DBClientBase *conn,
     const std::string& collection,
     mongo::Query query,
     int numToReturn,
@@ -74,7 +393,12 @@ std::auto_ptr<mongo::DBClientCursor> ConnectionHandle::query(
     int queryOptions,
     int batchSize)
 {
-    return _conn.query(collection,
+    if (!conn) {
+        return std::auto_ptr<mongo::DBClientCursor>();
+    }
+
+    applyReadPreference(&query, &queryOptions);
+    return conn->query(collection,
                        query,
                        numToReturn,
                        numToSkip,
@@ -83,5 +407,69 @@ std::auto_ptr<mongo::DBClientCursor> ConnectionHandle::query(
                        batchSize);
 }
 
-} // close mongoodbc namespace
+int ConnectionHandle::runReadCommand(mongo::DBClientBase *conn,
+                                     const std::string& db,
+                                     const mongo::BSONObj& cmd,
+                                     mongo::BSONObj *reply,
+                                     int *queryOptions)
+{
+    // commands are queries of '$cmd', so they carry the read preference
+    // the same way
+    mongo::Query query(cmd);
+    *queryOptions = 0;
+    applyReadPreference(&query, queryOptions);
+    *reply = conn->findOne(db + ".$cmd", query, 0, *queryOptions);
+    return reply->getField("ok").trueValue() ? 0 : -1;
+}
+
+unsigned long long ConnectionHandle::count(mongo::DBClientBase *conn,
+                                           const std::string& collection,
+                                           const mongo::BSONObj& filter)
+{
+    size_t periodIdx = collection.find('.');
+    mongo::BSONObjBuilder cmd;
+    cmd.append("count", collection.substr(periodIdx + 1));
+    cmd.append("query", filter);
+    mongo::BSONObj reply;
+    int queryOptions;
+    if (0 != runReadCommand(conn, collection.substr(0, periodIdx), cmd.obj(), &reply, &queryOptions)) {
+        throw std::runtime_error("count of " + collection + " failed: " + reply.toString());
+    }
+    return (unsigned long long)reply["n"].numberLong();
+}
+
+int ConnectionHandle::aggregate(mongo::DBClientBase *conn,
+                                const std::string& collection,
+                                const mongo::BSONObj& pipeline,
+                                int batchSize,
+                                const mongo::BSONObj& options,
+                                mongo::BSONObj *reply,
+                                int *queryOptions)
+{
+    size_t periodIdx = collection.find('.');
+    mongo::BSONObjBuilder cursor;
+    cursor.append("batchSize", batchSize);
+    mongo::BSONObjBuilder cmd;
+    cmd.append("aggregate", collection.substr(periodIdx + 1));
+    cmd.appendArray("pipeline", pipeline);
+    cmd.append("cursor", cursor.obj());
+    cmd.appendElements(options);
+    return runReadCommand(conn, collection.substr(0, periodIdx), cmd.obj(), reply, queryOptions);
+}
 
+ScopedConnection::ScopedConnection(ConnectionHandle *connHandle)
+    : _connHandle(connHandle)
+    , _conn(0)
+    , _generation(0)
+{
+    _conn = _connHandle->checkoutConnection(&_generation);
+}
+
+ScopedConnection::~ScopedConnection()
+{
+    if (_conn) {
+        _connHandle->checkinConnection(_conn, _generation);
+    }
+}
+
+} // close mongoodbc namespace
@@ -17,46 +17,278 @@
 #ifndef MONGOODBC_CONNECTION_HANDLE_H_
 #define MONGOODBC_CONNECTION_HANDLE_H_
 
+#include "array_table.h"
+#include "catalog_cache.h"
+#include "connection_pool.h"
+#include "connection_string.h"
+
 #include <mongo/client/dbclient.h>
 #include <mongo/bson/bsonobj.h>
 
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+
 #include <list>
+#include <map>
 #include <string>
+#include <vector>
 
 namespace mongoodbc {
 
 class EnvironmentHandle;
+class PlanCache;
 
 /*
 * Class implementing an ODBC connection handle.
+*
+* The handle's own connection is used for short commands and catalog
+* queries.  Each statement reading through a cursor checks out a separate
+* connection, kept in a small per handle sub-pool between uses, so several
+* cursors may be open at once and used from different threads.  All methods
+* are thread safe.
 */
-class ConnectionHandle {
+class ConnectionHandle : boost::noncopyable {
+  public:
+    enum {
+        // idle statement connections kept by the handle
+        MAX_IDLE_STATEMENT_CONNECTIONS = 4
+    };
+
+  private:
     // The environment handle from which this connection handle was created
     // held, not owned.
     EnvironmentHandle *_envHandle;
 
-    // The actual connection to the mongoDB database
-    mongo::DBClientConnection _conn;
+    // The actual connection to the mongoDB database, owned.  Null while
+    // disconnected.
+    mongo::DBClientBase *_conn;
+
+    // the parsed connection string
+    ConnectionString _connectString;
+
+    // pool connections are returned to, null when pooling is off
+    ConnectionPool *_pool;
+    // key of this connection's physical connections in '_pool'
+    std::string _poolKey;
+
+    // idle connections for statements, owned
+    std::vector<mongo::DBClientBase *> _statementConns;
+    // incremented on every connect and disconnect, so that connections
+    // checked out before are not mixed into the new sub-pool
+    unsigned int _generation;
+
+    // namespaces resolved by 'arrayTable', with an empty path if not an
+    // array table
+    std::map<std::string, ArrayTable> _arrayTables;
+
+    // guards all of the above
+    mutable boost::mutex _mutex;
+
+    // indexes and sizes of the collections used, guarded by its own lock
+    CatalogCache _catalogCache;
+
+    // Open a new physical connection, or null on failure
+    static mongo::DBClientBase *newConnection(
+        const ConnectionString& connectString);
+
+    // Take a connection from 'pool' if not null or open a new one
+    static mongo::DBClientBase *openConnection(
+        ConnectionPool *pool,
+        const std::string& poolKey,
+        const ConnectionString& connectString);
+
+    // Return 'conn' to '_pool' or close it, called with '_mutex' held
+    void closeConnection(mongo::DBClientBase *conn);
+
+    // Run the read command 'cmd' in 'db' over 'conn', routed by the read
+    // preference, setting 'reply' and the 'queryOptions' it was run with.
+    // Returns 0 on success, -1 otherwise
+    int runReadCommand(mongo::DBClientBase *conn,
+                       const std::string& db,
+                       const mongo::BSONObj& cmd,
+                       mongo::BSONObj *reply,
+                       int *queryOptions);
+
   public:
     ConnectionHandle(EnvironmentHandle *envHandle);
+
+    ~ConnectionHandle();
+
     /*
-    * This method establishes a connection to the underlying mongoDB.
+    * This method establishes a connection to the underlying mongoDB,
+    * reusing an idle pooled connection opened with the same connection
+    * string where possible.  A replica set client is used when the string
+    * names a 'ReplicaSet'.
     * @return 0 on success, non-zero otherwise
     */
-    int connect();
+    int connect(const std::string& connectString = std::string());
+
+    /*
+    * Returns the underlying connection to the pool, or closes it.
+    */
+    void disconnect();
+
+    /*
+    * Returns the value of connection string attribute 'key', which is
+    * matched case insensitively, or an empty string if not present.
+    */
+    std::string attribute(const std::string& key) const;
+
+    int batchSize() const;
+
+    long long batchMemoryLimit() const;
+
+    /*
+    * Returns true if statements should be parsed with 'SQLFastParser'
+    * rather than the Spirit grammar.
+    */
+    bool fastParser() const;
+
+    long long joinMemoryLimit() const;
+
+    long long sortMemoryLimit() const;
+
+    long long aggregateMemoryLimit() const;
+
+    /*
+    * Returns the directory of temporary files, empty for the system's.
+    */
+    std::string tempDirectory() const;
+
+    /*
+    * Returns true if 'SQLRowCount' should count rows exactly rather than
+    * estimate them.
+    */
+    bool exactRowCount() const;
+
+    /*
+    * Returns the plan cache shared with the other connections of the
+    * environment.
+    */
+    PlanCache *planCache();
+
+    /*
+    * Adds the connection's read preference to 'query' and 'queryOptions'
+    * so that reads may be routed to secondaries.
+    */
+    void applyReadPreference(mongo::Query *query, int *queryOptions) const;
+
+    /*
+    * Returns an additional connection to the same server for work that runs
+    * alongside this handle's own connection, e.g. parallel scans.  Pooled
+    * connections are reused when available.
+    * @return the connection, or null on failure
+    */
+    mongo::DBClientBase *acquireConnection();
+
+    /*
+    * Gives back a connection obtained from 'acquireConnection'.
+    */
+    void releaseConnection(mongo::DBClientBase *conn);
+
+    /*
+    * Returns a connection for the exclusive use of one statement, taken
+    * from the handle's sub-pool when possible, and sets 'generation' to
+    * be passed back to 'checkinConnection'.
+    * @return the connection, or null if disconnected or on failure
+    */
+    mongo::DBClientBase *checkoutConnection(unsigned int *generation);
+
+    /*
+    * Returns a connection obtained from 'checkoutConnection' to the
+    * sub-pool.
+    */
+    void checkinConnection(mongo::DBClientBase *conn, unsigned int generation);
+
+    /*
+    * Runs the read command 'cmd' in 'db' on a statement connection, routed
+    * by the read preference, and sets 'info' to the reply.
+    * @return 0 on success, -1 otherwise
+    */
+    int runCommand(const std::string& db,
+                   const mongo::BSONObj& cmd,
+                   mongo::BSONObj *info);
 
     int getDbNames(std::list<std::string> *dbs);
 
     int getCollectionNames(const std::string& db,
                            std::list<std::string> *collections);
 
-    std::auto_ptr<mongo::DBClientCursor> query(const std::string& collection,
+    /*
+    * Sets 'table' to the array table named by 'ns', resolved once per
+    * connection.
+    * @return 0 if 'ns' names an array table, -1 otherwise
+    */
+    int arrayTable(const std::string& ns, ArrayTable *table);
+
+    /*
+    * Sets 'info' to the indexes and size of the collection 'ns', served
+    * from the catalog cache unless 'refresh' is true or the entry expired.
+    * @return 0 on success, -1 otherwise
+    */
+    int collectionInfo(const std::string& ns, bool refresh, CollectionInfo *info);
+
+    /*
+    * Returns the connection's catalog cache.
+    */
+    CatalogCache *catalogCache() { return &_catalogCache; }
+
+    /*
+    * Runs 'query' over 'conn', a connection checked out from this handle,
+    * applying the handle's read preference.
+    */
+    std::auto_ptr<mongo::DBClientCursor> query(mongo::DBClientBase *conn,
+                                               const std::string& collection,
                                                mongo::Query query = mongo::Query(),
                                                int numToReturn = 0,
                                                int numToSkip = 0,
                                                const mongo::BSONObj *fieldsToReturn = 0,
                                                int queryOptions = 0,
                                                int batchSize = 0);
+
+    /*
+    * Counts the documents of 'collection' matching 'filter' over 'conn',
+    * a connection checked out from this handle, applying the handle's read
+    * preference.  Throws std::exception on failure.
+    */
+    unsigned long long count(mongo::DBClientBase *conn,
+                             const std::string& collection,
+                             const mongo::BSONObj& filter);
+
+    /*
+    * Runs the aggregation 'pipeline', an array of stages, over 'collection'
+    * on 'conn', a connection checked out from this handle, applying the
+    * handle's read preference.  The fields of 'options', e.g. 'maxTimeMS',
+    * are added to the command.  'reply' is set to the server's reply, which
+    * holds the cursor.  'queryOptions' is set to the options to open the
+    * cursor with.
+    * @return 0 on success, -1 otherwise
+    */
+    int aggregate(mongo::DBClientBase *conn,
+                  const std::string& collection,
+                  const mongo::BSONObj& pipeline,
+                  int batchSize,
+                  const mongo::BSONObj& options,
+                  mongo::BSONObj *reply,
+                  int *queryOptions);
+};
+
+/*
+* A connection checked out of a 'ConnectionHandle' for the lifetime of this
+* object.  Cursors opened over it must be destroyed first.
+*/
+class ScopedConnection : boost::noncopyable {
+    ConnectionHandle *_connHandle;
+    mongo::DBClientBase *_conn;
+    unsigned int _generation;
+
+  public:
+    ScopedConnection(ConnectionHandle *connHandle);
+
+    ~ScopedConnection();
+
+    // null if no connection could be checked out
+    mongo::DBClientBase *get() const { return _conn; }
 };
 
 } // close mongoodbc namespace
@@ -0,0 +1,179 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "connection_pool.h"
+
+#include <vector>
+
+namespace {
+
+mongoodbc::ConnectionPool s_driverPool;
+
+boost::posix_time::ptime now()
+{
+    return boost::posix_time::microsec_clock::universal_time();
+}
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+ConnectionPool::ConnectionPool()
+{
+}
+
+ConnectionPool::~ConnectionPool()
+{
+    clear();
+}
+
+bool ConnectionPool::isHealthy(mongo::DBClientBase *conn,
+                               const boost::posix_time::time_duration& idleFor)
+{
+    if (conn->isFailed()) {
+        return false;
+    }
+    if (idleFor < boost::posix_time::seconds((long)PING_AFTER_SECONDS)) {
+        return true;
+    }
+
+    try {
+        mongo::BSONObjBuilder ping;
+        ping.append("ping", 1);
+        mongo::BSONObj info;
+        return conn->runCommand("admin", ping.obj(), info);
+    } catch (const mongo::DBException& ex) {
+        return false;
+    }
+}
+
+mongo::DBClientBase *ConnectionPool::checkout(const std::string& key)
+{
+    std::vector<mongo::DBClientBase *> stale;
+    mongo::DBClientBase *conn = 0;
+    boost::posix_time::time_duration idleFor;
+    {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        Idle::iterator it = _idle.find(key);
+        if (_idle.end() == it) {
+            return 0;
+        }
+        boost::posix_time::ptime checkoutTime = now();
+        Entries& entries = it->second;
+        while (!entries.empty() && !conn) {
+            Entry entry = entries.front();
+            entries.pop_front();
+            idleFor = checkoutTime - entry._idleSince;
+            if (idleFor > boost::posix_time::seconds((long)MAX_IDLE_SECONDS)) {
+                stale.push_back(entry._conn);
+            } else {
+                conn = entry._conn;
+            }
+        }
+        // everything behind a stale entry has been idle even longer
+        for (Entries::iterator entryIt = entries.begin();
+             conn && entryIt != entries.end();) {
+            if (checkoutTime - entryIt->_idleSince >
+                boost::posix_time::seconds((long)MAX_IDLE_SECONDS)) {
+                stale.push_back(entryIt->_conn);
+                entryIt = entries.erase(entryIt);
+            } else {
+                ++entryIt;
+            }
+        }
+        if (entries.empty()) {
+            _idle.erase(it);
+        }
+    }
+
+    // close and check connections without holding the lock
+    for (size_t i = 0; i < stale.size(); ++i) {
+        delete stale[i];
+    }
+    if (conn && !isHealthy(conn, idleFor)) {
+        delete conn;
+        // try the next idle connection
+        return checkout(key);
+    }
+
+    return conn;
+}
+
+void ConnectionPool::checkin(const std::string& key,
+                             mongo::DBClientBase *conn,
+                             size_t maxSize)
+{
+    if (!conn) {
+        return;
+    }
+
+    bool reusable = !conn->isFailed() && maxSize > 0;
+    if (reusable) {
+        try {
+            // clear the last error so the next user starts with a clean session
+            mongo::BSONObjBuilder resetError;
+            resetError.append("resetError", 1);
+            mongo::BSONObj info;
+            reusable = conn->runCommand("admin", resetError.obj(), info);
+        } catch (const mongo::DBException& ex) {
+            reusable = false;
+        }
+    }
+
+    if (reusable) {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        Entries& entries = _idle[key];
+        if (entries.size() < maxSize) {
+            Entry entry;
+            entry._conn = conn;
+            entry._idleSince = now();
+            entries.push_front(entry);
+            return;
+        }
+    }
+
+    delete conn;
+}
+
+void ConnectionPool::clear()
+{
+    Idle idle;
+    {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        idle.swap(_idle);
+    }
+    for (Idle::iterator it = idle.begin(); it != idle.end(); ++it) {
+        for (Entries::iterator entryIt = it->second.begin();
+             entryIt != it->second.end();
+             ++entryIt) {
+            delete entryIt->_conn;
+        }
+    }
+}
+
+size_t ConnectionPool::numIdle(const std::string& key)
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    Idle::const_iterator it = _idle.find(key);
+    return _idle.end() == it ? 0 : it->second.size();
+}
+
+ConnectionPool *ConnectionPool::driverPool()
+{
+    return &s_driverPool;
+}
+
+} // close mongoodbc namespace
@@ -0,0 +1,104 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_CONNECTION_POOL_H_
+#define MONGOODBC_CONNECTION_POOL_H_
+
+#include <mongo/client/dbclient.h>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <list>
+#include <map>
+#include <string>
+
+namespace mongoodbc {
+
+/*
+* Class implementing a pool of idle mongoDB connections, keyed by the
+* normalized connection string they were opened with.
+*/
+class ConnectionPool : boost::noncopyable {
+  public:
+    enum {
+        // idle connections kept per key unless the connection asks otherwise
+        DEFAULT_MAX_SIZE = 10,
+        // connections idle for longer than this are pinged before reuse
+        PING_AFTER_SECONDS = 5,
+        // connections idle for longer than this are closed
+        MAX_IDLE_SECONDS = 300
+    };
+
+  private:
+    struct Entry {
+        mongo::DBClientBase *_conn;
+        boost::posix_time::ptime _idleSince;
+    };
+    typedef std::list<Entry> Entries;
+    typedef std::map<std::string, Entries> Idle;
+
+    boost::mutex _mutex;
+    // most recently returned connections are at the front of each list
+    Idle _idle;
+
+    // Returns false if 'conn' should not be handed out again
+    static bool isHealthy(mongo::DBClientBase *conn,
+                          const boost::posix_time::time_duration& idleFor);
+
+  public:
+    ConnectionPool();
+
+    // Closes all idle connections
+    ~ConnectionPool();
+
+    /*
+    * Returns an idle connection opened with 'key' that passed a health
+    * check, or null if there is none.  The caller takes ownership.
+    */
+    mongo::DBClientBase *checkout(const std::string& key);
+
+    /*
+    * Returns 'conn', opened with 'key', to the pool.  Its session state is
+    * reset first.  The connection is closed instead if it failed or if
+    * 'maxSize' connections for 'key' are already idle.
+    */
+    void checkin(const std::string& key,
+                 mongo::DBClientBase *conn,
+                 size_t maxSize = DEFAULT_MAX_SIZE);
+
+    /*
+    * Closes all idle connections.
+    */
+    void clear();
+
+    /*
+    * Returns the number of idle connections for 'key'.
+    */
+    size_t numIdle(const std::string& key);
+
+    /*
+    * Returns the pool shared by all environments, used for
+    * SQL_CP_ONE_PER_DRIVER.
+    */
+    static ConnectionPool *driverPool();
+};
+
+} // close mongoodbc namespace
+
+#endif
@@ -0,0 +1,308 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "connection_string.h"
+
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <sstream>
+
+namespace {
+
+// Attributes that are consumed by the driver itself and have no effect on
+// the physical connection
+const char *SESSION_ATTRIBUTES[] = {
+    "BATCHSIZE",
+    "BATCHMEMORYLIMIT",
+    "POOLING",
+    "MAXPOOLSIZE",
+    "READPREFERENCE",
+    "PARSER",
+    "JOINMEMORYLIMIT",
+    "SORTMEMORYLIMIT",
+    "AGGREGATEMEMORYLIMIT",
+    "TEMPDIRECTORY",
+    "ROWCOUNT",
+    0
+};
+
+bool isSessionAttribute(const std::string& key)
+{
+    for (const char **attr = SESSION_ATTRIBUTES; *attr; ++attr) {
+        if (key == *attr) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename T>
+bool parseNumber(const std::string& str, T *value)
+{
+    // unsigned conversions would wrap negative numbers around
+    if (str.empty() || '-' == str[0]) {
+        return false;
+    }
+    try {
+        *value = boost::lexical_cast<T>(str);
+    } catch (const boost::bad_lexical_cast&) {
+        return false;
+    }
+    return true;
+}
+
+/*
+* Splits 'str' into trimmed key/value pairs at the ';' that are not within
+* a value in braces.  The braces are removed and '}}' within them stands
+* for '}'.  Segments without '=' are skipped.
+*/
+void splitPairs(const std::string& str,
+                std::vector<std::pair<std::string, std::string> > *pairs)
+{
+    size_t pos = 0;
+    while (pos < str.size()) {
+        size_t eqIdx = str.find_first_of("=;", pos);
+        if (std::string::npos == eqIdx || ';' == str[eqIdx]) {
+            pos = std::string::npos == eqIdx ? str.size() : eqIdx + 1;
+            continue;
+        }
+        std::string key = boost::trim_copy(str.substr(pos, eqIdx - pos));
+        std::string value;
+        size_t valueIdx = str.find_first_not_of(" \t", eqIdx + 1);
+        if (std::string::npos != valueIdx && '{' == str[valueIdx]) {
+            size_t i = valueIdx + 1;
+            for (; i < str.size(); ++i) {
+                if ('}' == str[i]) {
+                    if (i + 1 < str.size() && '}' == str[i + 1]) {
+                        ++i;
+                    } else {
+                        break;
+                    }
+                }
+                value += str[i];
+            }
+            // anything between the closing brace and ';' is ignored
+            pos = str.find(';', i);
+        } else {
+            pos = str.find(';', eqIdx + 1);
+            value = boost::trim_copy(str.substr(eqIdx + 1,
+                                                std::string::npos == pos ? pos
+                                                                         : pos - eqIdx - 1));
+        }
+        pairs->push_back(std::make_pair(key, value));
+        pos = std::string::npos == pos ? str.size() : pos + 1;
+    }
+}
+
+bool parseReadPreference(const std::string& str, mongo::ReadPreference *pref)
+{
+    std::string lower = boost::to_lower_copy(str);
+    if ("primary" == lower) {
+        *pref = mongo::ReadPreference_PrimaryOnly;
+    } else if ("primarypreferred" == lower) {
+        *pref = mongo::ReadPreference_PrimaryPreferred;
+    } else if ("secondary" == lower) {
+        *pref = mongo::ReadPreference_SecondaryOnly;
+    } else if ("secondarypreferred" == lower) {
+        *pref = mongo::ReadPreference_SecondaryPreferred;
+    } else if ("nearest" == lower) {
+        *pref = mongo::ReadPreference_Nearest;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+std::string ConnectionString::Host::toString() const
+{
+    std::stringstream str;
+    str << _name << ':' << _port;
+    return str.str();
+}
+
+ConnectionString::ConnectionString()
+    : _readPreference(mongo::ReadPreference_PrimaryOnly)
+    , _connectTimeout(0)
+    , _socketTimeout(0)
+    , _batchSize(0)
+    , _batchMemoryLimit(0)
+    , _pooling(true)
+    , _maxPoolSize(DEFAULT_MAX_POOL_SIZE)
+    , _fastParser(false)
+    , _joinMemoryLimit(0)
+    , _sortMemoryLimit(0)
+    , _aggregateMemoryLimit(0)
+    , _exactRowCount(false)
+{
+}
+
+int ConnectionString::parse(const std::string& str, std::string *errmsg)
+{
+    *this = ConnectionString();
+
+    // ODBC allows braces around values containing separators
+    std::vector<std::pair<std::string, std::string> > pairs;
+    splitPairs(str, &pairs);
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        _attributes[boost::to_upper_copy(pairs[i].first)] = pairs[i].second;
+    }
+
+    std::vector<std::string> hosts;
+    std::string server = attribute("Server");
+    if (server.empty()) {
+        server = "localhost";
+    }
+    boost::split(hosts, server, boost::is_any_of(","));
+    for (std::vector<std::string>::const_iterator it = hosts.begin();
+         it != hosts.end();
+         ++it) {
+        std::string hostStr = boost::trim_copy(*it);
+        if (hostStr.empty()) {
+            continue;
+        }
+        Host host;
+        host._port = DEFAULT_PORT;
+        size_t colonIdx = hostStr.rfind(':');
+        if (std::string::npos != colonIdx) {
+            if (!parseNumber(hostStr.substr(colonIdx + 1), &host._port) ||
+                0 == host._port) {
+                *errmsg = "invalid port in '" + hostStr + "'";
+                return -1;
+            }
+            hostStr.erase(colonIdx);
+        }
+        host._name = boost::to_lower_copy(hostStr);
+        _hosts.push_back(host);
+    }
+    if (_hosts.empty()) {
+        *errmsg = "no server given";
+        return -1;
+    }
+
+    _replicaSet = attribute("ReplicaSet");
+
+    std::string value = attribute("ReadPreference");
+    if (!value.empty() && !parseReadPreference(value, &_readPreference)) {
+        *errmsg = "invalid ReadPreference '" + value + "'";
+        return -1;
+    }
+
+    int timeoutMS = 0;
+    value = attribute("ConnectTimeoutMS");
+    if (!value.empty()) {
+        if (!parseNumber(value, &timeoutMS)) {
+            *errmsg = "invalid ConnectTimeoutMS '" + value + "'";
+            return -1;
+        }
+        _connectTimeout = timeoutMS / 1000.0;
+    }
+    value = attribute("SocketTimeoutMS");
+    if (!value.empty()) {
+        if (!parseNumber(value, &timeoutMS)) {
+            *errmsg = "invalid SocketTimeoutMS '" + value + "'";
+            return -1;
+        }
+        _socketTimeout = timeoutMS / 1000.0;
+    }
+
+    value = attribute("BatchSize");
+    if (!value.empty() && !parseNumber(value, &_batchSize)) {
+        *errmsg = "invalid BatchSize '" + value + "'";
+        return -1;
+    }
+    value = attribute("BatchMemoryLimit");
+    if (!value.empty() && !parseNumber(value, &_batchMemoryLimit)) {
+        *errmsg = "invalid BatchMemoryLimit '" + value + "'";
+        return -1;
+    }
+
+    value = boost::to_lower_copy(attribute("Pooling"));
+    _pooling = !("0" == value || "false" == value || "no" == value || "off" == value);
+    value = attribute("MaxPoolSize");
+    if (!value.empty() && !parseNumber(value, &_maxPoolSize)) {
+        *errmsg = "invalid MaxPoolSize '" + value + "'";
+        return -1;
+    }
+
+    value = boost::to_lower_copy(attribute("Parser"));
+    if (!value.empty() && "spirit" != value && "fast" != value) {
+        *errmsg = "invalid Parser '" + attribute("Parser") + "'";
+        return -1;
+    }
+    _fastParser = "fast" == value;
+
+    value = attribute("JoinMemoryLimit");
+    if (!value.empty() && !parseNumber(value, &_joinMemoryLimit)) {
+        *errmsg = "invalid JoinMemoryLimit '" + value + "'";
+        return -1;
+    }
+    value = attribute("SortMemoryLimit");
+    if (!value.empty() && !parseNumber(value, &_sortMemoryLimit)) {
+        *errmsg = "invalid SortMemoryLimit '" + value + "'";
+        return -1;
+    }
+    value = attribute("AggregateMemoryLimit");
+    if (!value.empty() && !parseNumber(value, &_aggregateMemoryLimit)) {
+        *errmsg = "invalid AggregateMemoryLimit '" + value + "'";
+        return -1;
+    }
+    _tempDirectory = attribute("TempDirectory");
+
+    value = boost::to_lower_copy(attribute("RowCount"));
+    if (!value.empty() && "estimate" != value && "exact" != value) {
+        *errmsg = "invalid RowCount '" + attribute("RowCount") + "'";
+        return -1;
+    }
+    _exactRowCount = "exact" == value;
+
+    return 0;
+}
+
+std::string ConnectionString::attribute(const std::string& key) const
+{
+    std::map<std::string, std::string>::const_iterator it =
+        _attributes.find(boost::to_upper_copy(key));
+    if (_attributes.end() == it) {
+        return std::string();
+    }
+    return it->second;
+}
+
+std::string ConnectionString::normalized() const
+{
+    std::stringstream str;
+    str << "SERVER=";
+    for (size_t i = 0; i < _hosts.size(); ++i) {
+        str << (i ? "," : "") << _hosts[i].toString();
+    }
+    str << ';';
+    for (std::map<std::string, std::string>::const_iterator it = _attributes.begin();
+         it != _attributes.end();
+         ++it) {
+        if ("SERVER" == it->first || isSessionAttribute(it->first)) {
+            continue;
+        }
+        str << it->first << '=' << it->second << ';';
+    }
+    return str.str();
+}
+
+} // close mongoodbc namespace
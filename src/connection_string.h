@@ -0,0 +1,127 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_CONNECTION_STRING_H_
+#define MONGOODBC_CONNECTION_STRING_H_
+
+#include <mongo/client/dbclient.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace mongoodbc {
+
+/*
+* In memory representation of an ODBC connection string.
+*
+* The string is a list of 'key=value' pairs separated by ';', keys are case
+* insensitive.  Recognized keys are:
+*   Server           - comma separated 'host[:port]' list, default localhost
+*   ReplicaSet       - replica set name, connects with a replica set client
+*   ReadPreference   - primary, primaryPreferred, secondary,
+*                      secondaryPreferred or nearest
+*   ConnectTimeoutMS - timeout establishing a connection
+*   SocketTimeoutMS  - timeout on every socket operation
+*   BatchSize        - fixed cursor batch size, 0 for adaptive
+*   BatchMemoryLimit - memory budget of an adaptive cursor batch in bytes
+*   Pooling          - 'false' to bypass the connection pool
+*   MaxPoolSize      - idle connections kept in the pool
+*   Parser           - 'spirit' (default) or 'fast', see 'SQLFastParser'
+*   JoinMemoryLimit  - memory budget of a join's hash table in bytes
+*   SortMemoryLimit  - memory budget of a statement's sort in bytes
+*   AggregateMemoryLimit - memory budget of a statement's GROUP BY in bytes
+*   TempDirectory    - directory of the temporary files of joins, sorts and
+*                      aggregations
+*   RowCount         - 'estimate' (default) or 'exact', see 'RowCount'
+* All other keys, e.g. DSN, are kept and may be read through 'attribute'.
+*/
+class ConnectionString {
+  public:
+    enum {
+        DEFAULT_PORT = 27017,
+        DEFAULT_MAX_POOL_SIZE = 10
+    };
+
+    struct Host {
+        std::string _name;
+        int _port;
+
+        std::string toString() const;
+    };
+
+  private:
+    // key/value pairs, keys upper cased
+    std::map<std::string, std::string> _attributes;
+
+    std::vector<Host> _hosts;
+    std::string _replicaSet;
+    mongo::ReadPreference _readPreference;
+    // in seconds, 0 for none
+    double _connectTimeout;
+    double _socketTimeout;
+    int _batchSize;
+    long long _batchMemoryLimit;
+    bool _pooling;
+    size_t _maxPoolSize;
+    bool _fastParser;
+    long long _joinMemoryLimit;
+    long long _sortMemoryLimit;
+    long long _aggregateMemoryLimit;
+    std::string _tempDirectory;
+    bool _exactRowCount;
+
+  public:
+    ConnectionString();
+
+    /*
+    * Parses 'str', replacing any previous contents.
+    * @return 0 on success, non-zero with a description in 'errmsg' otherwise
+    */
+    int parse(const std::string& str, std::string *errmsg);
+
+    /*
+    * Returns the value of attribute 'key', matched case insensitively, or
+    * an empty string if not present.
+    */
+    std::string attribute(const std::string& key) const;
+
+    /*
+    * Returns a canonical form of the attributes that determine the physical
+    * connection, equal for any two strings connecting the same way.
+    */
+    std::string normalized() const;
+
+    const std::vector<Host>& hosts() const { return _hosts; }
+    const std::string& replicaSet() const { return _replicaSet; }
+    mongo::ReadPreference readPreference() const { return _readPreference; }
+    double connectTimeout() const { return _connectTimeout; }
+    double socketTimeout() const { return _socketTimeout; }
+    int batchSize() const { return _batchSize; }
+    long long batchMemoryLimit() const { return _batchMemoryLimit; }
+    bool pooling() const { return _pooling; }
+    size_t maxPoolSize() const { return _maxPoolSize; }
+    bool fastParser() const { return _fastParser; }
+    long long joinMemoryLimit() const { return _joinMemoryLimit; }
+    long long sortMemoryLimit() const { return _sortMemoryLimit; }
+    long long aggregateMemoryLimit() const { return _aggregateMemoryLimit; }
+    const std::string& tempDirectory() const { return _tempDirectory; }
+    bool exactRowCount() const { return _exactRowCount; }
+};
+
+} // close mongoodbc namespace
+
+#endif
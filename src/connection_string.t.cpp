@@ -0,0 +1,128 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "connection_string.h"
+
+#include <gtest/gtest.h>
+
+using mongoodbc::ConnectionString;
+
+TEST(ConnectionString, Defaults)
+{
+    ConnectionString cs;
+    std::string errmsg;
+    ASSERT_EQ(0, cs.parse("DSN=mongo", &errmsg));
+    ASSERT_EQ(1u, cs.hosts().size());
+    EXPECT_EQ("localhost", cs.hosts()[0]._name);
+    EXPECT_EQ(ConnectionString::DEFAULT_PORT, cs.hosts()[0]._port);
+    EXPECT_TRUE(cs.replicaSet().empty());
+    EXPECT_EQ(mongo::ReadPreference_PrimaryOnly, cs.readPreference());
+    EXPECT_EQ(0, cs.batchSize());
+    EXPECT_TRUE(cs.pooling());
+    EXPECT_FALSE(cs.fastParser());
+    EXPECT_FALSE(cs.exactRowCount());
+    EXPECT_EQ("mongo", cs.attribute("dsn"));
+}
+
+TEST(ConnectionString, HostList)
+{
+    ConnectionString cs;
+    std::string errmsg;
+    ASSERT_EQ(0, cs.parse("Server=DB1:27018, db2 ,db3:1;ReplicaSet=rs0", &errmsg));
+    ASSERT_EQ(3u, cs.hosts().size());
+    EXPECT_EQ("db1", cs.hosts()[0]._name);
+    EXPECT_EQ(27018, cs.hosts()[0]._port);
+    EXPECT_EQ("db2", cs.hosts()[1]._name);
+    EXPECT_EQ(ConnectionString::DEFAULT_PORT, cs.hosts()[1]._port);
+    EXPECT_EQ(1, cs.hosts()[2]._port);
+    EXPECT_EQ("rs0", cs.replicaSet());
+}
+
+TEST(ConnectionString, Options)
+{
+    ConnectionString cs;
+    std::string errmsg;
+    ASSERT_EQ(0, cs.parse("readpreference=SecondaryPreferred;BatchSize=50;"
+                          "SocketTimeoutMS=1500;ConnectTimeoutMS=200;"
+                          "Pooling=off;MaxPoolSize=3;Parser=Fast;"
+                          "JoinMemoryLimit=4096;SortMemoryLimit=8192;AggregateMemoryLimit=16384;"
+                          "TempDirectory=/var/tmp;RowCount=Exact",
+                          &errmsg));
+    EXPECT_EQ(mongo::ReadPreference_SecondaryPreferred, cs.readPreference());
+    EXPECT_EQ(50, cs.batchSize());
+    EXPECT_DOUBLE_EQ(1.5, cs.socketTimeout());
+    EXPECT_DOUBLE_EQ(0.2, cs.connectTimeout());
+    EXPECT_FALSE(cs.pooling());
+    EXPECT_EQ(3u, cs.maxPoolSize());
+    EXPECT_TRUE(cs.fastParser());
+    EXPECT_EQ(4096, cs.joinMemoryLimit());
+    EXPECT_EQ(8192, cs.sortMemoryLimit());
+    EXPECT_EQ(16384, cs.aggregateMemoryLimit());
+    EXPECT_EQ("/var/tmp", cs.tempDirectory());
+    EXPECT_TRUE(cs.exactRowCount());
+}
+
+TEST(ConnectionString, BracedValue)
+{
+    ConnectionString cs;
+    std::string errmsg;
+    ASSERT_EQ(0, cs.parse("Server={a,b:2}", &errmsg));
+    EXPECT_EQ(2u, cs.hosts().size());
+
+    // separators and doubled closing braces within braces are the value's
+    ASSERT_EQ(0, cs.parse("UID=u; PWD= {a;b=}}c} ;Server=db1", &errmsg));
+    EXPECT_EQ("a;b=}c", cs.attribute("pwd"));
+    EXPECT_EQ("u", cs.attribute("uid"));
+    ASSERT_EQ(1u, cs.hosts().size());
+    EXPECT_EQ("db1", cs.hosts()[0]._name);
+}
+
+TEST(ConnectionString, Invalid)
+{
+    ConnectionString cs;
+    std::string errmsg;
+    EXPECT_NE(0, cs.parse("Server=db1:abc", &errmsg));
+    EXPECT_NE(0, cs.parse("ReadPreference=fastest", &errmsg));
+    EXPECT_NE(0, cs.parse("BatchSize=-1", &errmsg));
+    EXPECT_NE(0, cs.parse("MaxPoolSize=-1", &errmsg));
+    EXPECT_NE(0, cs.parse("Server=,", &errmsg));
+    EXPECT_NE(0, cs.parse("Parser=yacc", &errmsg));
+    EXPECT_NE(0, cs.parse("JoinMemoryLimit=lots", &errmsg));
+    EXPECT_NE(0, cs.parse("SortMemoryLimit=-1", &errmsg));
+    EXPECT_NE(0, cs.parse("AggregateMemoryLimit=x", &errmsg));
+    EXPECT_NE(0, cs.parse("RowCount=guess", &errmsg));
+}
+
+TEST(ConnectionString, Normalized)
+{
+    ConnectionString a;
+    ConnectionString b;
+    std::string errmsg;
+    ASSERT_EQ(0, a.parse("server=DB1;dsn=x;BatchSize=10", &errmsg));
+    ASSERT_EQ(0, b.parse("DSN=x ; Server=db1:27017;ReadPreference=nearest", &errmsg));
+    EXPECT_EQ(a.normalized(), b.normalized());
+    ASSERT_EQ(0, b.parse("DSN=x;Server=db1;RowCount=estimate", &errmsg)) << errmsg;
+    EXPECT_EQ(a.normalized(), b.normalized());
+
+    ASSERT_EQ(0, b.parse("DSN=x;Server=db1;ReplicaSet=rs0", &errmsg));
+    EXPECT_NE(a.normalized(), b.normalized());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
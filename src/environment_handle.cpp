@@ -15,4 +15,109 @@
 //  limitations under the License.
 
 #include <environment_handle.h>
+#include <odbcintf.h>
+
+namespace {
+
+// as ODBC specifies, connections are not pooled unless asked for
+SQLUINTEGER s_defaultConnectionPooling = SQL_CP_OFF;
+
+bool validConnectionPooling(SQLUINTEGER value)
+{
+    return SQL_CP_OFF == value
+        || SQL_CP_ONE_PER_DRIVER == value
+        || SQL_CP_ONE_PER_HENV == value;
+}
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+EnvironmentHandle::EnvironmentHandle()
+    : _connectionPooling(s_defaultConnectionPooling)
+{
+}
+
+SQLRETURN EnvironmentHandle::sqlSetEnvAttr(SQLINTEGER attribute,
+                                           SQLPOINTER valuePtr,
+                                           SQLINTEGER stringLen)
+{
+    switch(attribute) {
+      case SQL_ATTR_ODBC_VERSION: {
+      } break;
+      case SQL_ATTR_CONNECTION_POOLING: {
+        SQLUINTEGER value = (SQLUINTEGER)(SQLULEN)valuePtr;
+        if (!validConnectionPooling(value)) {
+            return SQL_ERROR;
+        }
+        if (SQL_CP_ONE_PER_HENV != value) {
+            _pool.clear();
+        }
+        _connectionPooling = value;
+      } break;
+      case SQL_ATTR_CP_MATCH: {
+        // connections only ever match on the full normalized string
+      } break;
+      case SQL_ATTR_MONGOODBC_PLAN_CACHE_SIZE: {
+        _planCache.setMaxBytes((SQLULEN)valuePtr);
+      } break;
+      default: {
+      } break;
+    }
+
+    return SQL_SUCCESS;
+}
+
+SQLRETURN EnvironmentHandle::sqlGetEnvAttr(SQLINTEGER attribute,
+                                           SQLPOINTER valuePtr,
+                                           SQLINTEGER bufferLength,
+                                           SQLINTEGER *stringLenPtr)
+{
+    switch(attribute) {
+      case SQL_ATTR_ODBC_VERSION: {
+        *(SQLINTEGER *)valuePtr = SQL_OV_ODBC3;
+      } break;
+      case SQL_ATTR_CONNECTION_POOLING: {
+        *(SQLUINTEGER *)valuePtr = _connectionPooling;
+      } break;
+      case SQL_ATTR_MONGOODBC_PLAN_CACHE_SIZE: {
+        *(SQLULEN *)valuePtr = _planCache.maxBytes();
+      } break;
+      case SQL_ATTR_MONGOODBC_PLAN_CACHE_HITS: {
+        *(SQLULEN *)valuePtr = _planCache.hits();
+      } break;
+      case SQL_ATTR_MONGOODBC_PLAN_CACHE_MISSES: {
+        *(SQLULEN *)valuePtr = _planCache.misses();
+      } break;
+      default: {
+      } break;
+    }
+
+    return SQL_SUCCESS;
+}
+
+ConnectionPool *EnvironmentHandle::connectionPool()
+{
+    switch(_connectionPooling) {
+      case SQL_CP_ONE_PER_HENV: {
+        return &_pool;
+      } break;
+      case SQL_CP_ONE_PER_DRIVER: {
+        return ConnectionPool::driverPool();
+      } break;
+    }
+
+    return 0;
+}
+
+int EnvironmentHandle::setDefaultConnectionPooling(SQLUINTEGER value)
+{
+    if (!validConnectionPooling(value)) {
+        return -1;
+    }
+    s_defaultConnectionPooling = value;
+    return 0;
+}
+
+} // close mongoodbc namespace
 
@@ -17,12 +17,54 @@
 #ifndef MONGOODBC_ENVIRONMENT_HANDLE_H_
 #define MONGOODBC_ENVIRONMENT_HANDLE_H_
 
+#include "connection_pool.h"
+#include "plan_cache.h"
+
+#include <sql.h>
+#include <sqlext.h>
+
 namespace mongoodbc {
 
 /*
 * Class implementing an ODBC environment handle.
 */
 class EnvironmentHandle {
+    // SQL_ATTR_CONNECTION_POOLING for connections made in this environment
+    SQLUINTEGER _connectionPooling;
+
+    // idle connections for SQL_CP_ONE_PER_HENV
+    ConnectionPool _pool;
+
+    // plans of statements executed by connections of this environment
+    PlanCache _planCache;
+
+  public:
+    EnvironmentHandle();
+
+    SQLRETURN sqlSetEnvAttr(SQLINTEGER attribute,
+                            SQLPOINTER valuePtr,
+                            SQLINTEGER stringLen);
+
+    SQLRETURN sqlGetEnvAttr(SQLINTEGER attribute,
+                            SQLPOINTER valuePtr,
+                            SQLINTEGER bufferLength,
+                            SQLINTEGER *stringLenPtr);
+
+    /*
+    * Returns the pool connections of this environment should be taken from
+    * and returned to, or null if pooling is off.
+    */
+    ConnectionPool *connectionPool();
+
+    PlanCache *planCache() { return &_planCache; }
+
+    /*
+    * Sets the SQL_ATTR_CONNECTION_POOLING value environments start with,
+    * as set by SQLSetEnvAttr on a null environment handle.  The default is
+    * SQL_CP_OFF.
+    * @return 0 on success, -1 if 'value' is not a pooling mode
+    */
+    static int setDefaultConnectionPooling(SQLUINTEGER value);
 };
 
 } // close mongoodbc namespace
@@ -0,0 +1,378 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "expression_evaluator.h"
+
+#include <sstream>
+
+namespace {
+
+using mongoodbc::ExpressionValue;
+
+const char THIS[] = "this.";
+const size_t THIS_LEN = sizeof(THIS) - 1;
+
+std::string stripThis(const std::string& name)
+{
+    return 0 == name.compare(0, THIS_LEN, THIS) ? name.substr(THIS_LEN) : name;
+}
+
+ExpressionValue elementValue(const mongo::BSONElement& elem)
+{
+    ExpressionValue value;
+    if (elem.isNumber()) {
+        value._type = ExpressionValue::NUMBER;
+        value._num = elem.number();
+    } else if (mongo::String == elem.type()) {
+        value._type = ExpressionValue::STRING;
+        value._str.assign(elem.valuestr(), elem.valuestrsize() - 1);
+    } else if (!elem.eoo() && !elem.isNull() && mongo::Undefined != elem.type()) {
+        value._type = ExpressionValue::OTHER;
+    }
+    if (ExpressionValue::NONE != value._type) {
+        value._elem = elem;
+    }
+    return value;
+}
+
+/*
+* Returns the result of 'lhs op rhs', with no value unless both are numbers
+* and the result is defined.
+*/
+ExpressionValue arithmetic(const ExpressionValue& lhs, char op, const ExpressionValue& rhs)
+{
+    ExpressionValue result;
+    if (ExpressionValue::NUMBER != lhs._type || ExpressionValue::NUMBER != rhs._type) {
+        return result;
+    }
+    result._type = ExpressionValue::NUMBER;
+    switch(op) {
+      case '+': {
+        result._num = lhs._num + rhs._num;
+      } break;
+      case '-': {
+        result._num = lhs._num - rhs._num;
+      } break;
+      case '*': {
+        result._num = lhs._num * rhs._num;
+      } break;
+      case '/': {
+        if (0 == rhs._num) {
+            result._type = ExpressionValue::NONE;
+        } else {
+            result._num = lhs._num / rhs._num;
+        }
+      } break;
+      default: {
+        result._type = ExpressionValue::NONE;
+      } break;
+    }
+    return result;
+}
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+void ExpressionValue::append(const std::string& name, mongo::BSONObjBuilder *builder) const
+{
+    if (!_elem.eoo()) {
+        builder->appendAs(_elem, name);
+        return;
+    }
+    switch(_type) {
+      case NUMBER: {
+        builder->append(name, _num);
+      } break;
+      case STRING: {
+        builder->append(name, _str);
+      } break;
+      default: {
+        builder->appendNull(name);
+      } break;
+    }
+}
+
+ExpressionProgram::ExpressionProgram()
+    : _result(0)
+{
+}
+
+ExpressionProgram::ExpressionProgram(const SQLElementExpression& expr,
+                                     const std::string& defaultQualifier)
+    : _result(0)
+    , _defaultQualifier(defaultQualifier)
+{
+    Operand result = expression(expr);
+    if (result._isConst) {
+        _code.clear();
+        _fields.clear();
+        _paths = FieldPaths();
+        _constant = result._value;
+    }
+    _result = result._reg;
+    _registers.resize(_code.size());
+}
+
+size_t ExpressionProgram::emit(Opcode op, size_t lhs, size_t rhs, double num, size_t field)
+{
+    Instruction instruction;
+    instruction._op = op;
+    instruction._lhs = lhs;
+    instruction._rhs = rhs;
+    instruction._num = num;
+    instruction._field = field;
+    _code.push_back(instruction);
+    return _code.size() - 1;
+}
+
+ExpressionProgram::Operand ExpressionProgram::combine(const Operand& lhs,
+                                                      char op,
+                                                      const Operand& rhs)
+{
+    Operand result;
+    result._isConst = true;
+    result._reg = 0;
+    if (lhs._isConst && rhs._isConst) {
+        result._value = arithmetic(lhs._value, op, rhs._value);
+        return result;
+    }
+    if ((lhs._isConst && ExpressionValue::NUMBER != lhs._value._type)
+        || (rhs._isConst && ExpressionValue::NUMBER != rhs._value._type)
+        || ('/' == op && rhs._isConst && 0 == rhs._value._num)) {
+        // never has a value, whatever the row
+        return result;
+    }
+    result._isConst = false;
+    if (rhs._isConst) {
+        Opcode code = '+' == op ? ADD_CONST
+                    : '-' == op ? SUB_CONST
+                    : '*' == op ? MUL_CONST
+                    : DIV_CONST;
+        result._reg = emit(code, lhs._reg, 0, rhs._value._num, 0);
+    } else if (lhs._isConst) {
+        // addition and multiplication commute
+        Opcode code = '+' == op ? ADD_CONST
+                    : '-' == op ? CONST_SUB
+                    : '*' == op ? MUL_CONST
+                    : CONST_DIV;
+        result._reg = emit(code, rhs._reg, 0, lhs._value._num, 0);
+    } else {
+        Opcode code = '+' == op ? ADD
+                    : '-' == op ? SUB
+                    : '*' == op ? MUL
+                    : DIV;
+        result._reg = emit(code, lhs._reg, rhs._reg, 0, 0);
+    }
+    return result;
+}
+
+ExpressionProgram::Operand ExpressionProgram::loadField(const std::string& qualified,
+                                                        const std::string& name)
+{
+    Field field;
+    field._hasQualified = !qualified.empty();
+    field._qualified = field._hasQualified ? _paths.add(qualified) : 0;
+    field._name = _paths.add(name);
+    _fields.push_back(field);
+    Operand result;
+    result._isConst = false;
+    result._reg = emit(LOAD_FIELD, 0, 0, 0, _fields.size() - 1);
+    return result;
+}
+
+ExpressionProgram::Operand ExpressionProgram::primary(const SQLElementExpression_Primary& primary)
+{
+    if (primary._function) {
+        SQLElementExpression call;
+        call._op = '\0';
+        call._term._op = '\0';
+        call._term._factor._primary = primary;
+        return loadField("", expressionLabel(call));
+    }
+    if (primary._columnName) {
+        const SQLElementColumnName& name = *primary._columnName;
+        std::string field = stripThis(name._columnName);
+        std::string qualifier = name._tableName ? stripThis(*name._tableName)
+                                                : _defaultQualifier;
+        return loadField(qualifier.empty() ? std::string() : qualifier + "." + field, field);
+    }
+    if (!primary._expr.empty()) {
+        return expression(primary._expr[0].get());
+    }
+    Operand result;
+    result._isConst = true;
+    result._reg = 0;
+    if (primary._literal) {
+        result._value._type = ExpressionValue::STRING;
+        result._value._str = *primary._literal;
+    } else if (primary._num) {
+        result._value._type = ExpressionValue::NUMBER;
+        result._value._num = (double)*primary._num;
+    }
+    // parameters are not bound when rows are evaluated, so they have no
+    // value
+    return result;
+}
+
+ExpressionProgram::Operand ExpressionProgram::factor(const SQLElementExpression_Factor& factor)
+{
+    Operand value = primary(factor._primary);
+    if ('-' == factor._op) {
+        Operand zero;
+        zero._isConst = true;
+        zero._value._type = ExpressionValue::NUMBER;
+        zero._reg = 0;
+        value = combine(zero, '-', value);
+    } else if ('+' == factor._op) {
+        if (!value._isConst) {
+            value._reg = emit(TO_NUMBER, value._reg, 0, 0, 0);
+        } else if (ExpressionValue::NUMBER != value._value._type) {
+            value._value = ExpressionValue();
+        }
+    }
+    return value;
+}
+
+ExpressionProgram::Operand ExpressionProgram::term(const SQLElementExpression_Term& term)
+{
+    if (term._term.empty()) {
+        return factor(term._factor);
+    }
+    Operand lhs = this->term(term._term[0].get());
+    return combine(lhs, term._op, factor(term._factor));
+}
+
+ExpressionProgram::Operand ExpressionProgram::expression(const SQLElementExpression& expr)
+{
+    if (expr._expr.empty()) {
+        return term(expr._term);
+    }
+    Operand lhs = expression(expr._expr[0].get());
+    return combine(lhs, expr._op, term(expr._term));
+}
+
+ExpressionValue ExpressionProgram::run(const mongo::BSONObj& row) const
+{
+    if (_code.empty()) {
+        return _constant;
+    }
+    _paths.extract(row, &_values);
+    Register *regs = &_registers[0];
+    for (size_t pc = 0; pc < _code.size(); ++pc) {
+        const Instruction& instruction = _code[pc];
+        Register& dst = regs[pc];
+        const Register& lhs = regs[instruction._lhs];
+        const Register& rhs = regs[instruction._rhs];
+        // arithmetic has a value only on numbers
+        bool numbers = ExpressionValue::NUMBER == lhs._type;
+        switch(instruction._op) {
+          case LOAD_FIELD: {
+            const Field& field = _fields[instruction._field];
+            mongo::BSONElement elem;
+            if (field._hasQualified) {
+                elem = _values[field._qualified];
+            }
+            if (elem.eoo()) {
+                elem = _values[field._name];
+            }
+            dst._elem = elem;
+            if (elem.isNumber()) {
+                dst._type = ExpressionValue::NUMBER;
+                dst._num = elem.number();
+            } else if (mongo::String == elem.type()) {
+                dst._type = ExpressionValue::STRING;
+            } else if (!elem.eoo() && !elem.isNull() && mongo::Undefined != elem.type()) {
+                dst._type = ExpressionValue::OTHER;
+            } else {
+                dst._type = ExpressionValue::NONE;
+            }
+            continue;
+          }
+          case ADD: {
+            numbers = numbers && ExpressionValue::NUMBER == rhs._type;
+            dst._num = lhs._num + rhs._num;
+          } break;
+          case SUB: {
+            numbers = numbers && ExpressionValue::NUMBER == rhs._type;
+            dst._num = lhs._num - rhs._num;
+          } break;
+          case MUL: {
+            numbers = numbers && ExpressionValue::NUMBER == rhs._type;
+            dst._num = lhs._num * rhs._num;
+          } break;
+          case DIV: {
+            numbers = numbers && ExpressionValue::NUMBER == rhs._type && 0 != rhs._num;
+            dst._num = numbers ? lhs._num / rhs._num : 0;
+          } break;
+          case ADD_CONST: {
+            dst._num = lhs._num + instruction._num;
+          } break;
+          case SUB_CONST: {
+            dst._num = lhs._num - instruction._num;
+          } break;
+          case MUL_CONST: {
+            dst._num = lhs._num * instruction._num;
+          } break;
+          case DIV_CONST: {
+            // the constant is not 0
+            dst._num = lhs._num / instruction._num;
+          } break;
+          case CONST_SUB: {
+            dst._num = instruction._num - lhs._num;
+          } break;
+          case CONST_DIV: {
+            numbers = numbers && 0 != lhs._num;
+            dst._num = numbers ? instruction._num / lhs._num : 0;
+          } break;
+          case TO_NUMBER: {
+            dst._num = lhs._num;
+            dst._elem = lhs._elem;
+            dst._type = numbers ? ExpressionValue::NUMBER : ExpressionValue::NONE;
+            continue;
+          }
+        }
+        // a computed number is not a column's
+        dst._type = numbers ? ExpressionValue::NUMBER : ExpressionValue::NONE;
+        dst._elem = mongo::BSONElement();
+    }
+
+    const Register& result = regs[_result];
+    if (ExpressionValue::NONE == result._type) {
+        return ExpressionValue();
+    }
+    if (!result._elem.eoo()) {
+        return elementValue(result._elem);
+    }
+    ExpressionValue value;
+    value._type = ExpressionValue::NUMBER;
+    value._num = result._num;
+    return value;
+}
+
+std::string expressionLabel(const SQLElementExpression& expr)
+{
+    std::ostringstream text;
+    text << expr;
+    std::string label = text.str();
+    size_t pos = 0;
+    while (std::string::npos != (pos = label.find(THIS, pos))) {
+        label.erase(pos, THIS_LEN);
+    }
+    return label;
+}
+
+} // close mongoodbc namespace
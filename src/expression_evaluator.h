@@ -0,0 +1,201 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_EXPRESSION_EVALUATOR_H_
+#define MONGOODBC_EXPRESSION_EVALUATOR_H_
+
+#include "field_paths.h"
+#include "sql_element_expression.h"
+
+#include <mongo/bson/bsonobj.h>
+
+#include <string>
+#include <vector>
+
+namespace mongoodbc {
+
+/*
+* Value of an expression over a row.
+*/
+struct ExpressionValue {
+    // in the order values sort in
+    enum Type {
+        NONE = 1,
+        NUMBER,
+        STRING,
+        OTHER
+    };
+
+    Type _type;
+    double _num;
+    std::string _str;
+    // the row's field if the value is a column's, eoo otherwise; refers
+    // into the row
+    mongo::BSONElement _elem;
+
+    ExpressionValue()
+        : _type(NONE)
+        , _num(0)
+    {
+    }
+
+    /*
+    * Appends the value to 'builder' as 'name', with the column's type if
+    * it has one, NULL if it has no value.
+    */
+    void append(const std::string& name, mongo::BSONObjBuilder *builder) const;
+};
+
+/*
+* An expression compiled to a flat program over a register file, evaluated
+* over rows without walking the expression tree.  Expressions may use
+* columns, literals, unary minus and arithmetic on numbers; anything else,
+* e.g. arithmetic on a string, a missing operand or a division by zero, has
+* no value.
+*
+* Compiling folds the parts that use no column into constants and
+* specializes arithmetic with a constant operand, so e.g. 'price * (1 + 0.2)'
+* runs as a column load and one multiplication by 1.2, and 'a + \'x\''
+* runs as nothing at all.
+*
+* A column 't.c' is read from the field 't.c' of a joined row, or the
+* embedded field 'c' of a single table's field 't', else 'c' of a single
+* table's row; an unqualified column from the field '<default qualifier>.c'
+* if there is one, else 'c'.  Every field a program reads is found in one
+* walk over the row.  An aggregate function
+* call is read from the field named by its label, where an aggregation put
+* its result.
+*
+* Running a program writes its registers, so a program must not be run by
+* two threads at once.
+*/
+class ExpressionProgram {
+    enum Opcode {
+        LOAD_FIELD,
+        // lhs op rhs
+        ADD,
+        SUB,
+        MUL,
+        DIV,
+        // lhs op constant
+        ADD_CONST,
+        SUB_CONST,
+        MUL_CONST,
+        DIV_CONST,
+        // constant op lhs
+        CONST_SUB,
+        CONST_DIV,
+        // unary plus, lhs if it is a number
+        TO_NUMBER
+    };
+
+    /*
+    * An instruction, writing the register of its own index.
+    */
+    struct Instruction {
+        Opcode _op;
+        // registers of the operands
+        size_t _lhs;
+        size_t _rhs;
+        // constant operand or, for LOAD_FIELD, index into '_fields'
+        double _num;
+        size_t _field;
+    };
+
+    /*
+    * A field read by LOAD_FIELD: the path '_qualified' if present, else
+    * '_name', indexes into '_paths'.
+    */
+    struct Field {
+        bool _hasQualified;
+        size_t _qualified;
+        size_t _name;
+    };
+
+    /*
+    * A register: a number or the row's field holding the value.
+    */
+    struct Register {
+        ExpressionValue::Type _type;
+        double _num;
+        mongo::BSONElement _elem;
+    };
+
+    /*
+    * Operand of an instruction being compiled: a constant or a register.
+    */
+    struct Operand {
+        bool _isConst;
+        ExpressionValue _value;
+        size_t _reg;
+    };
+
+    std::vector<Instruction> _code;
+    std::vector<Field> _fields;
+    // every path LOAD_FIELD reads, found in one walk over the row
+    FieldPaths _paths;
+    mutable std::vector<mongo::BSONElement> _values;
+    // value of a program without instructions
+    ExpressionValue _constant;
+    // register holding the value
+    size_t _result;
+    mutable std::vector<Register> _registers;
+
+    std::string _defaultQualifier;
+
+    size_t emit(Opcode op, size_t lhs, size_t rhs, double num, size_t field);
+    Operand combine(const Operand& lhs, char op, const Operand& rhs);
+    Operand loadField(const std::string& qualified, const std::string& name);
+    Operand primary(const SQLElementExpression_Primary& primary);
+    Operand factor(const SQLElementExpression_Factor& factor);
+    Operand term(const SQLElementExpression_Term& term);
+    Operand expression(const SQLElementExpression& expr);
+
+  public:
+    /*
+    * Constructs a program without value.
+    */
+    ExpressionProgram();
+
+    ExpressionProgram(const SQLElementExpression& expr,
+                      const std::string& defaultQualifier = std::string());
+
+    /*
+    * Returns whether the program is a constant, i.e. reads no column.
+    */
+    bool isConstant() const { return _code.empty(); }
+
+    /*
+    * Returns the number of instructions.
+    */
+    size_t size() const { return _code.size(); }
+
+    /*
+    * Returns the value of the expression over 'row'.  A column's value
+    * refers into 'row'.
+    */
+    ExpressionValue run(const mongo::BSONObj& row) const;
+};
+
+/*
+* Returns the name of the result column of 'expr': its text without the
+* 'this.' prefixes of columns, e.g. 'a.x + 1' or 'COUNT(*)'.
+*/
+std::string expressionLabel(const SQLElementExpression& expr);
+
+} // close mongoodbc namespace
+
+#endif
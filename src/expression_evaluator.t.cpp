@@ -0,0 +1,287 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "expression_evaluator.h"
+#include "projection.h"
+#include "sql_fast_parser.h"
+#include "vector_row_source.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using mongoodbc::ExpressionProgram;
+using mongoodbc::ExpressionValue;
+using mongoodbc::ProjectRowSource;
+using mongoodbc::RowSource;
+using mongoodbc::SQLElementExpression;
+using mongoodbc::VectorRowSource;
+
+namespace {
+
+mongoodbc::SQLStatement parse(const std::string& sql)
+{
+    mongoodbc::SQLStatement stmt;
+    std::string errmsg;
+    EXPECT_EQ(0, mongoodbc::SQLFastParser::parse(sql, &stmt, &errmsg)) << sql << ": " << errmsg;
+    return stmt;
+}
+
+std::vector<SQLElementExpression> selectListOf(const std::string& sql)
+{
+    return parse(sql)._selectList;
+}
+
+ExpressionProgram compile(const std::string& expr,
+                          const std::string& defaultQualifier = std::string())
+{
+    std::vector<SQLElementExpression> selectList = selectListOf("SELECT " + expr + " FROM t");
+    EXPECT_EQ(1U, selectList.size()) << expr;
+    return ExpressionProgram(selectList[0], defaultQualifier);
+}
+
+} // close unnamed namespace
+
+TEST(ExpressionProgramTest, FoldsConstants)
+{
+    ExpressionProgram program = compile("1 + 2 * 3");
+    EXPECT_TRUE(program.isConstant());
+    ExpressionValue value = program.run(mongo::BSONObj());
+    EXPECT_EQ(ExpressionValue::NUMBER, value._type);
+    EXPECT_EQ(7, value._num);
+
+    program = compile("-(4 - 6) / 4");
+    EXPECT_TRUE(program.isConstant());
+    EXPECT_EQ(0.5, program.run(mongo::BSONObj())._num);
+
+    program = compile("'abc'");
+    EXPECT_TRUE(program.isConstant());
+    value = program.run(mongo::BSONObj());
+    EXPECT_EQ(ExpressionValue::STRING, value._type);
+    EXPECT_EQ("abc", value._str);
+}
+
+TEST(ExpressionProgramTest, SpecializesConstantOperands)
+{
+    mongo::BSONObj row = BSON("a" << 4 << "b" << 8);
+
+    // a load and one multiplication by the folded constant
+    ExpressionProgram program = compile("a * (1 + 2)");
+    EXPECT_EQ(2U, program.size());
+    EXPECT_EQ(12, program.run(row)._num);
+
+    program = compile("2 + a");
+    EXPECT_EQ(2U, program.size());
+    EXPECT_EQ(6, program.run(row)._num);
+
+    program = compile("10 - a");
+    EXPECT_EQ(2U, program.size());
+    EXPECT_EQ(6, program.run(row)._num);
+
+    program = compile("2 / a");
+    EXPECT_EQ(0.5, program.run(row)._num);
+
+    program = compile("a / 2 - b");
+    EXPECT_EQ(4U, program.size());
+    EXPECT_EQ(-6, program.run(row)._num);
+
+    program = compile("-a");
+    EXPECT_EQ(-4, program.run(row)._num);
+}
+
+TEST(ExpressionProgramTest, NoValue)
+{
+    mongo::BSONObj row = BSON("a" << 4 << "s" << "x" << "z" << 0);
+
+    // never a value, whatever the row
+    EXPECT_TRUE(compile("a + 'x'").isConstant());
+    EXPECT_TRUE(compile("a / 0").isConstant());
+    EXPECT_TRUE(compile("(a + 1) * ?").isConstant());
+    EXPECT_EQ(ExpressionValue::NONE, compile("a / 0").run(row)._type);
+
+    EXPECT_EQ(ExpressionValue::NONE, compile("a + s").run(row)._type);
+    EXPECT_EQ(ExpressionValue::NONE, compile("a / z").run(row)._type);
+    EXPECT_EQ(ExpressionValue::NONE, compile("1 / z").run(row)._type);
+    EXPECT_EQ(ExpressionValue::NONE, compile("missing * 2").run(row)._type);
+    EXPECT_EQ(ExpressionValue::NONE, compile("+s").run(row)._type);
+    EXPECT_EQ(ExpressionValue::NONE, compile("missing").run(row)._type);
+}
+
+TEST(ExpressionProgramTest, Columns)
+{
+    mongo::BSONObj row = BSON("t.a" << 1 << "b" << "x" << "u.a" << 5 << "COUNT(*)" << 3);
+
+    // a column keeps its field
+    ExpressionValue value = compile("+a", "t").run(row);
+    EXPECT_EQ(ExpressionValue::NUMBER, value._type);
+    EXPECT_EQ(mongo::NumberInt, value._elem.type());
+
+    value = compile("b", "t").run(row);
+    EXPECT_EQ(ExpressionValue::STRING, value._type);
+    EXPECT_EQ("x", value._str);
+
+    EXPECT_EQ(6, compile("a + u.a", "t").run(row)._num);
+    EXPECT_EQ(4, compile("COUNT(*) + 1").run(row)._num);
+}
+
+TEST(ExpressionProgramTest, Paths)
+{
+    mongo::BSONObj row = BSON("qty" << 2 << "item" << BSON("price" << 1.5
+                                                          << "size" << BSON("w" << 3)));
+
+    EXPECT_EQ(3, compile("item.price * qty").run(row)._num);
+    EXPECT_EQ(4.5, compile("item.price * item.size.w").run(row)._num);
+    // a table name is not a path
+    EXPECT_EQ(2, compile("coll.qty").run(row)._num);
+    EXPECT_EQ(ExpressionValue::NONE, compile("item.weight").run(row)._type);
+}
+
+TEST(ProjectRowSourceTest, Project)
+{
+    std::vector<mongo::BSONObj> rows;
+    rows.push_back(BSON("_id" << 1 << "price" << 2.5 << "qty" << 4 << "name" << "a"));
+    rows.push_back(BSON("_id" << 2 << "price" << 3 << "name" << "b"));
+
+    ProjectRowSource source(std::auto_ptr<RowSource>(new VectorRowSource(rows)),
+                            selectListOf("SELECT name, price * qty FROM t"));
+    ASSERT_TRUE(source.more());
+    EXPECT_EQ(BSON("name" << "a" << "price * qty" << 10.0), source.next());
+    ASSERT_TRUE(source.more());
+    mongo::BSONObjBuilder expected;
+    expected.append("name", "b");
+    expected.appendNull("price * qty");
+    EXPECT_EQ(expected.obj(), source.next());
+    EXPECT_FALSE(source.more());
+}
+
+TEST(ProjectRowSourceTest, IsComputed)
+{
+    EXPECT_FALSE(ProjectRowSource::isComputed(selectListOf("SELECT * FROM t")));
+    EXPECT_FALSE(ProjectRowSource::isComputed(selectListOf("SELECT a, t.b FROM t")));
+    EXPECT_TRUE(ProjectRowSource::isComputed(selectListOf("SELECT a, b + 1 FROM t")));
+    EXPECT_TRUE(ProjectRowSource::isComputed(selectListOf("SELECT -a FROM t")));
+}
+
+TEST(ProjectStageTest, Translate)
+{
+    mongo::BSONObj stage;
+    ASSERT_EQ(0, mongoodbc::projectStage(selectListOf("SELECT name, price * 2 FROM t"), &stage));
+
+    mongo::BSONArrayBuilder numberTypes;
+    numberTypes.append("double").append("int").append("long").append("decimal");
+    mongo::BSONObj price = BSON("$cond" << BSON_ARRAY(
+        BSON("$in" << BSON_ARRAY(BSON("$type" << "$price") << numberTypes.arr()))
+        << "$price"
+        << mongo::BSONNULL));
+    mongo::BSONObj name = BSON("$ifNull" << BSON_ARRAY("$name" << mongo::BSONNULL));
+    EXPECT_EQ(BSON("$project" << BSON("name" << name
+                                      << "price * 2" << BSON("$multiply" << BSON_ARRAY(price << 2.0))
+                                      << "_id" << 0)),
+              stage);
+}
+
+TEST(ProjectStageTest, Constants)
+{
+    mongo::BSONObj stage;
+    ASSERT_EQ(0, mongoodbc::projectStage(selectListOf("SELECT _id, 1 + 2, a + 'x' FROM t"), &stage));
+    mongo::BSONObjBuilder fields;
+    fields.append("_id", BSON("$ifNull" << BSON_ARRAY("$_id" << mongo::BSONNULL)));
+    fields.append("1 + 2", BSON("$literal" << 3.0));
+    fields.appendNull("a + x");
+    EXPECT_EQ(BSON("$project" << fields.obj()), stage);
+}
+
+TEST(ProjectStageTest, DivisionByColumn)
+{
+    mongo::BSONObj stage;
+    ASSERT_EQ(0, mongoodbc::projectStage(selectListOf("SELECT 1 / a FROM t"), &stage));
+    mongo::BSONObj value = stage["$project"].Obj()["1 / a"].Obj();
+    ASSERT_EQ(std::string("$cond"), value.firstElementFieldName());
+    std::vector<mongo::BSONElement> cond = value.firstElement().Array();
+    ASSERT_EQ(3U, cond.size());
+    EXPECT_TRUE(cond[1].isNull());
+    EXPECT_EQ(std::string("$divide"), cond[2].Obj().firstElementFieldName());
+}
+
+TEST(ProjectStageTest, NotTranslated)
+{
+    mongo::BSONObj stage;
+    // only plain columns
+    EXPECT_NE(0, mongoodbc::projectStage(selectListOf("SELECT a, b FROM t"), &stage));
+    // labels '$project' cannot output
+    EXPECT_NE(0, mongoodbc::projectStage(selectListOf("SELECT t.a + 1 FROM t"), &stage));
+    EXPECT_NE(0, mongoodbc::projectStage(selectListOf("SELECT a + 1, a + 1 FROM t"), &stage));
+}
+
+TEST(ProjectPipelineTest, Where)
+{
+    mongoodbc::SQLStatement stmt = parse("SELECT price * 2 FROM t WHERE price > 1");
+    mongo::BSONObj pipeline;
+    ASSERT_EQ(0, mongoodbc::projectPipeline(stmt._whereClause->obj,
+                                            BSON("price" << -1),
+                                            5,
+                                            stmt._selectList,
+                                            &pipeline));
+    std::vector<mongo::BSONElement> stages;
+    mongo::BSONObjIterator stageIt(pipeline);
+    while (stageIt.more()) {
+        stages.push_back(stageIt.next());
+    }
+    ASSERT_EQ(4U, stages.size());
+    // '$where' cannot run in '$match', its native form can
+    EXPECT_EQ(BSON("$match" << BSON("price" << BSON("$gt" << 1))), stages[0].Obj());
+    EXPECT_EQ(BSON("$sort" << BSON("price" << -1)), stages[1].Obj());
+    EXPECT_EQ(BSON("$limit" << 5), stages[2].Obj());
+    EXPECT_EQ(std::string("$project"), stages[3].Obj().firstElementFieldName());
+}
+
+TEST(ProjectPipelineTest, NoWhere)
+{
+    mongoodbc::SQLStatement stmt = parse("SELECT price * 2 FROM t");
+    mongo::BSONObj pipeline;
+    ASSERT_EQ(0, mongoodbc::projectPipeline(mongo::BSONObj(),
+                                            mongo::BSONObj(),
+                                            0,
+                                            stmt._selectList,
+                                            &pipeline));
+    EXPECT_EQ(1, pipeline.nFields());
+    EXPECT_EQ(std::string("$project"), pipeline.firstElement().Obj().firstElementFieldName());
+}
+
+TEST(ProjectPipelineTest, NotTranslated)
+{
+    mongo::BSONObj pipeline;
+    // the condition must translate, or the query stays a find
+    mongoodbc::SQLStatement stmt = parse("SELECT price * 2 FROM t WHERE price > qty");
+    EXPECT_NE(0, mongoodbc::projectPipeline(stmt._whereClause->obj,
+                                            mongo::BSONObj(),
+                                            0,
+                                            stmt._selectList,
+                                            &pipeline));
+    stmt = parse("SELECT a, b FROM t WHERE a > 1");
+    EXPECT_NE(0, mongoodbc::projectPipeline(stmt._whereClause->obj,
+                                            mongo::BSONObj(),
+                                            0,
+                                            stmt._selectList,
+                                            &pipeline));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,284 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "external_sort.h"
+
+#include <algorithm>
+
+#include <string.h>
+
+namespace {
+
+const size_t KEY_SIZE_BYTES = 4;
+
+size_t keySize(const std::string& record)
+{
+    return (unsigned char)record[0]
+           | ((unsigned char)record[1] << 8)
+           | ((unsigned char)record[2] << 16)
+           | ((size_t)(unsigned char)record[3] << 24);
+}
+
+int compareKeys(const std::string& lhs, const std::string& rhs)
+{
+    size_t lhsSize = keySize(lhs);
+    size_t rhsSize = keySize(rhs);
+    int cmp = memcmp(lhs.data() + KEY_SIZE_BYTES,
+                     rhs.data() + KEY_SIZE_BYTES,
+                     std::min(lhsSize, rhsSize));
+    if (0 != cmp) {
+        return cmp;
+    }
+    return lhsSize < rhsSize ? -1 : (lhsSize > rhsSize ? 1 : 0);
+}
+
+void makeRecord(const std::string& key, const mongo::BSONObj& row, std::string *record)
+{
+    record->reserve(KEY_SIZE_BYTES + key.size() + row.objsize());
+    for (size_t i = 0; i < KEY_SIZE_BYTES; ++i) {
+        record->push_back((char)(key.size() >> (8 * i)));
+    }
+    record->append(key);
+    record->append(row.objdata(), row.objsize());
+}
+
+mongo::BSONObj recordRow(const std::string& record)
+{
+    return mongo::BSONObj(record.data() + KEY_SIZE_BYTES + keySize(record)).getOwned();
+}
+
+/*
+* Orders indexes in a vector of records by key, then by index.
+*/
+class IndexLess {
+    const std::vector<std::string> *_records;
+
+  public:
+    explicit IndexLess(const std::vector<std::string> *records)
+        : _records(records)
+    {
+    }
+
+    bool operator()(size_t lhs, size_t rhs) const
+    {
+        int cmp = compareKeys((*_records)[lhs], (*_records)[rhs]);
+        return 0 != cmp ? cmp < 0 : lhs < rhs;
+    }
+};
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+const size_t ExternalSortRowSource::UNLIMITED;
+
+/*
+* k-way merge of sorted runs.  Runs are in input order, so among equal keys
+* the record of the earliest run comes first.
+*/
+class ExternalSortRowSource::Merge {
+    Runs _runs;
+    // next record of each run
+    std::vector<std::string> _heads;
+    // runs with a next record, a heap with the smallest at the front
+    std::vector<size_t> _heap;
+
+    class Greater {
+        const std::vector<std::string> *_heads;
+
+      public:
+        explicit Greater(const std::vector<std::string> *heads)
+            : _heads(heads)
+        {
+        }
+
+        bool operator()(size_t lhs, size_t rhs) const
+        {
+            return IndexLess(_heads)(rhs, lhs);
+        }
+    };
+
+  public:
+    explicit Merge(const Runs& runs)
+        : _runs(runs)
+        , _heads(runs.size())
+    {
+        for (size_t i = 0; i < _runs.size(); ++i) {
+            _runs[i]->rewind();
+            if (_runs[i]->read(&_heads[i])) {
+                _heap.push_back(i);
+            }
+        }
+        std::make_heap(_heap.begin(), _heap.end(), Greater(&_heads));
+    }
+
+    /*
+    * Moves the smallest record into 'record'.
+    * @return false once all runs are exhausted
+    */
+    bool next(std::string *record)
+    {
+        if (_heap.empty()) {
+            return false;
+        }
+        std::pop_heap(_heap.begin(), _heap.end(), Greater(&_heads));
+        size_t run = _heap.back();
+        record->swap(_heads[run]);
+        if (_runs[run]->read(&_heads[run])) {
+            std::push_heap(_heap.begin(), _heap.end(), Greater(&_heads));
+        } else {
+            _heap.pop_back();
+        }
+        return true;
+    }
+};
+
+ExternalSortRowSource::ExternalSortRowSource(std::auto_ptr<RowSource> source,
+                                             const SortKey& sortKey,
+                                             size_t memoryLimit,
+                                             const std::string& tempDirectory,
+                                             size_t *spilledBytes,
+                                             size_t limit)
+    : _source(source)
+    , _sortKey(sortKey)
+    , _memoryLimit(memoryLimit)
+    , _tempDirectory(tempDirectory)
+    , _spilledBytes(spilledBytes)
+    , _limit(limit)
+    , _loaded(false)
+    , _recordBytes(0)
+    , _next(0)
+    , _numRuns(0)
+    , _hasRecord(false)
+    , _numReturned(0)
+{
+}
+
+ExternalSortRowSource::~ExternalSortRowSource()
+{
+}
+
+void ExternalSortRowSource::addSpilled(size_t bytes)
+{
+    if (_spilledBytes) {
+        *_spilledBytes += bytes;
+    }
+}
+
+void ExternalSortRowSource::sortRecords()
+{
+    _order.resize(_records.size());
+    for (size_t i = 0; i < _order.size(); ++i) {
+        _order[i] = i;
+    }
+    std::sort(_order.begin(), _order.end(), IndexLess(&_records));
+}
+
+void ExternalSortRowSource::spill()
+{
+    sortRecords();
+    boost::shared_ptr<SpillFile> run(new SpillFile(_tempDirectory));
+    // a run holds consecutive input rows, so the ones after its first
+    // 'limit' have at least as many rows before them in the output
+    size_t size = std::min(_order.size(), _limit);
+    for (size_t i = 0; i < size; ++i) {
+        run->write(_records[_order[i]]);
+    }
+    addSpilled(run->bytes());
+    _runs.push_back(run);
+    ++_numRuns;
+
+    _records.clear();
+    _order.clear();
+    _recordBytes = 0;
+}
+
+void ExternalSortRowSource::load()
+{
+    _loaded = true;
+    std::string key;
+    while (_source->more()) {
+        mongo::BSONObj row = _source->next();
+        _sortKey.encode(row, &key);
+        _records.push_back(std::string());
+        makeRecord(key, row, &_records.back());
+        _recordBytes += _records.back().size() + sizeof(std::string) + sizeof(size_t);
+        if (_recordBytes > _memoryLimit) {
+            spill();
+        }
+    }
+
+    if (_runs.empty()) {
+        sortRecords();
+        return;
+    }
+    if (!_records.empty()) {
+        spill();
+    }
+
+    // each pass merges consecutive groups, keeping the runs in input order
+    while (_runs.size() > MERGE_WIDTH) {
+        Runs merged;
+        for (size_t begin = 0; begin < _runs.size(); begin += MERGE_WIDTH) {
+            size_t end = std::min(begin + (size_t)MERGE_WIDTH, _runs.size());
+            if (1 == end - begin) {
+                merged.push_back(_runs[begin]);
+                continue;
+            }
+            Merge merge(Runs(_runs.begin() + begin, _runs.begin() + end));
+            boost::shared_ptr<SpillFile> run(new SpillFile(_tempDirectory));
+            for (size_t i = 0; i < _limit && merge.next(&_record); ++i) {
+                run->write(_record);
+            }
+            addSpilled(run->bytes());
+            merged.push_back(run);
+            ++_numRuns;
+        }
+        _runs.swap(merged);
+    }
+    _merge.reset(new Merge(_runs));
+    _runs.clear();
+}
+
+bool ExternalSortRowSource::more()
+{
+    if (!_loaded) {
+        load();
+    }
+    if (_numReturned >= _limit) {
+        return false;
+    }
+    if (!_merge) {
+        return _next < _order.size();
+    }
+    if (!_hasRecord) {
+        _hasRecord = _merge->next(&_record);
+    }
+    return _hasRecord;
+}
+
+mongo::BSONObj ExternalSortRowSource::next()
+{
+    ++_numReturned;
+    if (!_merge) {
+        return recordRow(_records[_order[_next++]]);
+    }
+    more();
+    _hasRecord = false;
+    return recordRow(_record);
+}
+
+} // close mongoodbc namespace
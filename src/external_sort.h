@@ -0,0 +1,123 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_EXTERNAL_SORT_H_
+#define MONGOODBC_EXTERNAL_SORT_H_
+
+#include "row_source.h"
+#include "sort_key.h"
+#include "spill_file.h"
+
+#include <mongo/bson/bsonobj.h>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mongoodbc {
+
+/*
+* Row source returning all rows of another source in the order of a
+* 'SortKey', using at most about 'memoryLimit' bytes.  Rows are collected
+* in memory, and whenever they exceed the limit they are sorted and written
+* to a temporary file as a run.  Runs are merged MERGE_WIDTH at a time until
+* few enough are left to be merged while the rows are fetched.  Rows with
+* equal keys keep their input order.  With a 'limit' only the first rows are
+* returned, and no run holds more than that many.
+*
+* Rows are held in memory and in runs as records: the size of the encoded
+* key as a little endian int32, the key, then the row's BSON.
+*
+* The input is read on the first call to 'more'.
+*/
+class ExternalSortRowSource : public RowSource {
+  public:
+    // A limit returning every row
+    static const size_t UNLIMITED = (size_t)-1;
+
+    enum {
+        DEFAULT_MEMORY_LIMIT = 64 * 1024 * 1024,
+        MERGE_WIDTH = 64
+    };
+
+  private:
+    typedef std::vector<boost::shared_ptr<SpillFile> > Runs;
+
+    class Merge;
+
+    std::auto_ptr<RowSource> _source;
+    SortKey _sortKey;
+    size_t _memoryLimit;
+    std::string _tempDirectory;
+    size_t *_spilledBytes;
+    size_t _limit;
+
+    bool _loaded;
+    // rows of the current run, in input order
+    std::vector<std::string> _records;
+    // estimated memory held by '_records'
+    size_t _recordBytes;
+    // indexes in '_records' in output order, once sorted
+    std::vector<size_t> _order;
+    size_t _next;
+
+    Runs _runs;
+    size_t _numRuns;
+    // reads the final runs, if any were written
+    boost::scoped_ptr<Merge> _merge;
+    // next record of '_merge', if '_hasRecord'
+    std::string _record;
+    bool _hasRecord;
+    // rows returned so far
+    size_t _numReturned;
+
+    void load();
+    void sortRecords();
+    void spill();
+    void addSpilled(size_t bytes);
+
+  public:
+    /*
+    * Runs are written to 'tempDirectory', or to the system's temporary
+    * directory if empty.  The bytes written are added to '*spilledBytes'
+    * if not null.  At most 'limit' rows are returned.
+    */
+    ExternalSortRowSource(std::auto_ptr<RowSource> source,
+                          const SortKey& sortKey,
+                          size_t memoryLimit,
+                          const std::string& tempDirectory = std::string(),
+                          size_t *spilledBytes = 0,
+                          size_t limit = UNLIMITED);
+
+    ~ExternalSortRowSource();
+
+    virtual bool more();
+
+    virtual mongo::BSONObj next();
+
+    /*
+    * Returns the number of runs written to temporary files, including
+    * those of intermediate merges.
+    */
+    size_t numRuns() const { return _numRuns; }
+};
+
+} // close mongoodbc namespace
+
+#endif
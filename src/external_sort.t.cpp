@@ -0,0 +1,162 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#include "external_sort.h"
+#include "sql_fast_parser.h"
+#include "vector_row_source.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+
+using mongoodbc::ExternalSortRowSource;
+using mongoodbc::RowSource;
+using mongoodbc::SortKey;
+using mongoodbc::VectorRowSource;
+
+namespace {
+
+SortKey sortKey(const std::string& clause)
+{
+    mongoodbc::SQLStatement stmt;
+    std::string errmsg;
+    EXPECT_EQ(0, mongoodbc::SQLFastParser::parse("SELECT * FROM db.t ORDER BY " + clause,
+                                                 &stmt,
+                                                 &errmsg)) << clause << ": " << errmsg;
+    return SortKey(stmt._orderBy);
+}
+
+/*
+* Returns rows with a sequential 'id' and a 'v' from a few distinct values,
+* so that many rows tie.
+*/
+std::vector<mongo::BSONObj> makeRows(int numRows)
+{
+    std::vector<mongo::BSONObj> rows;
+    srand(7);
+    for (int i = 0; i < numRows; ++i) {
+        rows.push_back(BSON("id" << i << "v" << rand() % 50 << "pad" << std::string(20, 'x')));
+    }
+    return rows;
+}
+
+/*
+* Checks that the rows of 'sort' are ordered by 'v' descending, ties by
+* 'id', and returns their number.
+*/
+int checkSorted(ExternalSortRowSource *sort)
+{
+    int numRows = 0;
+    int lastV = 0;
+    int lastId = -1;
+    while (sort->more()) {
+        mongo::BSONObj row = sort->next();
+        int v = row.getIntField("v");
+        int id = row.getIntField("id");
+        if (numRows) {
+            EXPECT_TRUE(v < lastV || (v == lastV && id > lastId)) << row;
+        }
+        lastV = v;
+        lastId = id;
+        ++numRows;
+    }
+    return numRows;
+}
+
+} // close unnamed namespace
+
+TEST(ExternalSortRowSource, InMemory)
+{
+    size_t spilledBytes = 0;
+    ExternalSortRowSource sort(std::auto_ptr<RowSource>(new VectorRowSource(makeRows(1000))),
+                               sortKey("v DESC"),
+                               1 << 20,
+                               std::string(),
+                               &spilledBytes);
+    EXPECT_EQ(1000, checkSorted(&sort));
+    EXPECT_EQ(0u, sort.numRuns());
+    EXPECT_EQ(0u, spilledBytes);
+}
+
+TEST(ExternalSortRowSource, Spill)
+{
+    size_t spilledBytes = 0;
+    ExternalSortRowSource sort(std::auto_ptr<RowSource>(new VectorRowSource(makeRows(1000))),
+                               sortKey("v DESC"),
+                               4096,
+                               "/tmp",
+                               &spilledBytes);
+    EXPECT_EQ(1000, checkSorted(&sort));
+    EXPECT_LT(1u, sort.numRuns());
+    // few enough runs to merge while fetching
+    EXPECT_GT(ExternalSortRowSource::MERGE_WIDTH, sort.numRuns());
+    EXPECT_LT(0u, spilledBytes);
+}
+
+TEST(ExternalSortRowSource, MultiplePasses)
+{
+    // every row is a run of its own, so runs are merged in several passes
+    size_t spilledBytes = 0;
+    ExternalSortRowSource sort(std::auto_ptr<RowSource>(new VectorRowSource(makeRows(5000))),
+                               sortKey("v DESC"),
+                               1,
+                               std::string(),
+                               &spilledBytes);
+    EXPECT_EQ(5000, checkSorted(&sort));
+    // 5000 runs, 79 after the first pass, 2 after the second
+    EXPECT_EQ(5000u + 79u + 2u, sort.numRuns());
+}
+
+TEST(ExternalSortRowSource, Limit)
+{
+    // the first rows of the full sort, from runs cut at the limit
+    size_t memoryLimits[] = { 1 << 20, 4096, 1 };
+    for (size_t i = 0; i < sizeof(memoryLimits) / sizeof(memoryLimits[0]); ++i) {
+        ExternalSortRowSource all(std::auto_ptr<RowSource>(new VectorRowSource(makeRows(2000))),
+                                  sortKey("v DESC"),
+                                  memoryLimits[i]);
+        ExternalSortRowSource first(std::auto_ptr<RowSource>(new VectorRowSource(makeRows(2000))),
+                                    sortKey("v DESC"),
+                                    memoryLimits[i],
+                                    std::string(),
+                                    0,
+                                    300);
+        for (int j = 0; j < 300; ++j) {
+            ASSERT_TRUE(first.more()) << memoryLimits[i];
+            ASSERT_TRUE(all.more());
+            EXPECT_EQ(all.next().getIntField("id"), first.next().getIntField("id"));
+        }
+        EXPECT_FALSE(first.more());
+        EXPECT_TRUE(all.more());
+    }
+}
+
+TEST(ExternalSortRowSource, Empty)
+{
+    ExternalSortRowSource sort(
+        std::auto_ptr<RowSource>(new VectorRowSource(std::vector<mongo::BSONObj>())),
+        sortKey("v"),
+        1);
+    EXPECT_FALSE(sort.more());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,114 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "field_paths.h"
+
+#include <string.h>
+
+namespace mongoodbc {
+
+FieldPaths::FieldPaths()
+    : _nodes(1)
+    , _numPaths(0)
+{
+    _nodes[0]._path = -1;
+}
+
+size_t FieldPaths::child(size_t node, const char *segment, size_t len) const
+{
+    const std::vector<size_t>& children = _nodes[node]._children;
+    for (size_t i = 0; i < children.size(); ++i) {
+        const std::string& name = _nodes[children[i]]._segment;
+        if (name.size() == len && 0 == memcmp(name.data(), segment, len)) {
+            return children[i];
+        }
+    }
+    return 0;
+}
+
+size_t FieldPaths::descend(size_t node, const char *name) const
+{
+    const char *dot;
+    while ((dot = strchr(name, '.'))) {
+        node = child(node, name, dot - name);
+        if (!node) {
+            return 0;
+        }
+        name = dot + 1;
+    }
+    return child(node, name, strlen(name));
+}
+
+size_t FieldPaths::add(const std::string& path)
+{
+    size_t node = 0;
+    size_t begin = 0;
+    while (true) {
+        size_t end = path.find('.', begin);
+        if (std::string::npos == end) {
+            end = path.size();
+        }
+        size_t next = child(node, path.data() + begin, end - begin);
+        if (!next) {
+            Node segment;
+            segment._segment = path.substr(begin, end - begin);
+            segment._path = -1;
+            _nodes.push_back(segment);
+            next = _nodes.size() - 1;
+            _nodes[node]._children.push_back(next);
+        }
+        node = next;
+        if (end == path.size()) {
+            break;
+        }
+        begin = end + 1;
+    }
+    if (_nodes[node]._path < 0) {
+        _nodes[node]._path = (int)_numPaths++;
+    }
+    return (size_t)_nodes[node]._path;
+}
+
+void FieldPaths::walk(const mongo::BSONObj& obj,
+                      size_t node,
+                      std::vector<mongo::BSONElement> *values) const
+{
+    mongo::BSONObjIterator fieldIt(obj);
+    while (fieldIt.more()) {
+        mongo::BSONElement elem = fieldIt.next();
+        size_t found = descend(node, elem.fieldName());
+        if (!found) {
+            continue;
+        }
+        const Node& match = _nodes[found];
+        if (match._path >= 0) {
+            (*values)[match._path] = elem;
+        }
+        if (!match._children.empty() && mongo::Object == elem.type()) {
+            walk(elem.embeddedObject(), found, values);
+        }
+    }
+}
+
+void FieldPaths::extract(const mongo::BSONObj& doc, std::vector<mongo::BSONElement> *values) const
+{
+    values->assign(_numPaths, mongo::BSONElement());
+    if (_numPaths) {
+        walk(doc, 0, values);
+    }
+}
+
+} // close mongoodbc namespace
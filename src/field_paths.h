@@ -0,0 +1,87 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_FIELD_PATHS_H_
+#define MONGOODBC_FIELD_PATHS_H_
+
+#include <mongo/bson/bsonobj.h>
+
+#include <string>
+#include <vector>
+
+namespace mongoodbc {
+
+/*
+* A set of dotted field paths, e.g. 'address.city', compiled into a tree of
+* path segments so that one walk over a document finds all of them.  Only
+* the embedded documents leading to a path are entered.
+*
+* A field whose name contains dots, e.g. 't.a' of a joined row, stands for
+* the path of its segments, so 't.address.city' is found both in
+* '{ "t.address": { city: ... } }' and in '{ t: { address: { city: ... } } }'.
+*/
+class FieldPaths {
+    /*
+    * A segment, with the path ending there if any.
+    */
+    struct Node {
+        std::string _segment;
+        // index of the path ending at this node, or -1
+        int _path;
+        // indexes of the child nodes
+        std::vector<size_t> _children;
+    };
+
+    // the root, with an empty segment, first
+    std::vector<Node> _nodes;
+    size_t _numPaths;
+
+    // Returns the child of 'node' named 'segment', of 'len' bytes, or 0;
+    // the root is nobody's child
+    size_t child(size_t node, const char *segment, size_t len) const;
+
+    // Returns the node reached from 'node' through the segments of 'name',
+    // or 0
+    size_t descend(size_t node, const char *name) const;
+
+    void walk(const mongo::BSONObj& obj,
+              size_t node,
+              std::vector<mongo::BSONElement> *values) const;
+
+  public:
+    FieldPaths();
+
+    /*
+    * Adds 'path' unless already present.
+    * @return the index of 'path' in the values of 'extract'
+    */
+    size_t add(const std::string& path);
+
+    /*
+    * Returns the number of paths.
+    */
+    size_t size() const { return _numPaths; }
+
+    /*
+    * Sets 'values' to the element at each path of 'doc', eoo if missing,
+    * in the order the paths were added.  The elements refer into 'doc'.
+    */
+    void extract(const mongo::BSONObj& doc, std::vector<mongo::BSONElement> *values) const;
+};
+
+} // close mongoodbc namespace
+
+#endif
@@ -0,0 +1,85 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "field_paths.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using mongoodbc::FieldPaths;
+
+TEST(FieldPaths, Add)
+{
+    FieldPaths paths;
+    EXPECT_EQ(0U, paths.add("a"));
+    EXPECT_EQ(1U, paths.add("b.c"));
+    EXPECT_EQ(2U, paths.add("b"));
+    EXPECT_EQ(1U, paths.add("b.c"));
+    EXPECT_EQ(3U, paths.size());
+}
+
+TEST(FieldPaths, ExtractNested)
+{
+    FieldPaths paths;
+    paths.add("name");
+    paths.add("address.city");
+    paths.add("address.geo.lat");
+    paths.add("missing.x");
+
+    mongo::BSONObj doc = BSON("name" << "a"
+                              << "address" << BSON("city" << "x"
+                                                   << "geo" << BSON("lat" << 1.5)));
+    std::vector<mongo::BSONElement> values;
+    paths.extract(doc, &values);
+    ASSERT_EQ(4U, values.size());
+    EXPECT_EQ("a", values[0].str());
+    EXPECT_EQ("x", values[1].str());
+    EXPECT_EQ(1.5, values[2].number());
+    EXPECT_TRUE(values[3].eoo());
+}
+
+TEST(FieldPaths, DottedNames)
+{
+    FieldPaths paths;
+    paths.add("t.a");
+    paths.add("t.address.city");
+
+    // a joined row, whose fields are qualified by their table
+    mongo::BSONObj row = BSON("t.a" << 1 << "t.address" << BSON("city" << "x"));
+    std::vector<mongo::BSONElement> values;
+    paths.extract(row, &values);
+    EXPECT_EQ(1, values[0].numberInt());
+    EXPECT_EQ("x", values[1].str());
+}
+
+TEST(FieldPaths, NotDocuments)
+{
+    FieldPaths paths;
+    paths.add("a.b");
+
+    std::vector<mongo::BSONElement> values;
+    paths.extract(BSON("a" << 1), &values);
+    EXPECT_TRUE(values[0].eoo());
+    paths.extract(BSON("a" << BSON_ARRAY(BSON("b" << 1))), &values);
+    EXPECT_TRUE(values[0].eoo());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,318 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "hash_aggregate.h"
+
+#include "sort_key.h"
+
+namespace {
+
+using mongoodbc::RowSource;
+using mongoodbc::SpillFile;
+
+const size_t NOT_FOUND = (size_t)-1;
+const size_t INITIAL_SLOTS = 16;
+// bits of the hash choosing a partition, taken from the top down one level
+// at a time; the table uses the low bits
+const int PARTITION_BITS = 4;
+
+/*
+* Hashes an encoded key: FNV-1a, then mixed so that the top bits used for
+* partitions depend on every byte.
+*/
+unsigned long long hashKey(const std::string& key)
+{
+    unsigned long long hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < key.size(); ++i) {
+        hash ^= (unsigned char)key[i];
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+size_t partitionOf(unsigned long long hash, int level)
+{
+    return (size_t)(hash >> (64 - PARTITION_BITS * (level + 1)))
+           & ((1 << PARTITION_BITS) - 1);
+}
+
+/*
+* Row source reading back the rows of a partition.
+*/
+class SpillFileRowSource : public RowSource {
+    SpillFile *_file;
+    mongo::BSONObj _next;
+    bool _hasNext;
+
+  public:
+    explicit SpillFileRowSource(SpillFile *file)
+        : _file(file)
+        , _hasNext(false)
+    {
+        _file->rewind();
+    }
+
+    virtual bool more()
+    {
+        if (!_hasNext) {
+            _hasNext = _file->read(&_next);
+        }
+        return _hasNext;
+    }
+
+    virtual mongo::BSONObj next()
+    {
+        _hasNext = false;
+        return _next.getOwned();
+    }
+};
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+HashAggregateRowSource::HashAggregateRowSource(std::auto_ptr<RowSource> source,
+                                               const AggregatePlan& plan,
+                                               const std::string& defaultQualifier,
+                                               size_t memoryLimit,
+                                               const std::string& tempDirectory,
+                                               size_t *spilledBytes)
+    : _source(source)
+    , _plan(plan)
+    , _memoryLimit(memoryLimit)
+    , _tempDirectory(tempDirectory)
+    , _spilledBytes(spilledBytes)
+    , _started(false)
+    , _bytes(0)
+    , _next(0)
+    , _spilled(false)
+{
+    const std::vector<SQLElementExpression>& keys = _plan.keys();
+    for (size_t k = 0; k < keys.size(); ++k) {
+        _keyPrograms.push_back(ExpressionProgram(keys[k], defaultQualifier));
+    }
+    const std::vector<AggregateFunction>& aggregates = _plan.aggregates();
+    for (size_t a = 0; a < aggregates.size(); ++a) {
+        _argPrograms.push_back(aggregates[a]._hasArg
+                               ? ExpressionProgram(aggregates[a]._arg, defaultQualifier)
+                               : ExpressionProgram());
+    }
+}
+
+void HashAggregateRowSource::aggregate(RowSource *source, int level)
+{
+    _groups.clear();
+    _states.clear();
+    _slots.assign(INITIAL_SLOTS, 0);
+    _bytes = _slots.size() * sizeof(size_t);
+    _spill.clear();
+    _next = 0;
+
+    while (source->more()) {
+        _batch.push_back(source->next().getOwned());
+        if (BATCH_SIZE == _batch.size()) {
+            processBatch(level);
+        }
+    }
+    if (!_batch.empty()) {
+        processBatch(level);
+    }
+
+    for (size_t i = 0; i < _spill.size(); ++i) {
+        if (_spill[i]->numDocs()) {
+            addSpilled(_spill[i]->bytes());
+            Partition partition;
+            partition._file = _spill[i];
+            partition._level = level + 1;
+            _pending.push_back(partition);
+        }
+    }
+    _spill.clear();
+}
+
+void HashAggregateRowSource::processBatch(int level)
+{
+    const std::vector<SQLElementExpression>& keys = _plan.keys();
+    const std::vector<AggregateFunction>& aggregates = _plan.aggregates();
+    size_t numRows = _batch.size();
+
+    // key columns one at a time over the batch
+    _batchKeys.resize(numRows);
+    _batchHashes.resize(numRows);
+    _batchGroups.resize(numRows);
+    for (size_t i = 0; i < numRows; ++i) {
+        _batchKeys[i].clear();
+    }
+    for (size_t k = 0; k < keys.size(); ++k) {
+        for (size_t i = 0; i < numRows; ++i) {
+            encodeValue(_keyPrograms[k].run(_batch[i]), &_batchKeys[i]);
+        }
+    }
+
+    for (size_t i = 0; i < numRows; ++i) {
+        _batchHashes[i] = hashKey(_batchKeys[i]);
+        size_t group = findGroup(_batchKeys[i], _batchHashes[i]);
+        if (NOT_FOUND == group) {
+            if (_spill.empty() && _bytes > _memoryLimit && level < MAX_LEVELS) {
+                for (int p = 0; p < NUM_PARTITIONS; ++p) {
+                    _spill.push_back(boost::shared_ptr<SpillFile>(new SpillFile(_tempDirectory)));
+                }
+                _spilled = true;
+            }
+            if (_spill.empty()) {
+                group = addGroup(i);
+            } else {
+                spill(i, level);
+            }
+        }
+        _batchGroups[i] = group;
+    }
+
+    // then each aggregate over the rows of existing groups
+    for (size_t a = 0; a < aggregates.size(); ++a) {
+        const AggregateFunction& fn = aggregates[a];
+        _values.clear();
+        _batchStates.clear();
+        for (size_t i = 0; i < numRows; ++i) {
+            if (NOT_FOUND == _batchGroups[i]) {
+                continue;
+            }
+            if (fn._hasArg) {
+                _values.push_back(_argPrograms[a].run(_batch[i]));
+            }
+            _batchStates.push_back(&_states[_batchGroups[i] * aggregates.size() + a]);
+        }
+        long long delta = updateStates(fn, _values, _batchStates);
+        _bytes = (size_t)((long long)_bytes + delta);
+    }
+
+    _values.clear();
+    _batch.clear();
+}
+
+size_t HashAggregateRowSource::findGroup(const std::string& key, unsigned long long hash) const
+{
+    size_t mask = _slots.size() - 1;
+    for (size_t slot = (size_t)hash & mask; _slots[slot]; slot = (slot + 1) & mask) {
+        const Group& group = _groups[_slots[slot] - 1];
+        if (group._hash == hash && group._key == key) {
+            return _slots[slot] - 1;
+        }
+    }
+    return NOT_FOUND;
+}
+
+size_t HashAggregateRowSource::addGroup(size_t row)
+{
+    const std::vector<SQLElementExpression>& keys = _plan.keys();
+    const std::vector<std::string>& keyNames = _plan.keyNames();
+    size_t numAggregates = _plan.aggregates().size();
+
+    Group group;
+    group._hash = _batchHashes[row];
+    group._key = _batchKeys[row];
+    mongo::BSONObjBuilder keyValues;
+    for (size_t k = 0; k < keys.size(); ++k) {
+        _keyPrograms[k].run(_batch[row]).append(keyNames[k], &keyValues);
+    }
+    group._keyValues = keyValues.obj();
+
+    size_t index = _groups.size();
+    _groups.push_back(group);
+    _states.resize(_states.size() + numAggregates);
+    _bytes += sizeof(Group) + group._key.capacity() + group._keyValues.objsize()
+              + numAggregates * sizeof(AggregateState);
+
+    if (2 * _groups.size() > _slots.size()) {
+        growTable();
+    } else {
+        size_t mask = _slots.size() - 1;
+        size_t slot = (size_t)group._hash & mask;
+        while (_slots[slot]) {
+            slot = (slot + 1) & mask;
+        }
+        _slots[slot] = index + 1;
+    }
+    return index;
+}
+
+void HashAggregateRowSource::growTable()
+{
+    _bytes += _slots.size() * sizeof(size_t);
+    _slots.assign(2 * _slots.size(), 0);
+    size_t mask = _slots.size() - 1;
+    for (size_t g = 0; g < _groups.size(); ++g) {
+        size_t slot = (size_t)_groups[g]._hash & mask;
+        while (_slots[slot]) {
+            slot = (slot + 1) & mask;
+        }
+        _slots[slot] = g + 1;
+    }
+}
+
+void HashAggregateRowSource::spill(size_t row, int level)
+{
+    _spill[partitionOf(_batchHashes[row], level)]->write(_batch[row]);
+}
+
+void HashAggregateRowSource::addSpilled(size_t bytes)
+{
+    if (_spilledBytes) {
+        *_spilledBytes += bytes;
+    }
+}
+
+bool HashAggregateRowSource::more()
+{
+    if (!_started) {
+        _started = true;
+        aggregate(_source.get(), 0);
+        _source.reset();
+        if (_groups.empty() && _plan.keys().empty()) {
+            // an aggregate of no rows is still one row
+            Group group;
+            group._hash = 0;
+            _groups.push_back(group);
+            _states.resize(_plan.aggregates().size());
+        }
+    }
+    while (_next >= _groups.size()) {
+        if (_pending.empty()) {
+            return false;
+        }
+        Partition partition = _pending.back();
+        _pending.pop_back();
+        SpillFileRowSource rows(partition._file.get());
+        aggregate(&rows, partition._level);
+    }
+    return true;
+}
+
+mongo::BSONObj HashAggregateRowSource::next()
+{
+    size_t numAggregates = _plan.aggregates().size();
+    const AggregateState *states = numAggregates ? &_states[_next * numAggregates] : 0;
+    mongo::BSONObj row = _plan.resultRow(_groups[_next]._keyValues, states);
+    ++_next;
+    return row;
+}
+
+} // close mongoodbc namespace
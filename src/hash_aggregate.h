@@ -0,0 +1,153 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_HASH_AGGREGATE_H_
+#define MONGOODBC_HASH_AGGREGATE_H_
+
+#include "aggregate_function.h"
+#include "aggregate_plan.h"
+#include "expression_evaluator.h"
+#include "row_source.h"
+#include "spill_file.h"
+
+#include <mongo/bson/bsonobj.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mongoodbc {
+
+/*
+* Row source grouping the rows of another source by the keys of an
+* 'AggregatePlan' and returning one result row per group, in no particular
+* order.  Rows without a value for a key form a group of their own.
+*
+* Groups are found through an open addressing hash table on the encoded
+* key values.  Rows are read in batches of BATCH_SIZE: each row of a batch
+* is first assigned its group, then each aggregate is evaluated for the
+* whole batch and its states updated in one loop.
+*
+* Once the groups use more than 'memoryLimit' bytes no group is added:
+* rows of existing groups still update them, while other rows are written
+* to one of NUM_PARTITIONS temporary files by key hash.  After the input is
+* read the groups in memory are returned and each partition is aggregated
+* the same way, using other bits of the hash, up to MAX_LEVELS deep.
+*
+* An aggregate without GROUP BY returns one row, even for no input.  The
+* input is read on the first call to 'more'.
+*/
+class HashAggregateRowSource : public RowSource {
+  public:
+    enum {
+        DEFAULT_MEMORY_LIMIT = 64 * 1024 * 1024,
+        BATCH_SIZE = 1024,
+        NUM_PARTITIONS = 16,
+        MAX_LEVELS = 8
+    };
+
+  private:
+    struct Group {
+        unsigned long long _hash;
+        // key values encoded with 'encodeValue'
+        std::string _key;
+        // key values, one field per key
+        mongo::BSONObj _keyValues;
+    };
+
+    // rows spilled by a pass, aggregated by a pass one level deeper
+    struct Partition {
+        boost::shared_ptr<SpillFile> _file;
+        int _level;
+    };
+
+    std::auto_ptr<RowSource> _source;
+    AggregatePlan _plan;
+    // key expressions and aggregate arguments, compiled
+    std::vector<ExpressionProgram> _keyPrograms;
+    std::vector<ExpressionProgram> _argPrograms;
+    size_t _memoryLimit;
+    std::string _tempDirectory;
+    size_t *_spilledBytes;
+
+    bool _started;
+    // groups of the current pass and their states, 'numAggregates' per
+    // group
+    std::vector<Group> _groups;
+    std::vector<AggregateState> _states;
+    // open addressing table of group index + 1, 0 for an empty slot; the
+    // size is a power of 2
+    std::vector<size_t> _slots;
+    // estimated memory held by the groups and the table
+    size_t _bytes;
+    // partitions of the current pass once it spills
+    std::vector<boost::shared_ptr<SpillFile> > _spill;
+    // partitions left to aggregate
+    std::vector<Partition> _pending;
+    // next group to return
+    size_t _next;
+    bool _spilled;
+
+    // per batch: rows, their key encodings and hashes, groups, values of
+    // the current aggregate and the states they update
+    std::vector<mongo::BSONObj> _batch;
+    std::vector<std::string> _batchKeys;
+    std::vector<unsigned long long> _batchHashes;
+    std::vector<size_t> _batchGroups;
+    std::vector<ExpressionValue> _values;
+    std::vector<AggregateState *> _batchStates;
+
+    void aggregate(RowSource *source, int level);
+    void processBatch(int level);
+    size_t findGroup(const std::string& key, unsigned long long hash) const;
+    size_t addGroup(size_t row);
+    void growTable();
+    void spill(size_t row, int level);
+    void addSpilled(size_t bytes);
+
+  public:
+    /*
+    * Partitions are written to 'tempDirectory', or to the system's
+    * temporary directory if empty, and their bytes added to
+    * '*spilledBytes' if not null.
+    */
+    HashAggregateRowSource(std::auto_ptr<RowSource> source,
+                           const AggregatePlan& plan,
+                           const std::string& defaultQualifier,
+                           size_t memoryLimit,
+                           const std::string& tempDirectory = std::string(),
+                           size_t *spilledBytes = 0);
+
+    virtual bool more();
+
+    virtual mongo::BSONObj next();
+
+    /*
+    * Returns true if a pass went over the memory limit.
+    */
+    bool spilled() const;
+};
+
+inline bool HashAggregateRowSource::spilled() const
+{
+    return _spilled;
+}
+
+} // close mongoodbc namespace
+
+#endif
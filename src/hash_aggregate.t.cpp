@@ -0,0 +1,224 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#include "hash_aggregate.h"
+#include "sql_fast_parser.h"
+#include "vector_row_source.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <limits.h>
+
+using mongoodbc::AggregatePlan;
+using mongoodbc::HashAggregateRowSource;
+using mongoodbc::RowSource;
+using mongoodbc::VectorRowSource;
+
+namespace {
+
+int planOf(const std::string& sql, AggregatePlan *plan, std::string *errmsg)
+{
+    mongoodbc::SQLStatement stmt;
+    EXPECT_EQ(0, mongoodbc::SQLFastParser::parse(sql, &stmt, errmsg)) << sql << ": " << *errmsg;
+    EXPECT_TRUE(AggregatePlan::isAggregate(stmt)) << sql;
+    return plan->init(stmt, errmsg);
+}
+
+/*
+* Returns the result rows of 'sql' over 'rows' as strings, sorted.
+*/
+std::vector<std::string> aggregate(const std::string& sql,
+                                   const std::vector<mongo::BSONObj>& rows,
+                                   size_t memoryLimit = HashAggregateRowSource::DEFAULT_MEMORY_LIMIT,
+                                   bool *spilled = 0,
+                                   size_t *spilledBytes = 0)
+{
+    AggregatePlan plan;
+    std::string errmsg;
+    EXPECT_EQ(0, planOf(sql, &plan, &errmsg)) << errmsg;
+
+    HashAggregateRowSource source(std::auto_ptr<RowSource>(new VectorRowSource(rows)),
+                                  plan,
+                                  "",
+                                  memoryLimit,
+                                  "",
+                                  spilledBytes);
+    std::vector<std::string> result;
+    while (source.more()) {
+        result.push_back(source.next().toString());
+    }
+    if (spilled) {
+        *spilled = source.spilled();
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+} // close unnamed namespace
+
+TEST(HashAggregate, Functions)
+{
+    std::vector<mongo::BSONObj> rows;
+    for (int i = 0; i < 10; ++i) {
+        rows.push_back(BSON("g" << i % 3 << "v" << i));
+    }
+    std::vector<std::string> result =
+        aggregate("SELECT g, COUNT(*), SUM(v), MIN(v), MAX(v), AVG(v) FROM db.t GROUP BY g", rows);
+    ASSERT_EQ(3u, result.size());
+
+    mongo::BSONObjBuilder g0;
+    g0.append("g", 0);
+    g0.append("COUNT(*)", 4LL);
+    g0.append("SUM(v)", 18LL);
+    g0.append("MIN(v)", 0);
+    g0.append("MAX(v)", 9);
+    g0.append("AVG(v)", 4.5);
+    EXPECT_EQ(g0.obj().toString(), result[0]);
+
+    mongo::BSONObjBuilder g2;
+    g2.append("g", 2);
+    g2.append("COUNT(*)", 3LL);
+    g2.append("SUM(v)", 15LL);
+    g2.append("MIN(v)", 2);
+    g2.append("MAX(v)", 8);
+    g2.append("AVG(v)", 5.0);
+    EXPECT_EQ(g2.obj().toString(), result[2]);
+}
+
+TEST(HashAggregate, Nulls)
+{
+    std::vector<mongo::BSONObj> rows;
+    mongo::BSONObjBuilder nullValue;
+    nullValue.append("g", 1);
+    nullValue.appendNull("v");
+    mongo::BSONObjBuilder nullKey;
+    nullKey.appendNull("g");
+    nullKey.append("v", 4);
+    rows.push_back(BSON("g" << 1));
+    rows.push_back(nullValue.obj());
+    rows.push_back(BSON("v" << 3));
+    rows.push_back(nullKey.obj());
+    std::vector<std::string> result =
+        aggregate("SELECT g, COUNT(*), COUNT(v), SUM(v), MAX(v) FROM db.t GROUP BY g", rows);
+    ASSERT_EQ(2u, result.size());
+
+    // missing and null keys form one group
+    mongo::BSONObjBuilder none;
+    none.appendNull("g");
+    none.append("COUNT(*)", 2LL);
+    none.append("COUNT(v)", 2LL);
+    none.append("SUM(v)", 7LL);
+    none.append("MAX(v)", 4);
+    mongo::BSONObjBuilder one;
+    one.append("g", 1);
+    one.append("COUNT(*)", 2LL);
+    one.append("COUNT(v)", 0LL);
+    one.appendNull("SUM(v)");
+    one.appendNull("MAX(v)");
+    std::vector<std::string> expected;
+    expected.push_back(none.obj().toString());
+    expected.push_back(one.obj().toString());
+    std::sort(expected.begin(), expected.end());
+    EXPECT_EQ(expected, result);
+}
+
+TEST(HashAggregate, Sums)
+{
+    std::vector<mongo::BSONObj> rows;
+    rows.push_back(BSON("g" << 1 << "v" << LLONG_MAX));
+    rows.push_back(BSON("g" << 1 << "v" << 1));
+    rows.push_back(BSON("g" << 2 << "v" << 1));
+    rows.push_back(BSON("g" << 2 << "v" << 0.5));
+    std::vector<std::string> result = aggregate("SELECT g, SUM(v) FROM db.t GROUP BY g", rows);
+    ASSERT_EQ(2u, result.size());
+    EXPECT_EQ(BSON("g" << 1 << "SUM(v)" << (double)LLONG_MAX + 1).toString(), result[0]);
+    EXPECT_EQ(BSON("g" << 2 << "SUM(v)" << 1.5).toString(), result[1]);
+}
+
+TEST(HashAggregate, ComputedKey)
+{
+    AggregatePlan plan;
+    std::string errmsg;
+    ASSERT_EQ(0, planOf("SELECT COUNT(*), a * 2 FROM db.t GROUP BY a * 2", &plan, &errmsg))
+        << errmsg;
+    ASSERT_EQ(2u, plan.columns().size());
+    EXPECT_FALSE(plan.columns()[0]._isKey);
+    EXPECT_TRUE(plan.columns()[1]._isKey);
+
+    std::vector<mongo::BSONObj> rows;
+    for (int i = 0; i < 25; ++i) {
+        rows.push_back(BSON("a" << i % 5));
+    }
+    std::vector<std::string> result =
+        aggregate("SELECT COUNT(*) FROM db.t GROUP BY a * 2", rows);
+    EXPECT_EQ(std::vector<std::string>(5, BSON("COUNT(*)" << 5LL).toString()), result);
+}
+
+TEST(HashAggregate, Spill)
+{
+    std::vector<mongo::BSONObj> rows;
+    for (int i = 0; i < 20000; ++i) {
+        rows.push_back(BSON("g" << (i * 7919) % 3000 << "v" << i));
+    }
+    const std::string sql = "SELECT g, COUNT(*), SUM(v), MIN(v) FROM db.t GROUP BY g";
+    bool spilled = true;
+    std::vector<std::string> expected = aggregate(sql, rows, 1 << 30, &spilled);
+    EXPECT_FALSE(spilled);
+    ASSERT_EQ(3000u, expected.size());
+
+    size_t spilledBytes = 0;
+    EXPECT_EQ(expected, aggregate(sql, rows, 16 * 1024, &spilled, &spilledBytes));
+    EXPECT_TRUE(spilled);
+    EXPECT_LT(0u, spilledBytes);
+}
+
+TEST(HashAggregate, NoGroupBy)
+{
+    std::vector<mongo::BSONObj> rows;
+    const std::string sql = "SELECT COUNT(*), SUM(v) FROM db.t";
+
+    mongo::BSONObjBuilder empty;
+    empty.append("COUNT(*)", 0LL);
+    empty.appendNull("SUM(v)");
+    EXPECT_EQ(std::vector<std::string>(1, empty.obj().toString()), aggregate(sql, rows));
+
+    rows.push_back(BSON("v" << 2));
+    rows.push_back(BSON("v" << 3));
+    EXPECT_EQ(std::vector<std::string>(1, BSON("COUNT(*)" << 2LL << "SUM(v)" << 5LL).toString()),
+              aggregate(sql, rows));
+}
+
+TEST(HashAggregate, InvalidPlans)
+{
+    AggregatePlan plan;
+    std::string errmsg;
+    EXPECT_NE(0, planOf("SELECT a, COUNT(*) FROM db.t", &plan, &errmsg));
+    EXPECT_NE(0, planOf("SELECT b FROM db.t GROUP BY a", &plan, &errmsg));
+    EXPECT_NE(0, planOf("SELECT * FROM db.t GROUP BY a", &plan, &errmsg));
+    EXPECT_NE(0, planOf("SELECT SUM(*) FROM db.t", &plan, &errmsg));
+    EXPECT_NE(0, planOf("SELECT MAX(COUNT(a)) FROM db.t", &plan, &errmsg));
+    EXPECT_NE(0, planOf("SELECT COUNT(*) + 1 FROM db.t", &plan, &errmsg));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,211 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "hash_join.h"
+#include "join_key.h"
+
+namespace {
+
+// bookkeeping per build row besides its BSON: the vector slot and a hash
+// table node
+const size_t ROW_OVERHEAD = sizeof(mongo::BSONObj) + 4 * sizeof(void *);
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+HashJoinRowSource::HashJoinRowSource(std::auto_ptr<RowSource> left,
+                                     const std::vector<std::string>& leftKeys,
+                                     std::auto_ptr<RowSource> right,
+                                     const std::vector<std::string>& rightKeys,
+                                     Side build,
+                                     size_t memoryLimit,
+                                     const std::string& tempDirectory)
+    : _probe(BUILD_LEFT == build ? right : left)
+    , _build(BUILD_LEFT == build ? left : right)
+    , _probeKeys(BUILD_LEFT == build ? rightKeys : leftKeys)
+    , _buildKeys(BUILD_LEFT == build ? leftKeys : rightKeys)
+    , _buildIsLeft(BUILD_LEFT == build)
+    , _memoryLimit(memoryLimit)
+    , _tempDirectory(tempDirectory)
+    , _built(false)
+    , _buildBytes(0)
+    , _partition(0)
+    , _match(_table.end())
+    , _matchEnd(_table.end())
+    , _hasNext(false)
+{
+}
+
+bool HashJoinRowSource::more()
+{
+    if (!_hasNext) {
+        _hasNext = advance();
+    }
+    return _hasNext;
+}
+
+mongo::BSONObj HashJoinRowSource::next()
+{
+    more();
+    _hasNext = false;
+    return _next;
+}
+
+void HashJoinRowSource::build()
+{
+    _built = true;
+    while (_build->more()) {
+        mongo::BSONObj row = _build->next();
+        size_t hash;
+        if (!joinKeyHash(row, _buildKeys, &hash)) {
+            continue;
+        }
+        if (spilled()) {
+            _buildPartitions[hash % NUM_PARTITIONS]->write(row);
+            continue;
+        }
+        addBuildRow(row, hash);
+        if (_buildBytes > _memoryLimit) {
+            spill();
+        }
+    }
+    // give the cursor and its connection back early
+    _build.reset();
+
+    if (!spilled()) {
+        return;
+    }
+    while (_probe->more()) {
+        mongo::BSONObj row = _probe->next();
+        size_t hash;
+        if (joinKeyHash(row, _probeKeys, &hash)) {
+            _probePartitions[hash % NUM_PARTITIONS]->write(row);
+        }
+    }
+    _probe.reset();
+    loadPartition(0);
+}
+
+void HashJoinRowSource::addBuildRow(const mongo::BSONObj& row, size_t hash)
+{
+    _table.insert(std::make_pair(hash, _buildRows.size()));
+    _buildRows.push_back(row);
+    _buildBytes += row.objsize() + ROW_OVERHEAD;
+}
+
+void HashJoinRowSource::clearBuildRows()
+{
+    _table.clear();
+    _buildRows.clear();
+    _buildBytes = 0;
+    _match = _matchEnd = _table.end();
+}
+
+void HashJoinRowSource::spill()
+{
+    for (size_t i = 0; i < NUM_PARTITIONS; ++i) {
+        _buildPartitions.push_back(boost::shared_ptr<SpillFile>(new SpillFile(_tempDirectory)));
+        _probePartitions.push_back(boost::shared_ptr<SpillFile>(new SpillFile(_tempDirectory)));
+    }
+    for (HashTable::const_iterator it = _table.begin(); it != _table.end(); ++it) {
+        _buildPartitions[it->first % NUM_PARTITIONS]->write(_buildRows[it->second]);
+    }
+    clearBuildRows();
+}
+
+void HashJoinRowSource::loadPartition(size_t partition)
+{
+    clearBuildRows();
+    if (partition > 0) {
+        // done with the previous partition's files
+        _buildPartitions[partition - 1].reset();
+        _probePartitions[partition - 1].reset();
+    }
+
+    SpillFile& buildFile = *_buildPartitions[partition];
+    buildFile.rewind();
+    mongo::BSONObj row;
+    while (buildFile.read(&row)) {
+        size_t hash;
+        joinKeyHash(row, _buildKeys, &hash);
+        addBuildRow(row, hash);
+    }
+    _probePartitions[partition]->rewind();
+}
+
+bool HashJoinRowSource::nextProbeRow(size_t *hash)
+{
+    if (!spilled()) {
+        if (_buildRows.empty()) {
+            // nothing can match
+            return false;
+        }
+        while (_probe->more()) {
+            _probeRow = _probe->next();
+            if (joinKeyHash(_probeRow, _probeKeys, hash)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    while (_partition < NUM_PARTITIONS) {
+        // only rows with a key were written out
+        if (!_buildRows.empty() && _probePartitions[_partition]->read(&_probeRow)) {
+            joinKeyHash(_probeRow, _probeKeys, hash);
+            return true;
+        }
+        if (++_partition < NUM_PARTITIONS) {
+            loadPartition(_partition);
+        }
+    }
+    return false;
+}
+
+bool HashJoinRowSource::advance()
+{
+    if (!_built) {
+        build();
+    }
+
+    for (;;) {
+        while (_match != _matchEnd) {
+            const mongo::BSONObj& candidate = _buildRows[_match->second];
+            ++_match;
+            if (joinKeysEqual(_probeRow, _probeKeys, candidate, _buildKeys)) {
+                _next = merge(candidate);
+                return true;
+            }
+        }
+
+        size_t hash;
+        if (!nextProbeRow(&hash)) {
+            return false;
+        }
+        std::pair<HashTable::const_iterator, HashTable::const_iterator> range =
+            _table.equal_range(hash);
+        _match = range.first;
+        _matchEnd = range.second;
+    }
+}
+
+mongo::BSONObj HashJoinRowSource::merge(const mongo::BSONObj& buildRow) const
+{
+    return _buildIsLeft ? joinRows(buildRow, _probeRow) : joinRows(_probeRow, buildRow);
+}
+
+} // close mongoodbc namespace
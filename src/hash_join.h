@@ -0,0 +1,131 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_HASH_JOIN_H_
+#define MONGOODBC_HASH_JOIN_H_
+
+#include "row_source.h"
+#include "spill_file.h"
+
+#include <mongo/bson/bsonobj.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mongoodbc {
+
+/*
+* Inner equi-join of two row sources.  Rows of the build side are loaded
+* into a hash table on their key fields, then rows of the probe side are
+* streamed through it.  Joined rows hold the fields of the left row followed
+* by those of the right row, whichever side was built.
+*
+* Rows with a missing or null key field never match.  With no key fields
+* every pair of rows matches.
+*
+* When the build side grows past the memory limit both sides are split into
+* NUM_PARTITIONS temporary files by key hash and joined one partition at a
+* time.  A partition is loaded whole, even if it alone is over the limit.
+*/
+class HashJoinRowSource : public RowSource {
+  public:
+    enum Side {
+        BUILD_LEFT,
+        BUILD_RIGHT
+    };
+
+    enum {
+        NUM_PARTITIONS = 16
+    };
+
+  private:
+    // key hash to index in '_buildRows'
+    typedef boost::unordered_multimap<size_t, size_t> HashTable;
+    typedef std::vector<boost::shared_ptr<SpillFile> > Partitions;
+
+    std::auto_ptr<RowSource> _probe;
+    std::auto_ptr<RowSource> _build;
+    std::vector<std::string> _probeKeys;
+    std::vector<std::string> _buildKeys;
+    bool _buildIsLeft;
+    size_t _memoryLimit;
+    std::string _tempDirectory;
+
+    bool _built;
+    std::vector<mongo::BSONObj> _buildRows;
+    HashTable _table;
+    // estimated memory held by '_buildRows' and '_table'
+    size_t _buildBytes;
+
+    // empty until the build side spills
+    Partitions _buildPartitions;
+    Partitions _probePartitions;
+    size_t _partition;
+
+    // current probe row and the build rows sharing its key hash
+    mongo::BSONObj _probeRow;
+    HashTable::const_iterator _match;
+    HashTable::const_iterator _matchEnd;
+
+    mongo::BSONObj _next;
+    bool _hasNext;
+
+    void build();
+    void addBuildRow(const mongo::BSONObj& row, size_t hash);
+    void clearBuildRows();
+    void spill();
+    void loadPartition(size_t partition);
+    bool nextProbeRow(size_t *hash);
+    bool advance();
+    mongo::BSONObj merge(const mongo::BSONObj& buildRow) const;
+
+  public:
+    /*
+    * Joins rows where each 'leftKeys' field of 'left' equals the
+    * corresponding 'rightKeys' field of 'right', building the hash table
+    * from the side named by 'build'.  Partitions are written to
+    * 'tempDirectory', or to the system's temporary directory if empty.
+    */
+    HashJoinRowSource(std::auto_ptr<RowSource> left,
+                      const std::vector<std::string>& leftKeys,
+                      std::auto_ptr<RowSource> right,
+                      const std::vector<std::string>& rightKeys,
+                      Side build,
+                      size_t memoryLimit,
+                      const std::string& tempDirectory = std::string());
+
+    virtual bool more();
+
+    virtual mongo::BSONObj next();
+
+    /*
+    * Returns true if the build side went over the memory limit.
+    */
+    bool spilled() const;
+};
+
+inline bool HashJoinRowSource::spilled() const
+{
+    return !_buildPartitions.empty();
+}
+
+} // close mongoodbc namespace
+
+#endif
@@ -0,0 +1,166 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "hash_join.h"
+#include "vector_row_source.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using mongoodbc::HashJoinRowSource;
+using mongoodbc::RowSource;
+using mongoodbc::VectorRowSource;
+
+namespace {
+
+std::vector<std::string> keys(const char *first, const char *second = 0)
+{
+    std::vector<std::string> result(1, first);
+    if (second) {
+        result.push_back(second);
+    }
+    return result;
+}
+
+std::vector<std::string> join(const std::vector<mongo::BSONObj>& left,
+                              const std::vector<std::string>& leftKeys,
+                              const std::vector<mongo::BSONObj>& right,
+                              const std::vector<std::string>& rightKeys,
+                              HashJoinRowSource::Side build,
+                              size_t memoryLimit = 1 << 20,
+                              bool *spilled = 0)
+{
+    HashJoinRowSource rows(std::auto_ptr<RowSource>(new VectorRowSource(left)),
+                           leftKeys,
+                           std::auto_ptr<RowSource>(new VectorRowSource(right)),
+                           rightKeys,
+                           build,
+                           memoryLimit);
+    std::vector<std::string> result;
+    while (rows.more()) {
+        result.push_back(rows.next().toString());
+    }
+    if (spilled) {
+        *spilled = rows.spilled();
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+std::vector<mongo::BSONObj> orders()
+{
+    std::vector<mongo::BSONObj> rows;
+    rows.push_back(BSON("o.id" << 1 << "o.cust" << 10));
+    rows.push_back(BSON("o.id" << 2 << "o.cust" << 20));
+    rows.push_back(BSON("o.id" << 3 << "o.cust" << 10));
+    rows.push_back(BSON("o.id" << 4 << "o.cust" << 99));
+    rows.push_back(BSON("o.id" << 5));
+    return rows;
+}
+
+std::vector<mongo::BSONObj> customers()
+{
+    std::vector<mongo::BSONObj> rows;
+    rows.push_back(BSON("c.id" << 10.0 << "c.name" << "ann"));
+    rows.push_back(BSON("c.id" << 20LL << "c.name" << "bob"));
+    rows.push_back(BSON("c.id" << 30 << "c.name" << "cy"));
+    return rows;
+}
+
+} // close unnamed namespace
+
+TEST(HashJoin, Equality)
+{
+    std::vector<std::string> rows = join(orders(), keys("o.cust"),
+                                         customers(), keys("c.id"),
+                                         HashJoinRowSource::BUILD_RIGHT);
+    ASSERT_EQ(3u, rows.size());
+    EXPECT_EQ(BSON("o.id" << 1 << "o.cust" << 10 << "c.id" << 10.0 << "c.name" << "ann").toString(),
+              rows[0]);
+    EXPECT_EQ(BSON("o.id" << 2 << "o.cust" << 20 << "c.id" << 20LL << "c.name" << "bob").toString(),
+              rows[1]);
+
+    // the left row comes first whichever side is built
+    EXPECT_EQ(rows, join(orders(), keys("o.cust"),
+                         customers(), keys("c.id"),
+                         HashJoinRowSource::BUILD_LEFT));
+}
+
+TEST(HashJoin, NullKeys)
+{
+    std::vector<mongo::BSONObj> left;
+    left.push_back(BSON("a.k" << 1));
+    left.push_back(BSON("a.x" << 1));
+    mongo::BSONObjBuilder nullKey;
+    nullKey.appendNull("a.k");
+    left.push_back(nullKey.obj());
+
+    std::vector<mongo::BSONObj> right;
+    right.push_back(BSON("b.k" << 1));
+    mongo::BSONObjBuilder rightNull;
+    rightNull.appendNull("b.k");
+    right.push_back(rightNull.obj());
+
+    EXPECT_EQ(1u, join(left, keys("a.k"), right, keys("b.k"),
+                       HashJoinRowSource::BUILD_LEFT).size());
+}
+
+TEST(HashJoin, MultipleKeysAndCrossJoin)
+{
+    std::vector<mongo::BSONObj> left;
+    left.push_back(BSON("a.x" << 1 << "a.y" << "p"));
+    left.push_back(BSON("a.x" << 1 << "a.y" << "q"));
+    std::vector<mongo::BSONObj> right;
+    right.push_back(BSON("b.x" << 1 << "b.y" << "q"));
+    right.push_back(BSON("b.x" << 2 << "b.y" << "q"));
+
+    EXPECT_EQ(1u, join(left, keys("a.x", "a.y"), right, keys("b.x", "b.y"),
+                       HashJoinRowSource::BUILD_RIGHT).size());
+    EXPECT_EQ(4u, join(left, std::vector<std::string>(), right, std::vector<std::string>(),
+                       HashJoinRowSource::BUILD_RIGHT).size());
+}
+
+TEST(HashJoin, Spill)
+{
+    std::vector<mongo::BSONObj> left;
+    std::vector<mongo::BSONObj> right;
+    for (int i = 0; i < 500; ++i) {
+        left.push_back(BSON("a.id" << i << "a.k" << i % 37));
+        right.push_back(BSON("b.k" << i % 41 << "b.pad" << std::string(i % 13, 'x')));
+    }
+
+    bool spilled = true;
+    std::vector<std::string> inMemory = join(left, keys("a.k"), right, keys("b.k"),
+                                             HashJoinRowSource::BUILD_RIGHT,
+                                             1 << 24, &spilled);
+    EXPECT_FALSE(spilled);
+    EXPECT_FALSE(inMemory.empty());
+
+    std::vector<std::string> partitioned = join(left, keys("a.k"), right, keys("b.k"),
+                                                HashJoinRowSource::BUILD_RIGHT,
+                                                1024, &spilled);
+    EXPECT_TRUE(spilled);
+    EXPECT_EQ(inMemory, partitioned);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
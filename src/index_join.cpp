@@ -0,0 +1,146 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "index_join.h"
+#include "join_key.h"
+
+#include <algorithm>
+#include <set>
+
+namespace {
+
+struct ElementLess {
+    bool operator()(const mongo::BSONElement& lhs, const mongo::BSONElement& rhs) const
+    {
+        return lhs.woCompare(rhs, false) < 0;
+    }
+};
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+JoinProbe::~JoinProbe()
+{
+}
+
+IndexJoinRowSource::IndexJoinRowSource(std::auto_ptr<RowSource> outer,
+                                       const std::vector<std::string>& outerKeys,
+                                       std::auto_ptr<JoinProbe> probe,
+                                       const std::string& probeField,
+                                       const std::vector<std::string>& innerKeys,
+                                       Side outerSide,
+                                       size_t batchSize)
+    : _outer(outer)
+    , _outerKeys(outerKeys)
+    , _probe(probe)
+    , _probeField(probeField)
+    , _innerKeys(innerKeys)
+    , _outerIsLeft(OUTER_LEFT == outerSide)
+    , _batchSize(std::max(batchSize, (size_t)1))
+    , _numProbes(0)
+    , _outerIdx(0)
+    , _match(_table.end())
+    , _matchEnd(_table.end())
+    , _hasNext(false)
+{
+}
+
+bool IndexJoinRowSource::more()
+{
+    if (!_hasNext) {
+        _hasNext = advance();
+    }
+    return _hasNext;
+}
+
+mongo::BSONObj IndexJoinRowSource::next()
+{
+    more();
+    _hasNext = false;
+    return _next;
+}
+
+bool IndexJoinRowSource::nextBatch()
+{
+    _outerRows.clear();
+    _outerHashes.clear();
+    _outerIdx = 0;
+    _innerRows.clear();
+    _table.clear();
+    _match = _matchEnd = _table.end();
+
+    while (_outerRows.size() < _batchSize && _outer->more()) {
+        mongo::BSONObj row = _outer->next();
+        size_t hash;
+        if (joinKeyHash(row, _outerKeys, &hash)) {
+            _outerRows.push_back(row);
+            _outerHashes.push_back(hash);
+        }
+    }
+    if (_outerRows.empty()) {
+        return false;
+    }
+
+    std::set<mongo::BSONElement, ElementLess> values;
+    for (size_t i = 0; i < _outerRows.size(); ++i) {
+        values.insert(_outerRows[i].getField(_outerKeys[0]));
+    }
+    mongo::BSONArrayBuilder valueArray;
+    for (std::set<mongo::BSONElement, ElementLess>::const_iterator it = values.begin();
+         it != values.end();
+         ++it) {
+        valueArray.append(*it);
+    }
+
+    std::auto_ptr<RowSource> inner = _probe->find(_probeField, valueArray.arr());
+    ++_numProbes;
+    while (inner->more()) {
+        mongo::BSONObj row = inner->next();
+        size_t hash;
+        if (joinKeyHash(row, _innerKeys, &hash)) {
+            _table.insert(std::make_pair(hash, _innerRows.size()));
+            _innerRows.push_back(row);
+        }
+    }
+    return true;
+}
+
+bool IndexJoinRowSource::advance()
+{
+    for (;;) {
+        while (_match != _matchEnd) {
+            const mongo::BSONObj& outer = _outerRows[_outerIdx - 1];
+            const mongo::BSONObj& candidate = _innerRows[_match->second];
+            ++_match;
+            if (joinKeysEqual(outer, _outerKeys, candidate, _innerKeys)) {
+                _next = _outerIsLeft ? joinRows(outer, candidate) : joinRows(candidate, outer);
+                return true;
+            }
+        }
+
+        if (_outerIdx >= _outerRows.size() && !nextBatch()) {
+            return false;
+        }
+        std::pair<HashTable::const_iterator, HashTable::const_iterator> range =
+            _table.equal_range(_outerHashes[_outerIdx]);
+        _match = range.first;
+        _matchEnd = range.second;
+        ++_outerIdx;
+    }
+}
+
+} // close mongoodbc namespace
@@ -0,0 +1,127 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_INDEX_JOIN_H_
+#define MONGOODBC_INDEX_JOIN_H_
+
+#include "row_source.h"
+
+#include <mongo/bson/bsonobj.h>
+
+#include <boost/unordered_map.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mongoodbc {
+
+/*
+* Access to the inner side of an 'IndexJoinRowSource'.
+*/
+class JoinProbe {
+  public:
+    virtual ~JoinProbe();
+
+    /*
+    * Returns the inner rows whose 'field' equals one of the elements of
+    * the array 'values'.  May throw std::exception.
+    */
+    virtual std::auto_ptr<RowSource> find(const std::string& field,
+                                          const mongo::BSONObj& values) = 0;
+};
+
+/*
+* Inner equi-join reading the inner side through an index: rows of the
+* outer side are streamed in batches and the distinct keys of each batch
+* looked up with a single '$in' probe, whose results are joined with the
+* batch in memory.  Output follows the order of the outer side; as with
+* 'HashJoinRowSource' the fields of the left row come first.
+*
+* Only the first key field is probed; the others are compared when the
+* probe results are joined.  Rows with a missing or null key never match.
+*/
+class IndexJoinRowSource : public RowSource {
+  public:
+    enum Side {
+        OUTER_LEFT,
+        OUTER_RIGHT
+    };
+
+    enum {
+        DEFAULT_BATCH_SIZE = 2000
+    };
+
+  private:
+    // key hash to index in '_innerRows'
+    typedef boost::unordered_multimap<size_t, size_t> HashTable;
+
+    std::auto_ptr<RowSource> _outer;
+    std::vector<std::string> _outerKeys;
+    std::auto_ptr<JoinProbe> _probe;
+    std::string _probeField;
+    std::vector<std::string> _innerKeys;
+    bool _outerIsLeft;
+    size_t _batchSize;
+    size_t _numProbes;
+
+    std::vector<mongo::BSONObj> _outerRows;
+    std::vector<size_t> _outerHashes;
+    // next outer row of the batch to join
+    size_t _outerIdx;
+    std::vector<mongo::BSONObj> _innerRows;
+    HashTable _table;
+    HashTable::const_iterator _match;
+    HashTable::const_iterator _matchEnd;
+
+    mongo::BSONObj _next;
+    bool _hasNext;
+
+    bool nextBatch();
+    bool advance();
+
+  public:
+    /*
+    * Joins rows where each 'outerKeys' field of 'outer' equals the
+    * corresponding 'innerKeys' field of the rows 'probe' returns.  The
+    * probe is asked for 'probeField', its name for the first inner key.
+    */
+    IndexJoinRowSource(std::auto_ptr<RowSource> outer,
+                       const std::vector<std::string>& outerKeys,
+                       std::auto_ptr<JoinProbe> probe,
+                       const std::string& probeField,
+                       const std::vector<std::string>& innerKeys,
+                       Side outerSide,
+                       size_t batchSize = DEFAULT_BATCH_SIZE);
+
+    virtual bool more();
+
+    virtual mongo::BSONObj next();
+
+    /*
+    * Returns the number of probes sent so far.
+    */
+    size_t numProbes() const;
+};
+
+inline size_t IndexJoinRowSource::numProbes() const
+{
+    return _numProbes;
+}
+
+} // close mongoodbc namespace
+
+#endif
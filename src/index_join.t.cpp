@@ -0,0 +1,150 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "index_join.h"
+#include "vector_row_source.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using mongoodbc::IndexJoinRowSource;
+using mongoodbc::JoinProbe;
+using mongoodbc::RowSource;
+using mongoodbc::VectorRowSource;
+
+namespace {
+
+/*
+* Probe over in memory rows named '<qualifier>.<field>'.
+*/
+class VectorProbe : public JoinProbe {
+    std::vector<mongo::BSONObj> _rows;
+    std::string _qualifier;
+    std::vector<size_t> *_probeSizes;
+
+  public:
+    VectorProbe(const std::vector<mongo::BSONObj>& rows,
+                const std::string& qualifier,
+                std::vector<size_t> *probeSizes)
+        : _rows(rows)
+        , _qualifier(qualifier)
+        , _probeSizes(probeSizes)
+    {
+    }
+
+    virtual std::auto_ptr<RowSource> find(const std::string& field,
+                                          const mongo::BSONObj& values)
+    {
+        _probeSizes->push_back(values.nFields());
+        std::vector<mongo::BSONObj> found;
+        for (size_t i = 0; i < _rows.size(); ++i) {
+            mongo::BSONElement key = _rows[i].getField(_qualifier + "." + field);
+            mongo::BSONObjIterator valueIt(values);
+            while (valueIt.more()) {
+                if (0 == key.woCompare(valueIt.next(), false)) {
+                    found.push_back(_rows[i]);
+                    break;
+                }
+            }
+        }
+        return std::auto_ptr<RowSource>(new VectorRowSource(found));
+    }
+};
+
+std::vector<mongo::BSONObj> outerRows()
+{
+    std::vector<mongo::BSONObj> rows;
+    for (int i = 0; i < 10; ++i) {
+        rows.push_back(BSON("o.id" << i << "o.cust" << i % 4 << "o.region" << (i % 2 ? "e" : "w")));
+    }
+    rows.push_back(BSON("o.id" << 10));
+    return rows;
+}
+
+std::vector<mongo::BSONObj> innerRows()
+{
+    std::vector<mongo::BSONObj> rows;
+    rows.push_back(BSON("c.id" << 1.0 << "c.region" << "e"));
+    rows.push_back(BSON("c.id" << 2LL << "c.region" << "w"));
+    rows.push_back(BSON("c.id" << 2 << "c.region" << "e"));
+    rows.push_back(BSON("c.id" << 7 << "c.region" << "e"));
+    return rows;
+}
+
+} // close unnamed namespace
+
+TEST(IndexJoin, Batches)
+{
+    std::vector<size_t> probeSizes;
+    IndexJoinRowSource rows(std::auto_ptr<RowSource>(new VectorRowSource(outerRows())),
+                            std::vector<std::string>(1, "o.cust"),
+                            std::auto_ptr<JoinProbe>(new VectorProbe(innerRows(), "c", &probeSizes)),
+                            "id",
+                            std::vector<std::string>(1, "c.id"),
+                            IndexJoinRowSource::OUTER_LEFT,
+                            4);
+    std::vector<int> ids;
+    while (rows.more()) {
+        mongo::BSONObj row = rows.next();
+        EXPECT_EQ(row.getIntField("o.cust"), (int)row.getField("c.id").number());
+        EXPECT_STREQ("o.id", row.firstElement().fieldName());
+        ids.push_back(row.getIntField("o.id"));
+    }
+
+    // outer order is kept; cust 2 matches two inner rows
+    int expected[] = { 1, 2, 2, 5, 6, 6, 9 };
+    EXPECT_EQ(std::vector<int>(expected, expected + sizeof(expected) / sizeof(expected[0])), ids);
+
+    // ten keyed rows in batches of four, distinct keys probed once per batch
+    EXPECT_EQ(3u, rows.numProbes());
+    ASSERT_EQ(3u, probeSizes.size());
+    EXPECT_EQ(4u, probeSizes[0]);
+    EXPECT_EQ(2u, probeSizes[2]);
+}
+
+TEST(IndexJoin, MultipleKeysOuterRight)
+{
+    std::vector<size_t> probeSizes;
+    std::vector<std::string> outerKeys;
+    outerKeys.push_back("o.cust");
+    outerKeys.push_back("o.region");
+    std::vector<std::string> innerKeys;
+    innerKeys.push_back("c.id");
+    innerKeys.push_back("c.region");
+    IndexJoinRowSource rows(std::auto_ptr<RowSource>(new VectorRowSource(outerRows())),
+                            outerKeys,
+                            std::auto_ptr<JoinProbe>(new VectorProbe(innerRows(), "c", &probeSizes)),
+                            "id",
+                            innerKeys,
+                            IndexJoinRowSource::OUTER_RIGHT);
+    std::vector<int> ids;
+    while (rows.more()) {
+        mongo::BSONObj row = rows.next();
+        EXPECT_STREQ("c.id", row.firstElement().fieldName());
+        ids.push_back(row.getIntField("o.id"));
+    }
+    int expected[] = { 1, 2, 5, 6, 9 };
+    EXPECT_EQ(std::vector<int>(expected, expected + sizeof(expected) / sizeof(expected[0])), ids);
+    EXPECT_EQ(1u, rows.numProbes());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
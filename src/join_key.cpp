@@ -0,0 +1,91 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "join_key.h"
+
+#include <boost/functional/hash.hpp>
+
+namespace {
+
+void hashElement(const mongo::BSONElement& elem, size_t *seed)
+{
+    boost::hash_combine(*seed, elem.canonicalType());
+    switch(elem.type()) {
+      case mongo::NumberDouble:
+      case mongo::NumberInt:
+      case mongo::NumberLong: {
+        // numbers compare equal across types, so hash the value
+        double value = elem.number();
+        long long whole = (long long)value;
+        if ((double)whole == value) {
+            boost::hash_combine(*seed, whole);
+        } else {
+            boost::hash_combine(*seed, value);
+        }
+      } break;
+      case mongo::String: {
+        const char *str = elem.valuestr();
+        boost::hash_range(*seed, str, str + elem.valuestrsize() - 1);
+      } break;
+      case mongo::Bool: {
+        boost::hash_combine(*seed, elem.boolean());
+      } break;
+      default: {
+        boost::hash_combine(*seed, elem.toString(false));
+      } break;
+    }
+}
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+bool joinKeyHash(const mongo::BSONObj& row, const std::vector<std::string>& keys, size_t *hash)
+{
+    size_t seed = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        mongo::BSONElement elem = row.getField(keys[i]);
+        if (elem.eoo() || elem.isNull()) {
+            return false;
+        }
+        hashElement(elem, &seed);
+    }
+    *hash = seed;
+    return true;
+}
+
+bool joinKeysEqual(const mongo::BSONObj& lhs,
+                   const std::vector<std::string>& lhsKeys,
+                   const mongo::BSONObj& rhs,
+                   const std::vector<std::string>& rhsKeys)
+{
+    for (size_t i = 0; i < lhsKeys.size(); ++i) {
+        if (0 != lhs.getField(lhsKeys[i]).woCompare(rhs.getField(rhsKeys[i]), false)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+mongo::BSONObj joinRows(const mongo::BSONObj& left, const mongo::BSONObj& right)
+{
+    mongo::BSONObjBuilder builder(left.objsize() + right.objsize());
+    builder.appendElements(left);
+    builder.appendElements(right);
+    return builder.obj();
+}
+
+} // close mongoodbc namespace
@@ -0,0 +1,50 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_JOIN_KEY_H_
+#define MONGOODBC_JOIN_KEY_H_
+
+#include <mongo/bson/bsonobj.h>
+
+#include <string>
+#include <vector>
+
+namespace mongoodbc {
+
+/*
+* Hashes the 'keys' fields of 'row' such that rows whose key fields compare
+* equal, e.g. the numbers 1 and 1.0, hash alike.
+* @return false if a key field is missing or null; such rows never join
+*/
+bool joinKeyHash(const mongo::BSONObj& row, const std::vector<std::string>& keys, size_t *hash);
+
+/*
+* Returns true if each 'lhsKeys' field of 'lhs' compares equal to the
+* corresponding 'rhsKeys' field of 'rhs'.
+*/
+bool joinKeysEqual(const mongo::BSONObj& lhs,
+                   const std::vector<std::string>& lhsKeys,
+                   const mongo::BSONObj& rhs,
+                   const std::vector<std::string>& rhsKeys);
+
+/*
+* Returns the fields of 'left' followed by those of 'right'.
+*/
+mongo::BSONObj joinRows(const mongo::BSONObj& left, const mongo::BSONObj& right);
+
+} // close mongoodbc namespace
+
+#endif
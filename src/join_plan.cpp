@@ -0,0 +1,639 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "join_plan.h"
+
+#include "aggregation.h"
+#include "catalog_cache.h"
+#include "connection_handle.h"
+#include "hash_join.h"
+#include "index_join.h"
+#include "native_filter.h"
+#include "residual_filter.h"
+
+#include <boost/algorithm/string/replace.hpp>
+
+#include <algorithm>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+#include <ctype.h>
+#include <string.h>
+
+namespace {
+
+using mongoodbc::ConnectionHandle;
+using mongoodbc::ScopedConnection;
+
+// the parsers write column 'c' of table 't' as 'this.t.this.c'
+const char THIS[] = "this.";
+const size_t THIS_LEN = sizeof(THIS) - 1;
+const char QUALIFIER_END[] = ".this.";
+const size_t QUALIFIER_END_LEN = sizeof(QUALIFIER_END) - 1;
+
+std::string stripThis(const std::string& name)
+{
+    return 0 == name.compare(0, THIS_LEN, THIS) ? name.substr(THIS_LEN) : name;
+}
+
+bool isIdentifier(const std::string& str)
+{
+    if (str.empty()) {
+        return false;
+    }
+    for (size_t i = 0; i < str.size(); ++i) {
+        if (!isalnum((unsigned char)str[i]) && '_' != str[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+* Splits 'this.<table>.this.<column>' into its parts.
+* @return false if 'str' is not a qualified column
+*/
+bool parseColumn(const std::string& str, std::string *table, std::string *column)
+{
+    if (0 != str.compare(0, THIS_LEN, THIS)) {
+        return false;
+    }
+    size_t end = str.find(QUALIFIER_END, THIS_LEN);
+    if (std::string::npos == end) {
+        return false;
+    }
+    *table = str.substr(THIS_LEN, end - THIS_LEN);
+    *column = str.substr(end + QUALIFIER_END_LEN);
+    return isIdentifier(*table) && isIdentifier(*column);
+}
+
+bool isWhere(const mongo::BSONElement& elem)
+{
+    return mongo::String == elem.type() && 0 == strcmp("$where", elem.fieldName());
+}
+
+/*
+* Adds the tables qualifying columns anywhere in 'cond' to 'names'.
+*/
+void referencedTables(const mongo::BSONObj& cond, std::set<std::string> *names)
+{
+    mongo::BSONObjIterator fieldIt(cond);
+    while (fieldIt.more()) {
+        mongo::BSONElement elem = fieldIt.next();
+        if (elem.isABSONObj()) {
+            referencedTables(elem.embeddedObject(), names);
+        } else if (isWhere(elem)) {
+            std::string expr = elem.str();
+            size_t pos = 0;
+            while (std::string::npos != (pos = expr.find(THIS, pos))) {
+                size_t begin = pos + THIS_LEN;
+                size_t end = begin;
+                while (end < expr.size() && (isalnum((unsigned char)expr[end]) || '_' == expr[end])) {
+                    ++end;
+                }
+                if (end > begin && 0 == expr.compare(end, QUALIFIER_END_LEN, QUALIFIER_END)) {
+                    names->insert(expr.substr(begin, end - begin));
+                }
+                pos = end;
+            }
+        }
+    }
+}
+
+/*
+* Returns 'cond' with the columns of table 'name' unqualified, as the
+* server sees them in that table's documents.
+*/
+mongo::BSONObj unqualify(const mongo::BSONObj& cond, const std::string& name)
+{
+    std::string qualifier(THIS);
+    qualifier.append(name);
+    qualifier.append(QUALIFIER_END);
+
+    mongo::BSONObjBuilder builder;
+    mongo::BSONObjIterator fieldIt(cond);
+    while (fieldIt.more()) {
+        mongo::BSONElement elem = fieldIt.next();
+        if (mongo::Object == elem.type()) {
+            builder.append(elem.fieldName(), unqualify(elem.embeddedObject(), name));
+        } else if (mongo::Array == elem.type()) {
+            builder.appendArray(elem.fieldName(), unqualify(elem.embeddedObject(), name));
+        } else if (isWhere(elem)) {
+            builder.append(elem.fieldName(),
+                           boost::replace_all_copy(elem.str(), qualifier, std::string(THIS)));
+        } else {
+            builder.append(elem);
+        }
+    }
+    return builder.obj();
+}
+
+/*
+* Adds the conjuncts of the right nested '$and' tree 'cond' to 'conjuncts'.
+*/
+void splitConjuncts(const mongo::BSONObj& cond, std::vector<mongo::BSONObj> *conjuncts)
+{
+    if (cond.isEmpty()) {
+        return;
+    }
+    mongo::BSONElement andElem = cond.getField("$and");
+    if (1 != cond.nFields() || mongo::Array != andElem.type()) {
+        conjuncts->push_back(cond);
+        return;
+    }
+    mongo::BSONObjIterator termIt(andElem.embeddedObject());
+    while (termIt.more()) {
+        splitConjuncts(termIt.next().embeddedObject(), conjuncts);
+    }
+}
+
+/*
+* Row source over one collection, owning the connection its cursor reads.
+*/
+class ScanRowSource : public mongoodbc::RowSource {
+    std::auto_ptr<ScopedConnection> _conn;
+    std::auto_ptr<mongoodbc::RowSource> _cursor;
+
+  public:
+    ScanRowSource(ConnectionHandle *connHandle,
+                  const std::string& ns,
+                  const mongo::BSONObj& filter,
+                  const mongoodbc::BatchSizer& batchSizer)
+        : _conn(new ScopedConnection(connHandle))
+    {
+        mongoodbc::BatchSizer sizer(batchSizer);
+        std::auto_ptr<mongo::DBClientCursor> cursor =
+            connHandle->query(_conn->get(),
+                              ns,
+                              mongo::Query(filter),
+                              0,
+                              0,
+                              0,
+                              0,
+                              sizer.initialBatchSize());
+        if (!cursor.get()) {
+            throw std::runtime_error("cannot query " + ns);
+        }
+        _cursor.reset(new mongoodbc::CursorRowSource(cursor, sizer));
+    }
+
+    ~ScanRowSource()
+    {
+        // the cursor goes before its connection
+        _cursor.reset();
+    }
+
+    virtual bool more()
+    {
+        return _cursor->more();
+    }
+
+    virtual mongo::BSONObj next()
+    {
+        return _cursor->next();
+    }
+};
+
+/*
+* Probes a table of a 'JoinPlan' with one query per batch of keys.
+*/
+class CollectionProbe : public mongoodbc::JoinProbe {
+    ConnectionHandle *_connHandle;
+    mongoodbc::JoinPlan::Table _table;
+    mongoodbc::BatchSizer _batchSizer;
+
+  public:
+    CollectionProbe(ConnectionHandle *connHandle,
+                    const mongoodbc::JoinPlan::Table& table,
+                    const mongoodbc::BatchSizer& batchSizer)
+        : _connHandle(connHandle)
+        , _table(table)
+        , _batchSizer(batchSizer)
+    {
+    }
+
+    virtual std::auto_ptr<mongoodbc::RowSource> find(const std::string& field,
+                                                     const mongo::BSONObj& values)
+    {
+        mongo::BSONObjBuilder in;
+        in.appendArray("$in", values);
+        mongo::BSONObjBuilder keyFilter;
+        keyFilter.append(field, in.obj());
+        mongo::BSONObj filter = keyFilter.obj();
+        if (!_table.queryFilter().isEmpty()) {
+            mongo::BSONArrayBuilder terms;
+            terms.append(_table.queryFilter());
+            terms.append(filter);
+            filter = BSON("$and" << terms.arr());
+        }
+        return std::auto_ptr<mongoodbc::RowSource>(
+            new mongoodbc::QualifiedRowSource(std::auto_ptr<mongoodbc::RowSource>(
+                                                  new ScanRowSource(_connHandle,
+                                                                    _table._ns,
+                                                                    filter,
+                                                                    _batchSizer)),
+                                              _table._name));
+    }
+};
+
+/*
+* Adds the first field of each index of 'ns' to 'fields'.
+*/
+void indexedFields(mongoodbc::ConnectionHandle *connHandle,
+                   const std::string& ns,
+                   std::set<std::string> *fields)
+{
+    mongoodbc::CollectionInfo info;
+    if (0 != connHandle->collectionInfo(ns, false, &info)) {
+        return;
+    }
+    for (size_t i = 0; i < info._indexes.size(); ++i) {
+        mongo::BSONObj key = info._indexes[i].getObjectField("key");
+        if (!key.isEmpty()) {
+            fields->insert(key.firstElement().fieldName());
+        }
+    }
+}
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+int JoinPlan::init(const SQLSelectStatement& stmt, std::string *errmsg)
+{
+    _tables.clear();
+    _conditions.clear();
+    _residual = mongo::BSONObj();
+
+    std::vector<std::string> namespaces(stmt._tableRefList);
+    for (size_t i = 0; i < stmt._joins.size(); ++i) {
+        namespaces.push_back(stmt._joins[i]._table);
+    }
+    for (size_t i = 0; i < namespaces.size(); ++i) {
+        Table table;
+        table._ns = namespaces[i];
+        size_t dot = table._ns.find('.');
+        table._name = std::string::npos == dot ? table._ns : table._ns.substr(dot + 1);
+        size_t existing;
+        if (0 == tableIndex(table._name, &existing, 0)) {
+            *errmsg = "table '" + table._name + "' is used more than once";
+            return -1;
+        }
+        _tables.push_back(table);
+    }
+
+    for (size_t i = 0; i < stmt._joins.size(); ++i) {
+        const std::vector<SQLElementJoinCondition>& on = stmt._joins[i]._on;
+        for (size_t j = 0; j < on.size(); ++j) {
+            if (!on[j]._left._tableName || !on[j]._right._tableName) {
+                *errmsg = "columns in ON must be qualified with their table";
+                return -1;
+            }
+            if (0 != addCondition(stripThis(*on[j]._left._tableName),
+                                  stripThis(on[j]._left._columnName),
+                                  stripThis(*on[j]._right._tableName),
+                                  stripThis(on[j]._right._columnName),
+                                  errmsg)) {
+                return -1;
+            }
+        }
+    }
+
+    std::vector<std::vector<mongo::BSONObj> > filters(_tables.size());
+    std::vector<mongo::BSONObj> residual;
+    if (stmt._whereClause) {
+        std::vector<mongo::BSONObj> conjuncts;
+        splitConjuncts(stmt._whereClause->obj, &conjuncts);
+        for (size_t i = 0; i < conjuncts.size(); ++i) {
+            if (0 != addConjunct(conjuncts[i], &filters, &residual, errmsg)) {
+                return -1;
+            }
+        }
+    }
+    if (1 == residual.size()) {
+        _residual = residual[0];
+    } else if (!residual.empty()) {
+        mongo::BSONArrayBuilder terms;
+        for (size_t i = 0; i < residual.size(); ++i) {
+            terms.append(residual[i]);
+        }
+        _residual = BSON("$and" << terms.arr());
+    }
+    for (size_t i = 0; i < _tables.size(); ++i) {
+        if (1 == filters[i].size()) {
+            _tables[i]._filter = filters[i][0];
+        } else if (!filters[i].empty()) {
+            mongo::BSONArrayBuilder terms;
+            for (size_t j = 0; j < filters[i].size(); ++j) {
+                terms.append(filters[i][j]);
+            }
+            _tables[i]._filter = BSON("$and" << terms.arr());
+        }
+        _tables[i]._hasNativeFilter =
+            0 == nativeFilter(_tables[i]._filter, &_tables[i]._nativeFilter);
+    }
+
+    return 0;
+}
+
+int JoinPlan::tableIndex(const std::string& name, size_t *index, std::string *errmsg) const
+{
+    for (size_t i = 0; i < _tables.size(); ++i) {
+        if (name == _tables[i]._name) {
+            *index = i;
+            return 0;
+        }
+    }
+    if (errmsg) {
+        *errmsg = "unknown table '" + name + "'";
+    }
+    return -1;
+}
+
+int JoinPlan::addCondition(const std::string& leftTable,
+                           const std::string& leftField,
+                           const std::string& rightTable,
+                           const std::string& rightField,
+                           std::string *errmsg)
+{
+    Condition cond;
+    if (0 != tableIndex(leftTable, &cond._leftTable, errmsg)
+        || 0 != tableIndex(rightTable, &cond._rightTable, errmsg)) {
+        return -1;
+    }
+    if (cond._leftTable == cond._rightTable) {
+        *errmsg = "join condition compares table '" + leftTable + "' with itself";
+        return -1;
+    }
+    cond._leftField = leftField;
+    cond._rightField = rightField;
+    if (cond._leftTable > cond._rightTable) {
+        std::swap(cond._leftTable, cond._rightTable);
+        std::swap(cond._leftField, cond._rightField);
+    }
+    _conditions.push_back(cond);
+    return 0;
+}
+
+int JoinPlan::addConjunct(const mongo::BSONObj& cond,
+                          std::vector<std::vector<mongo::BSONObj> > *filters,
+                          std::vector<mongo::BSONObj> *residual,
+                          std::string *errmsg)
+{
+    mongo::BSONElement where = cond.firstElement();
+    if (1 == cond.nFields() && isWhere(where)) {
+        std::string expr = where.str();
+        size_t op = expr.find(" == ");
+        std::string leftTable;
+        std::string leftField;
+        std::string rightTable;
+        std::string rightField;
+        if (std::string::npos != op
+            && parseColumn(expr.substr(0, op), &leftTable, &leftField)
+            && parseColumn(expr.substr(op + 4), &rightTable, &rightField)
+            && leftTable != rightTable) {
+            return addCondition(leftTable, leftField, rightTable, rightField, errmsg);
+        }
+    }
+
+    std::set<std::string> names;
+    referencedTables(cond, &names);
+    if (names.size() > 1) {
+        ResidualFilter filter;
+        std::string filterErrmsg;
+        if (0 != filter.compile(cond, _tables[0]._name, &filterErrmsg)) {
+            *errmsg = "condition '" + cond.toString() + "' compares several tables"
+                      " and cannot be evaluated: " + filterErrmsg;
+            return -1;
+        }
+        residual->push_back(cond);
+        return 0;
+    }
+    if (names.empty()) {
+        (*filters)[0].push_back(cond);
+        return 0;
+    }
+    size_t index;
+    if (0 != tableIndex(*names.begin(), &index, errmsg)) {
+        return -1;
+    }
+    (*filters)[index].push_back(unqualify(cond, *names.begin()));
+    return 0;
+}
+
+int JoinPlan::lookupPipeline(mongo::BSONObj *pipeline) const
+{
+    std::string db = _tables[0]._ns.substr(0, _tables[0]._ns.find('.'));
+    for (size_t i = 0; i < _tables.size(); ++i) {
+        if (db + "." + _tables[i]._name != _tables[i]._ns || !_tables[i]._hasNativeFilter) {
+            return -1;
+        }
+    }
+
+    mongo::BSONArrayBuilder stages;
+    if (!_tables[0]._nativeFilter.isEmpty()) {
+        stages.append(BSON("$match" << _tables[0]._nativeFilter));
+    }
+    stages.append(BSON("$project" << BSON("_id" << 0 << _tables[0]._name << "$$ROOT")));
+
+    for (size_t i = 1; i < _tables.size(); ++i) {
+        mongo::BSONObjBuilder let;
+        mongo::BSONObjBuilder notNull;
+        mongo::BSONArrayBuilder equalities;
+        int numKeys = 0;
+        for (size_t j = 0; j < _conditions.size(); ++j) {
+            const Condition& cond = _conditions[j];
+            if (i != cond._rightTable) {
+                continue;
+            }
+            std::string local = _tables[cond._leftTable]._name + "." + cond._leftField;
+            std::stringstream var;
+            var << "k" << numKeys++;
+            let.append(var.str(), "$" + local);
+            // null keys never match, as in 'HashJoinRowSource'
+            mongo::BSONObjBuilder ne;
+            ne.appendNull("$ne");
+            notNull.append(local, ne.obj());
+            equalities.append(BSON("$eq" << BSON_ARRAY("$" + cond._rightField << "$$" + var.str())));
+        }
+        if (0 == numKeys) {
+            return -1;
+        }
+
+        mongo::BSONArrayBuilder inner;
+        inner.append(BSON("$match" << BSON("$expr" << BSON("$and" << equalities.arr()))));
+        if (!_tables[i]._nativeFilter.isEmpty()) {
+            inner.append(BSON("$match" << _tables[i]._nativeFilter));
+        }
+        stages.append(BSON("$match" << notNull.obj()));
+        stages.append(BSON("$lookup" << BSON("from" << _tables[i]._name
+                                             << "let" << let.obj()
+                                             << "pipeline" << inner.arr()
+                                             << "as" << _tables[i]._name)));
+        stages.append(BSON("$unwind" << "$" + _tables[i]._name));
+    }
+
+    *pipeline = stages.arr();
+    return 0;
+}
+
+bool JoinPlan::preferLookup(const std::vector<unsigned long long>& counts)
+{
+    unsigned long long others = 0;
+    for (size_t i = 1; i < counts.size(); ++i) {
+        others += counts[i];
+    }
+    return counts[0] <= LOOKUP_MAX_DRIVING_ROWS && counts[0] <= others;
+}
+
+bool JoinPlan::preferIndexJoin(unsigned long long outerCount, unsigned long long innerCount)
+{
+    return outerCount * INDEX_JOIN_MIN_RATIO <= innerCount;
+}
+
+std::auto_ptr<RowSource> JoinPlan::scan(ConnectionHandle *connHandle,
+                                        size_t table,
+                                        const BatchSizer& batchSizer) const
+{
+    return std::auto_ptr<RowSource>(
+        new QualifiedRowSource(std::auto_ptr<RowSource>(
+                                   new ScanRowSource(connHandle,
+                                                     _tables[table]._ns,
+                                                     _tables[table].queryFilter(),
+                                                     batchSizer)),
+                               _tables[table]._name));
+}
+
+std::auto_ptr<RowSource> JoinPlan::execute(ConnectionHandle *connHandle,
+                                           const BatchSizer& batchSizer,
+                                           size_t memoryLimit) const
+{
+    // estimated rows per table and the fields its indexes lead with, to pick
+    // the strategy and sides of each join
+    std::vector<unsigned long long> counts;
+    std::vector<std::set<std::string> > indexed(_tables.size());
+    std::string tempDirectory = connHandle->tempDirectory();
+    {
+        ScopedConnection conn(connHandle);
+        if (!conn.get()) {
+            throw std::runtime_error("not connected");
+        }
+        for (size_t i = 0; i < _tables.size(); ++i) {
+            counts.push_back(connHandle->count(conn.get(),
+                                               _tables[i]._ns,
+                                               _tables[i].queryFilter()));
+            indexedFields(connHandle, _tables[i]._ns, &indexed[i]);
+        }
+    }
+
+    mongo::BSONObj pipeline;
+    if (preferLookup(counts) && 0 == lookupPipeline(&pipeline)) {
+        try {
+            return std::auto_ptr<RowSource>(
+                new FlattenRowSource(std::auto_ptr<RowSource>(
+                                         new AggregationRowSource(connHandle,
+                                                                  _tables[0]._ns,
+                                                                  pipeline,
+                                                                  batchSizer))));
+        } catch (const std::exception& ex) {
+            // e.g. servers before 3.6 reject '$lookup' with a pipeline
+        }
+    }
+
+    // the first table is only scanned if the first join does not probe it
+    std::auto_ptr<RowSource> rows;
+    unsigned long long leftCount = counts[0];
+    for (size_t i = 1; i < _tables.size(); ++i) {
+        std::vector<const Condition *> conds;
+        for (size_t j = 0; j < _conditions.size(); ++j) {
+            if (i == _conditions[j]._rightTable) {
+                conds.push_back(&_conditions[j]);
+            }
+        }
+
+        // an index join probes the first key, so put an indexed one there
+        bool indexRight = false;
+        bool indexLeft = false;
+        for (size_t j = 0; j < conds.size() && !indexRight; ++j) {
+            if (indexed[i].count(conds[j]->_rightField) &&
+                preferIndexJoin(leftCount, counts[i])) {
+                std::swap(conds[0], conds[j]);
+                indexRight = true;
+            }
+        }
+        for (size_t j = 0; 1 == i && j < conds.size() && !indexRight && !indexLeft; ++j) {
+            if (indexed[0].count(conds[j]->_leftField) &&
+                preferIndexJoin(counts[1], counts[0])) {
+                std::swap(conds[0], conds[j]);
+                indexLeft = true;
+            }
+        }
+
+        std::vector<std::string> leftKeys;
+        std::vector<std::string> rightKeys;
+        for (size_t j = 0; j < conds.size(); ++j) {
+            leftKeys.push_back(_tables[conds[j]->_leftTable]._name + "." + conds[j]->_leftField);
+            rightKeys.push_back(_tables[i]._name + "." + conds[j]->_rightField);
+        }
+
+        if (indexLeft) {
+            rows.reset(new IndexJoinRowSource(scan(connHandle, 1, batchSizer),
+                                              rightKeys,
+                                              std::auto_ptr<JoinProbe>(
+                                                  new CollectionProbe(connHandle,
+                                                                      _tables[0],
+                                                                      batchSizer)),
+                                              conds[0]->_leftField,
+                                              leftKeys,
+                                              IndexJoinRowSource::OUTER_RIGHT));
+            leftCount = counts[1];
+            continue;
+        }
+
+        if (!rows.get()) {
+            rows = scan(connHandle, 0, batchSizer);
+        }
+        if (indexRight) {
+            rows.reset(new IndexJoinRowSource(rows,
+                                              leftKeys,
+                                              std::auto_ptr<JoinProbe>(
+                                                  new CollectionProbe(connHandle,
+                                                                      _tables[i],
+                                                                      batchSizer)),
+                                              conds[0]->_rightField,
+                                              rightKeys,
+                                              IndexJoinRowSource::OUTER_LEFT));
+            continue;
+        }
+
+        HashJoinRowSource::Side build = leftCount < counts[i] ? HashJoinRowSource::BUILD_LEFT
+                                                              : HashJoinRowSource::BUILD_RIGHT;
+        rows.reset(new HashJoinRowSource(rows,
+                                         leftKeys,
+                                         scan(connHandle, i, batchSizer),
+                                         rightKeys,
+                                         build,
+                                         memoryLimit,
+                                         tempDirectory));
+        // assume each row of the larger side finds one partner
+        leftCount = std::max(leftCount, counts[i]);
+    }
+
+    return rows;
+}
+
+} // close mongoodbc namespace
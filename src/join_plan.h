@@ -0,0 +1,170 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_JOIN_PLAN_H_
+#define MONGOODBC_JOIN_PLAN_H_
+
+#include "batch_sizer.h"
+#include "row_source.h"
+#include "sql_select_statement.h"
+
+#include <mongo/bson/bsonobj.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mongoodbc {
+
+class ConnectionHandle;
+
+/*
+* Execution plan of a SELECT reading several tables, either listed in FROM
+* or added with JOIN ... ON.  Tables are joined left-deep in the order they
+* appear with 'HashJoinRowSource'; result rows name their fields
+* '<collection>.<field>'.
+*
+* The equalities of ON clauses and the top level 'a.x = b.y' conjuncts of
+* WHERE become join keys.  WHERE conjuncts referencing one table are sent to
+* the server with that table's query; those comparing several tables make
+* the residual condition, evaluated over the joined rows with a
+* 'ResidualFilter'.  Unqualified columns belong to the first table.
+*
+* A join whose inner table has an index on a join key and is much larger
+* than the outer side probes it with batches of keys instead
+* ('IndexJoinRowSource').  When all tables live in one database the join may
+* also run on the server as an aggregation over the first table, with a
+* '$lookup' and an '$unwind' stage per further table.
+*/
+class JoinPlan {
+  public:
+    enum {
+        DEFAULT_MEMORY_LIMIT = 64 * 1024 * 1024,
+        // '$lookup' runs one query per row of the first table
+        LOOKUP_MAX_DRIVING_ROWS = 10000,
+        INDEX_JOIN_MIN_RATIO = 10
+    };
+
+    struct Table {
+        std::string _ns;
+        // collection name, which qualifies the table's columns
+        std::string _name;
+        mongo::BSONObj _filter;
+        // '_filter' in a form a '$match' stage accepts, if it has one
+        bool _hasNativeFilter;
+        mongo::BSONObj _nativeFilter;
+
+        /*
+        * Returns the filter to send with the table's queries: the native
+        * one if there is one, which spares the server running '$where'.
+        */
+        const mongo::BSONObj& queryFilter() const
+        {
+            return _hasNativeFilter ? _nativeFilter : _filter;
+        }
+    };
+
+    /*
+    * Equality between a field of '_leftTable' and a field of the later
+    * table '_rightTable'.
+    */
+    struct Condition {
+        size_t _leftTable;
+        std::string _leftField;
+        size_t _rightTable;
+        std::string _rightField;
+    };
+
+  private:
+    std::vector<Table> _tables;
+    std::vector<Condition> _conditions;
+    mongo::BSONObj _residual;
+
+    int addCondition(const std::string& leftTable,
+                     const std::string& leftField,
+                     const std::string& rightTable,
+                     const std::string& rightField,
+                     std::string *errmsg);
+    int addConjunct(const mongo::BSONObj& cond,
+                    std::vector<std::vector<mongo::BSONObj> > *filters,
+                    std::vector<mongo::BSONObj> *residual,
+                    std::string *errmsg);
+    int tableIndex(const std::string& name, size_t *index, std::string *errmsg) const;
+    std::auto_ptr<RowSource> scan(ConnectionHandle *connHandle,
+                                  size_t table,
+                                  const BatchSizer& batchSizer) const;
+
+  public:
+    /*
+    * Plans 'stmt'.
+    * @return 0 on success, -1 with a description in 'errmsg' if the
+    *         statement cannot be executed as a join
+    */
+    int init(const SQLSelectStatement& stmt, std::string *errmsg);
+
+    const std::vector<Table>& tables() const { return _tables; }
+    const std::vector<Condition>& conditions() const { return _conditions; }
+
+    /*
+    * Returns the conjuncts comparing several tables, to be evaluated over
+    * the joined rows, empty if none.
+    */
+    const mongo::BSONObj& residual() const { return _residual; }
+
+    /*
+    * Builds the aggregation pipeline joining the tables with '$lookup', to
+    * be run over the first table.  Each table's fields are nested under its
+    * name.
+    * @return 0 on success, -1 if the tables are in different databases, a
+    *         filter has no native form or a table has no join condition
+    */
+    int lookupPipeline(mongo::BSONObj *pipeline) const;
+
+    /*
+    * Returns true if a '$lookup' pipeline is expected to be cheaper than a
+    * join in the driver, given the number of matching documents of each
+    * table: the first table must be small enough to run a query per row,
+    * and no larger than the others together, which are then never read in
+    * full.
+    */
+    static bool preferLookup(const std::vector<unsigned long long>& counts);
+
+    /*
+    * Returns true if probing an indexed inner side with the keys of
+    * 'outerCount' rows is expected to be cheaper than reading all its
+    * 'innerCount' rows, i.e. if it is at least INDEX_JOIN_MIN_RATIO times
+    * larger.
+    */
+    static bool preferIndexJoin(unsigned long long outerCount, unsigned long long innerCount);
+
+    /*
+    * Returns the joined rows, from a '$lookup' pipeline when possible and
+    * preferred.  Otherwise joins in the driver, with cursors over
+    * connections of their own from 'connHandle', each join either probing
+    * an index or holding the side expected to be smaller in memory, up to
+    * 'memoryLimit' bytes before spilling to temporary files in the
+    * connection's temporary directory.
+    *
+    * May throw std::exception, like the returned row source.
+    */
+    std::auto_ptr<RowSource> execute(ConnectionHandle *connHandle,
+                                     const BatchSizer& batchSizer,
+                                     size_t memoryLimit) const;
+};
+
+} // close mongoodbc namespace
+
+#endif
@@ -0,0 +1,202 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "join_plan.h"
+
+#include "sql_fast_parser.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using mongoodbc::JoinPlan;
+
+namespace {
+
+int plan(const std::string& sql, JoinPlan *joinPlan, std::string *errmsg)
+{
+    mongoodbc::SQLSelectStatement stmt;
+    if (0 != mongoodbc::SQLFastParser::parse(sql, &stmt, errmsg)) {
+        return -1;
+    }
+    return joinPlan->init(stmt, errmsg);
+}
+
+} // close unnamed namespace
+
+TEST(JoinPlan, CommaJoin)
+{
+    JoinPlan joinPlan;
+    std::string errmsg;
+    ASSERT_EQ(0, plan("SELECT * FROM shop.orders, shop.customers"
+                      " WHERE orders.cust = customers.id AND customers.age > 30"
+                      " AND total > 5 AND (orders.qty < 2 OR orders.qty > 10)",
+                      &joinPlan, &errmsg)) << errmsg;
+
+    ASSERT_EQ(2u, joinPlan.tables().size());
+    EXPECT_EQ("shop.orders", joinPlan.tables()[0]._ns);
+    EXPECT_EQ("orders", joinPlan.tables()[0]._name);
+    EXPECT_EQ("customers", joinPlan.tables()[1]._name);
+
+    ASSERT_EQ(1u, joinPlan.conditions().size());
+    const JoinPlan::Condition& cond = joinPlan.conditions()[0];
+    EXPECT_EQ(0u, cond._leftTable);
+    EXPECT_EQ("cust", cond._leftField);
+    EXPECT_EQ(1u, cond._rightTable);
+    EXPECT_EQ("id", cond._rightField);
+
+    // unqualified columns go with the first table
+    std::string orders = joinPlan.tables()[0]._filter.toString();
+    EXPECT_NE(std::string::npos, orders.find("this.total > 5"));
+    EXPECT_NE(std::string::npos, orders.find("this.qty < 2"));
+    EXPECT_EQ(std::string::npos, orders.find("this.orders."));
+    EXPECT_EQ(BSON("$where" << "this.age > 30").toString(),
+              joinPlan.tables()[1]._filter.toString());
+}
+
+TEST(JoinPlan, JoinOn)
+{
+    JoinPlan joinPlan;
+    std::string errmsg;
+    ASSERT_EQ(0, plan("SELECT * FROM db.a JOIN db.b ON b.x = a.x AND a.y = b.y"
+                      " INNER JOIN db.c ON c.z = a.z",
+                      &joinPlan, &errmsg)) << errmsg;
+    ASSERT_EQ(3u, joinPlan.tables().size());
+    ASSERT_EQ(3u, joinPlan.conditions().size());
+
+    // conditions are ordered so the right table is the later one
+    EXPECT_EQ(0u, joinPlan.conditions()[0]._leftTable);
+    EXPECT_EQ(1u, joinPlan.conditions()[0]._rightTable);
+    EXPECT_EQ(0u, joinPlan.conditions()[2]._leftTable);
+    EXPECT_EQ(2u, joinPlan.conditions()[2]._rightTable);
+    EXPECT_EQ("z", joinPlan.conditions()[2]._rightField);
+    EXPECT_TRUE(joinPlan.tables()[0]._filter.isEmpty());
+}
+
+TEST(JoinPlan, Residual)
+{
+    JoinPlan joinPlan;
+    std::string errmsg;
+    ASSERT_EQ(0, plan("SELECT * FROM db.a, db.b WHERE a.k = b.k AND a.x < b.y"
+                      " AND (a.x = 1 OR b.y = 2) AND b.z > 3",
+                      &joinPlan, &errmsg)) << errmsg;
+    EXPECT_EQ(1u, joinPlan.conditions().size());
+    EXPECT_EQ(BSON("$where" << "this.z > 3").toString(), joinPlan.tables()[1]._filter.toString());
+    // the server gets the native form of a table's filter
+    EXPECT_EQ(BSON("z" << BSON("$gt" << 3)).toString(),
+              joinPlan.tables()[1].queryFilter().toString());
+
+    std::string residual = joinPlan.residual().toString();
+    EXPECT_NE(std::string::npos, residual.find("this.a.this.x < this.b.this.y"));
+    EXPECT_NE(std::string::npos, residual.find("$or"));
+
+    ASSERT_EQ(0, plan("SELECT * FROM db.a, db.b WHERE a.k = b.k", &joinPlan, &errmsg));
+    EXPECT_TRUE(joinPlan.residual().isEmpty());
+
+    ASSERT_EQ(0, plan("SELECT * FROM db.a, db.b WHERE a.k = b.k AND b.z + 1 > 3",
+                      &joinPlan, &errmsg)) << errmsg;
+    EXPECT_EQ(BSON("$where" << "this.z + 1 > 3").toString(),
+              joinPlan.tables()[1].queryFilter().toString());
+}
+
+TEST(JoinPlan, Errors)
+{
+    const char *queries[] = {
+        "SELECT * FROM db.a, db.b WHERE a.x < b.y + ?",
+        "SELECT * FROM db.a, db.b WHERE c.x = b.x",
+        "SELECT * FROM db.a, other.a",
+        "SELECT * FROM db.a JOIN db.b ON x = b.y",
+        "SELECT * FROM db.a JOIN db.b ON a.x = a.y",
+        "SELECT * FROM db.a JOIN db.b ON a.x = c.y"
+    };
+    for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); ++i) {
+        JoinPlan joinPlan;
+        std::string errmsg;
+        EXPECT_NE(0, plan(queries[i], &joinPlan, &errmsg)) << queries[i];
+        EXPECT_FALSE(errmsg.empty()) << queries[i];
+    }
+}
+
+TEST(JoinPlan, LookupPipeline)
+{
+    JoinPlan joinPlan;
+    std::string errmsg;
+    ASSERT_EQ(0, plan("SELECT * FROM shop.orders JOIN shop.customers ON orders.cust = customers.id"
+                      " WHERE total > 5 AND customers.age >= 30",
+                      &joinPlan, &errmsg)) << errmsg;
+    mongo::BSONObj pipeline;
+    ASSERT_EQ(0, joinPlan.lookupPipeline(&pipeline));
+
+    mongo::BSONObjBuilder ne;
+    ne.appendNull("$ne");
+    mongo::BSONArrayBuilder inner;
+    inner.append(BSON("$match" << BSON("$expr" << BSON("$and" << BSON_ARRAY(
+        BSON("$eq" << BSON_ARRAY("$id" << "$$k0")))))));
+    inner.append(BSON("$match" << BSON("age" << BSON("$gte" << 30))));
+    mongo::BSONArrayBuilder stages;
+    stages.append(BSON("$match" << BSON("total" << BSON("$gt" << 5))));
+    stages.append(BSON("$project" << BSON("_id" << 0 << "orders" << "$$ROOT")));
+    stages.append(BSON("$match" << BSON("orders.cust" << ne.obj())));
+    stages.append(BSON("$lookup" << BSON("from" << "customers"
+                                         << "let" << BSON("k0" << "$orders.cust")
+                                         << "pipeline" << inner.arr()
+                                         << "as" << "customers")));
+    stages.append(BSON("$unwind" << "$customers"));
+    EXPECT_EQ(stages.arr().toString(), pipeline.toString());
+}
+
+TEST(JoinPlan, NoLookupPipeline)
+{
+    const char *queries[] = {
+        "SELECT * FROM shop.orders, other.customers WHERE orders.cust = customers.id",
+        "SELECT * FROM shop.orders, shop.customers",
+        "SELECT * FROM shop.orders, shop.customers WHERE orders.cust = customers.id"
+        " AND customers.age = ?"
+    };
+    for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); ++i) {
+        JoinPlan joinPlan;
+        std::string errmsg;
+        ASSERT_EQ(0, plan(queries[i], &joinPlan, &errmsg)) << errmsg;
+        mongo::BSONObj pipeline;
+        EXPECT_NE(0, joinPlan.lookupPipeline(&pipeline)) << queries[i];
+    }
+}
+
+TEST(JoinPlan, PreferLookup)
+{
+    std::vector<unsigned long long> counts;
+    counts.push_back(100);
+    counts.push_back(1000000);
+    EXPECT_TRUE(JoinPlan::preferLookup(counts));
+    counts[0] = JoinPlan::LOOKUP_MAX_DRIVING_ROWS + 1;
+    EXPECT_FALSE(JoinPlan::preferLookup(counts));
+    counts[0] = 100;
+    counts[1] = 10;
+    EXPECT_FALSE(JoinPlan::preferLookup(counts));
+}
+
+TEST(JoinPlan, PreferIndexJoin)
+{
+    EXPECT_TRUE(JoinPlan::preferIndexJoin(100, 1000000));
+    EXPECT_TRUE(JoinPlan::preferIndexJoin(0, 0));
+    EXPECT_FALSE(JoinPlan::preferIndexJoin(100, 500));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
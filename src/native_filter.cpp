@@ -0,0 +1,246 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "native_filter.h"
+
+#include "sql_element_expression.h"
+
+#include <mongo/client/dbclient.h>
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <limits>
+#include <string>
+
+namespace {
+
+struct Comparison {
+    const char *_sql;
+    const char *_operator;
+    // comparison with the operands swapped
+    const char *_flipped;
+    // comparison holding when this one is false
+    const char *_negated;
+};
+
+const Comparison COMPARISONS[] = {
+    { "==", "$eq", "==", "!=" },
+    { "!=", "$ne", "!=", "==" },
+    { "<", "$lt", ">", ">=" },
+    { "<=", "$lte", ">=", ">" },
+    { ">", "$gt", "<", "<=" },
+    { ">=", "$gte", "<=", "<" }
+};
+
+const Comparison *findComparison(const std::string& op)
+{
+    for (size_t i = 0; i < sizeof(COMPARISONS) / sizeof(COMPARISONS[0]); ++i) {
+        if (op == COMPARISONS[i]._sql) {
+            return &COMPARISONS[i];
+        }
+    }
+    return 0;
+}
+
+/*
+* Sets 'field' for a column written 'this.<field>', where 'field' may be a
+* dotted path into embedded documents.  A single table's column written
+* 'this.<name>.this.<field>' is the path '<name>.<field>'.
+*/
+bool isColumn(const std::string& str, std::string *field)
+{
+    if (0 != str.compare(0, 5, "this.")) {
+        return false;
+    }
+    std::string path = str.substr(5);
+    size_t qualifierEnd = path.find(".this.");
+    if (std::string::npos != qualifierEnd) {
+        path.erase(qualifierEnd + 1, 5);
+    }
+    bool segmentStart = true;
+    for (size_t i = 0; i < path.size(); ++i) {
+        if ('.' == path[i] && !segmentStart) {
+            segmentStart = true;
+        } else if (isalnum((unsigned char)path[i]) || '_' == path[i]) {
+            segmentStart = false;
+        } else {
+            return false;
+        }
+    }
+    if (segmentStart) {
+        // empty, or an empty last segment
+        return false;
+    }
+    *field = path;
+    return true;
+}
+
+/*
+* Appends the literal 'str' as 'name' to 'builder', with the least value of
+* its type as 'lowestName' if that is not null.  Numbers are written in
+* digits and strings quoted, so a literal keeps the type it has in SQL.
+*/
+bool appendLiteral(const std::string& str,
+                   const char *name,
+                   const char *lowestName,
+                   mongo::BSONObjBuilder *builder)
+{
+    if (str.empty()) {
+        return false;
+    }
+
+    std::string value;
+    if (0 == mongoodbc::unquoteWhereString(str, &value)) {
+        builder->append(name, value);
+        if (lowestName) {
+            builder->append(lowestName, "");
+        }
+        return true;
+    }
+
+    size_t digits = ('-' == str[0] || '+' == str[0]) ? 1 : 0;
+    bool number = digits < str.size();
+    for (size_t i = digits; i < str.size(); ++i) {
+        number = number && isdigit((unsigned char)str[i]);
+    }
+    if (!number) {
+        return false;
+    }
+    long long num = strtoll(str.c_str(), 0, 10);
+    if (num == (int)num) {
+        builder->append(name, (int)num);
+    } else {
+        builder->append(name, num);
+    }
+    if (lowestName) {
+        builder->append(lowestName, -std::numeric_limits<double>::infinity());
+    }
+    return true;
+}
+
+int translateComparison(const std::string& expr, bool negated, mongo::BSONObj *filter)
+{
+    // '<column> <op> <literal>' or '<literal> <op> <column>'
+    std::string field;
+    std::string literal;
+    size_t first = expr.find(' ');
+    size_t last = expr.rfind(' ');
+    if (std::string::npos == first) {
+        return -1;
+    }
+    size_t second = expr.find(' ', first + 1);
+    size_t beforeLast = expr.rfind(' ', last - 1);
+    const Comparison *comparison;
+    if (isColumn(expr.substr(0, first), &field) && std::string::npos != second &&
+        (comparison = findComparison(expr.substr(first + 1, second - first - 1)))) {
+        literal = expr.substr(second + 1);
+    } else if (isColumn(expr.substr(last + 1), &field) && std::string::npos != beforeLast &&
+               (comparison = findComparison(expr.substr(beforeLast + 1, last - beforeLast - 1)))) {
+        literal = expr.substr(0, beforeLast);
+        comparison = findComparison(comparison->_flipped);
+    } else {
+        return -1;
+    }
+    if (negated) {
+        comparison = findComparison(comparison->_negated);
+    }
+
+    // the other comparisons only match values of the literal's type, but
+    // '$ne' also matches other types and missing or null fields, for which
+    // the comparison is unknown in SQL
+    const char *lowestName = 0 == strcmp("$ne", comparison->_operator) ? "$gte" : 0;
+    mongo::BSONObjBuilder predicate;
+    if (!appendLiteral(literal, comparison->_operator, lowestName, &predicate)) {
+        return -1;
+    }
+    mongo::BSONObjBuilder builder;
+    builder.append(field, predicate.obj());
+    *filter = builder.obj();
+    return 0;
+}
+
+int translate(const mongo::BSONObj& cond, bool negated, mongo::BSONObj *filter);
+
+int translateList(const mongo::BSONElement& list, bool negated, mongo::BSONObj *filter)
+{
+    if (mongo::Array != list.type()) {
+        return -1;
+    }
+    mongo::BSONArrayBuilder terms;
+    mongo::BSONObjIterator termIt(list.embeddedObject());
+    while (termIt.more()) {
+        mongo::BSONElement term = termIt.next();
+        mongo::BSONObj translated;
+        if (mongo::Object != term.type()
+            || 0 != translate(term.embeddedObject(), negated, &translated)) {
+            return -1;
+        }
+        terms.append(translated);
+    }
+    // the negation of a conjunction is the disjunction of the negated terms
+    bool isAnd = 0 == strcmp("$and", list.fieldName());
+    mongo::BSONObjBuilder builder;
+    builder.append(isAnd != negated ? "$and" : "$or", terms.arr());
+    *filter = builder.obj();
+    return 0;
+}
+
+/*
+* Translates 'cond', or its negation if 'negated'.  A negation is moved
+* down onto the comparisons rather than written as '$nor', which would match
+* the documents for which 'cond' is unknown.
+*/
+int translate(const mongo::BSONObj& cond, bool negated, mongo::BSONObj *filter)
+{
+    if (1 != cond.nFields()) {
+        return -1;
+    }
+
+    mongo::BSONElement elem = cond.firstElement();
+    if (0 == strcmp("$where", elem.fieldName()) && mongo::String == elem.type()) {
+        return translateComparison(elem.str(), negated, filter);
+    }
+    if (0 == strcmp("$and", elem.fieldName()) || 0 == strcmp("$or", elem.fieldName())) {
+        return translateList(elem, negated, filter);
+    }
+    if (0 == strcmp("$not", elem.fieldName()) && mongo::Object == elem.type()) {
+        return translate(elem.embeddedObject(), !negated, filter);
+    }
+    if ('$' != elem.fieldName()[0] && !negated) {
+        // a field's predicate, already translated
+        *filter = cond;
+        return 0;
+    }
+
+    return -1;
+}
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+int nativeFilter(const mongo::BSONObj& cond, mongo::BSONObj *filter)
+{
+    if (cond.isEmpty()) {
+        *filter = mongo::BSONObj();
+        return 0;
+    }
+    return translate(cond, false, filter);
+}
+
+} // close mongoodbc namespace
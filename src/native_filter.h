@@ -0,0 +1,41 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_NATIVE_FILTER_H_
+#define MONGOODBC_NATIVE_FILTER_H_
+
+#include <mongo/bson/bsonobj.h>
+
+namespace mongoodbc {
+
+/*
+* Translates a WHERE clause as built by the parsers, comparisons wrapped in
+* '$where', into query operators the server can also evaluate inside an
+* aggregation '$match', e.g. '{ $where: "this.age > 5" }' into
+* '{ age: { $gt: 5 } }'.
+*
+* Only comparisons between an unqualified column and a number or string
+* literal, combined with AND, OR and NOT, are translated.  As in SQL, a
+* comparison with a missing or null field, or with a value of another type
+* than the literal, is unknown: neither it nor its negation matches.
+* Conjuncts already translated, as 'splitResidual' pushes them, are kept.
+* @return 0 on success, -1 if any part of 'cond' cannot be translated
+*/
+int nativeFilter(const mongo::BSONObj& cond, mongo::BSONObj *filter);
+
+} // close mongoodbc namespace
+
+#endif
@@ -0,0 +1,130 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "native_filter.h"
+
+#include "sql_fast_parser.h"
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <string>
+
+namespace {
+
+std::string translate(const std::string& where)
+{
+    mongoodbc::SQLSelectStatement stmt;
+    std::string sql("SELECT * FROM db.coll WHERE " + where);
+    if (0 != mongoodbc::SQLFastParser::parse(sql, &stmt, 0)) {
+        return "parse error";
+    }
+    mongo::BSONObj filter;
+    if (0 != mongoodbc::nativeFilter(stmt._whereClause->obj, &filter)) {
+        return "untranslatable";
+    }
+    return filter.toString();
+}
+
+const double MIN_NUMBER = -std::numeric_limits<double>::infinity();
+
+} // close unnamed namespace
+
+TEST(NativeFilter, Comparisons)
+{
+    EXPECT_EQ(BSON("age" << BSON("$gt" << 5)).toString(), translate("age > 5"));
+    EXPECT_EQ(BSON("age" << BSON("$eq" << -5)).toString(), translate("age = -5"));
+    EXPECT_EQ(BSON("age" << BSON("$gte" << 7)).toString(), translate("7 <= age"));
+    EXPECT_EQ(BSON("n" << BSON("$lt" << 5000000000LL)).toString(), translate("n < 5000000000"));
+}
+
+TEST(NativeFilter, Strings)
+{
+    // strings stay strings, however they look
+    EXPECT_EQ(BSON("zip" << BSON("$eq" << "02134")).toString(), translate("zip = '02134'"));
+    EXPECT_EQ(BSON("a" << BSON("$eq" << "x + y")).toString(), translate("a = 'x + y'"));
+    EXPECT_EQ(BSON("a" << BSON("$lt" << "say \"hi\"")).toString(),
+              translate("'say \"hi\"' > a"));
+    EXPECT_EQ(BSON("a" << BSON("$eq" << "this.b")).toString(), translate("a = 'this.b'"));
+}
+
+TEST(NativeFilter, Unknown)
+{
+    // '<>' and NOT do not match missing or null fields, nor other types
+    EXPECT_EQ(BSON("name" << BSON("$ne" << "bob" << "$gte" << "")).toString(),
+              translate("name <> 'bob'"));
+    EXPECT_EQ(BSON("a" << BSON("$ne" << 1 << "$gte" << MIN_NUMBER)).toString(),
+              translate("NOT a = 1"));
+    EXPECT_EQ(BSON("a" << BSON("$gte" << 1)).toString(), translate("NOT a < 1"));
+    EXPECT_EQ(BSON("a" << BSON("$eq" << 1)).toString(), translate("NOT NOT a = 1"));
+    EXPECT_EQ(BSON("a" << BSON("$lt" << 5)).toString(), translate("NOT 5 <= a"));
+}
+
+TEST(NativeFilter, Conditions)
+{
+    mongo::BSONArrayBuilder terms;
+    terms.append(BSON("a" << BSON("$eq" << 1)));
+    terms.append(BSON("b" << BSON("$lt" << 2)));
+    EXPECT_EQ(BSON("$or" << terms.arr()).toString(), translate("a = 1 OR b < 2"));
+
+    // a negated condition is the condition of the negated comparisons
+    mongo::BSONArrayBuilder negated;
+    negated.append(BSON("a" << BSON("$ne" << 1 << "$gte" << MIN_NUMBER)));
+    negated.append(BSON("b" << BSON("$gte" << 2)));
+    EXPECT_EQ(BSON("$and" << negated.arr()).toString(), translate("NOT (a = 1 OR b < 2)"));
+
+    mongo::BSONObj empty;
+    EXPECT_EQ(0, mongoodbc::nativeFilter(mongo::BSONObj(), &empty));
+    EXPECT_TRUE(empty.isEmpty());
+}
+
+TEST(NativeFilter, Translated)
+{
+    // conjuncts pushed by 'splitResidual' may already be translated
+    mongo::BSONArrayBuilder mixed;
+    mixed.append(BSON("a" << BSON("$gt" << 1)));
+    mixed.append(BSON("$where" << "this.b == 2"));
+    mongo::BSONArrayBuilder expected;
+    expected.append(BSON("a" << BSON("$gt" << 1)));
+    expected.append(BSON("b" << BSON("$eq" << 2)));
+    mongo::BSONObj filter;
+    ASSERT_EQ(0, mongoodbc::nativeFilter(BSON("$and" << mixed.arr()), &filter));
+    EXPECT_EQ(BSON("$and" << expected.arr()).toString(), filter.toString());
+
+    EXPECT_EQ(-1, mongoodbc::nativeFilter(BSON("$not" << BSON("a" << BSON("$gt" << 1))), &filter));
+}
+
+TEST(NativeFilter, Paths)
+{
+    EXPECT_EQ(BSON("address.city" << BSON("$eq" << "x")).toString(),
+              translate("address.city = 'x'"));
+    EXPECT_EQ(BSON("t.geo.lat" << BSON("$gt" << 1)).toString(), translate("t.geo.lat > 1"));
+}
+
+TEST(NativeFilter, Untranslatable)
+{
+    EXPECT_EQ("untranslatable", translate("a = b"));
+    EXPECT_EQ("untranslatable", translate("a + 1 = 2"));
+    EXPECT_EQ("untranslatable", translate("a = ?"));
+    EXPECT_EQ("untranslatable", translate("a.b = c"));
+    EXPECT_EQ("untranslatable", translate("a = 1 AND b = c"));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -20,6 +20,8 @@
 #include <environment_handle.h>
 #include <statement_handle.h>
 
+#include <boost/thread/locks.hpp>
+
 #include <iostream>
 #include <list>
 #include <map>
@@ -36,15 +38,11 @@ SQLGetEnvAttr(SQLHENV environmentHandle,
 {
     mongoodbc::EnvironmentHandle *env =
         static_cast<mongoodbc::EnvironmentHandle *> (environmentHandle);
-    switch(attribute) {
-      case SQL_ATTR_ODBC_VERSION: {
-        *(SQLINTEGER *)valuePtr = SQL_OV_ODBC3;
-      } break;
-      default: {
-      } break;
-    }
 
-    return SQL_SUCCESS;
+    return env->sqlGetEnvAttr(attribute,
+                              valuePtr,
+                              bufferLength,
+                              stringLenPtr);
 }
 
 SQLRETURN SQLSetEnvAttr(SQLHENV environmentHandle,
@@ -52,7 +50,24 @@ SQLRETURN SQLSetEnvAttr(SQLHENV environmentHandle,
                         SQLPOINTER valuePtr,
                         SQLINTEGER stringLen)
 {
-    return SQL_SUCCESS;
+    if (SQL_NULL_HANDLE == environmentHandle) {
+        // process level setting for environments allocated from now on
+        if (SQL_ATTR_CONNECTION_POOLING == attribute) {
+            if (0 != mongoodbc::EnvironmentHandle::setDefaultConnectionPooling(
+                         (SQLUINTEGER)(SQLULEN)valuePtr)) {
+                return SQL_ERROR;
+            }
+            return SQL_SUCCESS;
+        }
+        return SQL_ERROR;
+    }
+
+    mongoodbc::EnvironmentHandle *env =
+        static_cast<mongoodbc::EnvironmentHandle *> (environmentHandle);
+
+    return env->sqlSetEnvAttr(attribute,
+                              valuePtr,
+                              stringLen);
 }
 
 SQLRETURN SQL_API
@@ -62,7 +77,29 @@ SQLGetStmtAttr(SQLHSTMT stmtHandle,
 	           SQLINTEGER bufferLength,
                SQLINTEGER *stringLenPtr)
 {
-    return SQL_ERROR;
+    mongoodbc::StatementHandle *stmt =
+        static_cast<mongoodbc::StatementHandle *> (stmtHandle);
+    boost::lock_guard<boost::mutex> lock(stmt->mutex());
+
+    return stmt->sqlGetStmtAttr(attribute,
+                                valuePtr,
+                                bufferLength,
+                                stringLenPtr);
+}
+
+SQLRETURN SQL_API
+SQLSetStmtAttr(SQLHSTMT stmtHandle,
+               SQLINTEGER attribute,
+               SQLPOINTER valuePtr,
+               SQLINTEGER stringLen)
+{
+    mongoodbc::StatementHandle *stmt =
+        static_cast<mongoodbc::StatementHandle *> (stmtHandle);
+    boost::lock_guard<boost::mutex> lock(stmt->mutex());
+
+    return stmt->sqlSetStmtAttr(attribute,
+                                valuePtr,
+                                stringLen);
 }
 
 SQLRETURN SQL_API
@@ -91,6 +128,10 @@ SQLGetInfo(SQLHDBC connHandle,
 SQLRETURN SQL_API
 SQLDisconnect(SQLHDBC dbc)
 {
+    mongoodbc::ConnectionHandle *conn =
+        static_cast<mongoodbc::ConnectionHandle *> (dbc);
+    conn->disconnect();
+
     return SQL_SUCCESS;
 }
 
@@ -177,7 +218,17 @@ SQLDriverConnect(SQLHDBC connectionHandle,
 
     mongoodbc::ConnectionHandle *conn =
         static_cast<mongoodbc::ConnectionHandle *> (connectionHandle);
-    conn->connect();
+    std::string connectString;
+    if (NULL != inConnectString) {
+        if (inConnectStringLen == SQL_NTS) {
+            connectString.assign((char *)inConnectString);
+        } else {
+            connectString.assign((char *)inConnectString, (int)inConnectStringLen);
+        }
+    }
+    if (0 != conn->connect(connectString)) {
+        return SQL_ERROR;
+    }
 
     *outConnectStringLen = 0;
 
@@ -200,6 +251,7 @@ SQLTables(SQLHSTMT statementHandle,
 
     mongoodbc::StatementHandle *stmt =
         static_cast<mongoodbc::StatementHandle *> (statementHandle);
+    boost::lock_guard<boost::mutex> lock(stmt->mutex());
 
     return stmt->sqlTables(catalogName,
                            catalogNameLen,
@@ -225,6 +277,7 @@ SQLColumns(SQLHSTMT statementHandle,
 
     mongoodbc::StatementHandle *stmt =
         static_cast<mongoodbc::StatementHandle *> (statementHandle);
+    boost::lock_guard<boost::mutex> lock(stmt->mutex());
 
     return stmt->sqlColumns(catalogName,
                             catalogNameLen,
@@ -243,6 +296,7 @@ SQLExecDirect(SQLHSTMT statementHandle,
 {
     mongoodbc::StatementHandle *stmt =
         static_cast<mongoodbc::StatementHandle *> (statementHandle);
+    boost::lock_guard<boost::mutex> lock(stmt->mutex());
     
     return stmt->sqlExec(query, queryLen);
 }
@@ -253,6 +307,7 @@ SQLNumResultCols(SQLHSTMT statementHandle,
 {
     mongoodbc::StatementHandle *stmt =
         static_cast<mongoodbc::StatementHandle *> (statementHandle);
+    boost::lock_guard<boost::mutex> lock(stmt->mutex());
     
     return stmt->sqlNumResultCols(numColumns);
 }
@@ -262,6 +317,7 @@ SQLFetch(SQLHSTMT statementHandle)
 {
     mongoodbc::StatementHandle *stmt =
         static_cast<mongoodbc::StatementHandle *> (statementHandle);
+    boost::lock_guard<boost::mutex> lock(stmt->mutex());
     
     return stmt->sqlFetch();
 }
@@ -276,6 +332,7 @@ SQLGetData(SQLHSTMT statementHandle,
 {
     mongoodbc::StatementHandle *stmt =
         static_cast<mongoodbc::StatementHandle *> (statementHandle);
+    boost::lock_guard<boost::mutex> lock(stmt->mutex());
     
     return stmt->sqlGetData(columnNum,
                             type,
@@ -405,7 +462,7 @@ SQLRETURN SQL_API
 SQLCopyDesc(SQLHDESC source, SQLHDESC target);
 
 SQLRETURN SQL_API
-SQLNativeSql(SQLHSTMT stmt, SQLCHAR *sqlin, SQLINTEGER sqlinLen,
+SQLNativeSql(SQLHDBC dbc, SQLCHAR *sqlin, SQLINTEGER sqlinLen,
 	     SQLCHAR *sql, SQLINTEGER sqlMax, SQLINTEGER *sqlLen);
 
 SQLRETURN SQL_API
@@ -426,10 +483,6 @@ SQLGetDiagField(SQLSMALLINT htype, SQLHANDLE handle, SQLSMALLINT recno,
 		SQLSMALLINT id, SQLPOINTER info, 
 		SQLSMALLINT buflen, SQLSMALLINT *stringlen);
 
-SQLRETURN SQL_API
-SQLSetStmtAttr(SQLHSTMT stmt, SQLINTEGER attr, SQLPOINTER val,
-	       SQLINTEGER buflen);
-
 SQLRETURN SQL_API
 SQLSetPos(SQLHSTMT stmt, SQLSETPOSIROW row, SQLUSMALLINT op, SQLUSMALLINT lock);
 
@@ -696,14 +749,16 @@ SQLColumnPrivileges(SQLHSTMT stmt,
 }
 
 SQLRETURN SQL_API
-SQLPrimaryKeys(SQLHSTMT stmt,
+SQLPrimaryKeys(SQLHSTMT statementHandle,
 	       SQLCHAR *cat, SQLSMALLINT catLen,
 	       SQLCHAR *schema, SQLSMALLINT schemaLen,
 	       SQLCHAR *table, SQLSMALLINT tableLen)
 {
-    assert(0);
-    std::cout << "SQLPrimaryKeys" << std::endl;
-    return 0;
+    mongoodbc::StatementHandle *stmt =
+        static_cast<mongoodbc::StatementHandle *> (statementHandle);
+    boost::lock_guard<boost::mutex> lock(stmt->mutex());
+
+    return stmt->sqlPrimaryKeys(cat, catLen, schema, schemaLen, table, tableLen);
 }
 
 SQLRETURN SQL_API
@@ -757,12 +812,15 @@ SQLCopyDesc(SQLHDESC source, SQLHDESC target)
 }
 
 SQLRETURN SQL_API
-SQLNativeSql(SQLHSTMT stmt, SQLCHAR *sqlin, SQLINTEGER sqlinLen,
+SQLNativeSql(SQLHDBC dbc, SQLCHAR *sqlin, SQLINTEGER sqlinLen,
 	     SQLCHAR *sql, SQLINTEGER sqlMax, SQLINTEGER *sqlLen)
 {
-    assert(0);
-    std::cout << "SQLNativeSql" << std::endl;
-    return 0;
+    mongoodbc::ConnectionHandle *conn =
+        static_cast<mongoodbc::ConnectionHandle *> (dbc);
+    // translated the way a statement of the connection executes it
+    mongoodbc::StatementHandle stmt(conn);
+
+    return stmt.sqlNativeSql(sqlin, sqlinLen, sql, sqlMax, sqlLen);
 }
 
 SQLRETURN SQL_API
@@ -793,18 +851,15 @@ SQLGetDiagField(SQLSMALLINT htype, SQLHANDLE handle, SQLSMALLINT recno,
 		SQLSMALLINT id, SQLPOINTER info, 
 		SQLSMALLINT buflen, SQLSMALLINT *stringlen)
 {
-    assert(0);
-    std::cout << "SQLGetDiagField" << std::endl;
-    return 0;
-}
+    if (SQL_HANDLE_STMT != htype || 0 != recno) {
+        // only the header fields of statements are kept
+        return SQL_NO_DATA;
+    }
+    mongoodbc::StatementHandle *stmt =
+        static_cast<mongoodbc::StatementHandle *> (handle);
+    boost::lock_guard<boost::mutex> lock(stmt->mutex());
 
-SQLRETURN SQL_API
-SQLSetStmtAttr(SQLHSTMT stmt, SQLINTEGER attr, SQLPOINTER val,
-	       SQLINTEGER buflen)
-{
-    assert(0);
-    std::cout << "SQLSetStmtAttr" << std::endl;
-    return 0;
+    return stmt->sqlGetDiagField(id, info);
 }
 
 SQLRETURN SQL_API
@@ -909,14 +964,16 @@ SQLGetTypeInfo(SQLHSTMT stmt, SQLSMALLINT sqltype)
 }
 
 SQLRETURN SQL_API
-SQLStatistics(SQLHSTMT stmt, SQLCHAR *cat, SQLSMALLINT catLen,
+SQLStatistics(SQLHSTMT statementHandle, SQLCHAR *cat, SQLSMALLINT catLen,
 	      SQLCHAR *schema, SQLSMALLINT schemaLen,
 	      SQLCHAR *table, SQLSMALLINT tableLen,
 	      SQLUSMALLINT itype, SQLUSMALLINT resv)
 {
-    assert(0);
-    std::cout << "SQLStatistics" << std::endl;
-    return 0;
+    mongoodbc::StatementHandle *stmt =
+        static_cast<mongoodbc::StatementHandle *> (statementHandle);
+    boost::lock_guard<boost::mutex> lock(stmt->mutex());
+
+    return stmt->sqlStatistics(cat, catLen, schema, schemaLen, table, tableLen, itype, resv);
 }
 
 SQLRETURN SQL_API
@@ -928,11 +985,13 @@ SQLFetchScroll(SQLHSTMT stmt, SQLSMALLINT orient, SQLLEN offset)
 }
 
 SQLRETURN SQL_API
-SQLRowCount(SQLHSTMT stmt, SQLLEN *nrows)
+SQLRowCount(SQLHSTMT statementHandle, SQLLEN *nrows)
 {
-    assert(0);
-    std::cout << "SQLRowCount" << std::endl;
-    return 0;
+    mongoodbc::StatementHandle *stmt =
+        static_cast<mongoodbc::StatementHandle *> (statementHandle);
+    boost::lock_guard<boost::mutex> lock(stmt->mutex());
+
+    return stmt->sqlRowCount(nrows);
 }
 
 SQLRETURN SQL_API
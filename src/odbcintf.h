@@ -21,6 +21,25 @@
 #include <sql.h>
 #include <sqlext.h>
 
+// Driver specific statement attributes
+
+// Number of concurrent cursors used to scan a collection, 0 or 1 for a
+// single cursor.  Rows are returned in no particular order when enabled.
+#define SQL_ATTR_MONGOODBC_PARALLEL_SCAN (SQL_DRIVER_STMT_ATTR_BASE + 1)
+// Read only, number of bytes the sort and GROUP BY of the last executed
+// statement wrote to temporary files.
+#define SQL_ATTR_MONGOODBC_SORT_SPILLED_BYTES (SQL_DRIVER_STMT_ATTR_BASE + 2)
+
+// Driver specific environment attributes.  ODBC reserves no range for these,
+// so they share the driver connection attribute range.
+
+// Memory cap in bytes of the environment's cache of parsed statements, 0 to
+// disable it.
+#define SQL_ATTR_MONGOODBC_PLAN_CACHE_SIZE (SQL_DRIVER_CONN_ATTR_BASE + 1)
+// Read only, number of statements found in and missing from the plan cache.
+#define SQL_ATTR_MONGOODBC_PLAN_CACHE_HITS (SQL_DRIVER_CONN_ATTR_BASE + 2)
+#define SQL_ATTR_MONGOODBC_PLAN_CACHE_MISSES (SQL_DRIVER_CONN_ATTR_BASE + 3)
+
 extern "C" {
 
 SQLRETURN SQL_API
@@ -42,6 +61,12 @@ SQLGetStmtAttr(SQLHSTMT stmtHandle,
 	           SQLINTEGER bufferLength,
                SQLINTEGER *stringLenPtr);
 
+SQLRETURN SQL_API
+SQLSetStmtAttr(SQLHSTMT stmtHandle,
+               SQLINTEGER attribute,
+               SQLPOINTER valuePtr,
+               SQLINTEGER stringLen);
+
 SQLRETURN SQL_API
 SQLGetDiagRec(SQLSMALLINT handleType,
               SQLHANDLE handle,
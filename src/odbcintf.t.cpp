@@ -93,6 +93,26 @@ class ODBCIntfTest : public ::testing::Test {
     SQLHSTMT _stmtHandle;
 };
 
+TEST_F(ODBCIntfTest, Reconnect)
+{
+    // the second connect is served from the environment's connection pool
+    SQLRETURN ret = SQLFreeHandle(SQL_HANDLE_STMT, _stmtHandle);
+    ASSERT_TRUE(SQL_SUCCEEDED(ret));
+    ret = SQLDisconnect(_dbHandle);
+    ASSERT_TRUE(SQL_SUCCEEDED(ret));
+
+    SQLCHAR outstr[1024];
+    SQLSMALLINT outstrlen;
+    SQLCHAR *dsn = (SQLCHAR *)"DSN=MongoDB";
+    ret = SQLDriverConnect(_dbHandle, NULL, dsn ,SQL_NTS, outstr, sizeof(outstr), &outstrlen, SQL_DRIVER_COMPLETE);
+    ASSERT_TRUE(SQL_SUCCEEDED(ret));
+    ret = SQLAllocHandle(SQL_HANDLE_STMT, _dbHandle, &_stmtHandle);
+    ASSERT_TRUE(SQL_SUCCEEDED(ret));
+
+    ret = SQLTables(_stmtHandle, NULL, 0, NULL, 0, NULL, 0, (SQLCHAR*)"TABLE", SQL_NTS);
+    EXPECT_TRUE(SQL_SUCCEEDED(ret));
+}
+
 class SQLTablesTest : public ODBCIntfTest {
   protected:
     enum {
@@ -489,6 +509,102 @@ TEST_F(SQLExecDirectTest, SELECT_WHERE_OR)
     }
 }
 
+TEST_F(SQLExecDirectTest, InterleavedStatements)
+{
+    // two cursors open on one connection at the same time
+    std::string collection = _collections.begin()->first;
+    std::string query = "SELECT * FROM " + collection;
+
+    SQLHSTMT otherHandle;
+    SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_STMT, _dbHandle, &otherHandle);
+    ASSERT_TRUE(SQL_SUCCEEDED(ret));
+
+    ret = SQLExecDirect(_stmtHandle, (SQLCHAR *)query.c_str(), SQL_NTS);
+    EXPECT_EQ(SQL_SUCCESS, ret);
+    ret = SQLExecDirect(otherHandle, (SQLCHAR *)query.c_str(), SQL_NTS);
+    EXPECT_EQ(SQL_SUCCESS, ret);
+
+    for (int i = 0; i < 5; ++i) {
+        SQLLEN len;
+        unsigned long int value;
+        unsigned long int otherValue;
+        ASSERT_EQ(SQL_SUCCESS, SQLFetch(_stmtHandle));
+        ASSERT_EQ(SQL_SUCCESS, SQLFetch(otherHandle));
+        SQLGetData(_stmtHandle, 1, SQL_C_ULONG, (SQLPOINTER)&value, sizeof(unsigned long int), &len);
+        SQLGetData(otherHandle, 1, SQL_C_ULONG, (SQLPOINTER)&otherValue, sizeof(unsigned long int), &len);
+        EXPECT_EQ(i, value);
+        EXPECT_EQ(i, otherValue);
+    }
+    EXPECT_EQ(SQL_NO_DATA, SQLFetch(_stmtHandle));
+    EXPECT_EQ(SQL_NO_DATA, SQLFetch(otherHandle));
+
+    ret = SQLFreeHandle(SQL_HANDLE_STMT, otherHandle);
+    EXPECT_TRUE(SQL_SUCCEEDED(ret));
+}
+
+TEST_F(SQLExecDirectTest, SQLStatistics)
+{
+    // the table statistics row, then the '_id' key of the '_id_' index
+    std::string collection = _collections.begin()->first;
+    std::string::size_type dot = collection.find('.');
+    std::string schema = collection.substr(0, dot);
+    std::string table = collection.substr(dot + 1);
+
+    SQLRETURN ret = SQLStatistics(_stmtHandle, NULL, 0,
+                                  (SQLCHAR *)schema.c_str(), SQL_NTS,
+                                  (SQLCHAR *)table.c_str(), SQL_NTS,
+                                  SQL_INDEX_UNIQUE, SQL_ENSURE);
+    ASSERT_EQ(SQL_SUCCESS, ret);
+
+    SQLLEN len;
+    char buf[256];
+    SQLSMALLINT smallValue;
+    SQLINTEGER value;
+    ASSERT_EQ(SQL_SUCCESS, SQLFetch(_stmtHandle));
+    ret = SQLGetData(_stmtHandle, 7, SQL_C_CHAR, buf, sizeof(buf), &len);
+    EXPECT_EQ(SQL_SUCCESS, ret);
+    EXPECT_EQ(SQL_TABLE_STAT, atoi(buf));
+    ret = SQLGetData(_stmtHandle, 7, SQL_C_SSHORT, &smallValue, sizeof(smallValue), &len);
+    EXPECT_EQ(SQL_SUCCESS, ret);
+    EXPECT_EQ(SQL_TABLE_STAT, smallValue);
+    ret = SQLGetData(_stmtHandle, 11, SQL_C_CHAR, buf, sizeof(buf), &len);
+    EXPECT_EQ(SQL_SUCCESS, ret);
+    EXPECT_STREQ("5", buf);
+    ret = SQLGetData(_stmtHandle, 11, SQL_C_SLONG, &value, sizeof(value), &len);
+    EXPECT_EQ(SQL_SUCCESS, ret);
+    EXPECT_EQ(5, value);
+    ret = SQLGetData(_stmtHandle, 12, SQL_C_SLONG, &value, sizeof(value), &len);
+    EXPECT_EQ(SQL_SUCCESS, ret);
+    EXPECT_LE(0, value);
+    ret = SQLGetData(_stmtHandle, 8, SQL_C_SSHORT, &smallValue, sizeof(smallValue), &len);
+    EXPECT_EQ(SQL_SUCCESS, ret);
+    EXPECT_EQ(SQL_NULL_DATA, len);
+
+    ASSERT_EQ(SQL_SUCCESS, SQLFetch(_stmtHandle));
+    ret = SQLGetData(_stmtHandle, 4, SQL_C_SSHORT, &smallValue, sizeof(smallValue), &len);
+    EXPECT_EQ(SQL_SUCCESS, ret);
+    EXPECT_EQ(SQL_FALSE, smallValue);
+    ret = SQLGetData(_stmtHandle, 4, SQL_C_CHAR, buf, sizeof(buf), &len);
+    EXPECT_EQ(SQL_SUCCESS, ret);
+    EXPECT_STREQ("0", buf);
+    ret = SQLGetData(_stmtHandle, 7, SQL_C_SSHORT, &smallValue, sizeof(smallValue), &len);
+    EXPECT_EQ(SQL_SUCCESS, ret);
+    EXPECT_EQ(SQL_INDEX_OTHER, smallValue);
+    ret = SQLGetData(_stmtHandle, 8, SQL_C_CHAR, buf, sizeof(buf), &len);
+    EXPECT_EQ(SQL_SUCCESS, ret);
+    EXPECT_STREQ("1", buf);
+    ret = SQLGetData(_stmtHandle, 8, SQL_C_SLONG, &value, sizeof(value), &len);
+    EXPECT_EQ(SQL_SUCCESS, ret);
+    EXPECT_EQ(1, value);
+    ret = SQLGetData(_stmtHandle, 11, SQL_C_SLONG, &value, sizeof(value), &len);
+    EXPECT_EQ(SQL_SUCCESS, ret);
+    EXPECT_EQ(5, value);
+    ret = SQLGetData(_stmtHandle, 12, SQL_C_CHAR, buf, sizeof(buf), &len);
+    EXPECT_EQ(SQL_SUCCESS, ret);
+
+    EXPECT_EQ(SQL_NO_DATA, SQLFetch(_stmtHandle));
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
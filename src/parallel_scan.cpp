@@ -0,0 +1,268 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "parallel_scan.h"
+#include "connection_handle.h"
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// aim for several partitions per worker so fast workers can steal work
+const int PARTITIONS_PER_WORKER = 4;
+
+// collections smaller than this are not worth splitting
+const long long MIN_PARTITION_BYTES = 1024 * 1024;
+
+// queued batches per worker before workers block
+const size_t QUEUED_BATCHES_PER_WORKER = 2;
+
+/*
+* Returns the query for the documents matching 'filter' whose '_id' is at
+* least 'lower' and below 'upper', unbounded where empty.  The range is
+* given as bounds of the '_id' index, which order keys of any type, where
+* '$gte' and '$lt' would only match '_id's of the split keys' type.
+*/
+mongo::Query rangeQuery(const mongo::BSONObj& filter,
+                        const mongo::BSONObj& lower,
+                        const mongo::BSONObj& upper)
+{
+    mongo::Query query(filter.getOwned());
+    mongo::BSONObjBuilder idIndex;
+    idIndex.append("_id", 1);
+    query.hint(idIndex.obj());
+    if (!lower.isEmpty()) {
+        query.minKey(lower);
+    }
+    if (!upper.isEmpty()) {
+        query.maxKey(upper);
+    }
+    return query;
+}
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+ParallelScanRowSource::ParallelScanRowSource(ConnectionHandle *connHandle,
+                                             const std::string& ns,
+                                             const mongo::BSONObj& filter,
+                                             int degree,
+                                             int batchSize)
+    : _connHandle(connHandle)
+    , _ns(ns)
+    , _batchSize(batchSize)
+    , _nextPartition(0)
+    , _maxQueued(QUEUED_BATCHES_PER_WORKER * std::max(degree, 1))
+    , _activeWorkers(0)
+    , _cancelled(false)
+    , _currentIdx(0)
+{
+    partition(filter, std::max(degree, 1));
+
+    int numWorkers = std::min(std::max(degree, 1), (int)_partitions.size());
+    try {
+        for (int i = 0; i < numWorkers; ++i) {
+            // counted before the worker can finish
+            boost::lock_guard<boost::mutex> lock(_mutex);
+            _workers.create_thread(boost::bind(&ParallelScanRowSource::scan, this));
+            ++_activeWorkers;
+        }
+    } catch (...) {
+        // the destructor does not run, stop the workers already started
+        stop();
+        throw;
+    }
+}
+
+ParallelScanRowSource::~ParallelScanRowSource()
+{
+    stop();
+}
+
+void ParallelScanRowSource::stop()
+{
+    {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        _cancelled = true;
+    }
+    _spaceReady.notify_all();
+    _workers.join_all();
+}
+
+void ParallelScanRowSource::partition(const mongo::BSONObj& filter, int degree)
+{
+    size_t periodIdx = _ns.find('.');
+    std::string db(_ns, 0, periodIdx);
+    std::string collection(_ns, periodIdx + 1);
+
+    std::vector<mongo::BSONObj> splitKeys;
+    mongo::BSONObj stats;
+    mongo::BSONObjBuilder collStats;
+    collStats.append("collStats", collection);
+    if (degree > 1 &&
+        0 == _connHandle->runCommand(db, collStats.obj(), &stats) &&
+        stats["size"].number() >= 2 * MIN_PARTITION_BYTES) {
+        long long chunkBytes = std::max(
+            (long long)stats["size"].number() / (degree * PARTITIONS_PER_WORKER),
+            MIN_PARTITION_BYTES);
+        mongo::BSONObjBuilder keyPattern;
+        keyPattern.append("_id", 1);
+        mongo::BSONObjBuilder splitVector;
+        splitVector.append("splitVector", _ns);
+        splitVector.append("keyPattern", keyPattern.obj());
+        splitVector.append("maxChunkSizeBytes", chunkBytes);
+        mongo::BSONObj info;
+        if (0 == _connHandle->runCommand(db, splitVector.obj(), &info)) {
+            std::vector<mongo::BSONElement> keys = info["splitKeys"].Array();
+            for (size_t i = 0; i < keys.size(); ++i) {
+                splitKeys.push_back(keys[i].Obj().getOwned());
+            }
+        }
+        // without split points the whole collection is one partition
+    }
+
+    // the first and last ranges are open, so every '_id' is in one
+    mongo::BSONObj lower;
+    for (size_t i = 0; i < splitKeys.size(); ++i) {
+        _partitions.push_back(rangeQuery(filter, lower, splitKeys[i]));
+        lower = splitKeys[i];
+    }
+    if (splitKeys.empty()) {
+        _partitions.push_back(mongo::Query(filter.getOwned()));
+    } else {
+        _partitions.push_back(rangeQuery(filter, lower, mongo::BSONObj()));
+    }
+}
+
+bool ParallelScanRowSource::takePartition(mongo::Query *query)
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    if (_cancelled || _nextPartition >= _partitions.size()) {
+        return false;
+    }
+    *query = _partitions[_nextPartition++];
+    return true;
+}
+
+bool ParallelScanRowSource::push(Batch *batch)
+{
+    boost::unique_lock<boost::mutex> lock(_mutex);
+    while (!_cancelled && _queue.size() >= _maxQueued) {
+        _spaceReady.wait(lock);
+    }
+    if (_cancelled) {
+        return false;
+    }
+    _queue.push_back(Batch());
+    _queue.back().swap(*batch);
+    _batchReady.notify_one();
+    return true;
+}
+
+void ParallelScanRowSource::finishWorker(const std::string& error)
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    if (!error.empty() && _error.empty()) {
+        _error = error;
+        // stop the remaining workers, the result is incomplete anyway
+        _cancelled = true;
+        _spaceReady.notify_all();
+    }
+    --_activeWorkers;
+    _batchReady.notify_all();
+}
+
+void ParallelScanRowSource::scan()
+{
+    ScopedConnection scopedConn(_connHandle);
+    mongo::DBClientBase *conn = scopedConn.get();
+    if (!conn) {
+        finishWorker("parallel scan could not open a connection");
+        return;
+    }
+
+    try {
+        mongo::Query query;
+        while (takePartition(&query)) {
+            std::auto_ptr<mongo::DBClientCursor> cursor =
+                _connHandle->query(conn,
+                                   _ns,
+                                   query,
+                                   0,
+                                   0,
+                                   0,
+                                   0,
+                                   _batchSize);
+            if (!cursor.get()) {
+                finishWorker("parallel scan query failed");
+                return;
+            }
+            Batch batch;
+            while (cursor->more()) {
+                batch.push_back(cursor->next().getOwned());
+                if (!cursor->moreInCurrentBatch() && !push(&batch)) {
+                    finishWorker(std::string());
+                    return;
+                }
+            }
+            if (!batch.empty() && !push(&batch)) {
+                finishWorker(std::string());
+                return;
+            }
+        }
+    } catch (const std::exception& ex) {
+        finishWorker(std::string("parallel scan failed: ") + ex.what());
+        return;
+    }
+
+    finishWorker(std::string());
+}
+
+bool ParallelScanRowSource::more()
+{
+    if (_currentIdx < _current.size()) {
+        return true;
+    }
+
+    boost::unique_lock<boost::mutex> lock(_mutex);
+    while (_queue.empty() && _activeWorkers > 0) {
+        _batchReady.wait(lock);
+    }
+    if (!_error.empty()) {
+        throw std::runtime_error(_error);
+    }
+    if (_queue.empty()) {
+        return false;
+    }
+    _current.clear();
+    _current.swap(_queue.front());
+    _queue.pop_front();
+    _currentIdx = 0;
+    _spaceReady.notify_one();
+
+    return true;
+}
+
+mongo::BSONObj ParallelScanRowSource::next()
+{
+    return _current[_currentIdx++];
+}
+
+} // close mongoodbc namespace
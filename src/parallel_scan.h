@@ -0,0 +1,111 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_PARALLEL_SCAN_H_
+#define MONGOODBC_PARALLEL_SCAN_H_
+
+#include "row_source.h"
+
+#include <mongo/client/dbclient.h>
+#include <mongo/bson/bsonobj.h>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace mongoodbc {
+
+class ConnectionHandle;
+
+/*
+* Row source scanning one collection with several concurrent cursors.
+*
+* The collection is split into '_id' ranges using the 'splitVector' command,
+* each read through the '_id' index between its bounds.
+* Worker threads each take a connection from the connection handle, scan one
+* range at a time and queue every batch they receive.  Batches are handed out
+* in arrival order, so no ordering of the result is preserved.
+*/
+class ParallelScanRowSource : public RowSource {
+    typedef std::vector<mongo::BSONObj> Batch;
+
+    // held, not owned
+    ConnectionHandle *_connHandle;
+    std::string _ns;
+    int _batchSize;
+
+    // one query per partition, the query filter restricted to an '_id' range
+    std::vector<mongo::Query> _partitions;
+    size_t _nextPartition;
+
+    // protects everything below up to '_workers'
+    boost::mutex _mutex;
+    boost::condition_variable _batchReady;
+    boost::condition_variable _spaceReady;
+    std::deque<Batch> _queue;
+    size_t _maxQueued;
+    int _activeWorkers;
+    bool _cancelled;
+    std::string _error;
+
+    boost::thread_group _workers;
+
+    // the batch currently being returned from 'next'
+    Batch _current;
+    size_t _currentIdx;
+
+    // Compute '_partitions' from the collection's split points
+    void partition(const mongo::BSONObj& filter, int degree);
+
+    // Worker thread body
+    void scan();
+
+    bool takePartition(mongo::Query *query);
+
+    // Queue 'batch', blocking while the queue is full.  Returns false once
+    // the scan has been cancelled.
+    bool push(Batch *batch);
+
+    void finishWorker(const std::string& error);
+
+    // Cancel the scan and wait for the workers to end
+    void stop();
+
+  public:
+    /*
+    * Starts scanning 'ns' for documents matching 'filter' with up to
+    * 'degree' concurrent cursors requesting 'batchSize' documents at a time.
+    */
+    ParallelScanRowSource(ConnectionHandle *connHandle,
+                          const std::string& ns,
+                          const mongo::BSONObj& filter,
+                          int degree,
+                          int batchSize);
+
+    ~ParallelScanRowSource();
+
+    virtual bool more();
+
+    virtual mongo::BSONObj next();
+};
+
+} // close mongoodbc namespace
+
+#endif
@@ -0,0 +1,212 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "plan_cache.h"
+
+#include "query_plan.h"
+
+#include <boost/thread/locks.hpp>
+
+namespace {
+
+const char *KEYWORDS[] = {
+    "SELECT",
+    "ALL",
+    "DISTINCT",
+    "FROM",
+    "WHERE",
+    "AND",
+    "OR",
+    "NOT",
+    "INNER",
+    "JOIN",
+    "ON",
+    "GROUP",
+    "ORDER",
+    "BY",
+    "ASC",
+    "DESC",
+    "LIMIT",
+    0
+};
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+PlanCache::PlanCache(size_t maxBytes)
+    : _bytes(0)
+    , _maxBytes(maxBytes)
+    , _hits(0)
+    , _misses(0)
+{
+}
+
+int PlanCache::normalize(const std::string& sql,
+                         std::string *key,
+                         std::vector<SQLToken> *literals)
+{
+    key->clear();
+    key->reserve(sql.size());
+    SQLLexer lexer(sql.data(), sql.data() + sql.size());
+    bool afterLimit = false;
+    for (;;) {
+        SQLToken token = lexer.next();
+        if (afterLimit && SQLToken::NUMBER == token._type) {
+            // the row limit is not an expression the plan can rebind, so
+            // it stays part of the key
+            key->append(" ");
+            key->append(token._begin, token._length);
+            afterLimit = false;
+            continue;
+        }
+        afterLimit = token.isKeyword("LIMIT");
+        switch(token._type) {
+          case SQLToken::END: {
+            return 0;
+          } break;
+          case SQLToken::ERROR: {
+            return -1;
+          } break;
+          case SQLToken::NUMBER:
+          case SQLToken::STRING: {
+            // a plan is only bound to literals of the kind it was parsed
+            // with, since a parser may accept a number where it rejects a
+            // string or a string in one quote but not the other
+            literals->push_back(token);
+            if (!key->empty()) {
+                key->append(" ");
+            }
+            if (SQLToken::NUMBER == token._type) {
+                key->append("#n");
+            } else {
+                key->append("#s");
+                key->append(token._begin, 1);
+            }
+          } break;
+          default: {
+            if (!key->empty()) {
+                key->append(" ");
+            }
+            const char **keyword = KEYWORDS;
+            while (*keyword && !token.isKeyword(*keyword)) {
+                ++keyword;
+            }
+            if (*keyword) {
+                key->append(*keyword);
+            } else {
+                // identifiers name fields and collections, which are case
+                // sensitive
+                key->append(token._begin, token._length);
+            }
+          } break;
+        }
+    }
+}
+
+boost::shared_ptr<const QueryPlan> PlanCache::lookup(const std::string& key)
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    if (0 == _maxBytes) {
+        return boost::shared_ptr<const QueryPlan>();
+    }
+    Index::iterator it = _index.find(key);
+    if (_index.end() == it) {
+        ++_misses;
+        return boost::shared_ptr<const QueryPlan>();
+    }
+    ++_hits;
+    _entries.splice(_entries.begin(), _entries, it->second);
+    return it->second->_plan;
+}
+
+void PlanCache::insert(const std::string& key, const boost::shared_ptr<const QueryPlan>& plan)
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    Index::iterator it = _index.find(key);
+    if (_index.end() != it) {
+        _bytes -= it->second->_size;
+        _entries.erase(it->second);
+        _index.erase(it);
+    }
+
+    Entry entry;
+    entry._key = key;
+    entry._plan = plan;
+    // the key is held twice, by the entry and by the index
+    entry._size = plan->size() + 2 * key.size();
+    _entries.push_front(entry);
+    _index[key] = _entries.begin();
+    _bytes += entry._size;
+    evict();
+}
+
+void PlanCache::evict()
+{
+    while (_bytes > _maxBytes && !_entries.empty()) {
+        Entry& entry = _entries.back();
+        _bytes -= entry._size;
+        _index.erase(entry._key);
+        _entries.pop_back();
+    }
+}
+
+void PlanCache::setMaxBytes(size_t maxBytes)
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    _maxBytes = maxBytes;
+    evict();
+}
+
+size_t PlanCache::maxBytes()
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    return _maxBytes;
+}
+
+void PlanCache::clear()
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    _entries.clear();
+    _index.clear();
+    _bytes = 0;
+}
+
+unsigned long PlanCache::hits()
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    return _hits;
+}
+
+unsigned long PlanCache::misses()
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    return _misses;
+}
+
+size_t PlanCache::numEntries()
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    return _entries.size();
+}
+
+size_t PlanCache::bytes()
+{
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    return _bytes;
+}
+
+} // close mongoodbc namespace
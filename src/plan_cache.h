@@ -0,0 +1,116 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_PLAN_CACHE_H_
+#define MONGOODBC_PLAN_CACHE_H_
+
+#include "sql_lexer.h"
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace mongoodbc {
+
+class QueryPlan;
+
+/*
+* Least recently used cache of 'QueryPlan's keyed by normalized SQL text,
+* shared by the connections of an environment.  Entries are evicted once
+* their estimated total size exceeds 'maxBytes'.
+*/
+class PlanCache : boost::noncopyable {
+  public:
+    enum {
+        DEFAULT_MAX_BYTES = 1024 * 1024
+    };
+
+  private:
+    struct Entry {
+        std::string _key;
+        boost::shared_ptr<const QueryPlan> _plan;
+        size_t _size;
+    };
+    // most recently used first
+    typedef std::list<Entry> Entries;
+    typedef std::map<std::string, Entries::iterator> Index;
+
+    boost::mutex _mutex;
+    Entries _entries;
+    Index _index;
+    size_t _bytes;
+    size_t _maxBytes;
+    unsigned long _hits;
+    unsigned long _misses;
+
+    // Drops least recently used entries until the cache fits in '_maxBytes'
+    void evict();
+
+  public:
+    explicit PlanCache(size_t maxBytes = DEFAULT_MAX_BYTES);
+
+    /*
+    * Stores in 'key' the text of 'sql' with whitespace collapsed, keywords
+    * upper cased and each literal but the count of a LIMIT replaced by its
+    * kind, '#n' for a number and '#s' followed by the quote for a string,
+    * and appends the replaced literal tokens, which refer into 'sql', to
+    * 'literals'.
+    * @return 0 on success, -1 if 'sql' cannot be tokenized
+    */
+    static int normalize(const std::string& sql,
+                         std::string *key,
+                         std::vector<SQLToken> *literals);
+
+    /*
+    * Returns the plan for 'key' and marks it most recently used, or null.
+    * Counts a hit or a miss unless the cache is disabled.
+    */
+    boost::shared_ptr<const QueryPlan> lookup(const std::string& key);
+
+    /*
+    * Adds 'plan' under 'key', replacing any plan already there.
+    */
+    void insert(const std::string& key, const boost::shared_ptr<const QueryPlan>& plan);
+
+    /*
+    * Sets the memory cap; 0 disables the cache.
+    */
+    void setMaxBytes(size_t maxBytes);
+
+    size_t maxBytes();
+
+    /*
+    * Removes all plans.  The counters are kept.
+    */
+    void clear();
+
+    unsigned long hits();
+
+    unsigned long misses();
+
+    size_t numEntries();
+
+    size_t bytes();
+};
+
+} // close mongoodbc namespace
+
+#endif
@@ -0,0 +1,243 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "plan_cache.h"
+#include "query_plan.h"
+#include "sql_fast_parser.h"
+#include "sql_parser.h"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using mongoodbc::PlanCache;
+using mongoodbc::QueryPlan;
+using mongoodbc::SQLStatement;
+using mongoodbc::SQLToken;
+
+namespace {
+
+std::string toString(const SQLStatement& stmt)
+{
+    std::ostringstream str;
+    str << stmt;
+    return str.str();
+}
+
+int parseFast(const std::string& sql, SQLStatement *stmt)
+{
+    return mongoodbc::SQLFastParser::parse(sql, stmt, 0);
+}
+
+int parseSpirit(const std::string& sql, SQLStatement *stmt)
+{
+    std::string::const_iterator begin = sql.begin();
+    std::string::const_iterator end = sql.end();
+    return boost::spirit::qi::phrase_parse(begin,
+                                           end,
+                                           mongoodbc::sharedSQLParser(),
+                                           boost::spirit::ascii::space,
+                                           *stmt) ? 0 : -1;
+}
+
+boost::shared_ptr<const QueryPlan> compile(const std::string& sql,
+                                           mongoodbc::SQLParseFunction parse = parseFast)
+{
+    std::string key;
+    std::vector<SQLToken> literals;
+    EXPECT_EQ(0, PlanCache::normalize(sql, &key, &literals));
+    return QueryPlan::compile(sql, literals, parse);
+}
+
+} // close unnamed namespace
+
+TEST(PlanCache, Normalize)
+{
+    // literals refer into the text
+    std::string sql("select  Name\n FROM db.People where age>=21 AND name <> 'x'");
+    std::string key;
+    std::vector<SQLToken> literals;
+    ASSERT_EQ(0, PlanCache::normalize(sql, &key, &literals));
+    EXPECT_EQ("SELECT Name FROM db . People WHERE age >= #n AND name <> #s'", key);
+    ASSERT_EQ(2u, literals.size());
+    EXPECT_EQ("21", literals[0].text());
+    EXPECT_EQ("'x'", literals[1].text());
+
+    std::string other;
+    literals.clear();
+    ASSERT_EQ(0, PlanCache::normalize("SELECT Name\n from db.People WHERE age >= 30 and name<>'y'",
+                                      &other,
+                                      &literals));
+    EXPECT_EQ(2u, literals.size());
+    EXPECT_EQ(key, other);
+
+    // the kind of each literal is part of the key
+    literals.clear();
+    ASSERT_EQ(0, PlanCache::normalize("SELECT Name FROM db.People WHERE age >= 30 AND name <> \"y\"",
+                                      &other,
+                                      &literals));
+    EXPECT_EQ("SELECT Name FROM db . People WHERE age >= #n AND name <> #s\"", other);
+    literals.clear();
+    ASSERT_EQ(0, PlanCache::normalize("SELECT Name FROM db.People WHERE age >= '30' AND name <> 'y'",
+                                      &other,
+                                      &literals));
+    EXPECT_NE(key, other);
+
+    EXPECT_EQ(-1, PlanCache::normalize("SELECT * FROM db.t WHERE a = 'open", &key, &literals));
+
+    // the row limit stays in the key
+    literals.clear();
+    ASSERT_EQ(0, PlanCache::normalize("SELECT * FROM db.t ORDER BY a + 1 desc LIMIT 10",
+                                      &key,
+                                      &literals));
+    EXPECT_EQ("SELECT * FROM db . t ORDER BY a + #n DESC LIMIT 10", key);
+    EXPECT_EQ(1u, literals.size());
+}
+
+TEST(PlanCache, LookupAndEvict)
+{
+    boost::shared_ptr<const QueryPlan> plan = compile("SELECT a FROM db.t WHERE a = 1");
+    ASSERT_TRUE(plan.get() != 0);
+    size_t entrySize = plan->size() + 2 * std::string("k1").size();
+
+    PlanCache cache(2 * entrySize);
+    EXPECT_FALSE(cache.lookup("k1").get());
+    cache.insert("k1", plan);
+    cache.insert("k2", plan);
+    EXPECT_TRUE(cache.lookup("k1") == plan);
+    EXPECT_EQ(1u, cache.hits());
+    EXPECT_EQ(1u, cache.misses());
+    EXPECT_EQ(2u, cache.numEntries());
+    EXPECT_EQ(2 * entrySize, cache.bytes());
+
+    // "k2" is least recently used
+    cache.insert("k3", plan);
+    EXPECT_EQ(2u, cache.numEntries());
+    EXPECT_FALSE(cache.lookup("k2").get());
+    EXPECT_TRUE(cache.lookup("k1").get());
+    EXPECT_TRUE(cache.lookup("k3").get());
+
+    cache.setMaxBytes(0);
+    EXPECT_EQ(0u, cache.numEntries());
+    EXPECT_FALSE(cache.lookup("k1").get());
+    EXPECT_EQ(3u, cache.hits());
+    EXPECT_EQ(2u, cache.misses());
+}
+
+TEST(PlanCache, LiteralKind)
+{
+    // a plan parsed by Spirit with a number is not served for a string,
+    // which Spirit rejects in single quotes
+    PlanCache cache;
+    std::string sql("SELECT a FROM db.t WHERE a = 5");
+    std::string key;
+    std::vector<SQLToken> literals;
+    ASSERT_EQ(0, PlanCache::normalize(sql, &key, &literals));
+    boost::shared_ptr<const QueryPlan> plan = QueryPlan::compile(sql, literals, parseSpirit);
+    ASSERT_TRUE(plan.get() != 0);
+    cache.insert(key, plan);
+
+    std::string other;
+    literals.clear();
+    ASSERT_EQ(0, PlanCache::normalize("SELECT a FROM db.t WHERE a = 'x'", &other, &literals));
+    EXPECT_FALSE(cache.lookup(other).get());
+    literals.clear();
+    ASSERT_EQ(0, PlanCache::normalize("SELECT a FROM db.t WHERE a = 7", &other, &literals));
+    EXPECT_TRUE(cache.lookup(other) == plan);
+}
+
+TEST(QueryPlan, Bind)
+{
+    boost::shared_ptr<const QueryPlan> plan =
+        compile("SELECT a, 5, \"five\" FROM db.t WHERE a > 1 AND b = \"x\" OR NOT c = -2");
+    ASSERT_TRUE(plan.get() != 0);
+
+    const char *queries[] = {
+        "SELECT a, 5, \"five\" FROM db.t WHERE a > 1 AND b = \"x\" OR NOT c = -2",
+        "SELECT a, 7, 'seven' FROM db.t WHERE a > 100 AND b = 'it''s' OR NOT c = -0",
+    };
+    for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); ++i) {
+        std::string sql(queries[i]);
+        std::string key;
+        std::vector<SQLToken> literals;
+        ASSERT_EQ(0, PlanCache::normalize(sql, &key, &literals));
+
+        SQLStatement expected;
+        ASSERT_EQ(0, mongoodbc::SQLFastParser::parse(sql, &expected, 0));
+        SQLStatement bound;
+        ASSERT_EQ(0, plan->bind(literals, &bound));
+        EXPECT_EQ(toString(expected), toString(bound));
+    }
+
+    std::vector<SQLToken> tooFew;
+    SQLStatement stmt;
+    EXPECT_EQ(-1, plan->bind(tooFew, &stmt));
+}
+
+TEST(QueryPlan, BindOrderBy)
+{
+    boost::shared_ptr<const QueryPlan> plan =
+        compile("SELECT a FROM db.t WHERE a > 1 ORDER BY a * 2 DESC, b LIMIT 5");
+    ASSERT_TRUE(plan.get() != 0);
+
+    std::string sql("SELECT a FROM db.t WHERE a > 3 ORDER BY a * 4 DESC, b LIMIT 5");
+    std::string key;
+    std::vector<SQLToken> literals;
+    ASSERT_EQ(0, PlanCache::normalize(sql, &key, &literals));
+    SQLStatement expected;
+    ASSERT_EQ(0, mongoodbc::SQLFastParser::parse(sql, &expected, 0));
+    SQLStatement bound;
+    ASSERT_EQ(0, plan->bind(literals, &bound));
+    EXPECT_EQ(toString(expected), toString(bound));
+    ASSERT_TRUE(bound._limit.is_initialized());
+    EXPECT_EQ(5u, *bound._limit);
+}
+
+TEST(QueryPlan, Uncacheable)
+{
+    EXPECT_FALSE(compile("SELECT a FROM db.t WHERE").get());
+    EXPECT_FALSE(compile("SELECT a FROM db.t WHERE a = \"`\"").get());
+}
+
+TEST(QueryPlan, SpiritParser)
+{
+    // the plan is parsed by the parser of the statements it serves, and
+    // the Spirit grammar only knows double quoted strings
+    EXPECT_FALSE(compile("SELECT a FROM db.t WHERE b = 'x'", parseSpirit).get());
+    EXPECT_TRUE(compile("SELECT a FROM db.t WHERE b = 'x'").get() != 0);
+
+    boost::shared_ptr<const QueryPlan> plan =
+        compile("SELECT a, \"five\" FROM db.t WHERE a > 1 AND b = \"x\"", parseSpirit);
+    ASSERT_TRUE(plan.get() != 0);
+
+    std::string sql("SELECT a, \"seven\" FROM db.t WHERE a > 100 AND b = \"y z\"");
+    std::string key;
+    std::vector<SQLToken> literals;
+    ASSERT_EQ(0, PlanCache::normalize(sql, &key, &literals));
+    SQLStatement expected;
+    ASSERT_EQ(0, parseSpirit(sql, &expected));
+    SQLStatement bound;
+    ASSERT_EQ(0, plan->bind(literals, &bound));
+    EXPECT_EQ(toString(expected), toString(bound));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
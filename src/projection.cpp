@@ -0,0 +1,296 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "projection.h"
+
+#include "native_filter.h"
+
+#include <mongo/client/dbclient.h>
+
+#include <set>
+
+namespace {
+
+using mongoodbc::ExpressionProgram;
+using mongoodbc::ExpressionValue;
+using mongoodbc::SQLElementExpression;
+using mongoodbc::SQLElementExpression_Factor;
+using mongoodbc::SQLElementExpression_Primary;
+using mongoodbc::SQLElementExpression_Term;
+
+std::string stripThis(const std::string& name)
+{
+    return 0 == name.compare(0, 5, "this.") ? name.substr(5) : name;
+}
+
+/*
+* Translates an expression into an aggregation expression appended to
+* 'builder' as 'name', with the semantics of 'ExpressionProgram'.  A
+* column used as a number, i.e. if 'numeric', is null unless it is one, so
+* '$add' and the like are null where the driver's arithmetic has no value
+* instead of failing.
+*
+* Only expressions reading a column are translated; their constant parts
+* are numbers, since any other constant operand makes the whole expression
+* constant.
+*/
+class ProjectTranslation {
+    static int primary(const SQLElementExpression_Primary& primary,
+                       bool numeric,
+                       const std::string& name,
+                       mongo::BSONObjBuilder *builder);
+    static int factor(const SQLElementExpression_Factor& factor,
+                      bool numeric,
+                      const std::string& name,
+                      mongo::BSONObjBuilder *builder);
+    static int term(const SQLElementExpression_Term& term,
+                    bool numeric,
+                    const std::string& name,
+                    mongo::BSONObjBuilder *builder);
+
+    // appends '{ <op>: [ lhs, rhs ] }', null for a division by 0
+    static void arithmetic(const mongo::BSONObj& operands,
+                           char op,
+                           const std::string& name,
+                           mongo::BSONObjBuilder *builder);
+
+  public:
+    static int expression(const SQLElementExpression& expr,
+                          bool numeric,
+                          const std::string& name,
+                          mongo::BSONObjBuilder *builder);
+};
+
+int ProjectTranslation::primary(const SQLElementExpression_Primary& primary,
+                                bool numeric,
+                                const std::string& name,
+                                mongo::BSONObjBuilder *builder)
+{
+    if (primary._columnName) {
+        // single table, whose fields are not qualified
+        std::string field = "$" + stripThis(primary._columnName->_columnName);
+        if (numeric) {
+            mongo::BSONArrayBuilder numberTypes;
+            numberTypes.append("double").append("int").append("long").append("decimal");
+            mongo::BSONArrayBuilder typeIn;
+            typeIn.append(BSON("$type" << field)).append(numberTypes.arr());
+            mongo::BSONArrayBuilder cond;
+            cond.append(BSON("$in" << typeIn.arr())).append(field).appendNull();
+            builder->append(name, BSON("$cond" << cond.arr()));
+        } else {
+            // a missing field is NULL rather than left out
+            mongo::BSONArrayBuilder ifNull;
+            ifNull.append(field).appendNull();
+            builder->append(name, BSON("$ifNull" << ifNull.arr()));
+        }
+        return 0;
+    }
+    if (primary._num) {
+        builder->append(name, (double)*primary._num);
+        return 0;
+    }
+    if (!primary._function && !primary._expr.empty()) {
+        return expression(primary._expr[0].get(), numeric, name, builder);
+    }
+    // aggregate functions are computed by the driver; other constants are
+    // folded before translating
+    return -1;
+}
+
+int ProjectTranslation::factor(const SQLElementExpression_Factor& factor,
+                               bool numeric,
+                               const std::string& name,
+                               mongo::BSONObjBuilder *builder)
+{
+    if ('-' == factor._op) {
+        mongo::BSONObjBuilder operands;
+        operands.append("0", 0.0);
+        if (0 != primary(factor._primary, true, "1", &operands)) {
+            return -1;
+        }
+        arithmetic(operands.obj(), '-', name, builder);
+        return 0;
+    }
+    return primary(factor._primary, numeric || '+' == factor._op, name, builder);
+}
+
+int ProjectTranslation::term(const SQLElementExpression_Term& term,
+                             bool numeric,
+                             const std::string& name,
+                             mongo::BSONObjBuilder *builder)
+{
+    if (term._term.empty()) {
+        return factor(term._factor, numeric, name, builder);
+    }
+    mongo::BSONObjBuilder operands;
+    if (0 != ProjectTranslation::term(term._term[0].get(), true, "0", &operands)
+        || 0 != factor(term._factor, true, "1", &operands)) {
+        return -1;
+    }
+    arithmetic(operands.obj(), term._op, name, builder);
+    return 0;
+}
+
+int ProjectTranslation::expression(const SQLElementExpression& expr,
+                                   bool numeric,
+                                   const std::string& name,
+                                   mongo::BSONObjBuilder *builder)
+{
+    if (expr._expr.empty()) {
+        return term(expr._term, numeric, name, builder);
+    }
+    mongo::BSONObjBuilder operands;
+    if (0 != expression(expr._expr[0].get(), true, "0", &operands)
+        || 0 != term(expr._term, true, "1", &operands)) {
+        return -1;
+    }
+    arithmetic(operands.obj(), expr._op, name, builder);
+    return 0;
+}
+
+void ProjectTranslation::arithmetic(const mongo::BSONObj& operands,
+                                    char op,
+                                    const std::string& name,
+                                    mongo::BSONObjBuilder *builder)
+{
+    mongo::BSONElement lhs = operands["0"];
+    mongo::BSONElement rhs = operands["1"];
+    const char *opName = '+' == op ? "$add"
+                       : '-' == op ? "$subtract"
+                       : '*' == op ? "$multiply"
+                       : "$divide";
+    mongo::BSONArrayBuilder args;
+    args.append(lhs).append(rhs);
+    mongo::BSONObj value = BSON(opName << args.arr());
+    if ('/' != op || rhs.isNumber()) {
+        // a constant divisor is not 0
+        builder->append(name, value);
+        return;
+    }
+    mongo::BSONArrayBuilder isZero;
+    isZero.append(rhs).append(0);
+    mongo::BSONArrayBuilder cond;
+    cond.append(BSON("$eq" << isZero.arr())).appendNull().append(value);
+    builder->append(name, BSON("$cond" << cond.arr()));
+}
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+int projectStage(const std::vector<SQLElementExpression>& selectList, mongo::BSONObj *stage)
+{
+    if (!ProjectRowSource::isComputed(selectList)) {
+        return -1;
+    }
+    std::set<std::string> labels;
+    mongo::BSONObjBuilder fields;
+    for (size_t i = 0; i < selectList.size(); ++i) {
+        std::string label = expressionLabel(selectList[i]);
+        if (label.empty() || '$' == label[0] || std::string::npos != label.find('.')
+            || !labels.insert(label).second) {
+            // not a field name '$project' can output
+            return -1;
+        }
+        ExpressionProgram program(selectList[i]);
+        if (!program.isConstant()) {
+            if (0 != ProjectTranslation::expression(selectList[i], false, label, &fields)) {
+                return -1;
+            }
+            continue;
+        }
+        ExpressionValue value = program.run(mongo::BSONObj());
+        if (ExpressionValue::NONE == value._type) {
+            fields.appendNull(label);
+        } else {
+            mongo::BSONObjBuilder literal;
+            value.append("$literal", &literal);
+            fields.append(label, literal.obj());
+        }
+    }
+    if (!labels.count("_id")) {
+        fields.append("_id", 0);
+    }
+    *stage = BSON("$project" << fields.obj());
+    return 0;
+}
+
+int projectPipeline(const mongo::BSONObj& cond,
+                    const mongo::BSONObj& sortPattern,
+                    int limit,
+                    const std::vector<SQLElementExpression>& selectList,
+                    mongo::BSONObj *pipeline)
+{
+    mongo::BSONObj filter;
+    mongo::BSONObj project;
+    if (0 != nativeFilter(cond, &filter) || 0 != projectStage(selectList, &project)) {
+        return -1;
+    }
+    mongo::BSONArrayBuilder stages;
+    if (!filter.isEmpty()) {
+        stages.append(BSON("$match" << filter));
+    }
+    if (!sortPattern.isEmpty()) {
+        stages.append(BSON("$sort" << sortPattern));
+    }
+    if (limit > 0) {
+        stages.append(BSON("$limit" << limit));
+    }
+    stages.append(project);
+    *pipeline = stages.arr();
+    return 0;
+}
+
+ProjectRowSource::ProjectRowSource(std::auto_ptr<RowSource> source,
+                                   const std::vector<SQLElementExpression>& selectList,
+                                   const std::string& defaultQualifier)
+    : _source(source)
+{
+    for (size_t i = 0; i < selectList.size(); ++i) {
+        _labels.push_back(expressionLabel(selectList[i]));
+        _programs.push_back(ExpressionProgram(selectList[i], defaultQualifier));
+    }
+}
+
+bool ProjectRowSource::isComputed(const std::vector<SQLElementExpression>& selectList)
+{
+    for (size_t i = 0; i < selectList.size(); ++i) {
+        const SQLElementExpression& expr = selectList[i];
+        const SQLElementExpression_Factor& factor = expr._term._factor;
+        if (!expr._expr.empty() || !expr._term._term.empty() || factor._op
+            || !factor._primary._columnName) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ProjectRowSource::more()
+{
+    return _source->more();
+}
+
+mongo::BSONObj ProjectRowSource::next()
+{
+    mongo::BSONObj row = _source->next();
+    mongo::BSONObjBuilder builder;
+    for (size_t i = 0; i < _programs.size(); ++i) {
+        _programs[i].run(row).append(_labels[i], &builder);
+    }
+    return builder.obj();
+}
+
+} // close mongoodbc namespace
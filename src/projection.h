@@ -0,0 +1,89 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_PROJECTION_H_
+#define MONGOODBC_PROJECTION_H_
+
+#include "expression_evaluator.h"
+#include "row_source.h"
+
+#include <mongo/bson/bsonobj.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mongoodbc {
+
+/*
+* Row source returning the select list of a query over the rows of another
+* source: one field per expression, named by its 'expressionLabel', e.g.
+* 'price * qty'.  Each expression is compiled once to an
+* 'ExpressionProgram' and run over every row.
+*/
+class ProjectRowSource : public RowSource {
+    std::auto_ptr<RowSource> _source;
+    std::vector<std::string> _labels;
+    std::vector<ExpressionProgram> _programs;
+
+  public:
+    ProjectRowSource(std::auto_ptr<RowSource> source,
+                     const std::vector<SQLElementExpression>& selectList,
+                     const std::string& defaultQualifier = std::string());
+
+    /*
+    * Returns whether 'selectList' computes a column, i.e. is more than
+    * '*' or a list of plain columns.
+    */
+    static bool isComputed(const std::vector<SQLElementExpression>& selectList);
+
+    virtual bool more();
+
+    virtual mongo::BSONObj next();
+};
+
+/*
+* Translates a select list computing columns, see
+* 'ProjectRowSource::isComputed', into an aggregation stage
+* '{ $project: { <label>: <expression>, ... } }' returning the same rows as
+* a 'ProjectRowSource' over a single table, so that the server computes the
+* columns and only sends their values.  Arithmetic that has no value in the
+* driver, e.g. on a string or dividing by 0, is null on the server too.
+* @return 0 on success, -1 if an expression or label cannot be translated,
+*         e.g. an aggregate function call or 't.a', which is not a field
+*         name '$project' can output
+*/
+int projectStage(const std::vector<SQLElementExpression>& selectList, mongo::BSONObj *stage);
+
+/*
+* Builds in 'pipeline' the aggregation running a query over a single table
+* whose select list 'projectStage' translates: a '$match' stage on the
+* WHERE condition 'cond', as built by the parsers and translated by
+* 'nativeFilter' since '$where' cannot run in a pipeline, then a '$sort' on
+* 'sortPattern' and a '$limit' of 'limit' unless empty or 0, and the
+* '$project' stage.
+* @return 0 on success, -1 if 'cond' or the select list cannot be
+*         translated
+*/
+int projectPipeline(const mongo::BSONObj& cond,
+                    const mongo::BSONObj& sortPattern,
+                    int limit,
+                    const std::vector<SQLElementExpression>& selectList,
+                    mongo::BSONObj *pipeline);
+
+} // close mongoodbc namespace
+
+#endif
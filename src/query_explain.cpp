@@ -0,0 +1,255 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "query_explain.h"
+#include "connection_handle.h"
+
+#include <ctype.h>
+#include <string.h>
+
+#include <sstream>
+
+namespace {
+
+/*
+* Splits 'ns' into its database and collection.
+*/
+void splitNamespace(const std::string& ns, std::string *db, std::string *collection)
+{
+    size_t periodIdx = ns.find('.');
+    *db = ns.substr(0, periodIdx);
+    *collection = std::string::npos == periodIdx ? ns : ns.substr(periodIdx + 1);
+}
+
+/*
+* Returns the first object named 'name' in 'obj', searched depth first.
+*/
+mongo::BSONObj findObject(const mongo::BSONObj& obj, const char *name)
+{
+    mongo::BSONObjIterator fieldIt(obj);
+    while (fieldIt.more()) {
+        mongo::BSONElement elem = fieldIt.next();
+        if (mongo::Object != elem.type() && mongo::Array != elem.type()) {
+            continue;
+        }
+        if (mongo::Object == elem.type() && 0 == strcmp(name, elem.fieldName())) {
+            return elem.embeddedObject();
+        }
+        mongo::BSONObj found = findObject(elem.embeddedObject(), name);
+        if (!found.isEmpty()) {
+            return found;
+        }
+    }
+    return mongo::BSONObj();
+}
+
+/*
+* Appends the stages of 'plan' to 'text', each followed by those it reads
+* from, e.g. 'FETCH < IXSCAN status_1'.
+*/
+void describePlan(const mongo::BSONObj& plan, std::string *text)
+{
+    if (plan.isEmpty()) {
+        return;
+    }
+    if (!text->empty()) {
+        text->append(" < ");
+    }
+    text->append(plan.getStringField("stage"));
+    if (plan.hasField("indexName")) {
+        text->append(" ");
+        text->append(plan.getStringField("indexName"));
+    }
+    if (plan.hasField("inputStage")) {
+        describePlan(plan.getObjectField("inputStage"), text);
+    }
+    if (plan.hasField("inputStages")) {
+        mongo::BSONObjIterator stageIt(plan.getObjectField("inputStages"));
+        text->append(" (");
+        std::string inputs;
+        while (stageIt.more()) {
+            mongo::BSONElement stage = stageIt.next();
+            std::string input;
+            if (mongo::Object == stage.type()) {
+                describePlan(stage.embeddedObject(), &input);
+            }
+            inputs.append(inputs.empty() ? "" : ", ").append(input);
+        }
+        text->append(inputs).append(")");
+    }
+}
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+void QueryExplain::addStep(const std::string& step,
+                           const std::string& location,
+                           const std::string& detail)
+{
+    Step s;
+    s._step = step;
+    s._location = location;
+    s._detail = detail;
+    _steps.push_back(s);
+}
+
+void QueryExplain::sql(const std::string& normalized)
+{
+    addStep("sql", "", normalized);
+}
+
+void QueryExplain::find(const std::string& ns, const mongo::Query& query, int limit)
+{
+    std::string db;
+    std::string collection;
+    splitNamespace(ns, &db, &collection);
+
+    mongo::BSONObj filter = query.getFilter();
+    mongo::BSONObj sort = query.getSort();
+    // an index name or key pattern
+    mongo::BSONElement hint = query.getHint();
+    mongo::BSONElement maxTime = query.isComplex() ? query.obj["$maxTimeMS"] : mongo::BSONElement();
+
+    std::ostringstream text;
+    text << ns << ".find(" << filter.jsonString() << ")";
+    if (!sort.isEmpty()) {
+        text << ".sort(" << sort.jsonString() << ")";
+    }
+    if (!hint.eoo()) {
+        text << ".hint(" << hint.jsonString(mongo::Strict, false) << ")";
+    }
+    if (limit > 0) {
+        text << ".limit(" << limit << ")";
+    }
+    if (maxTime.isNumber()) {
+        text << ".maxTimeMS(" << maxTime.numberInt() << ")";
+    }
+    addStep("find", "server", text.str());
+    _native.append(_native.empty() ? "" : "\n").append(text.str());
+
+    mongo::BSONObjBuilder cmd;
+    cmd.append("find", collection);
+    cmd.append("filter", filter);
+    if (!sort.isEmpty()) {
+        cmd.append("sort", sort);
+    }
+    if (!hint.eoo()) {
+        cmd.appendAs(hint, "hint");
+    }
+    if (limit > 0) {
+        cmd.append("limit", limit);
+    }
+    if (maxTime.isNumber()) {
+        cmd.appendAs(maxTime, "maxTimeMS");
+    }
+    Command command;
+    command._db = db;
+    command._cmd = cmd.obj();
+    _commands.push_back(command);
+}
+
+void QueryExplain::aggregate(const std::string& ns,
+                             const mongo::BSONObj& pipeline,
+                             const mongo::BSONObj& options)
+{
+    std::string db;
+    std::string collection;
+    splitNamespace(ns, &db, &collection);
+
+    std::ostringstream text;
+    text << ns << ".aggregate(" << pipeline.jsonString(mongo::Strict, 0, true);
+    if (!options.isEmpty()) {
+        text << ", " << options.jsonString();
+    }
+    text << ")";
+    addStep("aggregate", "server", text.str());
+    _native.append(_native.empty() ? "" : "\n").append(text.str());
+
+    mongo::BSONObjBuilder cmd;
+    cmd.append("aggregate", collection);
+    cmd.appendArray("pipeline", pipeline);
+    cmd.append("cursor", mongo::BSONObj());
+    cmd.appendElements(options);
+    Command command;
+    command._db = db;
+    command._cmd = cmd.obj();
+    _commands.push_back(command);
+}
+
+void QueryExplain::driver(const std::string& step, const std::string& detail)
+{
+    addStep(step, "driver", detail);
+}
+
+void QueryExplain::explainOnServer(ConnectionHandle *connHandle)
+{
+    for (size_t i = 0; i < _commands.size(); ++i) {
+        mongo::BSONObj info;
+        if (0 != connHandle->runCommand(_commands[i]._db,
+                                        BSON("explain" << _commands[i]._cmd
+                                             << "verbosity" << "executionStats"),
+                                        &info)) {
+            std::string errmsg = info.getStringField("errmsg");
+            addStep("server plan", "server", "not available" + (errmsg.empty() ? "" : ": " + errmsg));
+            continue;
+        }
+        addStep("server plan", "server", summarize(info));
+        mongo::BSONObj winningPlan = findObject(info, "winningPlan");
+        if (!winningPlan.isEmpty()) {
+            addStep("winning plan", "server", winningPlan.jsonString());
+        }
+    }
+}
+
+std::string QueryExplain::summarize(const mongo::BSONObj& explain)
+{
+    std::string plan;
+    describePlan(findObject(explain, "winningPlan"), &plan);
+    std::ostringstream text;
+    text << (plan.empty() ? "unknown plan" : plan);
+
+    mongo::BSONObj stats = findObject(explain, "executionStats");
+    if (!stats.isEmpty()) {
+        text << "; " << stats["totalKeysExamined"].numberLong() << " keys examined, "
+             << stats["totalDocsExamined"].numberLong() << " documents examined, "
+             << stats["nReturned"].numberLong() << " returned";
+    }
+    return text.str();
+}
+
+int QueryExplain::explained(const std::string& sql, std::string *statement)
+{
+    static const char KEYWORD[] = "EXPLAIN";
+    static const size_t KEYWORD_LEN = sizeof(KEYWORD) - 1;
+
+    size_t pos = 0;
+    while (pos < sql.size() && isspace((unsigned char)sql[pos])) {
+        ++pos;
+    }
+    if (sql.size() - pos <= KEYWORD_LEN || !isspace((unsigned char)sql[pos + KEYWORD_LEN])) {
+        return -1;
+    }
+    for (size_t i = 0; i < KEYWORD_LEN; ++i) {
+        if (toupper((unsigned char)sql[pos + i]) != KEYWORD[i]) {
+            return -1;
+        }
+    }
+    *statement = sql.substr(pos + KEYWORD_LEN + 1);
+    return 0;
+}
+
+} // close mongoodbc namespace
@@ -0,0 +1,122 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_QUERY_EXPLAIN_H_
+#define MONGOODBC_QUERY_EXPLAIN_H_
+
+#include <mongo/client/dbclient.h>
+#include <mongo/bson/bsonobj.h>
+
+#include <string>
+#include <vector>
+
+namespace mongoodbc {
+
+class ConnectionHandle;
+
+/*
+* Description of how a statement executes, collected while it is planned
+* for 'EXPLAIN <statement>' and 'SQLNativeSql': the queries and
+* aggregations sent to the server, in the shell's syntax, and the steps
+* the driver runs over their results.
+*/
+class QueryExplain {
+  public:
+    /*
+    * A step of the execution: what it does, where it runs, "server" or
+    * "driver", and its details.
+    */
+    struct Step {
+        std::string _step;
+        std::string _location;
+        std::string _detail;
+    };
+
+  private:
+    /*
+    * A command sent to the server, to be explained there.
+    */
+    struct Command {
+        std::string _db;
+        mongo::BSONObj _cmd;
+    };
+
+    std::vector<Step> _steps;
+    std::vector<Command> _commands;
+    // shell text of the commands, one per line
+    std::string _native;
+
+    void addStep(const std::string& step, const std::string& location, const std::string& detail);
+
+  public:
+    const std::vector<Step>& steps() const { return _steps; }
+
+    /*
+    * Returns the queries and aggregations sent to the server, one per
+    * line, in the shell's syntax.
+    */
+    const std::string& nativeText() const { return _native; }
+
+    /*
+    * Records the normalized text of the statement.
+    */
+    void sql(const std::string& normalized);
+
+    /*
+    * Records 'query' run over the collection 'ns', returning at most
+    * 'limit' documents if not 0.
+    */
+    void find(const std::string& ns, const mongo::Query& query, int limit);
+
+    /*
+    * Records the aggregation 'pipeline' run over the collection 'ns' with
+    * the command options 'options'.
+    */
+    void aggregate(const std::string& ns,
+                   const mongo::BSONObj& pipeline,
+                   const mongo::BSONObj& options = mongo::BSONObj());
+
+    /*
+    * Records 'step', run by the driver over the rows the server returns.
+    */
+    void driver(const std::string& step, const std::string& detail);
+
+    /*
+    * Runs the server's 'explain' over each recorded query and aggregation
+    * and records a summary of the chosen plan and the work done.  A
+    * server that cannot explain a command is recorded as such.
+    */
+    void explainOnServer(ConnectionHandle *connHandle);
+
+    /*
+    * Returns a summary of the reply of an 'explain' command: the stages
+    * of the winning plan, the indexes it uses and the numbers of keys and
+    * documents examined and returned, e.g. 'FETCH < IXSCAN status_1; 12
+    * keys examined, 10 documents examined, 10 returned'.
+    */
+    static std::string summarize(const mongo::BSONObj& explain);
+
+    /*
+    * Sets 'statement' to the statement following the keyword EXPLAIN that
+    * starts 'sql'.
+    * @return 0 if 'sql' is an EXPLAIN statement, -1 otherwise
+    */
+    static int explained(const std::string& sql, std::string *statement);
+};
+
+} // close mongoodbc namespace
+
+#endif
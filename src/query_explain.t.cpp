@@ -0,0 +1,108 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "query_explain.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using mongoodbc::QueryExplain;
+
+TEST(QueryExplain, Explained)
+{
+    std::string statement;
+    EXPECT_EQ(0, QueryExplain::explained("  explain SELECT a FROM db.t", &statement));
+    EXPECT_EQ("SELECT a FROM db.t", statement);
+    EXPECT_EQ(0, QueryExplain::explained("EXPLAIN\nSELECT a FROM db.t", &statement));
+    EXPECT_EQ("SELECT a FROM db.t", statement);
+
+    EXPECT_EQ(-1, QueryExplain::explained("SELECT a FROM db.t", &statement));
+    EXPECT_EQ(-1, QueryExplain::explained("EXPLAINED SELECT a FROM db.t", &statement));
+    EXPECT_EQ(-1, QueryExplain::explained("EXPLAIN", &statement));
+}
+
+TEST(QueryExplain, Find)
+{
+    mongo::BSONObj filter = BSON("a" << BSON("$gt" << 5));
+    mongo::BSONObj sort = BSON("b" << -1);
+    mongo::Query query(filter);
+    query.sort(sort);
+    query.hint("a_1");
+
+    QueryExplain explain;
+    explain.sql("SELECT a FROM db.t WHERE a > # ORDER BY b DESC LIMIT 10");
+    explain.find("db.t", query, 10);
+    explain.driver("filter", "{ $where: \"this.a + this.b > 1\" }");
+
+    std::string text = "db.t.find(" + filter.jsonString() + ").sort(" + sort.jsonString()
+                     + ").hint(\"a_1\").limit(10)";
+    ASSERT_EQ(3U, explain.steps().size());
+    EXPECT_EQ("sql", explain.steps()[0]._step);
+    EXPECT_EQ("find", explain.steps()[1]._step);
+    EXPECT_EQ("server", explain.steps()[1]._location);
+    EXPECT_EQ(text, explain.steps()[1]._detail);
+    EXPECT_EQ("filter", explain.steps()[2]._step);
+    EXPECT_EQ("driver", explain.steps()[2]._location);
+    EXPECT_EQ(text, explain.nativeText());
+}
+
+TEST(QueryExplain, Aggregate)
+{
+    mongo::BSONObj pipeline = BSON_ARRAY(BSON("$match" << BSON("a" << 1))
+                                         << BSON("$project" << BSON("a" << 1)));
+    mongo::BSONObj options = BSON("maxTimeMS" << 500);
+
+    QueryExplain explain;
+    explain.find("db.u", mongo::Query(), 0);
+    explain.aggregate("db.t", pipeline, options);
+
+    std::string text = "db.t.aggregate(" + pipeline.jsonString(mongo::Strict, 0, true)
+                     + ", " + options.jsonString() + ")";
+    ASSERT_EQ(2U, explain.steps().size());
+    EXPECT_EQ("aggregate", explain.steps()[1]._step);
+    EXPECT_EQ(text, explain.steps()[1]._detail);
+    EXPECT_EQ("db.u.find({})\n" + text, explain.nativeText());
+}
+
+TEST(QueryExplain, Summarize)
+{
+    mongo::BSONObj reply = BSON(
+        "queryPlanner" << BSON("winningPlan" << BSON("stage" << "FETCH"
+                                                     << "inputStage" << BSON("stage" << "IXSCAN"
+                                                                             << "indexName" << "a_1")))
+        << "executionStats" << BSON("nReturned" << 10
+                                    << "totalKeysExamined" << 12
+                                    << "totalDocsExamined" << 10)
+        << "ok" << 1.0);
+    EXPECT_EQ("FETCH < IXSCAN a_1; 12 keys examined, 10 documents examined, 10 returned",
+              QueryExplain::summarize(reply));
+
+    // an aggregation's plan is that of its first stage's cursor
+    mongo::BSONObj aggregation = BSON(
+        "stages" << BSON_ARRAY(BSON("$cursor" << BSON("queryPlanner"
+                                                      << BSON("winningPlan" << BSON("stage" << "COLLSCAN")))))
+        << "ok" << 1.0);
+    EXPECT_EQ("COLLSCAN", QueryExplain::summarize(aggregation));
+
+    EXPECT_EQ("unknown plan", QueryExplain::summarize(BSON("ok" << 1.0)));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
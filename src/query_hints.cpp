@@ -0,0 +1,171 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "query_hints.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+namespace {
+
+/*
+* Splits the arguments of a hint, separated by spaces or commas.
+*/
+std::vector<std::string> arguments(const std::string& text)
+{
+    std::vector<std::string> args;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        while (pos < text.size() && (isspace((unsigned char)text[pos]) || ',' == text[pos])) {
+            ++pos;
+        }
+        size_t end = pos;
+        while (end < text.size() && !isspace((unsigned char)text[end]) && ',' != text[end]) {
+            ++end;
+        }
+        if (end > pos) {
+            args.push_back(text.substr(pos, end - pos));
+        }
+        pos = end;
+    }
+    return args;
+}
+
+/*
+* Returns the positive integer 'text', 0 if it is not one.
+*/
+int positive(const std::string& text)
+{
+    if (text.empty() || text.size() > 9) {
+        return 0;
+    }
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (!isdigit((unsigned char)text[i])) {
+            return 0;
+        }
+    }
+    return atoi(text.c_str());
+}
+
+/*
+* Applies the hints in 'text', the body of a '/\*+' comment, to 'hints'.
+*/
+void parseHints(const std::string& text, mongoodbc::QueryHints *hints)
+{
+    size_t pos = 0;
+    while (pos < text.size()) {
+        if (!isalpha((unsigned char)text[pos])) {
+            ++pos;
+            continue;
+        }
+        size_t nameEnd = pos;
+        while (nameEnd < text.size() && (isalnum((unsigned char)text[nameEnd]) || '_' == text[nameEnd])) {
+            ++nameEnd;
+        }
+        std::string name = text.substr(pos, nameEnd - pos);
+        for (size_t i = 0; i < name.size(); ++i) {
+            name[i] = toupper((unsigned char)name[i]);
+        }
+        size_t open = nameEnd;
+        while (open < text.size() && isspace((unsigned char)text[open])) {
+            ++open;
+        }
+        size_t close = open < text.size() && '(' == text[open] ? text.find(')', open) : std::string::npos;
+        if (std::string::npos == close) {
+            // a hint without arguments, none of which are known
+            pos = nameEnd;
+            continue;
+        }
+        std::vector<std::string> args = arguments(text.substr(open + 1, close - open - 1));
+        pos = close + 1;
+
+        if ("INDEX" == name && 1 <= args.size() && args.size() <= 2) {
+            hints->_indexCollection = 2 == args.size() ? args[0] : std::string();
+            hints->_index = args.back();
+        } else if (1 != args.size() || !positive(args[0])) {
+            continue;
+        } else if ("MAXTIME" == name) {
+            hints->_maxTimeMS = positive(args[0]);
+        } else if ("BATCH" == name) {
+            hints->_batchSize = positive(args[0]);
+        } else if ("PARALLEL" == name) {
+            hints->_parallel = positive(args[0]);
+        }
+    }
+}
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+QueryHints::QueryHints()
+    : _maxTimeMS(0)
+    , _batchSize(0)
+    , _parallel(0)
+{
+}
+
+bool QueryHints::indexApplies(const std::string& ns, bool first) const
+{
+    if (_index.empty()) {
+        return false;
+    }
+    if (_indexCollection.empty()) {
+        return first;
+    }
+    size_t periodIdx = ns.find('.');
+    return ns == _indexCollection
+        || (std::string::npos != periodIdx && 0 == ns.compare(periodIdx + 1,
+                                                              std::string::npos,
+                                                              _indexCollection));
+}
+
+void QueryHints::extract(const std::string& sql, std::string *stripped, QueryHints *hints)
+{
+    *hints = QueryHints();
+    stripped->clear();
+    stripped->reserve(sql.size());
+    size_t pos = 0;
+    while (pos < sql.size()) {
+        char c = sql[pos];
+        if ('\'' == c || '"' == c) {
+            // a literal, where a doubled quote stands for itself
+            size_t end = pos + 1;
+            while (end < sql.size() && (sql[end] != c || (end + 1 < sql.size() && c == sql[end + 1]))) {
+                end += sql[end] == c ? 2 : 1;
+            }
+            end = end < sql.size() ? end + 1 : end;
+            stripped->append(sql, pos, end - pos);
+            pos = end;
+        } else if ('/' == c && pos + 1 < sql.size() && '*' == sql[pos + 1]) {
+            size_t end = sql.find("*/", pos + 2);
+            size_t bodyEnd = std::string::npos == end ? sql.size() : end;
+            if (pos + 2 < sql.size() && '+' == sql[pos + 2]) {
+                parseHints(sql.substr(pos + 3, bodyEnd - pos - 3), hints);
+            }
+            stripped->push_back(' ');
+            pos = std::string::npos == end ? sql.size() : end + 2;
+        } else {
+            stripped->push_back(c);
+            ++pos;
+        }
+    }
+}
+
+} // close mongoodbc namespace
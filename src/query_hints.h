@@ -0,0 +1,67 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_QUERY_HINTS_H_
+#define MONGOODBC_QUERY_HINTS_H_
+
+#include <string>
+
+namespace mongoodbc {
+
+/*
+* Optimizer hints given in a comment of a statement's text, e.g.
+* 'SELECT /\*+ INDEX(db.orders status_1) MAXTIME(500) BATCH(5000) *\/ ...':
+*
+*   INDEX([collection] name)  read the collection through the index 'name';
+*                             without a collection, the first one read
+*   MAXTIME(ms)               give up on the server after 'ms' milliseconds
+*   BATCH(n)                  request 'n' documents per batch
+*   PARALLEL(n)               scan the collection with 'n' cursors at once
+*
+* As in other databases, hints are only advice: unknown or malformed hints
+* are ignored, and a statement runs the same without them.
+*/
+struct QueryHints {
+    // collection named by INDEX, 'db.collection' or 'collection', empty
+    // for the first one read
+    std::string _indexCollection;
+    // index named by INDEX, empty for none
+    std::string _index;
+    // 0 for none
+    int _maxTimeMS;
+    int _batchSize;
+    int _parallel;
+
+    QueryHints();
+
+    /*
+    * Returns whether the INDEX hint applies to 'ns', a 'db.collection'
+    * namespace read as the statement's first table if 'first' is set.
+    */
+    bool indexApplies(const std::string& ns, bool first) const;
+
+    /*
+    * Sets 'stripped' to 'sql' with each comment '/\* ... *\/' outside
+    * string literals replaced by a space, and 'hints' to the hints of
+    * those starting with '/\*+'.  An unterminated comment runs to the end
+    * of the text.
+    */
+    static void extract(const std::string& sql, std::string *stripped, QueryHints *hints);
+};
+
+} // close mongoodbc namespace
+
+#endif
@@ -0,0 +1,94 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "query_hints.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using mongoodbc::QueryHints;
+
+TEST(QueryHints, Extract)
+{
+    std::string stripped;
+    QueryHints hints;
+    QueryHints::extract("SELECT /*+ INDEX(db.orders status_1) MAXTIME(500) "
+                        "batch(5000) PARALLEL(4) */ a FROM db.orders",
+                        &stripped, &hints);
+    EXPECT_EQ("SELECT   a FROM db.orders", stripped);
+    EXPECT_EQ("db.orders", hints._indexCollection);
+    EXPECT_EQ("status_1", hints._index);
+    EXPECT_EQ(500, hints._maxTimeMS);
+    EXPECT_EQ(5000, hints._batchSize);
+    EXPECT_EQ(4, hints._parallel);
+}
+
+TEST(QueryHints, Comments)
+{
+    std::string stripped;
+    QueryHints hints;
+    // plain comments are removed without giving hints
+    QueryHints::extract("SELECT a /* MAXTIME(5) */ FROM db.t", &stripped, &hints);
+    EXPECT_EQ("SELECT a   FROM db.t", stripped);
+    EXPECT_EQ(0, hints._maxTimeMS);
+
+    // nor are comments in literals
+    QueryHints::extract("SELECT a FROM db.t WHERE b = '/*+ BATCH(5) */' AND c = 'it''s'",
+                        &stripped, &hints);
+    EXPECT_EQ("SELECT a FROM db.t WHERE b = '/*+ BATCH(5) */' AND c = 'it''s'", stripped);
+    EXPECT_EQ(0, hints._batchSize);
+
+    QueryHints::extract("SELECT a FROM db.t /*+ BATCH(7)", &stripped, &hints);
+    EXPECT_EQ("SELECT a FROM db.t  ", stripped);
+    EXPECT_EQ(7, hints._batchSize);
+}
+
+TEST(QueryHints, Malformed)
+{
+    std::string stripped;
+    QueryHints hints;
+    QueryHints::extract("SELECT /*+ FULL(t) MAXTIME(-1) BATCH(x) PARALLEL(2, 3) INDEX() "
+                        "ORDERED */ a FROM db.t", &stripped, &hints);
+    EXPECT_TRUE(hints._index.empty());
+    EXPECT_EQ(0, hints._maxTimeMS);
+    EXPECT_EQ(0, hints._batchSize);
+    EXPECT_EQ(0, hints._parallel);
+}
+
+TEST(QueryHints, IndexApplies)
+{
+    QueryHints hints;
+    EXPECT_FALSE(hints.indexApplies("db.t", true));
+
+    hints._index = "a_1";
+    EXPECT_TRUE(hints.indexApplies("db.t", true));
+    EXPECT_FALSE(hints.indexApplies("db.u", false));
+
+    hints._indexCollection = "t";
+    EXPECT_TRUE(hints.indexApplies("db.t", false));
+    EXPECT_FALSE(hints.indexApplies("db.u", true));
+
+    hints._indexCollection = "db.t";
+    EXPECT_TRUE(hints.indexApplies("db.t", false));
+    EXPECT_FALSE(hints.indexApplies("other.t", true));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
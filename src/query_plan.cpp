@@ -0,0 +1,208 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "query_plan.h"
+
+#include <mongo/bson/bsonobj.h>
+
+#include <sstream>
+
+#include <stdlib.h>
+
+namespace {
+
+using mongoodbc::SQLElementExpression;
+using mongoodbc::SQLToken;
+
+// Placeholders are string literals of the form "`<index>`", which both
+// parsers accept.  They copy literals verbatim, so placeholders come out
+// unchanged in the select list and in the '$where' text of the WHERE clause.
+const char PLACEHOLDER_MARK = '`';
+
+/*
+* Returns the text the parser produces for 'literal' in '$where' code.
+*/
+std::string literalText(const SQLToken& literal)
+{
+    if (SQLToken::STRING == literal._type) {
+        return mongoodbc::quoteWhereString(literal.unquoted());
+    }
+    std::ostringstream str;
+    str << strtoul(literal._begin, 0, 10);
+    return str.str();
+}
+
+/*
+* Returns the '$where' code 'str' with every placeholder replaced by its
+* value.  A placeholder is a string literal there, so its quotes go too.
+*/
+std::string substitute(const std::string& str, const std::vector<std::string>& values)
+{
+    size_t mark = str.find(PLACEHOLDER_MARK);
+    if (std::string::npos == mark) {
+        return str;
+    }
+
+    std::string result;
+    size_t pos = 0;
+    while (std::string::npos != mark) {
+        size_t end = str.find(PLACEHOLDER_MARK, mark + 1);
+        result.append(str, pos, mark - 1 - pos);
+        result.append(values[strtoul(str.c_str() + mark + 1, 0, 10)]);
+        pos = end + 2;
+        mark = str.find(PLACEHOLDER_MARK, pos);
+    }
+    result.append(str, pos, std::string::npos);
+    return result;
+}
+
+mongo::BSONObj bindObj(const mongo::BSONObj& obj, const std::vector<std::string>& values)
+{
+    mongo::BSONObjBuilder builder;
+    mongo::BSONObjIterator it(obj);
+    while (it.more()) {
+        mongo::BSONElement elem = it.next();
+        switch(elem.type()) {
+          case mongo::String: {
+            builder.append(elem.fieldName(), substitute(elem.String(), values));
+          } break;
+          case mongo::Object: {
+            builder.append(elem.fieldName(), bindObj(elem.embeddedObject(), values));
+          } break;
+          case mongo::Array: {
+            builder.appendArray(elem.fieldName(), bindObj(elem.embeddedObject(), values));
+          } break;
+          default: {
+            builder.append(elem);
+          } break;
+        }
+    }
+    return builder.obj();
+}
+
+void bindExpression(SQLElementExpression *expr, const std::vector<SQLToken>& literals);
+
+void bindPrimary(mongoodbc::SQLElementExpression_Primary *primary,
+                 const std::vector<SQLToken>& literals)
+{
+    if (primary->_literal && !primary->_literal->empty()
+        && PLACEHOLDER_MARK == (*primary->_literal)[0]) {
+        const SQLToken& literal = literals[strtoul(primary->_literal->c_str() + 1, 0, 10)];
+        if (SQLToken::NUMBER == literal._type) {
+            primary->_literal.reset();
+            primary->_num = strtoul(literal._begin, 0, 10);
+        } else {
+            primary->_literal = literal.unquoted();
+        }
+    }
+    for (size_t i = 0; i < primary->_expr.size(); ++i) {
+        bindExpression(&primary->_expr[i].get(), literals);
+    }
+}
+
+void bindTerm(mongoodbc::SQLElementExpression_Term *term, const std::vector<SQLToken>& literals)
+{
+    for (size_t i = 0; i < term->_term.size(); ++i) {
+        bindTerm(&term->_term[i].get(), literals);
+    }
+    bindPrimary(&term->_factor._primary, literals);
+}
+
+void bindExpression(SQLElementExpression *expr, const std::vector<SQLToken>& literals)
+{
+    for (size_t i = 0; i < expr->_expr.size(); ++i) {
+        bindExpression(&expr->_expr[i].get(), literals);
+    }
+    bindTerm(&expr->_term, literals);
+}
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+QueryPlan::QueryPlan()
+    : _numLiterals(0)
+    , _size(sizeof(QueryPlan))
+{
+}
+
+boost::shared_ptr<const QueryPlan> QueryPlan::compile(const std::string& sql,
+                                                      const std::vector<SQLToken>& literals,
+                                                      SQLParseFunction parse)
+{
+    boost::shared_ptr<const QueryPlan> result;
+    if (std::string::npos != sql.find(PLACEHOLDER_MARK)) {
+        // the placeholders would be ambiguous
+        return result;
+    }
+
+    std::ostringstream text;
+    const char *pos = sql.data();
+    for (size_t i = 0; i < literals.size(); ++i) {
+        text.write(pos, literals[i]._begin - pos);
+        // a string keeps its quote, which not every parser accepts
+        char quote = SQLToken::STRING == literals[i]._type ? literals[i]._begin[0] : '"';
+        text << quote << PLACEHOLDER_MARK << i << PLACEHOLDER_MARK << quote;
+        pos = literals[i]._begin + literals[i]._length;
+    }
+    text.write(pos, sql.data() + sql.size() - pos);
+
+    boost::shared_ptr<QueryPlan> plan(new QueryPlan());
+    if (0 != parse(text.str(), &plan->_stmt)) {
+        return result;
+    }
+    plan->_numLiterals = literals.size();
+    // the parsed statement takes a few times the space of its text
+    plan->_size += 4 * text.str().size();
+    if (plan->_stmt._whereClause) {
+        plan->_size += plan->_stmt._whereClause->obj.objsize();
+    }
+    result = plan;
+    return result;
+}
+
+int QueryPlan::bind(const std::vector<SQLToken>& literals, SQLStatement *stmt) const
+{
+    if (literals.size() != _numLiterals) {
+        return -1;
+    }
+
+    *stmt = _stmt;
+    if (literals.empty()) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < stmt->_selectList.size(); ++i) {
+        bindExpression(&stmt->_selectList[i], literals);
+    }
+    for (size_t i = 0; i < stmt->_groupBy.size(); ++i) {
+        bindExpression(&stmt->_groupBy[i], literals);
+    }
+    for (size_t i = 0; i < stmt->_orderBy.size(); ++i) {
+        bindExpression(&stmt->_orderBy[i]._expr, literals);
+    }
+    if (stmt->_whereClause) {
+        std::vector<std::string> values;
+        values.reserve(literals.size());
+        for (size_t i = 0; i < literals.size(); ++i) {
+            values.push_back(literalText(literals[i]));
+        }
+        stmt->_whereClause = mongo::Query(bindObj(stmt->_whereClause->obj, values));
+    }
+    return 0;
+}
+
+} // close mongoodbc namespace
@@ -0,0 +1,78 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_QUERY_PLAN_H_
+#define MONGOODBC_QUERY_PLAN_H_
+
+#include "sql_lexer.h"
+#include "sql_parser.h"
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+
+namespace mongoodbc {
+
+/*
+* Parses 'sql' into 'stmt'.
+* @return 0 on success, -1 if 'sql' cannot be parsed
+*/
+typedef int (*SQLParseFunction)(const std::string& sql, SQLStatement *stmt);
+
+/*
+* Parsed and translated form of a statement with its literals taken out, so
+* that one plan serves every statement differing only in literal values.
+*
+* The plan holds the statement parsed with each literal replaced by a
+* placeholder string; 'bind' puts the literals of a particular statement
+* back into the select list and the translated WHERE clause.
+*/
+class QueryPlan : boost::noncopyable {
+    SQLStatement _stmt;
+    size_t _numLiterals;
+    size_t _size;
+
+    QueryPlan();
+
+  public:
+    /*
+    * Builds the plan for 'sql', whose literal tokens are 'literals' in the
+    * order they appear, parsing it with 'parse'.
+    * @return the plan, or null if 'sql' cannot be parsed
+    */
+    static boost::shared_ptr<const QueryPlan> compile(const std::string& sql,
+                                                      const std::vector<SQLToken>& literals,
+                                                      SQLParseFunction parse);
+
+    /*
+    * Stores in 'stmt' the statement with 'literals' in place of the
+    * placeholders.  'literals' must come from a statement with the same
+    * normalized text as the one the plan was compiled from.
+    * @return 0 on success, -1 if the number of literals does not match
+    */
+    int bind(const std::vector<SQLToken>& literals, SQLStatement *stmt) const;
+
+    /*
+    * Returns an estimate of the memory held by the plan in bytes.
+    */
+    size_t size() const { return _size; }
+};
+
+} // close mongoodbc namespace
+
+#endif
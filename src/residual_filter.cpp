@@ -0,0 +1,627 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "residual_filter.h"
+
+#include "native_filter.h"
+#include "sql_element_expression.h"
+#include "sql_lexer.h"
+
+#include <mongo/client/dbclient.h>
+
+#include <functional>
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+using mongoodbc::SQLLexer;
+using mongoodbc::SQLToken;
+
+bool isComparison(SQLToken::Type type)
+{
+    return SQLToken::EQ == type || SQLToken::NE == type || SQLToken::LT == type
+           || SQLToken::LE == type || SQLToken::GT == type || SQLToken::GE == type;
+}
+
+/*
+* Adds the conjuncts of the '$and' tree 'cond' to 'conjuncts'.
+*/
+void splitConjuncts(const mongo::BSONObj& cond, std::vector<mongo::BSONObj> *conjuncts)
+{
+    if (cond.isEmpty()) {
+        return;
+    }
+    mongo::BSONElement andElem = cond.getField("$and");
+    if (1 != cond.nFields() || mongo::Array != andElem.type()) {
+        conjuncts->push_back(cond);
+        return;
+    }
+    mongo::BSONObjIterator termIt(andElem.embeddedObject());
+    while (termIt.more()) {
+        splitConjuncts(termIt.next().embeddedObject(), conjuncts);
+    }
+}
+
+mongo::BSONObj conjunction(const std::vector<mongo::BSONObj>& conjuncts)
+{
+    if (conjuncts.empty()) {
+        return mongo::BSONObj();
+    }
+    if (1 == conjuncts.size()) {
+        return conjuncts[0];
+    }
+    mongo::BSONArrayBuilder terms;
+    for (size_t i = 0; i < conjuncts.size(); ++i) {
+        terms.append(conjuncts[i]);
+    }
+    return BSON("$and" << terms.arr());
+}
+
+/*
+* Compares numbers over a batch: a row is true or false if both operands
+* are numbers, neither otherwise.
+*/
+template <typename Compare>
+void compareNumbers(Compare cmp,
+                    const double *lhs,
+                    const unsigned char *lhsValid,
+                    const double *rhs,
+                    const unsigned char *rhsValid,
+                    size_t numRows,
+                    unsigned char *isTrue,
+                    unsigned char *isFalse)
+{
+    for (size_t i = 0; i < numRows; ++i) {
+        unsigned char known = lhsValid[i] & rhsValid[i];
+        unsigned char result = cmp(lhs[i], rhs[i]);
+        isTrue[i] = known & result;
+        isFalse[i] = known & !result;
+    }
+}
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+/*
+* Compiles conditions into the nodes of a 'ResidualFilter'.  Comparisons
+* are read from their '$where' text: columns are written 'this.<column>'
+* or 'this.<table>.this.<column>', a column being a dotted path for an
+* embedded field, and string literals as by 'quoteWhereString'.
+*/
+class ResidualFilter::Compiler {
+    std::vector<Node> *_nodes;
+    const std::string& _defaultQualifier;
+    std::string *_errmsg;
+
+    // the operand being parsed
+    SQLLexer *_lexer;
+
+    size_t add(Node::Kind kind, int op, size_t left, size_t right)
+    {
+        Node node;
+        node._kind = kind;
+        node._op = op;
+        node._left = left;
+        node._right = right;
+        node._num = 0;
+        _nodes->push_back(node);
+        return _nodes->size() - 1;
+    }
+
+    bool acceptThis()
+    {
+        if (!_lexer->peek().isKeyword("THIS")) {
+            return false;
+        }
+        _lexer->next();
+        return SQLToken::DOT == _lexer->next()._type;
+    }
+
+    int primary(size_t *node);
+    int factor(size_t *node);
+    int term(size_t *node);
+    int expression(size_t *node);
+    int operand(const char *begin, const char *end, size_t *node);
+    int comparison(const std::string& text, size_t *node);
+
+  public:
+    Compiler(std::vector<Node> *nodes, const std::string& defaultQualifier, std::string *errmsg)
+        : _nodes(nodes)
+        , _defaultQualifier(defaultQualifier)
+        , _errmsg(errmsg)
+        , _lexer(0)
+    {
+    }
+
+    int condition(const mongo::BSONObj& cond, size_t *node);
+};
+
+int ResidualFilter::Compiler::primary(size_t *node)
+{
+    SQLToken token = _lexer->peek();
+    switch(token._type) {
+      case SQLToken::NUMBER: {
+        _lexer->next();
+        *node = add(Node::NUMBER, 0, 0, 0);
+        (*_nodes)[*node]._num = strtod(token.text().c_str(), 0);
+      } break;
+      case SQLToken::LPAREN: {
+        _lexer->next();
+        if (0 != expression(node) || SQLToken::RPAREN != _lexer->next()._type) {
+            return -1;
+        }
+      } break;
+      case SQLToken::IDENTIFIER: {
+        if (!acceptThis() || SQLToken::IDENTIFIER != _lexer->peek()._type) {
+            return -1;
+        }
+        std::string field = _lexer->next().text();
+        bool qualified = false;
+        while (SQLToken::DOT == _lexer->peek()._type) {
+            _lexer->next();
+            if (!qualified && _lexer->peek().isKeyword("THIS")) {
+                // 'this.<table>.this.<column>'
+                if (!acceptThis()) {
+                    return -1;
+                }
+                qualified = true;
+            }
+            // else a path into embedded documents
+            if (SQLToken::IDENTIFIER != _lexer->peek()._type) {
+                return -1;
+            }
+            field += "." + _lexer->next().text();
+        }
+        if (!qualified && !_defaultQualifier.empty()) {
+            field = _defaultQualifier + "." + field;
+        }
+        *node = add(Node::COLUMN, 0, 0, 0);
+        (*_nodes)[*node]._str = field;
+      } break;
+      default: {
+        return -1;
+      }
+    }
+    return 0;
+}
+
+int ResidualFilter::Compiler::factor(size_t *node)
+{
+    SQLToken::Type type = _lexer->peek()._type;
+    if (SQLToken::MINUS != type && SQLToken::PLUS != type) {
+        return primary(node);
+    }
+    // '-x' as '0 - x', and '+x' as '0 + x' so that it must be a number
+    _lexer->next();
+    size_t operand;
+    if (0 != factor(&operand)) {
+        return -1;
+    }
+    size_t zero = add(Node::NUMBER, 0, 0, 0);
+    *node = add(Node::ARITHMETIC, SQLToken::MINUS == type ? '-' : '+', zero, operand);
+    return 0;
+}
+
+int ResidualFilter::Compiler::term(size_t *node)
+{
+    if (0 != factor(node)) {
+        return -1;
+    }
+    while (SQLToken::STAR == _lexer->peek()._type || SQLToken::SLASH == _lexer->peek()._type) {
+        char op = _lexer->next()._begin[0];
+        size_t rhs;
+        if (0 != factor(&rhs)) {
+            return -1;
+        }
+        *node = add(Node::ARITHMETIC, op, *node, rhs);
+    }
+    return 0;
+}
+
+int ResidualFilter::Compiler::expression(size_t *node)
+{
+    if (0 != term(node)) {
+        return -1;
+    }
+    while (SQLToken::PLUS == _lexer->peek()._type || SQLToken::MINUS == _lexer->peek()._type) {
+        char op = _lexer->next()._begin[0];
+        size_t rhs;
+        if (0 != term(&rhs)) {
+            return -1;
+        }
+        *node = add(Node::ARITHMETIC, op, *node, rhs);
+    }
+    return 0;
+}
+
+int ResidualFilter::Compiler::operand(const char *begin, const char *end, size_t *node)
+{
+    // a string is only compared, never part of an expression
+    std::string value;
+    if (0 == unquoteWhereString(std::string(begin, end), &value)) {
+        *node = add(Node::STRING, 0, 0, 0);
+        (*_nodes)[*node]._str = value;
+        return 0;
+    }
+
+    size_t numNodes = _nodes->size();
+    SQLLexer lexer(begin, end);
+    _lexer = &lexer;
+    int rc = expression(node);
+    _lexer = 0;
+    if (0 == rc && SQLToken::END == lexer.peek()._type) {
+        return 0;
+    }
+
+    _nodes->resize(numNodes);
+    *_errmsg = "cannot evaluate '" + std::string(begin, end) + "'";
+    return -1;
+}
+
+int ResidualFilter::Compiler::comparison(const std::string& text, size_t *node)
+{
+    // the operator is the first comparison outside parentheses, written
+    // with spaces around it
+    const char *begin = text.data();
+    const char *end = begin + text.size();
+    SQLLexer lexer(begin, end);
+    int depth = 0;
+    while (SQLToken::END != lexer.peek()._type && SQLToken::ERROR != lexer.peek()._type) {
+        SQLToken token = lexer.next();
+        if (SQLToken::LPAREN == token._type) {
+            ++depth;
+        } else if (SQLToken::RPAREN == token._type) {
+            --depth;
+        } else if (0 == depth && isComparison(token._type)) {
+            const char *opEnd = token._begin + token._length;
+            if (SQLToken::EQ == token._type && SQLToken::EQ == lexer.peek()._type) {
+                // '=='
+                opEnd = lexer.next()._begin + 1;
+            }
+            if (token._begin == begin || ' ' != token._begin[-1]
+                || opEnd == end || ' ' != *opEnd) {
+                continue;
+            }
+            size_t lhs;
+            size_t rhs;
+            if (0 != operand(begin, token._begin - 1, &lhs)
+                || 0 != operand(opEnd + 1, end, &rhs)) {
+                return -1;
+            }
+            *node = add(Node::COMPARISON, token._type, lhs, rhs);
+            return 0;
+        }
+    }
+    *_errmsg = "cannot evaluate '" + text + "'";
+    return -1;
+}
+
+int ResidualFilter::Compiler::condition(const mongo::BSONObj& cond, size_t *node)
+{
+    if (1 != cond.nFields()) {
+        *_errmsg = "cannot evaluate " + cond.toString();
+        return -1;
+    }
+    mongo::BSONElement elem = cond.firstElement();
+    if (0 == strcmp("$where", elem.fieldName()) && mongo::String == elem.type()) {
+        return comparison(elem.str(), node);
+    }
+    if (0 == strcmp("$not", elem.fieldName()) && mongo::Object == elem.type()) {
+        size_t operand;
+        if (0 != condition(elem.embeddedObject(), &operand)) {
+            return -1;
+        }
+        *node = add(Node::NOT, 0, operand, 0);
+        return 0;
+    }
+    bool isAnd = 0 == strcmp("$and", elem.fieldName());
+    if ((isAnd || 0 == strcmp("$or", elem.fieldName())) && mongo::Array == elem.type()) {
+        bool first = true;
+        mongo::BSONObjIterator termIt(elem.embeddedObject());
+        while (termIt.more()) {
+            mongo::BSONElement term = termIt.next();
+            size_t operand;
+            if (mongo::Object != term.type() || 0 != condition(term.embeddedObject(), &operand)) {
+                return -1;
+            }
+            *node = first ? operand : add(isAnd ? Node::AND : Node::OR, 0, *node, operand);
+            first = false;
+        }
+        if (!first) {
+            return 0;
+        }
+    }
+    *_errmsg = "cannot evaluate " + cond.toString();
+    return -1;
+}
+
+int ResidualFilter::compile(const mongo::BSONObj& cond,
+                            const std::string& defaultQualifier,
+                            std::string *errmsg)
+{
+    _nodes.clear();
+    _columns.clear();
+    _columnPaths.clear();
+    _paths = FieldPaths();
+    if (cond.isEmpty()) {
+        _vectors.clear();
+        return 0;
+    }
+
+    size_t root;
+    if (0 != Compiler(&_nodes, defaultQualifier, errmsg).condition(cond, &root)) {
+        _nodes.clear();
+        return -1;
+    }
+    // nodes are added after their operands, so the condition comes last
+    for (size_t i = 0; i < _nodes.size(); ++i) {
+        if (Node::COLUMN == _nodes[i]._kind) {
+            _columns.push_back(i);
+            _columnPaths.push_back(_paths.add(_nodes[i]._str));
+        }
+    }
+    _vectors.assign(_nodes.size(), Vector());
+    return 0;
+}
+
+void ResidualFilter::decode(const std::vector<mongo::BSONObj>& rows)
+{
+    size_t numRows = rows.size();
+    for (size_t c = 0; c < _columns.size(); ++c) {
+        Vector& column = _vectors[_columns[c]];
+        column._num.assign(numRows, 0);
+        column._isNum.assign(numRows, 0);
+        column._str.resize(numRows);
+        column._isStr.assign(numRows, 0);
+    }
+
+    // one walk over each row finds all columns
+    for (size_t i = 0; i < numRows; ++i) {
+        _paths.extract(rows[i], &_values);
+        for (size_t c = 0; c < _columns.size(); ++c) {
+            const mongo::BSONElement& elem = _values[_columnPaths[c]];
+            Vector& column = _vectors[_columns[c]];
+            if (elem.isNumber()) {
+                column._num[i] = elem.number();
+                column._isNum[i] = 1;
+            } else if (mongo::String == elem.type()) {
+                column._str[i].assign(elem.valuestr(), elem.valuestrsize() - 1);
+                column._isStr[i] = 1;
+            }
+        }
+    }
+}
+
+void ResidualFilter::evaluate(size_t node, size_t numRows)
+{
+    const Node& n = _nodes[node];
+    Vector& out = _vectors[node];
+    switch(n._kind) {
+      case Node::COLUMN: {
+        // decoded
+      } break;
+      case Node::NUMBER: {
+        out._num.assign(numRows, n._num);
+        out._isNum.assign(numRows, 1);
+      } break;
+      case Node::STRING: {
+        out._str.assign(numRows, n._str);
+        out._isStr.assign(numRows, 1);
+      } break;
+      case Node::ARITHMETIC: {
+        const double *lhs = &_vectors[n._left]._num[0];
+        const double *rhs = &_vectors[n._right]._num[0];
+        const unsigned char *lhsValid = &_vectors[n._left]._isNum[0];
+        const unsigned char *rhsValid = &_vectors[n._right]._isNum[0];
+        out._num.resize(numRows);
+        out._isNum.resize(numRows);
+        double *num = &out._num[0];
+        unsigned char *valid = &out._isNum[0];
+        switch(n._op) {
+          case '+': {
+            for (size_t i = 0; i < numRows; ++i) {
+                num[i] = lhs[i] + rhs[i];
+                valid[i] = lhsValid[i] & rhsValid[i];
+            }
+          } break;
+          case '-': {
+            for (size_t i = 0; i < numRows; ++i) {
+                num[i] = lhs[i] - rhs[i];
+                valid[i] = lhsValid[i] & rhsValid[i];
+            }
+          } break;
+          case '*': {
+            for (size_t i = 0; i < numRows; ++i) {
+                num[i] = lhs[i] * rhs[i];
+                valid[i] = lhsValid[i] & rhsValid[i];
+            }
+          } break;
+          default: {
+            for (size_t i = 0; i < numRows; ++i) {
+                bool zero = 0 == rhs[i];
+                num[i] = lhs[i] / (zero ? 1 : rhs[i]);
+                valid[i] = lhsValid[i] & rhsValid[i] & !zero;
+            }
+          } break;
+        }
+      } break;
+      case Node::COMPARISON: {
+        const Vector& lhs = _vectors[n._left];
+        const Vector& rhs = _vectors[n._right];
+        out._true.resize(numRows);
+        out._false.resize(numRows);
+        unsigned char *t = &out._true[0];
+        unsigned char *f = &out._false[0];
+        if (lhs._isNum.empty() || rhs._isNum.empty()) {
+            // a string literal is never a number
+            out._true.assign(numRows, 0);
+            out._false.assign(numRows, 0);
+        } else {
+            const double *l = &lhs._num[0];
+            const double *r = &rhs._num[0];
+            const unsigned char *lv = &lhs._isNum[0];
+            const unsigned char *rv = &rhs._isNum[0];
+            switch(n._op) {
+              case SQLToken::EQ: {
+                compareNumbers(std::equal_to<double>(), l, lv, r, rv, numRows, t, f);
+              } break;
+              case SQLToken::NE: {
+                compareNumbers(std::not_equal_to<double>(), l, lv, r, rv, numRows, t, f);
+              } break;
+              case SQLToken::LT: {
+                compareNumbers(std::less<double>(), l, lv, r, rv, numRows, t, f);
+              } break;
+              case SQLToken::LE: {
+                compareNumbers(std::less_equal<double>(), l, lv, r, rv, numRows, t, f);
+              } break;
+              case SQLToken::GT: {
+                compareNumbers(std::greater<double>(), l, lv, r, rv, numRows, t, f);
+              } break;
+              default: {
+                compareNumbers(std::greater_equal<double>(), l, lv, r, rv, numRows, t, f);
+              } break;
+            }
+        }
+        if (!lhs._isStr.empty() && !rhs._isStr.empty()) {
+            for (size_t i = 0; i < numRows; ++i) {
+                if (!(lhs._isStr[i] & rhs._isStr[i])) {
+                    continue;
+                }
+                int cmp = lhs._str[i].compare(rhs._str[i]);
+                bool result;
+                switch(n._op) {
+                  case SQLToken::EQ: result = 0 == cmp; break;
+                  case SQLToken::NE: result = 0 != cmp; break;
+                  case SQLToken::LT: result = cmp < 0; break;
+                  case SQLToken::LE: result = cmp <= 0; break;
+                  case SQLToken::GT: result = cmp > 0; break;
+                  default: result = cmp >= 0; break;
+                }
+                t[i] = result;
+                f[i] = !result;
+            }
+        }
+      } break;
+      case Node::AND:
+      case Node::OR: {
+        const Vector& lhs = _vectors[n._left];
+        const Vector& rhs = _vectors[n._right];
+        out._true.resize(numRows);
+        out._false.resize(numRows);
+        const unsigned char *lt = &lhs._true[0];
+        const unsigned char *lf = &lhs._false[0];
+        const unsigned char *rt = &rhs._true[0];
+        const unsigned char *rf = &rhs._false[0];
+        unsigned char *t = &out._true[0];
+        unsigned char *f = &out._false[0];
+        if (Node::AND == n._kind) {
+            for (size_t i = 0; i < numRows; ++i) {
+                t[i] = lt[i] & rt[i];
+                f[i] = lf[i] | rf[i];
+            }
+        } else {
+            for (size_t i = 0; i < numRows; ++i) {
+                t[i] = lt[i] | rt[i];
+                f[i] = lf[i] & rf[i];
+            }
+        }
+      } break;
+      case Node::NOT: {
+        out._true = _vectors[n._left]._false;
+        out._false = _vectors[n._left]._true;
+      } break;
+    }
+}
+
+void ResidualFilter::select(const std::vector<mongo::BSONObj>& rows, std::vector<size_t> *selection)
+{
+    selection->clear();
+    if (_nodes.empty()) {
+        for (size_t i = 0; i < rows.size(); ++i) {
+            selection->push_back(i);
+        }
+        return;
+    }
+    if (rows.empty()) {
+        return;
+    }
+
+    decode(rows);
+    for (size_t node = 0; node < _nodes.size(); ++node) {
+        evaluate(node, rows.size());
+    }
+    const std::vector<unsigned char>& accepted = _vectors.back()._true;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (accepted[i]) {
+            selection->push_back(i);
+        }
+    }
+}
+
+void splitResidual(const mongo::BSONObj& cond, mongo::BSONObj *pushed, mongo::BSONObj *residual)
+{
+    std::vector<mongo::BSONObj> conjuncts;
+    splitConjuncts(cond, &conjuncts);
+    std::vector<mongo::BSONObj> pushedConjuncts;
+    std::vector<mongo::BSONObj> residualConjuncts;
+    for (size_t i = 0; i < conjuncts.size(); ++i) {
+        mongo::BSONObj native;
+        ResidualFilter filter;
+        std::string errmsg;
+        if (0 == nativeFilter(conjuncts[i], &native)) {
+            pushedConjuncts.push_back(native);
+        } else if (0 == filter.compile(conjuncts[i], "", &errmsg)) {
+            residualConjuncts.push_back(conjuncts[i]);
+        } else {
+            pushedConjuncts.push_back(conjuncts[i]);
+        }
+    }
+    *pushed = conjunction(pushedConjuncts);
+    *residual = conjunction(residualConjuncts);
+}
+
+FilterRowSource::FilterRowSource(std::auto_ptr<RowSource> source, const ResidualFilter& filter)
+    : _source(source)
+    , _filter(filter)
+    , _next(0)
+{
+}
+
+bool FilterRowSource::more()
+{
+    while (_next >= _selection.size()) {
+        _batch.clear();
+        while (_batch.size() < ResidualFilter::BATCH_SIZE && _source->more()) {
+            _batch.push_back(_source->next().getOwned());
+        }
+        if (_batch.empty()) {
+            return false;
+        }
+        _filter.select(_batch, &_selection);
+        _next = 0;
+    }
+    return true;
+}
+
+mongo::BSONObj FilterRowSource::next()
+{
+    return _batch[_selection[_next++]];
+}
+
+} // close mongoodbc namespace
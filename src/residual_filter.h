@@ -0,0 +1,160 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_RESIDUAL_FILTER_H_
+#define MONGOODBC_RESIDUAL_FILTER_H_
+
+#include "field_paths.h"
+#include "row_source.h"
+
+#include <mongo/bson/bsonobj.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mongoodbc {
+
+/*
+* WHERE condition evaluated by the driver over batches of rows, for
+* conditions the server cannot evaluate natively, e.g. 'a + b > c' or a
+* comparison between columns of joined tables.
+*
+* The condition is compiled from the form the parsers give it: comparisons
+* in '$where', combined with '$and', '$or' and '$not'.  A batch is
+* evaluated column-wise: the referenced fields of every row, which may be
+* paths into embedded documents, are first decoded in one walk over each
+* row into number and string vectors, then
+* each node of the condition runs as a simple loop over the whole batch,
+* which the compiler can vectorize, down to a selection vector of the rows
+* that pass.
+*
+* Comparisons are between numbers or between strings; any other operands,
+* e.g. a missing field, a string in arithmetic or a division by zero, make
+* the comparison unknown.  Unknown combines as in SQL, and rows whose
+* condition is unknown are rejected.
+*/
+class ResidualFilter {
+  public:
+    enum {
+        BATCH_SIZE = 1024
+    };
+
+  private:
+    struct Node {
+        enum Kind {
+            COLUMN,
+            NUMBER,
+            STRING,
+            ARITHMETIC,
+            COMPARISON,
+            AND,
+            OR,
+            NOT
+        };
+
+        Kind _kind;
+        // '+', '-', '*' or '/' for ARITHMETIC, the comparison's token type
+        // for COMPARISON
+        int _op;
+        // operands, indexes of earlier nodes
+        size_t _left;
+        size_t _right;
+        // field of a COLUMN, value of a STRING
+        std::string _str;
+        double _num;
+    };
+
+    /*
+    * Values of a node over a batch.  Values are numbers, strings or
+    * neither; conditions are true, false or neither.
+    */
+    struct Vector {
+        std::vector<double> _num;
+        std::vector<unsigned char> _isNum;
+        std::vector<std::string> _str;
+        std::vector<unsigned char> _isStr;
+        std::vector<unsigned char> _true;
+        std::vector<unsigned char> _false;
+    };
+
+    class Compiler;
+
+    // in evaluation order, the condition last; empty for no condition
+    std::vector<Node> _nodes;
+    // scratch space, one vector per node
+    std::vector<Vector> _vectors;
+    // COLUMN nodes and the index of each one's field in '_paths'
+    std::vector<size_t> _columns;
+    std::vector<size_t> _columnPaths;
+    FieldPaths _paths;
+    // scratch space, the fields of one row
+    std::vector<mongo::BSONElement> _values;
+
+    void decode(const std::vector<mongo::BSONObj>& rows);
+    void evaluate(size_t node, size_t numRows);
+
+  public:
+    /*
+    * Compiles 'cond'.  Unqualified columns are read from the field
+    * '<defaultQualifier>.<column>' if 'defaultQualifier' is not empty.
+    * @return 0 on success, -1 with a description in 'errmsg' if 'cond'
+    *         holds anything else than comparisons of columns, numbers and
+    *         strings with arithmetic
+    */
+    int compile(const mongo::BSONObj& cond,
+                const std::string& defaultQualifier,
+                std::string *errmsg);
+
+    bool empty() const { return _nodes.empty(); }
+
+    /*
+    * Replaces the content of 'selection' with the indexes of the 'rows'
+    * the condition accepts, in order.
+    */
+    void select(const std::vector<mongo::BSONObj>& rows, std::vector<size_t> *selection);
+};
+
+/*
+* Splits the WHERE condition of a single collection into the conjuncts the
+* server evaluates natively, translated by 'nativeFilter', or that cannot
+* be compiled, in 'pushed', and the others, in 'residual', for a
+* 'ResidualFilter'.  Either may be empty.
+*/
+void splitResidual(const mongo::BSONObj& cond, mongo::BSONObj *pushed, mongo::BSONObj *residual);
+
+/*
+* Row source returning the rows of another source accepted by a
+* 'ResidualFilter', read in batches of BATCH_SIZE.
+*/
+class FilterRowSource : public RowSource {
+    std::auto_ptr<RowSource> _source;
+    ResidualFilter _filter;
+    std::vector<mongo::BSONObj> _batch;
+    std::vector<size_t> _selection;
+    size_t _next;
+
+  public:
+    FilterRowSource(std::auto_ptr<RowSource> source, const ResidualFilter& filter);
+
+    virtual bool more();
+
+    virtual mongo::BSONObj next();
+};
+
+} // close mongoodbc namespace
+
+#endif
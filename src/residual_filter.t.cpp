@@ -0,0 +1,195 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#include "residual_filter.h"
+#include "sql_fast_parser.h"
+#include "vector_row_source.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using mongoodbc::FilterRowSource;
+using mongoodbc::ResidualFilter;
+using mongoodbc::RowSource;
+using mongoodbc::VectorRowSource;
+
+namespace {
+
+mongo::BSONObj whereOf(const std::string& sql)
+{
+    mongoodbc::SQLStatement stmt;
+    std::string errmsg;
+    EXPECT_EQ(0, mongoodbc::SQLFastParser::parse(sql, &stmt, &errmsg)) << sql << ": " << errmsg;
+    return stmt._whereClause ? stmt._whereClause->obj : mongo::BSONObj();
+}
+
+/*
+* Returns the indexes of the 'rows' accepted by the WHERE clause of 'sql'.
+*/
+std::vector<size_t> select(const std::string& sql,
+                           const std::vector<mongo::BSONObj>& rows,
+                           const std::string& defaultQualifier = std::string())
+{
+    ResidualFilter filter;
+    std::string errmsg;
+    EXPECT_EQ(0, filter.compile(whereOf(sql), defaultQualifier, &errmsg)) << sql << ": " << errmsg;
+    std::vector<size_t> selection;
+    filter.select(rows, &selection);
+    return selection;
+}
+
+std::vector<size_t> indexes(size_t a, size_t b = (size_t)-1, size_t c = (size_t)-1)
+{
+    std::vector<size_t> result(1, a);
+    if ((size_t)-1 != b) {
+        result.push_back(b);
+    }
+    if ((size_t)-1 != c) {
+        result.push_back(c);
+    }
+    return result;
+}
+
+} // close unnamed namespace
+
+TEST(ResidualFilter, Arithmetic)
+{
+    std::vector<mongo::BSONObj> rows;
+    rows.push_back(BSON("a" << 1 << "b" << 2 << "c" << 2));
+    rows.push_back(BSON("a" << 1 << "b" << 2 << "c" << 3));
+    rows.push_back(BSON("a" << 1.5 << "b" << 2LL << "c" << 3));
+    rows.push_back(BSON("a" << "x" << "b" << 2 << "c" << 0));
+    rows.push_back(BSON("b" << 2 << "c" << 0));
+
+    EXPECT_EQ(indexes(0, 2), select("SELECT * FROM db.t WHERE a + b > c", rows));
+    EXPECT_EQ(indexes(1), select("SELECT * FROM db.t WHERE (a + b) * 2 = c * 2", rows));
+    EXPECT_EQ(indexes(0, 1, 2), select("SELECT * FROM db.t WHERE -a < b - c + 10 / b", rows));
+    // a division by zero has no value
+    EXPECT_TRUE(select("SELECT * FROM db.t WHERE b / (c - c) > 0", rows).empty());
+}
+
+TEST(ResidualFilter, Logic)
+{
+    std::vector<mongo::BSONObj> rows;
+    rows.push_back(BSON("a" << 1 << "b" << 1));
+    rows.push_back(BSON("a" << 2 << "b" << 1));
+    rows.push_back(BSON("b" << 1));
+
+    EXPECT_EQ(indexes(0), select("SELECT * FROM db.t WHERE a = b AND b = 1", rows));
+    EXPECT_EQ(indexes(0, 1), select("SELECT * FROM db.t WHERE a = b OR a > b", rows));
+    // unknown stays unknown under NOT, but an OR with a true side is true
+    EXPECT_EQ(indexes(1), select("SELECT * FROM db.t WHERE NOT a = b", rows));
+    EXPECT_EQ(indexes(0, 1, 2), select("SELECT * FROM db.t WHERE NOT a = b OR b = 1", rows));
+}
+
+TEST(ResidualFilter, Strings)
+{
+    std::vector<mongo::BSONObj> rows;
+    rows.push_back(BSON("name" << "bob" << "nick" << "bob"));
+    rows.push_back(BSON("name" << "al" << "nick" << "bob"));
+    rows.push_back(BSON("name" << 5 << "nick" << "5"));
+
+    EXPECT_EQ(indexes(0), select("SELECT * FROM db.t WHERE name = 'bob'", rows));
+    EXPECT_EQ(indexes(0), select("SELECT * FROM db.t WHERE name = nick", rows));
+    EXPECT_EQ(indexes(1), select("SELECT * FROM db.t WHERE name < nick", rows));
+    // strings and numbers do not compare
+    EXPECT_EQ(indexes(1), select("SELECT * FROM db.t WHERE name != nick", rows));
+    // a string literal is a string, whatever its text
+    EXPECT_EQ(indexes(2), select("SELECT * FROM db.t WHERE nick = '5'", rows));
+    EXPECT_TRUE(select("SELECT * FROM db.t WHERE name = '5'", rows).empty());
+}
+
+TEST(ResidualFilter, QualifiedColumns)
+{
+    std::vector<mongo::BSONObj> rows;
+    rows.push_back(BSON("a.x" << 1 << "b.y" << 2));
+    rows.push_back(BSON("a.x" << 3 << "b.y" << 2));
+
+    EXPECT_EQ(indexes(0), select("SELECT * FROM db.a, db.b WHERE a.x < b.y", rows));
+    EXPECT_EQ(indexes(1), select("SELECT * FROM db.a, db.b WHERE x > b.y", rows, "a"));
+}
+
+TEST(ResidualFilter, Paths)
+{
+    std::vector<mongo::BSONObj> rows;
+    rows.push_back(BSON("a" << 1 << "geo" << BSON("lat" << 2 << "lng" << 5)));
+    rows.push_back(BSON("a" << 3 << "geo" << BSON("lat" << 2)));
+    rows.push_back(BSON("a" << 3 << "geo" << 2));
+
+    EXPECT_EQ(indexes(0), select("SELECT * FROM db.c WHERE geo.lat + a < geo.lng", rows));
+    EXPECT_EQ(indexes(1, 2), select("SELECT * FROM db.c WHERE a > geo.lat OR a > geo", rows));
+
+    // the embedded documents of joined rows
+    std::vector<mongo::BSONObj> joined;
+    joined.push_back(BSON("t.a" << 1 << "t.geo" << BSON("lat" << 2)));
+    EXPECT_EQ(indexes(0), select("SELECT * FROM db.t, db.u WHERE t.geo.lat > t.a", joined));
+}
+
+TEST(ResidualFilter, Errors)
+{
+    ResidualFilter filter;
+    std::string errmsg;
+    EXPECT_NE(0, filter.compile(whereOf("SELECT * FROM db.t WHERE a + ? > c"), "", &errmsg));
+    EXPECT_NE(0, filter.compile(BSON("a" << 1), "", &errmsg));
+    EXPECT_EQ(0, filter.compile(mongo::BSONObj(), "", &errmsg));
+    EXPECT_TRUE(filter.empty());
+}
+
+TEST(ResidualFilter, Split)
+{
+    mongo::BSONObj pushed;
+    mongo::BSONObj residual;
+    mongoodbc::splitResidual(whereOf("SELECT * FROM db.t WHERE a > 1 AND a + b > c AND d = ?"),
+                             &pushed,
+                             &residual);
+    EXPECT_EQ(BSON("$where" << "this.a + this.b > this.c").toString(), residual.toString());
+    std::string pushedStr = pushed.toString();
+    EXPECT_NE(std::string::npos, pushedStr.find(BSON("a" << BSON("$gt" << 1)).toString()));
+    EXPECT_NE(std::string::npos, pushedStr.find("this.d == ?"));
+
+    mongoodbc::splitResidual(whereOf("SELECT * FROM db.t WHERE a > 1"), &pushed, &residual);
+    EXPECT_EQ(BSON("a" << BSON("$gt" << 1)).toString(), pushed.toString());
+    EXPECT_TRUE(residual.isEmpty());
+}
+
+TEST(FilterRowSource, Batches)
+{
+    std::vector<mongo::BSONObj> rows;
+    for (int i = 0; i < 3000; ++i) {
+        rows.push_back(BSON("a" << i << "b" << i % 3));
+    }
+    ResidualFilter filter;
+    std::string errmsg;
+    ASSERT_EQ(0, filter.compile(whereOf("SELECT * FROM db.t WHERE a - b * 0 > 1000 AND b = 0"),
+                                "",
+                                &errmsg)) << errmsg;
+    FilterRowSource source(std::auto_ptr<RowSource>(new VectorRowSource(rows)), filter);
+    int count = 0;
+    int expected = 1002;
+    while (source.more()) {
+        EXPECT_EQ(expected, source.next().getIntField("a"));
+        expected += 3;
+        ++count;
+    }
+    EXPECT_EQ(666, count);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,127 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#include "row_count.h"
+#include "catalog_cache.h"
+#include "connection_handle.h"
+
+#include <time.h>
+
+#include <algorithm>
+#include <sstream>
+
+namespace mongoodbc {
+
+RowCount::RowCount()
+    : _kind(UNKNOWN_ROWS)
+    , _limit(0)
+    , _evaluated(true)
+    , _rows(UNKNOWN)
+{
+}
+
+void RowCount::setRows(long long rows)
+{
+    _kind = KNOWN_ROWS;
+    _evaluated = true;
+    _rows = rows;
+}
+
+void RowCount::setCount(const std::string& ns,
+                        const mongo::BSONObj& filter,
+                        const std::string& hint,
+                        long long limit)
+{
+    _kind = COUNTED_ROWS;
+    _ns = ns;
+    _filter = filter.getOwned();
+    _hint = hint;
+    _limit = limit;
+    _evaluated = false;
+    _rows = UNKNOWN;
+}
+
+std::string RowCount::key() const
+{
+    if (COUNTED_ROWS != _kind) {
+        return std::string();
+    }
+    // starts with the namespace, so that the counts of a collection are
+    // dropped with its statistics
+    std::ostringstream key;
+    key << _ns << ' ' << _filter.toString() << ' ' << _hint << ' ' << _limit;
+    return key.str();
+}
+
+void RowCount::countCommand(int maxTimeMS, mongo::BSONObj *cmd) const
+{
+    mongo::BSONObjBuilder builder;
+    size_t periodIdx = _ns.find('.');
+    builder.append("count", std::string::npos == periodIdx ? _ns : _ns.substr(periodIdx + 1));
+    builder.append("query", _filter);
+    if (!_hint.empty()) {
+        builder.append("hint", _hint);
+    }
+    if (_limit > 0) {
+        builder.append("limit", _limit);
+    }
+    if (maxTimeMS > 0) {
+        builder.append("maxTimeMS", maxTimeMS);
+    }
+    *cmd = builder.obj();
+}
+
+long long RowCount::rows(ConnectionHandle *connHandle, bool exact)
+{
+    if (_evaluated) {
+        return _rows;
+    }
+    _evaluated = true;
+    size_t periodIdx = _ns.find('.');
+    if (std::string::npos == periodIdx) {
+        return _rows;
+    }
+
+    time_t now = time(0);
+    CatalogCache *cache = connHandle->catalogCache();
+    std::string key = this->key();
+    if (!exact) {
+        CollectionInfo info;
+        if (_filter.isEmpty() && _hint.empty()
+            && 0 == connHandle->collectionInfo(_ns, false, &info)) {
+            _rows = _limit > 0 ? std::min(info._count, _limit) : info._count;
+            return _rows;
+        }
+        if (0 == cache->lookupCount(key, now, &_rows)) {
+            return _rows;
+        }
+    }
+
+    // a count that takes too long is cached as unknown, so that it is not
+    // run again for every execution
+    mongo::BSONObj cmd;
+    countCommand(exact ? 0 : (int)COUNT_TIME_MS, &cmd);
+    mongo::BSONObj info;
+    bool counted = 0 == connHandle->runCommand(_ns.substr(0, periodIdx), cmd, &info);
+    if (counted) {
+        _rows = info["n"].numberLong();
+    }
+    if (counted || !exact) {
+        cache->insertCount(key, _rows, now);
+    }
+    return _rows;
+}
+
+} // close mongoodbc namespace
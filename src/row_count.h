@@ -0,0 +1,109 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_ROW_COUNT_H_
+#define MONGOODBC_ROW_COUNT_H_
+
+#include <mongo/bson/bsonobj.h>
+
+#include <string>
+
+namespace mongoodbc {
+
+class ConnectionHandle;
+
+/*
+* The number of rows of a statement's result, as 'SQLRowCount' reports it,
+* found without reading the rows.
+*
+* A statement's rows are either unknown, e.g. for joins and GROUP BY, a
+* known number, or the documents of a collection matching the filter sent
+* to the server, capped by the statement's limit.  Without a filter the
+* collection's count is taken from the catalog cache.  Otherwise the
+* server counts the documents with the statement's index hint, giving up
+* after 'COUNT_TIME_MS', and the result is cached with the collection's
+* statistics.  Conditions the driver evaluates only remove rows, so such
+* counts are upper bounds.  An exact count always asks the server, without
+* a time limit.
+*/
+class RowCount {
+  public:
+    enum {
+        UNKNOWN = -1,
+        // time limit of a count estimating the rows
+        COUNT_TIME_MS = 200
+    };
+
+  private:
+    enum Kind {
+        UNKNOWN_ROWS,
+        KNOWN_ROWS,
+        COUNTED_ROWS
+    };
+
+    Kind _kind;
+    std::string _ns;
+    mongo::BSONObj _filter;
+    // index name, empty for none
+    std::string _hint;
+    // 0 for none
+    long long _limit;
+    // set once known
+    bool _evaluated;
+    long long _rows;
+
+  public:
+    /*
+    * Constructs a count of unknown rows.
+    */
+    RowCount();
+
+    /*
+    * Sets the rows to 'rows'.
+    */
+    void setRows(long long rows);
+
+    /*
+    * Sets the rows to the documents of 'ns' matching 'filter', read with
+    * the index named 'hint' if not empty, and at most 'limit' if not 0.
+    */
+    void setCount(const std::string& ns,
+                  const mongo::BSONObj& filter,
+                  const std::string& hint,
+                  long long limit);
+
+    /*
+    * Returns the key the count is cached under, empty unless the rows are
+    * counted by the server.
+    */
+    std::string key() const;
+
+    /*
+    * Sets 'cmd' to the 'count' command counting the rows, with a time limit
+    * of 'maxTimeMS' unless 0.
+    */
+    void countCommand(int maxTimeMS, mongo::BSONObj *cmd) const;
+
+    /*
+    * Returns the rows, or UNKNOWN, counting them over 'connHandle' on the
+    * first call.
+    */
+    long long rows(ConnectionHandle *connHandle, bool exact);
+};
+
+} // close mongoodbc namespace
+
+#endif
@@ -0,0 +1,62 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#include "row_count.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using mongoodbc::RowCount;
+
+TEST(RowCount, Known)
+{
+    // neither needs the server
+    RowCount unknown;
+    EXPECT_EQ(RowCount::UNKNOWN, unknown.rows(0, false));
+    EXPECT_EQ("", unknown.key());
+
+    RowCount one;
+    one.setRows(1);
+    EXPECT_EQ(1, one.rows(0, true));
+    EXPECT_EQ("", one.key());
+}
+
+TEST(RowCount, CountCommand)
+{
+    RowCount count;
+    count.setCount("db.orders", BSON("status" << "A"), "status_1", 50);
+    EXPECT_EQ("db.orders { status: \"A\" } status_1 50", count.key());
+
+    mongo::BSONObj cmd;
+    count.countCommand(RowCount::COUNT_TIME_MS, &cmd);
+    mongo::BSONObj expected = BSON("count" << "orders"
+                                   << "query" << BSON("status" << "A")
+                                   << "hint" << "status_1"
+                                   << "limit" << 50LL
+                                   << "maxTimeMS" << (int)RowCount::COUNT_TIME_MS);
+    EXPECT_EQ(expected.toString(), cmd.toString());
+
+    count.setCount("db.orders", mongo::BSONObj(), "", 0);
+    count.countCommand(0, &cmd);
+    EXPECT_EQ(BSON("count" << "orders" << "query" << mongo::BSONObj()).toString(),
+              cmd.toString());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,112 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "row_source.h"
+
+namespace mongoodbc {
+
+RowSource::~RowSource()
+{
+}
+
+CursorRowSource::CursorRowSource(std::auto_ptr<mongo::DBClientCursor> cursor,
+                                 const BatchSizer& batchSizer)
+    : _cursor(cursor)
+    , _batchSizer(batchSizer)
+    , _batchSized(false)
+{
+}
+
+bool CursorRowSource::more()
+{
+    if (!_batchSized && !_cursor->moreInCurrentBatch()) {
+        // the next call to more() goes back to the server
+        _cursor->setBatchSize(_batchSizer.nextBatchSize());
+        _batchSized = true;
+    }
+    return _cursor->more();
+}
+
+mongo::BSONObj CursorRowSource::next()
+{
+    mongo::BSONObj row = _cursor->next();
+    _batchSized = false;
+    _batchSizer.observe(row.objsize());
+    return row;
+}
+
+QualifiedRowSource::QualifiedRowSource(std::auto_ptr<RowSource> source,
+                                       const std::string& qualifier)
+    : _source(source)
+    , _prefix(qualifier + ".")
+{
+}
+
+bool QualifiedRowSource::more()
+{
+    return _source->more();
+}
+
+mongo::BSONObj QualifiedRowSource::next()
+{
+    mongo::BSONObj row = _source->next();
+    mongo::BSONObjBuilder builder(row.objsize() + row.nFields() * _prefix.size());
+    std::string name(_prefix);
+    mongo::BSONObjIterator fieldIt(row);
+    while (fieldIt.more()) {
+        mongo::BSONElement elem = fieldIt.next();
+        name.resize(_prefix.size());
+        name.append(elem.fieldName());
+        builder.appendAs(elem, name);
+    }
+    return builder.obj();
+}
+
+FlattenRowSource::FlattenRowSource(std::auto_ptr<RowSource> source)
+    : _source(source)
+{
+}
+
+bool FlattenRowSource::more()
+{
+    return _source->more();
+}
+
+mongo::BSONObj FlattenRowSource::next()
+{
+    mongo::BSONObj row = _source->next();
+    mongo::BSONObjBuilder builder(row.objsize());
+    std::string name;
+    mongo::BSONObjIterator fieldIt(row);
+    while (fieldIt.more()) {
+        mongo::BSONElement elem = fieldIt.next();
+        if (mongo::Object != elem.type()) {
+            builder.append(elem);
+            continue;
+        }
+        mongo::BSONObjIterator subIt(elem.embeddedObject());
+        while (subIt.more()) {
+            mongo::BSONElement sub = subIt.next();
+            name.assign(elem.fieldName());
+            name.append(".");
+            name.append(sub.fieldName());
+            builder.appendAs(sub, name);
+        }
+    }
+    return builder.obj();
+}
+
+} // close mongoodbc namespace
@@ -0,0 +1,108 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_ROW_SOURCE_H_
+#define MONGOODBC_ROW_SOURCE_H_
+
+#include "batch_sizer.h"
+
+#include <mongo/client/dbclient.h>
+#include <mongo/bson/bsonobj.h>
+
+#include <memory>
+#include <string>
+
+namespace mongoodbc {
+
+/*
+* Interface for a stream of result documents consumed by SQLFetch.
+*
+* Implementations may throw std::exception (including mongo::DBException)
+* from 'more' and 'next' when the underlying read fails.
+*/
+class RowSource {
+  public:
+    virtual ~RowSource();
+
+    /*
+    * Returns true if 'next' will return another row.
+    */
+    virtual bool more() = 0;
+
+    /*
+    * Returns the next row.  Only valid after 'more' returned true.
+    */
+    virtual mongo::BSONObj next() = 0;
+};
+
+/*
+* Row source reading from a single mongoDB cursor, resizing each batch
+* through a 'BatchSizer'.
+*/
+class CursorRowSource : public RowSource {
+    std::auto_ptr<mongo::DBClientCursor> _cursor;
+    BatchSizer _batchSizer;
+    // set once the size of the upcoming batch has been chosen
+    bool _batchSized;
+
+  public:
+    /*
+    * 'batchSizer' must already have handed out the initial batch size used
+    * to open 'cursor'.
+    */
+    CursorRowSource(std::auto_ptr<mongo::DBClientCursor> cursor,
+                    const BatchSizer& batchSizer);
+
+    virtual bool more();
+
+    virtual mongo::BSONObj next();
+};
+
+/*
+* Row source renaming every field of another source's rows to
+* '<qualifier>.<field>', so rows from several tables can be merged.
+*/
+class QualifiedRowSource : public RowSource {
+    std::auto_ptr<RowSource> _source;
+    std::string _prefix;
+
+  public:
+    QualifiedRowSource(std::auto_ptr<RowSource> source, const std::string& qualifier);
+
+    virtual bool more();
+
+    virtual mongo::BSONObj next();
+};
+
+/*
+* Row source turning each embedded document '<name>: { <field>: ... }' of
+* another source's rows into fields '<name>.<field>'.  Other fields are
+* kept as they are.
+*/
+class FlattenRowSource : public RowSource {
+    std::auto_ptr<RowSource> _source;
+
+  public:
+    explicit FlattenRowSource(std::auto_ptr<RowSource> source);
+
+    virtual bool more();
+
+    virtual mongo::BSONObj next();
+};
+
+} // close mongoodbc namespace
+
+#endif
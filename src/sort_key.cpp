@@ -0,0 +1,129 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#include "sort_key.h"
+
+#include <string.h>
+
+namespace {
+
+using mongoodbc::ExpressionValue;
+using mongoodbc::SQLElementExpression;
+using mongoodbc::SQLElementExpression_Factor;
+
+const char THIS[] = "this.";
+const size_t THIS_LEN = sizeof(THIS) - 1;
+
+std::string stripThis(const std::string& name)
+{
+    return 0 == name.compare(0, THIS_LEN, THIS) ? name.substr(THIS_LEN) : name;
+}
+
+/*
+* Appends 'str' so that no encoding is a prefix of another: zero bytes are
+* escaped as 0x00 0xff and the end is marked with 0x00 0x00.
+*/
+void appendString(const char *str, size_t len, std::string *key)
+{
+    for (size_t i = 0; i < len; ++i) {
+        key->push_back(str[i]);
+        if ('\0' == str[i]) {
+            key->push_back('\xff');
+        }
+    }
+    key->append(2, '\0');
+}
+
+void appendNumber(double num, std::string *key)
+{
+    if (0 == num) {
+        // -0 and 0 compare equal
+        num = 0;
+    }
+    unsigned long long bits;
+    memcpy(&bits, &num, sizeof(bits));
+    // negative numbers sort below positive ones and in reverse magnitude
+    const unsigned long long SIGN = 1ULL << 63;
+    bits = (bits & SIGN) ? ~bits : (bits | SIGN);
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        key->push_back((char)(unsigned char)(bits >> shift));
+    }
+}
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+void encodeValue(const ExpressionValue& value, std::string *key)
+{
+    key->push_back((char)value._type);
+    switch(value._type) {
+      case ExpressionValue::NUMBER: {
+        appendNumber(value._num, key);
+      } break;
+      case ExpressionValue::STRING: {
+        appendString(value._str.data(), value._str.size(), key);
+      } break;
+      case ExpressionValue::OTHER: {
+        // ordered by type like the server, then by their text
+        key->push_back((char)(unsigned char)(value._elem.canonicalType() + 128));
+        std::string text = value._elem.toString(false);
+        appendString(text.data(), text.size(), key);
+      } break;
+      default: break;
+    }
+}
+
+SortKey::SortKey(const std::vector<SQLElementSortSpec>& specs,
+                 const std::string& defaultQualifier)
+    : _specs(specs)
+{
+    for (size_t i = 0; i < _specs.size(); ++i) {
+        _programs.push_back(ExpressionProgram(_specs[i]._expr, defaultQualifier));
+    }
+}
+
+void SortKey::encode(const mongo::BSONObj& row, std::string *key) const
+{
+    key->clear();
+    for (size_t i = 0; i < _specs.size(); ++i) {
+        size_t begin = key->size();
+        encodeValue(_programs[i].run(row), key);
+        if (_specs[i]._descending) {
+            for (size_t j = begin; j < key->size(); ++j) {
+                (*key)[j] = ~(*key)[j];
+            }
+        }
+    }
+}
+
+int SortKey::sortPattern(const std::vector<SQLElementSortSpec>& specs, mongo::BSONObj *pattern)
+{
+    mongo::BSONObjBuilder builder;
+    for (size_t i = 0; i < specs.size(); ++i) {
+        const SQLElementExpression& expr = specs[i]._expr;
+        const SQLElementExpression_Factor& factor = expr._term._factor;
+        if (!expr._expr.empty() || !expr._term._term.empty() || factor._op
+            || !factor._primary._columnName) {
+            return -1;
+        }
+        builder.append(stripThis(factor._primary._columnName->_columnName),
+                       specs[i]._descending ? -1 : 1);
+    }
+    *pattern = builder.obj();
+    return 0;
+}
+
+} // close mongoodbc namespace
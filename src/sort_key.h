@@ -0,0 +1,70 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_SORT_KEY_H_
+#define MONGOODBC_SORT_KEY_H_
+
+#include "expression_evaluator.h"
+#include "sql_element_sort_spec.h"
+
+#include <mongo/bson/bsonobj.h>
+
+#include <string>
+#include <vector>
+
+namespace mongoodbc {
+
+/*
+* Appends to 'key' an encoding of 'value' such that comparing encodings
+* byte by byte orders values like ORDER BY: values without a value first,
+* then numbers, strings and other values by type.  Numbers that compare
+* equal, e.g. 2 and 2.0, encode alike.
+*/
+void encodeValue(const ExpressionValue& value, std::string *key);
+
+/*
+* Evaluates the sort specifications of an ORDER BY clause over rows with
+* 'ExpressionProgram's and encodes the values with 'encodeValue', so that
+* comparing two encoded keys byte by byte orders the rows like the clause.
+* The bytes of a DESC key are inverted.
+*/
+class SortKey {
+    std::vector<SQLElementSortSpec> _specs;
+    // one per specification
+    std::vector<ExpressionProgram> _programs;
+
+  public:
+    SortKey(const std::vector<SQLElementSortSpec>& specs,
+            const std::string& defaultQualifier = std::string());
+
+    bool empty() const { return _specs.empty(); }
+
+    /*
+    * Replaces the content of 'key' with the encoded key of 'row'.
+    */
+    void encode(const mongo::BSONObj& row, std::string *key) const;
+
+    /*
+    * Stores in 'pattern' the sort pattern of a server query ordering like
+    * 'specs'.
+    * @return 0 on success, -1 if a key is not a plain column
+    */
+    static int sortPattern(const std::vector<SQLElementSortSpec>& specs, mongo::BSONObj *pattern);
+};
+
+} // close mongoodbc namespace
+
+#endif
@@ -0,0 +1,162 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "spill_file.h"
+
+#include <stdexcept>
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace {
+
+/*
+* Opens an anonymous file in 'directory': the file is unlinked as soon as
+* it is created.
+* @return the file, or 0 on failure
+*/
+std::FILE *createFile(const std::string& directory)
+{
+    if (directory.empty()) {
+        return std::tmpfile();
+    }
+    std::string path(directory);
+    path.append("/mongoodbc-XXXXXX");
+    int fd = mkstemp(&path[0]);
+    if (fd < 0) {
+        return 0;
+    }
+    unlink(path.c_str());
+    std::FILE *file = fdopen(fd, "w+b");
+    if (!file) {
+        close(fd);
+    }
+    return file;
+}
+
+/*
+* Reads the little endian int32 at 'bytes'.
+*/
+int readInt32(const char *bytes)
+{
+    return (unsigned char)bytes[0]
+           | ((unsigned char)bytes[1] << 8)
+           | ((unsigned char)bytes[2] << 16)
+           | ((unsigned char)bytes[3] << 24);
+}
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+SpillFile::SpillFile(const std::string& directory)
+    : _file(createFile(directory))
+    , _numDocs(0)
+    , _bytes(0)
+{
+    if (!_file) {
+        throw std::runtime_error("cannot create temporary file");
+    }
+}
+
+SpillFile::~SpillFile()
+{
+    std::fclose(_file);
+}
+
+void SpillFile::write(const mongo::BSONObj& doc)
+{
+    size_t size = doc.objsize();
+    if (size != std::fwrite(doc.objdata(), 1, size, _file)) {
+        throw std::runtime_error("cannot write temporary file");
+    }
+    ++_numDocs;
+    _bytes += size;
+}
+
+void SpillFile::write(const std::string& record)
+{
+    // records are prefixed with their size like documents
+    char sizeBytes[4];
+    size_t size = record.size();
+    for (size_t i = 0; i < sizeof(sizeBytes); ++i) {
+        sizeBytes[i] = (char)(size >> (8 * i));
+    }
+    if (sizeof(sizeBytes) != std::fwrite(sizeBytes, 1, sizeof(sizeBytes), _file)
+        || size != std::fwrite(record.data(), 1, size, _file)) {
+        throw std::runtime_error("cannot write temporary file");
+    }
+    ++_numDocs;
+    _bytes += sizeof(sizeBytes) + size;
+}
+
+void SpillFile::rewind()
+{
+    if (0 != std::fseek(_file, 0, SEEK_SET)) {
+        throw std::runtime_error("cannot rewind temporary file");
+    }
+}
+
+bool SpillFile::read(mongo::BSONObj *doc)
+{
+    // every document starts with its total size as a little endian int32
+    char sizeBytes[4];
+    size_t got = std::fread(sizeBytes, 1, sizeof(sizeBytes), _file);
+    if (0 == got && std::feof(_file)) {
+        return false;
+    }
+    if (sizeof(sizeBytes) != got) {
+        throw std::runtime_error("cannot read temporary file");
+    }
+    int size = readInt32(sizeBytes);
+    if (size < (int)sizeof(sizeBytes)) {
+        throw std::runtime_error("corrupt temporary file");
+    }
+
+    _buffer.resize(size);
+    memcpy(&_buffer[0], sizeBytes, sizeof(sizeBytes));
+    size_t rest = size - sizeof(sizeBytes);
+    if (rest != std::fread(&_buffer[sizeof(sizeBytes)], 1, rest, _file)) {
+        throw std::runtime_error("cannot read temporary file");
+    }
+    *doc = mongo::BSONObj(&_buffer[0]).getOwned();
+    return true;
+}
+
+bool SpillFile::read(std::string *record)
+{
+    char sizeBytes[4];
+    size_t got = std::fread(sizeBytes, 1, sizeof(sizeBytes), _file);
+    if (0 == got && std::feof(_file)) {
+        return false;
+    }
+    if (sizeof(sizeBytes) != got) {
+        throw std::runtime_error("cannot read temporary file");
+    }
+    int size = readInt32(sizeBytes);
+    if (size < 0) {
+        throw std::runtime_error("corrupt temporary file");
+    }
+
+    record->resize(size);
+    if (size && (size_t)size != std::fread(&(*record)[0], 1, size, _file)) {
+        throw std::runtime_error("cannot read temporary file");
+    }
+    return true;
+}
+
+} // close mongoodbc namespace
@@ -0,0 +1,103 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_SPILL_FILE_H_
+#define MONGOODBC_SPILL_FILE_H_
+
+#include <mongo/bson/bsonobj.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace mongoodbc {
+
+/*
+* Anonymous temporary file holding a sequence of BSON documents or of
+* length prefixed binary records, used by operators that run over their
+* memory budget.  A file holds one kind of entry.  The file is removed when
+* it is closed.
+*
+* Methods throw std::runtime_error when the file cannot be created, written
+* or read.
+*/
+class SpillFile : boost::noncopyable {
+    std::FILE *_file;
+    // number of documents or records written
+    size_t _numDocs;
+    size_t _bytes;
+    // read buffer, reused across documents
+    std::vector<char> _buffer;
+
+  public:
+    /*
+    * Creates the file in 'directory', or in the system's temporary
+    * directory if empty.
+    */
+    explicit SpillFile(const std::string& directory = std::string());
+
+    ~SpillFile();
+
+    /*
+    * Appends 'doc' to the end of the file.
+    */
+    void write(const mongo::BSONObj& doc);
+
+    /*
+    * Appends 'record' to the end of the file.
+    */
+    void write(const std::string& record);
+
+    /*
+    * Moves back to the first document; the next 'read' returns it.
+    */
+    void rewind();
+
+    /*
+    * Reads the next document into 'doc'.
+    * @return false at the end of the file
+    */
+    bool read(mongo::BSONObj *doc);
+
+    /*
+    * Reads the next record into 'record'.
+    * @return false at the end of the file
+    */
+    bool read(std::string *record);
+
+    size_t numDocs() const;
+
+    /*
+    * Returns the number of bytes written to the file.
+    */
+    size_t bytes() const;
+};
+
+inline size_t SpillFile::numDocs() const
+{
+    return _numDocs;
+}
+
+inline size_t SpillFile::bytes() const
+{
+    return _bytes;
+}
+
+} // close mongoodbc namespace
+
+#endif
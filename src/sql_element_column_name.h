@@ -52,6 +52,12 @@ struct PrependThis {
 
 namespace mongoodbc {
 
+/*
+* A column 'c' or 't.c'.  Further parts name a field of embedded documents,
+* e.g. 't.address.city' has table name 't' and column name 'address.city'.
+* In a query of a single table, whose columns need no qualifier, the table
+* name may also be the first part of such a path, e.g. 'address.city'.
+*/
 struct SQLElementColumnName {
     boost::optional<std::string> _tableName;
     std::string _columnName;
@@ -65,6 +71,7 @@ template <typename It>
 struct SQLElementColumnNameParser
     : qi::grammar<It, SQLElementColumnName(), ascii::space_type> {
     qi::rule<It, std::string(), ascii::space_type> _userDefinedName;
+    qi::rule<It, std::string(), ascii::space_type> _path;
     qi::rule<It, SQLElementColumnName(), ascii::space_type> _rule;
     SQLElementColumnNameParser();
 };
@@ -74,11 +81,14 @@ SQLElementColumnNameParser<It>::SQLElementColumnNameParser()
     : SQLElementColumnNameParser::base_type(_rule)
 {
     _userDefinedName %= qi::lexeme[ascii::alpha >> *ascii::alnum];
+    // a column, or a path to a field of embedded documents
+    _path %= qi::lexeme[ascii::alpha >> *ascii::alnum
+                        >> *(ascii::char_('.') >> ascii::alpha >> *ascii::alnum)];
 
     phoenix::function<PrependThis> prependThis;
 
     _rule = -(_userDefinedName >> '.') [phoenix::at_c<0>(qi::_val) = prependThis(qi::_1)]
-             >> _userDefinedName [phoenix::at_c<1>(qi::_val) = prependThis(qi::_1)];
+             >> _path [phoenix::at_c<1>(qi::_val) = prependThis(qi::_1)];
     BOOST_SPIRIT_DEBUG_NODE(_rule);
 };
 
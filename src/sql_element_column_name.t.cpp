@@ -65,6 +65,30 @@ TEST(ElementColumnNameParseTest, TableNameColumnName)
     }
 }
 
+TEST(ElementColumnNameParseTest, TableNamePath)
+{
+    mongoodbc::SQLElementColumnNameParser<std::string::const_iterator> parser;
+    mongoodbc::SQLElementColumnName columnName;
+    std::string str("table.address.city");
+    std::string::const_iterator iter = str.begin();
+    std::string::const_iterator end = str.end();
+    try
+    {
+        EXPECT_TRUE(
+            boost::spirit::qi::phrase_parse(iter, end, parser, boost::spirit::ascii::space, columnName));
+        EXPECT_TRUE(iter == end);
+        EXPECT_TRUE(columnName._tableName);
+        EXPECT_EQ("this.table", *columnName._tableName);
+        EXPECT_EQ("this.address.city", columnName._columnName);
+        std::cout << "ColumnName: " << columnName << std::endl;
+    }
+    catch (const boost::spirit::qi::expectation_failure<std::string::const_iterator>& ex)
+    {
+        std::string fragment(ex.first, ex.last);
+        std::cerr << ex.what() << "'" << fragment << "'" << std::endl;
+    }
+}
+
 TEST(ElementColumnNameParseTest, DotColumnName)
 {
     mongoodbc::SQLElementColumnNameParser<std::string::const_iterator> parser;
@@ -16,6 +16,51 @@
 
 #include <sql_element_expression.h>
 
+#include <ctype.h>
+#include <string.h>
+
+namespace {
+
+using mongoodbc::SQLElementExpression;
+
+const char HEX_DIGITS[] = "0123456789abcdef";
+
+int hexValue(char c)
+{
+    const char *digit = strchr(HEX_DIGITS, tolower((unsigned char)c));
+    return c && digit ? (int)(digit - HEX_DIGITS) : -1;
+}
+
+void quoteLiterals(SQLElementExpression *expr);
+
+void quoteLiterals(mongoodbc::SQLElementExpression_Primary *primary)
+{
+    if (primary->_literal) {
+        primary->_literal = mongoodbc::quoteWhereString(*primary->_literal);
+    }
+    for (size_t i = 0; i < primary->_expr.size(); ++i) {
+        quoteLiterals(&primary->_expr[i].get());
+    }
+}
+
+void quoteLiterals(mongoodbc::SQLElementExpression_Term *term)
+{
+    for (size_t i = 0; i < term->_term.size(); ++i) {
+        quoteLiterals(&term->_term[i].get());
+    }
+    quoteLiterals(&term->_factor._primary);
+}
+
+void quoteLiterals(SQLElementExpression *expr)
+{
+    for (size_t i = 0; i < expr->_expr.size(); ++i) {
+        quoteLiterals(&expr->_expr[i].get());
+    }
+    quoteLiterals(&expr->_term);
+}
+
+} // close unnamed namespace
+
 namespace mongoodbc {
 
 void SQLElementExpression::toString(std::string *str) const
@@ -25,6 +70,57 @@ void SQLElementExpression::toString(std::string *str) const
     *str = stream.str();
 }
 
+void SQLElementExpression::toWhereString(std::string *str) const
+{
+    SQLElementExpression quoted(*this);
+    quoteLiterals(&quoted);
+    quoted.toString(str);
+}
+
+std::string quoteWhereString(const std::string& str)
+{
+    std::string literal(1, '"');
+    for (size_t i = 0; i < str.size(); ++i) {
+        unsigned char c = str[i];
+        if ('"' == c || '\\' == c || c < 0x20) {
+            literal.append("\\x");
+            literal += HEX_DIGITS[c >> 4];
+            literal += HEX_DIGITS[c & 0xf];
+        } else {
+            literal += c;
+        }
+    }
+    literal += '"';
+    return literal;
+}
+
+int unquoteWhereString(const std::string& literal, std::string *value)
+{
+    if (literal.size() < 2 || '"' != literal[0] || '"' != literal[literal.size() - 1]) {
+        return -1;
+    }
+    std::string result;
+    for (size_t i = 1; i < literal.size() - 1; ++i) {
+        if ('"' == literal[i]) {
+            return -1;
+        }
+        if ('\\' != literal[i]) {
+            result += literal[i];
+            continue;
+        }
+        int high;
+        int low;
+        if (i + 3 >= literal.size() - 1 || 'x' != literal[i + 1]
+            || (high = hexValue(literal[i + 2])) < 0 || (low = hexValue(literal[i + 3])) < 0) {
+            return -1;
+        }
+        result += (char)(high << 4 | low);
+        i += 3;
+    }
+    *value = result;
+    return 0;
+}
+
 } // close mongoodbc namespace
 
 
@@ -55,7 +55,11 @@ struct SQLElementExpression_Primary {
     boost::optional<char> _dynamicParameter;
     boost::optional<std::string> _literal;
     boost::optional<unsigned long> _num;
+    // a parenthesized expression, or the argument of '_function'
     std::vector<boost::recursive_wrapper<SQLElementExpression> > _expr;
+    // upper cased name of an aggregate function call, whose argument is
+    // '_expr', or '*' if empty
+    boost::optional<std::string> _function;
 };
 inline std::ostream& operator<<(std::ostream& stream, const SQLElementExpression_Primary& rhs);
 
@@ -64,6 +68,7 @@ struct SQLElementExpression_PrimaryParser
     : qi::grammar<It, SQLElementExpression_Primary(), ascii::space_type> {
 
     qi::rule<It, std::string()> _quotedString;
+    qi::symbols<char, std::string> _functionName;
     qi::rule<It, SQLElementExpression_Primary(), ascii::space_type> _rule;
     SQLElementExpressionParser<It> *_exprParser;
     SQLElementColumnNameParser<It> _columnNameParser;
@@ -84,7 +89,16 @@ SQLElementExpression_PrimaryParser<It>::SQLElementExpression_PrimaryParser(
                                      ascii::char_(";:'?/\\|,.<>!@#$%^&*()-_+=[]{}~`"))]
                      >> '"';
 
-    _rule = _columnNameParser._rule [phoenix::at_c<0>(qi::_val) = qi::_1] |
+    _functionName.add("count", "COUNT")
+                     ("sum", "SUM")
+                     ("avg", "AVG")
+                     ("min", "MIN")
+                     ("max", "MAX");
+
+    _rule = ((ascii::no_case[_functionName] >> '(') [phoenix::at_c<5>(qi::_val) = qi::_1]
+                 >> ('*' | _exprParser->_rule [phoenix::push_back(phoenix::at_c<4>(qi::_val), qi::_1)])
+                 >> ')') |
+             _columnNameParser._rule [phoenix::at_c<0>(qi::_val) = qi::_1] |
              ascii::char_('?') [phoenix::at_c<1>(qi::_val) = qi::_1] |
              _quotedString [phoenix::at_c<2>(qi::_val) = qi::_1] |
              qi::ulong_  [phoenix::at_c<3>(qi::_val) = qi::_1] |
@@ -173,9 +187,28 @@ struct SQLElementExpression {
     SQLElementExpression_Term _term;
 
     void toString(std::string *str) const;
+
+    /*
+    * Stores in 'str' the expression as '$where' code: as by 'toString', but
+    * with string literals quoted by 'quoteWhereString'.
+    */
+    void toWhereString(std::string *str) const;
 };
 inline std::ostream& operator<<(std::ostream& stream, const SQLElementExpression& rhs);
 
+/*
+* Returns 'str' as a double quoted JavaScript string, the form of string
+* literals in '$where' code.  Quotes, backslashes and control characters
+* are written as '\xHH' escapes, so the literal holds no quote but its own.
+*/
+std::string quoteWhereString(const std::string& str);
+
+/*
+* Sets 'value' to the string quoted as 'literal' by 'quoteWhereString'.
+* @return 0 on success, -1 if 'literal' is not such a string literal
+*/
+int unquoteWhereString(const std::string& literal, std::string *value);
+
 template <typename It>
 struct SQLElementExpressionParser : qi::grammar<It, SQLElementExpression(), ascii::space_type> {
     qi::rule<It, SQLElementExpression(), ascii::space_type> _rule;
@@ -204,7 +237,8 @@ BOOST_FUSION_ADAPT_STRUCT(mongoodbc::SQLElementExpression_Primary,
                           (boost::optional<char>, _dynamicParameter)
                           (boost::optional<std::string>, _literal)
                           (boost::optional<unsigned long>, _num)
-                          (std::vector<boost::recursive_wrapper<mongoodbc::SQLElementExpression> >, _expr));
+                          (std::vector<boost::recursive_wrapper<mongoodbc::SQLElementExpression> >, _expr)
+                          (boost::optional<std::string>, _function));
 
 
 BOOST_FUSION_ADAPT_STRUCT(mongoodbc::SQLElementExpression_Factor,
@@ -224,7 +258,15 @@ BOOST_FUSION_ADAPT_STRUCT(mongoodbc::SQLElementExpression,
 inline std::ostream& mongoodbc::operator<<(std::ostream& stream,
                                            const mongoodbc::SQLElementExpression_Primary& rhs)
 {
-    if (rhs._columnName) {
+    if (rhs._function) {
+        stream << *rhs._function << "(";
+        if (rhs._expr.size()) {
+            stream << rhs._expr[0].get();
+        } else {
+            stream << "*";
+        }
+        stream << ")";
+    } else if (rhs._columnName) {
         stream << *rhs._columnName;
     } else if (rhs._dynamicParameter) {
         stream << *rhs._dynamicParameter;
@@ -233,7 +275,7 @@ inline std::ostream& mongoodbc::operator<<(std::ostream& stream,
     } else if (rhs._num) {
         stream << *rhs._num;
     } else if (rhs._expr.size()) {
-        stream << rhs._expr[0].get();
+        stream << "(" << rhs._expr[0].get() << ")";
     }
 
     return stream;
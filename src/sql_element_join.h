@@ -0,0 +1,105 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_SQL_ELEMENT_JOIN_H_
+#define MONGOODBC_SQL_ELEMENT_JOIN_H_
+
+#include "sql_element_column_name.h"
+
+#include <boost/fusion/adapted.hpp>
+#include <boost/spirit/include/qi.hpp>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace qi = boost::spirit::qi;
+namespace ascii = boost::spirit::ascii;
+
+namespace mongoodbc {
+
+/*
+* In memory representation of one 'column = column' condition of a join.
+*/
+struct SQLElementJoinCondition {
+    SQLElementColumnName _left;
+    SQLElementColumnName _right;
+};
+
+/*
+* In memory representation of '[INNER] JOIN <table> ON <condition> [AND ...]'.
+* Only equalities between columns are supported in the ON clause.
+*/
+struct SQLElementJoin {
+    std::string _table;
+    std::vector<SQLElementJoinCondition> _on;
+};
+inline std::ostream& operator<<(std::ostream& stream, const SQLElementJoin& rhs);
+
+/*
+* Parser for JOIN clauses.  Table names are read with 'namespaceRule',
+* owned by the statement parser.
+*/
+template <typename It>
+struct SQLElementJoinParser : qi::grammar<It, SQLElementJoin(), ascii::space_type> {
+    qi::rule<It, std::string(), ascii::space_type> *_namespace;
+    qi::rule<It, SQLElementJoinCondition(), ascii::space_type> _condition;
+    qi::rule<It, SQLElementJoin(), ascii::space_type> _rule;
+    SQLElementColumnNameParser<It> _columnNameParser;
+
+    SQLElementJoinParser(qi::rule<It, std::string(), ascii::space_type> *namespaceRule);
+};
+
+template <typename It>
+SQLElementJoinParser<It>::SQLElementJoinParser(
+    qi::rule<It, std::string(), ascii::space_type> *namespaceRule)
+    : SQLElementJoinParser::base_type(_rule)
+    , _namespace(namespaceRule)
+{
+    _condition %= _columnNameParser._rule >> '=' >> _columnNameParser._rule;
+    _rule %= qi::omit[-ascii::no_case["inner"]]
+             >> ascii::no_case["join"]
+             >> _namespace->alias()
+             >> ascii::no_case["on"]
+             >> (_condition % ascii::no_case["and"]);
+
+    BOOST_SPIRIT_DEBUG_NODE(_rule);
+}
+
+} // close mongoodbc namespace
+
+BOOST_FUSION_ADAPT_STRUCT(mongoodbc::SQLElementJoinCondition,
+                          (mongoodbc::SQLElementColumnName, _left)
+                          (mongoodbc::SQLElementColumnName, _right));
+
+BOOST_FUSION_ADAPT_STRUCT(mongoodbc::SQLElementJoin,
+                          (std::string, _table)
+                          (std::vector<mongoodbc::SQLElementJoinCondition>, _on));
+
+inline std::ostream& mongoodbc::operator<<(std::ostream& stream,
+                                           const mongoodbc::SQLElementJoin& rhs)
+{
+    stream << "JOIN " << rhs._table << " ON ";
+    for (size_t i = 0; i < rhs._on.size(); ++i) {
+        if (i) {
+            stream << " AND ";
+        }
+        stream << rhs._on[i]._left << " = " << rhs._on[i]._right;
+    }
+    return stream;
+}
+
+#endif
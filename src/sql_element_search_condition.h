@@ -59,9 +59,9 @@ struct BSONFromComparison {
                               const Arg3& rhs) const
     {
         std::string lhsStr;
-        lhs.toString(&lhsStr);
+        lhs.toWhereString(&lhsStr);
         std::string rhsStr;
-        rhs.toString(&rhsStr);
+        rhs.toWhereString(&rhsStr);
         lhsStr.append(" ");
         lhsStr.append(op);
         lhsStr.append(" ");
@@ -229,7 +229,8 @@ SQLElementSearchConditionParser<It>::SQLElementSearchConditionParser(
 {
     phoenix::function<BSONFromOr> bsonFromOr;
 
-    _rule = (_termParser._rule >> ascii::no_case["OR"] >> _rule) [qi::_val = bsonFromOr(qi::_1, qi::_2)] |
+    // 'OR' must not match the start of a following 'ORDER BY'
+    _rule = (_termParser._rule >> qi::lexeme[ascii::no_case["OR"] >> !ascii::alnum] >> _rule) [qi::_val = bsonFromOr(qi::_1, qi::_2)] |
             _termParser._rule [qi::_val = qi::_1];
 }
 
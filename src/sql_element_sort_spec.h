@@ -0,0 +1,88 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_SQL_ELEMENT_SORT_SPEC_H_
+#define MONGOODBC_SQL_ELEMENT_SORT_SPEC_H_
+
+#include "sql_element_expression.h"
+
+#include <boost/fusion/adapted.hpp>
+#include <boost/spirit/include/phoenix_operator.hpp>
+#include <boost/spirit/include/phoenix_fusion.hpp>
+#include <boost/spirit/include/phoenix_core.hpp>
+#include <boost/spirit/include/qi.hpp>
+
+#include <ostream>
+
+namespace qi = boost::spirit::qi;
+namespace ascii = boost::spirit::ascii;
+namespace phoenix = boost::phoenix;
+
+namespace mongoodbc {
+
+/*
+* In memory representation of one '<expression> [ASC | DESC]' of an ORDER BY
+* clause.
+*/
+struct SQLElementSortSpec {
+    SQLElementExpression _expr;
+    bool _descending;
+
+    SQLElementSortSpec()
+        : _descending(false)
+    {
+    }
+};
+inline std::ostream& operator<<(std::ostream& stream, const SQLElementSortSpec& rhs);
+
+/*
+* Parser for sort specifications.  Expressions are read with 'exprParser',
+* owned by the statement parser.
+*/
+template <typename It>
+struct SQLElementSortSpecParser : qi::grammar<It, SQLElementSortSpec(), ascii::space_type> {
+    qi::rule<It, SQLElementSortSpec(), ascii::space_type> _rule;
+    SQLElementExpressionParser<It> *_exprParser;
+
+    SQLElementSortSpecParser(SQLElementExpressionParser<It> *exprParser);
+};
+
+template <typename It>
+SQLElementSortSpecParser<It>::SQLElementSortSpecParser(SQLElementExpressionParser<It> *exprParser)
+    : SQLElementSortSpecParser::base_type(_rule)
+    , _exprParser(exprParser)
+{
+    _rule = _exprParser->_rule [phoenix::at_c<0>(qi::_val) = qi::_1]
+            >> -(qi::lexeme[ascii::no_case["asc"] >> !ascii::alnum] [phoenix::at_c<1>(qi::_val) = false] |
+                 qi::lexeme[ascii::no_case["desc"] >> !ascii::alnum] [phoenix::at_c<1>(qi::_val) = true]);
+
+    BOOST_SPIRIT_DEBUG_NODE(_rule);
+}
+
+} // close mongoodbc namespace
+
+BOOST_FUSION_ADAPT_STRUCT(mongoodbc::SQLElementSortSpec,
+                          (mongoodbc::SQLElementExpression, _expr)
+                          (bool, _descending));
+
+inline std::ostream& mongoodbc::operator<<(std::ostream& stream,
+                                           const mongoodbc::SQLElementSortSpec& rhs)
+{
+    stream << rhs._expr << (rhs._descending ? " DESC" : "");
+    return stream;
+}
+
+#endif
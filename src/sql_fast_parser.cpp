@@ -0,0 +1,576 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "sql_fast_parser.h"
+
+#include "sql_lexer.h"
+
+#include <mongo/bson/bsonobj.h>
+
+#include <stdexcept>
+
+#include <stdlib.h>
+#include <strings.h>
+
+namespace {
+
+using mongoodbc::SQLToken;
+using mongoodbc::SQLElementExpression;
+using mongoodbc::SQLElementExpression_Term;
+using mongoodbc::SQLElementExpression_Factor;
+
+/*
+* Thrown on a syntax error; caught by 'SQLFastParser::parse'.
+*/
+class ParseError : public std::runtime_error {
+  public:
+    explicit ParseError(const std::string& what)
+        : std::runtime_error(what)
+    {
+    }
+};
+
+/*
+* Binding power of the binary operators, lowest first.  'NOT' binds tighter
+* than 'AND' but looser than the comparisons, so 'NOT a = b AND c = d' is
+* '(NOT (a = b)) AND (c = d)'.
+*/
+enum Precedence {
+    PREC_NONE = 0,
+    PREC_OR,
+    PREC_AND,
+    PREC_NOT,
+    PREC_COMPARISON,
+    PREC_ADDITIVE,
+    PREC_MULTIPLICATIVE
+};
+
+/*
+* Either a value expression or a search condition, the latter already
+* converted to the mongo query the Spirit grammar would have built.
+*/
+struct Operand {
+    bool _isCondition;
+    SQLElementExpression _expr;
+    mongo::BSONObj _cond;
+
+    Operand()
+        : _isCondition(false)
+    {
+        _expr._op = '\0';
+        _expr._term._op = '\0';
+    }
+};
+
+int binaryPrecedence(const SQLToken& token)
+{
+    switch(token._type) {
+        case SQLToken::STAR:
+        case SQLToken::SLASH: return PREC_MULTIPLICATIVE;
+        case SQLToken::PLUS:
+        case SQLToken::MINUS: return PREC_ADDITIVE;
+        case SQLToken::EQ:
+        case SQLToken::NE:
+        case SQLToken::LT:
+        case SQLToken::LE:
+        case SQLToken::GT:
+        case SQLToken::GE: return PREC_COMPARISON;
+        case SQLToken::IDENTIFIER: {
+            if (token.isKeyword("AND")) {
+                return PREC_AND;
+            }
+            if (token.isKeyword("OR")) {
+                return PREC_OR;
+            }
+        } break;
+        default: break;
+    }
+
+    return PREC_NONE;
+}
+
+/*
+* Returns the operator as the Spirit grammar spells it in '$where'.
+*/
+const char * comparisonOp(SQLToken::Type type)
+{
+    switch(type) {
+        case SQLToken::EQ: return "==";
+        case SQLToken::NE: return "!=";
+        case SQLToken::LT: return "<";
+        case SQLToken::LE: return "<=";
+        case SQLToken::GT: return ">";
+        case SQLToken::GE: return ">=";
+        default: break;
+    }
+
+    return "";
+}
+
+bool isReserved(const SQLToken& token)
+{
+    static const char *reserved[] = {
+        "SELECT", "ALL", "DISTINCT", "FROM", "WHERE", "AND", "OR", "NOT",
+        "INNER", "JOIN", "ON", "GROUP", "ORDER", "BY", "ASC", "DESC", "LIMIT"
+    };
+    for (size_t i = 0; i < sizeof(reserved) / sizeof(reserved[0]); ++i) {
+        if (token.isKeyword(reserved[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+* Returns the upper cased name of the aggregate function 'name', or 0 if it
+* is not one.  Function names are not reserved, so 'count' may still name a
+* column.
+*/
+const char * functionName(const std::string& name)
+{
+    static const char *functions[] = { "COUNT", "SUM", "AVG", "MIN", "MAX" };
+    for (size_t i = 0; i < sizeof(functions) / sizeof(functions[0]); ++i) {
+        if (0 == strcasecmp(name.c_str(), functions[i])) {
+            return functions[i];
+        }
+    }
+    return 0;
+}
+
+// The expression structs nest as expression > term > factor > primary, with
+// '*' and '/' at the outermost level.  The helpers below place an operand at
+// the level an operator needs, wrapping it in a parenthesized primary when it
+// does not fit there.
+
+bool isFactor(const SQLElementExpression& expr)
+{
+    return expr._expr.empty() && expr._term._term.empty();
+}
+
+SQLElementExpression_Factor asFactor(const SQLElementExpression& expr)
+{
+    if (isFactor(expr)) {
+        return expr._term._factor;
+    }
+    SQLElementExpression_Factor factor;
+    factor._primary._expr.push_back(expr);
+    return factor;
+}
+
+SQLElementExpression_Term asTerm(const SQLElementExpression& expr)
+{
+    if (expr._expr.empty()) {
+        return expr._term;
+    }
+    SQLElementExpression_Term term;
+    term._op = '\0';
+    term._factor = asFactor(expr);
+    return term;
+}
+
+SQLElementExpression additive(const SQLElementExpression& lhs,
+                              char op,
+                              const SQLElementExpression& rhs)
+{
+    Operand result;
+    result._expr._term._term.push_back(asTerm(lhs));
+    result._expr._term._op = op;
+    result._expr._term._factor = asFactor(rhs);
+    return result._expr;
+}
+
+SQLElementExpression multiplicative(const SQLElementExpression& lhs,
+                                    char op,
+                                    const SQLElementExpression& rhs)
+{
+    Operand result;
+    if (lhs._expr.empty() && !lhs._term._term.empty()) {
+        Operand wrapped;
+        wrapped._expr._term._factor = asFactor(lhs);
+        result._expr._expr.push_back(wrapped._expr);
+    } else {
+        result._expr._expr.push_back(lhs);
+    }
+    result._expr._op = op;
+    result._expr._term._factor = asFactor(rhs);
+    return result._expr;
+}
+
+/*
+* Recursive descent over the token stream of one statement.
+*/
+class Parser {
+    mongoodbc::SQLLexer _lexer;
+
+    void fail(const char *expected) const
+    {
+        const SQLToken& token = _lexer.peek();
+        std::string msg("expected ");
+        msg.append(expected);
+        if (SQLToken::END == token._type) {
+            msg.append(" at end of statement");
+        } else {
+            msg.append(" at '");
+            msg.append(token._begin, token._length);
+            msg.append("'");
+        }
+        throw ParseError(msg);
+    }
+
+    bool accept(SQLToken::Type type)
+    {
+        if (type != _lexer.peek()._type) {
+            return false;
+        }
+        _lexer.next();
+        return true;
+    }
+
+    bool acceptKeyword(const char *keyword)
+    {
+        if (!_lexer.peek().isKeyword(keyword)) {
+            return false;
+        }
+        _lexer.next();
+        return true;
+    }
+
+    void expect(SQLToken::Type type, const char *what)
+    {
+        if (!accept(type)) {
+            fail(what);
+        }
+    }
+
+    std::string identifier()
+    {
+        const SQLToken& token = _lexer.peek();
+        if (SQLToken::IDENTIFIER != token._type || isReserved(token)) {
+            fail("identifier");
+        }
+        return _lexer.next().text();
+    }
+
+    void requireValue(const Operand& operand) const
+    {
+        if (operand._isCondition) {
+            throw ParseError("search condition used as a value");
+        }
+    }
+
+    void requireCondition(const Operand& operand) const
+    {
+        if (!operand._isCondition) {
+            throw ParseError("value used as a search condition");
+        }
+    }
+
+    std::string tableName();
+    mongoodbc::SQLElementColumnName columnName();
+    mongoodbc::SQLElementColumnName columnName(const std::string& first);
+    Operand primary();
+    Operand unary();
+    Operand expression(int minPrec);
+    Operand combine(const Operand& lhs, const SQLToken& op, const Operand& rhs);
+
+  public:
+    explicit Parser(const std::string& sql)
+        : _lexer(sql.data(), sql.data() + sql.size())
+    {
+    }
+
+    void statement(mongoodbc::SQLStatement *stmt);
+};
+
+std::string Parser::tableName()
+{
+    std::string ns = identifier();
+    while (accept(SQLToken::DOT)) {
+        ns += '.';
+        ns += identifier();
+    }
+    return ns;
+}
+
+mongoodbc::SQLElementColumnName Parser::columnName()
+{
+    return columnName(identifier());
+}
+
+mongoodbc::SQLElementColumnName Parser::columnName(const std::string& first)
+{
+    // the Spirit column name parser prefixes both parts with 'this.'
+    mongoodbc::SQLElementColumnName column;
+    column._columnName = "this." + first;
+    if (accept(SQLToken::DOT)) {
+        column._tableName = column._columnName;
+        column._columnName = "this." + identifier();
+    }
+    while (accept(SQLToken::DOT)) {
+        // a field of embedded documents
+        column._columnName += '.';
+        column._columnName += identifier();
+    }
+    return column;
+}
+
+Operand Parser::primary()
+{
+    Operand operand;
+    mongoodbc::SQLElementExpression_Primary& primary = operand._expr._term._factor._primary;
+    const SQLToken& token = _lexer.peek();
+    switch(token._type) {
+        case SQLToken::IDENTIFIER: {
+            std::string name = identifier();
+            const char *function = functionName(name);
+            if (!function || !accept(SQLToken::LPAREN)) {
+                primary._columnName = columnName(name);
+                break;
+            }
+            primary._function = std::string(function);
+            if (!accept(SQLToken::STAR)) {
+                Operand arg = expression(PREC_ADDITIVE);
+                requireValue(arg);
+                primary._expr.push_back(arg._expr);
+            }
+            expect(SQLToken::RPAREN, "')'");
+        } break;
+        case SQLToken::PARAMETER: {
+            _lexer.next();
+            primary._dynamicParameter = '?';
+        } break;
+        case SQLToken::STRING: {
+            primary._literal = _lexer.next().unquoted();
+        } break;
+        case SQLToken::NUMBER: {
+            primary._num = strtoul(_lexer.next()._begin, 0, 10);
+        } break;
+        case SQLToken::LPAREN: {
+            _lexer.next();
+            Operand inner = expression(PREC_OR);
+            expect(SQLToken::RPAREN, "')'");
+            if (inner._isCondition) {
+                return inner;
+            }
+            primary._expr.push_back(inner._expr);
+        } break;
+        default: fail("expression");
+    }
+
+    return operand;
+}
+
+Operand Parser::unary()
+{
+    if (acceptKeyword("NOT")) {
+        Operand operand = expression(PREC_NOT);
+        requireCondition(operand);
+        Operand result;
+        result._isCondition = true;
+        result._cond = BSONFromNot()(operand._cond);
+        return result;
+    }
+
+    SQLToken::Type type = _lexer.peek()._type;
+    if (SQLToken::PLUS != type && SQLToken::MINUS != type) {
+        return primary();
+    }
+    _lexer.next();
+    Operand operand = unary();
+    requireValue(operand);
+    if (!isFactor(operand._expr) || operand._expr._term._factor._op) {
+        // a factor carries one sign, so anything else is parenthesized
+        Operand wrapped;
+        wrapped._expr._term._factor._primary._expr.push_back(operand._expr);
+        operand = wrapped;
+    }
+    operand._expr._term._factor._op = SQLToken::PLUS == type ? '+' : '-';
+    return operand;
+}
+
+Operand Parser::expression(int minPrec)
+{
+    Operand lhs = unary();
+    for (;;) {
+        SQLToken op = _lexer.peek();
+        int prec = binaryPrecedence(op);
+        if (PREC_NONE == prec || prec < minPrec) {
+            break;
+        }
+        _lexer.next();
+
+        // 'AND' and 'OR' group to the right like the Spirit grammar; the
+        // other operators group to the left
+        bool rightAssoc = PREC_AND == prec || PREC_OR == prec;
+        Operand rhs = expression(rightAssoc ? prec : prec + 1);
+        lhs = combine(lhs, op, rhs);
+    }
+    return lhs;
+}
+
+Operand Parser::combine(const Operand& lhs, const SQLToken& op, const Operand& rhs)
+{
+    Operand result;
+    switch(op._type) {
+        case SQLToken::STAR:
+        case SQLToken::SLASH: {
+            requireValue(lhs);
+            requireValue(rhs);
+            result._expr = multiplicative(lhs._expr, op._begin[0], rhs._expr);
+        } break;
+        case SQLToken::PLUS:
+        case SQLToken::MINUS: {
+            requireValue(lhs);
+            requireValue(rhs);
+            result._expr = additive(lhs._expr, op._begin[0], rhs._expr);
+        } break;
+        case SQLToken::IDENTIFIER: {
+            requireCondition(lhs);
+            requireCondition(rhs);
+            result._isCondition = true;
+            result._cond = op.isKeyword("AND") ? BSONFromAnd()(lhs._cond, rhs._cond)
+                                               : BSONFromOr()(lhs._cond, rhs._cond);
+        } break;
+        default: {
+            requireValue(lhs);
+            requireValue(rhs);
+            result._isCondition = true;
+            result._cond = BSONFromComparison()(lhs._expr,
+                                                std::string(comparisonOp(op._type)),
+                                                rhs._expr);
+        } break;
+    }
+    return result;
+}
+
+void Parser::statement(mongoodbc::SQLStatement *stmt)
+{
+    if (!acceptKeyword("SELECT")) {
+        fail("SELECT");
+    }
+    if (acceptKeyword("ALL")) {
+        stmt->_all = true;
+    } else if (acceptKeyword("DISTINCT")) {
+        stmt->_distinct = true;
+    }
+
+    if (!accept(SQLToken::STAR)) {
+        do {
+            Operand column = expression(PREC_ADDITIVE);
+            requireValue(column);
+            stmt->_selectList.push_back(column._expr);
+        } while (accept(SQLToken::COMMA));
+    }
+
+    if (!acceptKeyword("FROM")) {
+        fail("FROM");
+    }
+    do {
+        stmt->_tableRefList.push_back(tableName());
+    } while (accept(SQLToken::COMMA));
+
+    for (;;) {
+        bool inner = acceptKeyword("INNER");
+        if (!acceptKeyword("JOIN")) {
+            if (inner) {
+                fail("JOIN");
+            }
+            break;
+        }
+        mongoodbc::SQLElementJoin join;
+        join._table = tableName();
+        if (!acceptKeyword("ON")) {
+            fail("ON");
+        }
+        do {
+            mongoodbc::SQLElementJoinCondition cond;
+            cond._left = columnName();
+            expect(SQLToken::EQ, "'='");
+            cond._right = columnName();
+            join._on.push_back(cond);
+        } while (acceptKeyword("AND"));
+        stmt->_joins.push_back(join);
+    }
+
+    if (acceptKeyword("WHERE")) {
+        Operand cond = expression(PREC_OR);
+        requireCondition(cond);
+        stmt->_whereClause = mongo::Query(cond._cond);
+    }
+
+    if (acceptKeyword("GROUP")) {
+        if (!acceptKeyword("BY")) {
+            fail("BY");
+        }
+        do {
+            Operand key = expression(PREC_ADDITIVE);
+            requireValue(key);
+            stmt->_groupBy.push_back(key._expr);
+        } while (accept(SQLToken::COMMA));
+    }
+
+    if (acceptKeyword("ORDER")) {
+        if (!acceptKeyword("BY")) {
+            fail("BY");
+        }
+        do {
+            Operand key = expression(PREC_ADDITIVE);
+            requireValue(key);
+            mongoodbc::SQLElementSortSpec spec;
+            spec._expr = key._expr;
+            if (acceptKeyword("DESC")) {
+                spec._descending = true;
+            } else {
+                acceptKeyword("ASC");
+            }
+            stmt->_orderBy.push_back(spec);
+        } while (accept(SQLToken::COMMA));
+    }
+
+    if (acceptKeyword("LIMIT")) {
+        if (SQLToken::NUMBER != _lexer.peek()._type) {
+            fail("number");
+        }
+        stmt->_limit = strtoul(_lexer.next()._begin, 0, 10);
+    }
+
+    accept(SQLToken::SEMICOLON);
+    if (SQLToken::END != _lexer.peek()._type) {
+        fail("end of statement");
+    }
+}
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+int SQLFastParser::parse(const std::string& sql, SQLStatement *stmt, std::string *errmsg)
+{
+    try {
+        SQLStatement parsed;
+        Parser(sql).statement(&parsed);
+        *stmt = parsed;
+    } catch (const ParseError& ex) {
+        if (errmsg) {
+            *errmsg = ex.what();
+        }
+        return -1;
+    }
+
+    return 0;
+}
+
+} // close mongoodbc namespace
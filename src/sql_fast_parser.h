@@ -0,0 +1,47 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_SQL_FAST_PARSER_H_
+#define MONGOODBC_SQL_FAST_PARSER_H_
+
+#include "sql_parser.h"
+
+#include <string>
+
+namespace mongoodbc {
+
+/*
+* Hand-written alternative to 'SQLParser'.  It reads the statement in one
+* pass with 'SQLLexer', using precedence climbing for expressions and search
+* conditions, and produces the same 'SQLStatement' as the Spirit grammar.
+*
+* It accepts a superset of the grammar: parenthesized search conditions,
+* arithmetic with the usual precedence, single quoted literals, single part
+* table names and a trailing ';'.  The whole text must be consumed.
+*/
+class SQLFastParser {
+  public:
+    /*
+    * Parses 'sql' into 'stmt'.  On failure a description of the error is
+    * stored in 'errmsg' if it is not null.
+    * @return 0 on success, -1 otherwise
+    */
+    static int parse(const std::string& sql, SQLStatement *stmt, std::string *errmsg);
+};
+
+} // close mongoodbc namespace
+
+#endif
@@ -0,0 +1,166 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "sql_fast_parser.h"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+
+using mongoodbc::SQLFastParser;
+using mongoodbc::SQLStatement;
+
+namespace {
+
+std::string toString(const SQLStatement& stmt)
+{
+    std::ostringstream str;
+    str << stmt;
+    return str.str();
+}
+
+std::string fastParse(const std::string& sql)
+{
+    SQLStatement stmt;
+    std::string errmsg;
+    EXPECT_EQ(0, SQLFastParser::parse(sql, &stmt, &errmsg)) << sql << ": " << errmsg;
+    return toString(stmt);
+}
+
+std::string spiritParse(const std::string& sql)
+{
+    SQLStatement stmt;
+    std::string::const_iterator iter = sql.begin();
+    std::string::const_iterator end = sql.end();
+    EXPECT_TRUE(boost::spirit::qi::phrase_parse(iter,
+                                                end,
+                                                mongoodbc::sharedSQLParser(),
+                                                boost::spirit::ascii::space,
+                                                stmt)) << sql;
+    EXPECT_TRUE(iter == end) << sql;
+    return toString(stmt);
+}
+
+} // close unnamed namespace
+
+TEST(SQLFastParser, MatchesSpirit)
+{
+    const char *queries[] = {
+        "SELECT * FROM db.coll",
+        "select all * from db.coll",
+        "SELECT DISTINCT a FROM db.coll",
+        "SELECT a, t.b, ?, 12, \"lit\" FROM db.coll, db.other",
+        "SELECT * FROM db.coll WHERE age > 5",
+        "SELECT * FROM db.coll WHERE age >= 5 AND name <> \"bob\"",
+        "SELECT * FROM db.coll WHERE a = 1 OR b < 2 AND c <= 3",
+        "SELECT * FROM db.coll WHERE a = 1 AND b = 2 AND c = 3 OR d = 4",
+        "SELECT * FROM db.coll WHERE NOT a = 1 AND b = ?",
+        "SELECT * FROM db.coll WHERE -a = +1",
+        "SELECT * FROM db.a JOIN db.b ON a.x = b.y",
+        "SELECT * FROM db.a INNER JOIN db.b ON a.x = b.y AND a.z = b.z JOIN db.c ON b.w = c.w WHERE a.v > 1",
+        "SELECT * FROM db.coll WHERE t.a = 1",
+        "SELECT a FROM db.coll WHERE a > 1 ORDER BY a, b DESC, c ASC LIMIT 50",
+        "SELECT * FROM db.a JOIN db.b ON a.x = b.y ORDER BY -a.v DESC, b.w",
+        "SELECT * FROM db.coll LIMIT 0",
+        "SELECT a, COUNT(*), sum(b), Max(-c) FROM db.coll WHERE b > 1 GROUP BY a ORDER BY a LIMIT 5",
+        "SELECT a.x, b.y, AVG(a.v) FROM db.a JOIN db.b ON a.x = b.y GROUP BY a.x, b.y",
+        "SELECT address.city, t.geo.lat FROM db.t WHERE address.zip.code > 1 ORDER BY address.city"
+    };
+    for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); ++i) {
+        EXPECT_EQ(spiritParse(queries[i]), fastParse(queries[i]));
+    }
+}
+
+TEST(SQLFastParser, Precedence)
+{
+    EXPECT_EQ("SELECT this.a + (this.b * this.c) FROM db.coll",
+              fastParse("SELECT a + b * c FROM db.coll"));
+    EXPECT_EQ("SELECT (this.a + this.b) * this.c FROM db.coll",
+              fastParse("SELECT (a + b) * c FROM db.coll"));
+    EXPECT_EQ("SELECT this.a - this.b - this.c FROM db.coll",
+              fastParse("SELECT a - b - c FROM db.coll"));
+    EXPECT_EQ("SELECT this.a - (this.b - this.c) FROM db.coll",
+              fastParse("SELECT a - (b - c) FROM db.coll"));
+    EXPECT_EQ("SELECT -(-this.a) FROM db.coll",
+              fastParse("SELECT - -a FROM db.coll"));
+}
+
+TEST(SQLFastParser, ParenthesizedConditions)
+{
+    // grouping overrides the right-nested AND/OR shape
+    EXPECT_EQ(fastParse("SELECT * FROM db.coll WHERE a = 1 OR b = 2 AND c = 3"),
+              fastParse("SELECT * FROM db.coll WHERE a = 1 OR (b = 2 AND c = 3)"));
+    EXPECT_NE(fastParse("SELECT * FROM db.coll WHERE a = 1 OR b = 2 AND c = 3"),
+              fastParse("SELECT * FROM db.coll WHERE (a = 1 OR b = 2) AND c = 3"));
+    EXPECT_EQ(fastParse("SELECT * FROM db.coll WHERE NOT a = 1"),
+              fastParse("SELECT * FROM db.coll WHERE NOT (a = 1)"));
+}
+
+TEST(SQLFastParser, Extensions)
+{
+    EXPECT_EQ("SELECT * FROM coll", fastParse("SELECT * FROM coll;"));
+    EXPECT_EQ(fastParse("SELECT * FROM db.coll WHERE a = \"it's\""),
+              fastParse("SELECT * FROM db.coll WHERE a = 'it''s'"));
+    EXPECT_EQ("SELECT * FROM db.coll.sub", fastParse("SELECT * FROM db.coll.sub"));
+}
+
+TEST(SQLFastParser, Errors)
+{
+    const char *queries[] = {
+        "",
+        "SELECT",
+        "SELECT * db.coll",
+        "SELECT * FROM",
+        "SELECT a FROM db.coll WHERE",
+        "SELECT a FROM db.coll WHERE a",
+        "SELECT a FROM db.coll WHERE a = 1 AND b",
+        "SELECT a FROM db.coll WHERE a < b < c",
+        "SELECT a FROM db.coll WHERE (a = 1",
+        "SELECT a = 1 FROM db.coll",
+        "SELECT * FROM db.a JOIN db.b",
+        "SELECT * FROM db.a INNER db.b ON a.x = b.y",
+        "SELECT * FROM db.a JOIN db.b ON a.x < b.y",
+        "SELECT * FROM db.coll WHERE a = 'open",
+        "SELECT * FROM db.coll extra",
+        "SELECT from FROM db.coll",
+        "SELECT * FROM db.coll ORDER a",
+        "SELECT * FROM db.coll ORDER BY",
+        "SELECT * FROM db.coll ORDER BY a = 1",
+        "SELECT * FROM db.coll LIMIT a",
+        "SELECT * FROM db.coll LIMIT 5 ORDER BY a",
+        "SELECT COUNT(* FROM db.coll",
+        "SELECT a FROM db.coll GROUP a",
+        "SELECT a FROM db.coll ORDER BY a GROUP BY a"
+    };
+    for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); ++i) {
+        SQLStatement stmt;
+        std::string errmsg;
+        EXPECT_EQ(-1, SQLFastParser::parse(queries[i], &stmt, &errmsg)) << queries[i];
+        EXPECT_FALSE(errmsg.empty()) << queries[i];
+    }
+
+    SQLStatement stmt;
+    std::string errmsg;
+    ASSERT_EQ(-1, SQLFastParser::parse("SELECT * FROM db.coll extra", &stmt, &errmsg));
+    EXPECT_EQ("expected end of statement at 'extra'", errmsg);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
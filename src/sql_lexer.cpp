@@ -0,0 +1,168 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "sql_lexer.h"
+
+#include <ctype.h>
+
+namespace {
+
+bool isIdentifierStart(char c)
+{
+    return isalpha((unsigned char)c) || '_' == c;
+}
+
+bool isIdentifierChar(char c)
+{
+    return isalnum((unsigned char)c) || '_' == c;
+}
+
+} // close unnamed namespace
+
+namespace mongoodbc {
+
+bool SQLToken::isKeyword(const char *keyword) const
+{
+    if (IDENTIFIER != _type) {
+        return false;
+    }
+    for (size_t i = 0; i < _length; ++i) {
+        if (!keyword[i] || toupper((unsigned char)_begin[i]) != keyword[i]) {
+            return false;
+        }
+    }
+    return !keyword[_length];
+}
+
+std::string SQLToken::unquoted() const
+{
+    std::string value;
+    if (_length < 2) {
+        return value;
+    }
+    char quote = _begin[0];
+    value.reserve(_length - 2);
+    for (size_t i = 1; i < _length - 1; ++i) {
+        value += _begin[i];
+        if (quote == _begin[i]) {
+            // skip the second of a doubled quote
+            ++i;
+        }
+    }
+    return value;
+}
+
+SQLLexer::SQLLexer(const char *begin, const char *end)
+    : _pos(begin)
+    , _end(end)
+{
+    advance();
+}
+
+SQLToken SQLLexer::next()
+{
+    SQLToken token = _current;
+    if (SQLToken::END != token._type && SQLToken::ERROR != token._type) {
+        advance();
+    }
+    return token;
+}
+
+void SQLLexer::advance()
+{
+    while (_pos != _end && isspace((unsigned char)*_pos)) {
+        ++_pos;
+    }
+
+    _current._begin = _pos;
+    _current._length = 0;
+    if (_pos == _end) {
+        _current._type = SQLToken::END;
+        return;
+    }
+
+    const char *start = _pos;
+    char c = *_pos++;
+    SQLToken::Type type = SQLToken::ERROR;
+    if (isIdentifierStart(c)) {
+        while (_pos != _end && isIdentifierChar(*_pos)) {
+            ++_pos;
+        }
+        type = SQLToken::IDENTIFIER;
+    } else if (isdigit((unsigned char)c)) {
+        while (_pos != _end && isdigit((unsigned char)*_pos)) {
+            ++_pos;
+        }
+        type = SQLToken::NUMBER;
+    } else if ('\'' == c || '"' == c) {
+        // a doubled quote stands for the quote character itself
+        type = SQLToken::ERROR;
+        while (_pos != _end) {
+            if (c == *_pos++) {
+                if (_pos == _end || c != *_pos) {
+                    type = SQLToken::STRING;
+                    break;
+                }
+                ++_pos;
+            }
+        }
+    } else {
+        char n = _pos != _end ? *_pos : '\0';
+        switch (c) {
+          case '?': type = SQLToken::PARAMETER; break;
+          case '(': type = SQLToken::LPAREN; break;
+          case ')': type = SQLToken::RPAREN; break;
+          case ',': type = SQLToken::COMMA; break;
+          case '.': type = SQLToken::DOT; break;
+          case ';': type = SQLToken::SEMICOLON; break;
+          case '*': type = SQLToken::STAR; break;
+          case '+': type = SQLToken::PLUS; break;
+          case '-': type = SQLToken::MINUS; break;
+          case '/': type = SQLToken::SLASH; break;
+          case '=': type = SQLToken::EQ; break;
+          case '!': {
+            if ('=' == n) {
+                ++_pos;
+                type = SQLToken::NE;
+            }
+          } break;
+          case '<': {
+            if ('=' == n) {
+                ++_pos;
+                type = SQLToken::LE;
+            } else if ('>' == n) {
+                ++_pos;
+                type = SQLToken::NE;
+            } else {
+                type = SQLToken::LT;
+            }
+          } break;
+          case '>': {
+            if ('=' == n) {
+                ++_pos;
+                type = SQLToken::GE;
+            } else {
+                type = SQLToken::GT;
+            }
+          } break;
+        }
+    }
+
+    _current._type = type;
+    _current._length = _pos - start;
+}
+
+} // close mongoodbc namespace
@@ -0,0 +1,101 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_SQL_LEXER_H_
+#define MONGOODBC_SQL_LEXER_H_
+
+#include <string>
+
+#include <stddef.h>
+
+namespace mongoodbc {
+
+/*
+* A token of SQL text.  Tokens refer into the text they were read from,
+* which must outlive them.
+*/
+struct SQLToken {
+    enum Type {
+        END,
+        ERROR,
+        IDENTIFIER,
+        NUMBER,
+        STRING,         // quoted with ' or ", quotes included
+        PARAMETER,      // ?
+        LPAREN,
+        RPAREN,
+        COMMA,
+        DOT,
+        SEMICOLON,
+        STAR,
+        PLUS,
+        MINUS,
+        SLASH,
+        EQ,             // =
+        NE,             // <> or !=
+        LT,
+        LE,
+        GT,
+        GE
+    };
+
+    Type _type;
+    const char *_begin;
+    size_t _length;
+
+    /*
+    * Returns true if this is an identifier equal to 'keyword', ignoring
+    * case.  'keyword' must be upper case.
+    */
+    bool isKeyword(const char *keyword) const;
+
+    std::string text() const { return std::string(_begin, _length); }
+
+    /*
+    * Returns the value of a STRING token with the quotes removed and
+    * doubled quotes collapsed.
+    */
+    std::string unquoted() const;
+};
+
+/*
+* Splits SQL text into tokens.  The lexer does not allocate; tokens are
+* views of the text.
+*/
+class SQLLexer {
+    const char *_pos;
+    const char *_end;
+    SQLToken _current;
+
+    void advance();
+
+  public:
+    SQLLexer(const char *begin, const char *end);
+
+    /*
+    * Returns the next token without consuming it.
+    */
+    const SQLToken& peek() const { return _current; }
+
+    /*
+    * Consumes and returns the next token.
+    */
+    SQLToken next();
+};
+
+} // close mongoodbc namespace
+
+#endif
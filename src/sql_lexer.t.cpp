@@ -0,0 +1,123 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "sql_lexer.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <string.h>
+
+using mongoodbc::SQLLexer;
+using mongoodbc::SQLToken;
+
+namespace {
+
+// tokens refer into the text, so it must outlive them
+std::vector<SQLToken> tokenize(const char *str)
+{
+    SQLLexer lexer(str, str + strlen(str));
+    std::vector<SQLToken> tokens;
+    for (;;) {
+        SQLToken token = lexer.next();
+        tokens.push_back(token);
+        if (SQLToken::END == token._type || SQLToken::ERROR == token._type) {
+            return tokens;
+        }
+    }
+}
+
+} // close unnamed namespace
+
+TEST(SQLLexer, Empty)
+{
+    std::vector<SQLToken> tokens = tokenize("  \t\n ");
+    ASSERT_EQ(1u, tokens.size());
+    EXPECT_EQ(SQLToken::END, tokens[0]._type);
+}
+
+TEST(SQLLexer, Statement)
+{
+    const char *str = "SELECT a, t.b FROM db.coll WHERE a >= 10 AND b <> ?;";
+    std::vector<SQLToken> tokens = tokenize(str);
+    SQLToken::Type expected[] = {
+        SQLToken::IDENTIFIER, SQLToken::IDENTIFIER, SQLToken::COMMA,
+        SQLToken::IDENTIFIER, SQLToken::DOT, SQLToken::IDENTIFIER,
+        SQLToken::IDENTIFIER, SQLToken::IDENTIFIER, SQLToken::DOT,
+        SQLToken::IDENTIFIER, SQLToken::IDENTIFIER, SQLToken::IDENTIFIER,
+        SQLToken::GE, SQLToken::NUMBER, SQLToken::IDENTIFIER,
+        SQLToken::IDENTIFIER, SQLToken::NE, SQLToken::PARAMETER,
+        SQLToken::SEMICOLON, SQLToken::END
+    };
+    ASSERT_EQ(sizeof(expected) / sizeof(expected[0]), tokens.size());
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        EXPECT_EQ(expected[i], tokens[i]._type) << i;
+    }
+    EXPECT_EQ("coll", tokens[9].text());
+    EXPECT_EQ("10", tokens[13].text());
+    // tokens are views of the input
+    EXPECT_EQ(str, tokens[0]._begin);
+}
+
+TEST(SQLLexer, Keywords)
+{
+    std::vector<SQLToken> tokens = tokenize("select Select SELECTED");
+    EXPECT_TRUE(tokens[0].isKeyword("SELECT"));
+    EXPECT_TRUE(tokens[1].isKeyword("SELECT"));
+    EXPECT_FALSE(tokens[2].isKeyword("SELECT"));
+    EXPECT_FALSE(tokens[0].isKeyword("SELECTED"));
+}
+
+TEST(SQLLexer, Operators)
+{
+    std::vector<SQLToken> tokens = tokenize("< <= <> != > >= = + - * / ( )");
+    SQLToken::Type expected[] = {
+        SQLToken::LT, SQLToken::LE, SQLToken::NE, SQLToken::NE,
+        SQLToken::GT, SQLToken::GE, SQLToken::EQ, SQLToken::PLUS,
+        SQLToken::MINUS, SQLToken::STAR, SQLToken::SLASH,
+        SQLToken::LPAREN, SQLToken::RPAREN, SQLToken::END
+    };
+    ASSERT_EQ(sizeof(expected) / sizeof(expected[0]), tokens.size());
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        EXPECT_EQ(expected[i], tokens[i]._type) << i;
+    }
+}
+
+TEST(SQLLexer, Strings)
+{
+    std::vector<SQLToken> tokens = tokenize("\"lite\"\"ral\" 'it''s' ''");
+    ASSERT_EQ(4u, tokens.size());
+    EXPECT_EQ(SQLToken::STRING, tokens[0]._type);
+    EXPECT_EQ("lite\"ral", tokens[0].unquoted());
+    EXPECT_EQ("it's", tokens[1].unquoted());
+    EXPECT_EQ("", tokens[2].unquoted());
+}
+
+TEST(SQLLexer, Errors)
+{
+    EXPECT_EQ(SQLToken::ERROR, tokenize("'open")[0]._type);
+    EXPECT_EQ(SQLToken::ERROR, tokenize("'open''")[0]._type);
+    EXPECT_EQ(SQLToken::ERROR, tokenize("a # b")[1]._type);
+    EXPECT_EQ(SQLToken::ERROR, tokenize("!")[0]._type);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
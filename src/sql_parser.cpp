@@ -16,7 +16,28 @@
 
 #include <sql_parser.h>
 
+#include <boost/thread/once.hpp>
+
+namespace {
+
+boost::once_flag s_parserOnce = BOOST_ONCE_INIT;
+const mongoodbc::SQLParser<std::string::const_iterator> *s_parser = 0;
+
+void createParser()
+{
+    // the grammar's rules refer to each other, so it is built in place once
+    static const mongoodbc::SQLParser<std::string::const_iterator> parser;
+    s_parser = &parser;
+}
+
+} // close unnamed namespace
+
 namespace mongoodbc {
 
+const SQLParser<std::string::const_iterator>& sharedSQLParser()
+{
+    boost::call_once(s_parserOnce, &createParser);
+    return *s_parser;
 }
 
+}
@@ -57,6 +57,13 @@ SQLParser<It>::SQLParser()
     BOOST_SPIRIT_DEBUG_NODE(_start);
 }
 
+/*
+* Returns the process wide parser for SQL held in a std::string.  It is
+* built on first use; parsing does not modify the grammar, so it may be used
+* by several threads at once.
+*/
+const SQLParser<std::string::const_iterator>& sharedSQLParser();
+
 } // close mongoodbc namespace
 
 #endif
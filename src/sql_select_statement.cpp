@@ -16,6 +16,115 @@
 
 #include "sql_select_statement.h"
 
+#include <mongo/client/dbclient.h>
+
+#include <ctype.h>
+#include <string.h>
+
+namespace {
+
+using mongoodbc::SQLElementColumnName;
+using mongoodbc::SQLElementExpression;
+using mongoodbc::SQLElementExpression_Primary;
+using mongoodbc::SQLElementExpression_Term;
+
+// the parsers write column 'c' of table 't' as 'this.t.this.c'
+const char THIS[] = "this.";
+const size_t THIS_LEN = sizeof(THIS) - 1;
+
+void resolveColumn(const std::string& table, SQLElementColumnName *column)
+{
+    if (!column->_tableName) {
+        return;
+    }
+    std::string qualifier = column->_tableName->substr(THIS_LEN);
+    if (qualifier != table) {
+        column->_columnName.insert(THIS_LEN, qualifier + ".");
+    }
+    column->_tableName.reset();
+}
+
+void resolveExpression(const std::string& table, SQLElementExpression *expr);
+
+void resolveTerm(const std::string& table, SQLElementExpression_Term *term)
+{
+    if (!term->_term.empty()) {
+        resolveTerm(table, &term->_term[0].get());
+    }
+    SQLElementExpression_Primary& primary = term->_factor._primary;
+    if (primary._columnName) {
+        resolveColumn(table, &*primary._columnName);
+    }
+    if (!primary._expr.empty()) {
+        resolveExpression(table, &primary._expr[0].get());
+    }
+}
+
+void resolveExpression(const std::string& table, SQLElementExpression *expr)
+{
+    if (!expr->_expr.empty()) {
+        resolveExpression(table, &expr->_expr[0].get());
+    }
+    resolveTerm(table, &expr->_term);
+}
+
+/*
+* Rewrites 'this.<qualifier>.this.' in the comparison text 'where'.
+*/
+std::string resolveWhere(const std::string& table, const std::string& where)
+{
+    std::string result;
+    size_t pos = 0;
+    while (pos < where.size()) {
+        size_t begin = where.find(THIS, pos);
+        if (std::string::npos == begin) {
+            break;
+        }
+        size_t end = begin + THIS_LEN;
+        while (end < where.size() && (isalnum((unsigned char)where[end]) || '_' == where[end])) {
+            ++end;
+        }
+        bool wordStart = 0 == begin || (!isalnum((unsigned char)where[begin - 1])
+                                        && '_' != where[begin - 1] && '.' != where[begin - 1]);
+        if (!wordStart || end == begin + THIS_LEN
+            || 0 != where.compare(end, THIS_LEN + 1, std::string(".") + THIS)) {
+            result.append(where, pos, end - pos);
+            pos = end;
+            continue;
+        }
+        std::string qualifier = where.substr(begin + THIS_LEN, end - begin - THIS_LEN);
+        result.append(where, pos, begin - pos);
+        result.append(THIS);
+        if (qualifier != table) {
+            result.append(qualifier + ".");
+        }
+        pos = end + 1 + THIS_LEN;
+    }
+    result.append(where, pos, std::string::npos);
+    return result;
+}
+
+mongo::BSONObj resolveCondition(const std::string& table, const mongo::BSONObj& cond)
+{
+    mongo::BSONObjBuilder builder;
+    mongo::BSONObjIterator fieldIt(cond);
+    while (fieldIt.more()) {
+        mongo::BSONElement elem = fieldIt.next();
+        if (mongo::String == elem.type() && 0 == strcmp("$where", elem.fieldName())) {
+            builder.append(elem.fieldName(), resolveWhere(table, elem.str()));
+        } else if (mongo::Object == elem.type()) {
+            builder.append(elem.fieldName(), resolveCondition(table, elem.embeddedObject()));
+        } else if (mongo::Array == elem.type()) {
+            builder.appendArray(elem.fieldName(), resolveCondition(table, elem.embeddedObject()));
+        } else {
+            builder.append(elem);
+        }
+    }
+    return builder.obj();
+}
+
+} // close unnamed namespace
+
 namespace mongoodbc {
 
 SQLSelectStatement::SQLSelectStatement()
@@ -24,6 +133,28 @@ SQLSelectStatement::SQLSelectStatement()
 {
 }
 
+void SQLSelectStatement::resolvePaths()
+{
+    if (1 != _tableRefList.size() || !_joins.empty()) {
+        return;
+    }
+    size_t dot = _tableRefList[0].find('.');
+    std::string table = std::string::npos == dot ? _tableRefList[0]
+                                                 : _tableRefList[0].substr(dot + 1);
+    for (size_t i = 0; i < _selectList.size(); ++i) {
+        resolveExpression(table, &_selectList[i]);
+    }
+    for (size_t i = 0; i < _groupBy.size(); ++i) {
+        resolveExpression(table, &_groupBy[i]);
+    }
+    for (size_t i = 0; i < _orderBy.size(); ++i) {
+        resolveExpression(table, &_orderBy[i]._expr);
+    }
+    if (_whereClause) {
+        _whereClause = mongo::Query(resolveCondition(table, _whereClause->obj));
+    }
+}
+
 } // close mongoodbc namespace
 
 
@@ -18,7 +18,9 @@
 #define MONGOODBC_SQL_SELECT_STATEMENT_H_
 
 #include "sql_element_expression.h"
+#include "sql_element_join.h"
 #include "sql_element_search_condition.h"
+#include "sql_element_sort_spec.h"
 
 #include <mongo/bson/bsonobj.h>
 
@@ -50,9 +52,21 @@ struct SQLSelectStatement {
     bool _distinct;
     std::vector<SQLElementExpression> _selectList;
     std::vector<std::string> _tableRefList;
+    std::vector<SQLElementJoin> _joins;
     boost::optional<mongo::Query> _whereClause;
+    std::vector<SQLElementExpression> _groupBy;
+    std::vector<SQLElementSortSpec> _orderBy;
+    boost::optional<unsigned long> _limit;
 
     SQLSelectStatement();
+
+    /*
+    * Turns the qualified columns of a statement reading a single table
+    * into paths of its documents: a qualifier naming the table is dropped,
+    * e.g. 'coll.a' is 'a' in 'FROM db.coll', and any other is the first
+    * part of a path into embedded documents, e.g. 'address.city'.
+    */
+    void resolvePaths();
 };
 inline std::ostream& operator<<(std::ostream& stream, const SQLSelectStatement& rhs);
 
@@ -66,6 +80,8 @@ struct SQLSelectStatementParser : qi::grammar<It, SQLSelectStatement(), ascii::s
     qi::rule<It, SQLSelectStatement(), ascii::space_type> _rule;
     SQLElementExpressionParser<It> _exprParser;
     SQLElementSearchConditionParser<It> _searchCondParser;
+    SQLElementJoinParser<It> _joinParser;
+    SQLElementSortSpecParser<It> _sortSpecParser;
 
     SQLSelectStatementParser();
 };
@@ -74,6 +90,8 @@ template <typename It>
 SQLSelectStatementParser<It>::SQLSelectStatementParser()
     : SQLSelectStatementParser::base_type(_rule)
     , _searchCondParser(&_exprParser)
+    , _joinParser(&_namespace)
+    , _sortSpecParser(&_exprParser)
 {
     _namespace %= qi::lexeme[ascii::alpha >> *ascii::alnum >> ascii::char_('.') >> ascii::alpha >> *ascii::alnum];
     _rule = ascii::no_case["select"]
@@ -83,8 +101,14 @@ SQLSelectStatementParser<It>::SQLSelectStatementParser()
                   (_exprParser._rule [phoenix::push_back(phoenix::at_c<2>(qi::_val), qi::_1)] % ','))
              >> ascii::no_case["from"]
              >> _namespace [phoenix::push_back(phoenix::at_c<3>(qi::_val), qi::_1)] % ','
+             >> *(_joinParser._rule [phoenix::push_back(phoenix::at_c<4>(qi::_val), qi::_1)])
              >> -(ascii::no_case["where"]
-                  >> _searchCondParser._rule) [phoenix::at_c<4>(qi::_val) = phoenix::construct<mongo::Query>(qi::_1)];
+                  >> _searchCondParser._rule) [phoenix::at_c<5>(qi::_val) = phoenix::construct<mongo::Query>(qi::_1)]
+             >> -(ascii::no_case["group"] >> ascii::no_case["by"]
+                  >> (_exprParser._rule [phoenix::push_back(phoenix::at_c<6>(qi::_val), qi::_1)] % ','))
+             >> -(ascii::no_case["order"] >> ascii::no_case["by"]
+                  >> (_sortSpecParser._rule [phoenix::push_back(phoenix::at_c<7>(qi::_val), qi::_1)] % ','))
+             >> -(ascii::no_case["limit"] >> qi::ulong_ [phoenix::at_c<8>(qi::_val) = qi::_1]);
 
     BOOST_SPIRIT_DEBUG_NODE(_rule);
 };
@@ -97,7 +121,11 @@ BOOST_FUSION_ADAPT_STRUCT(
     (bool, _distinct)
     (std::vector<mongoodbc::SQLElementExpression>, _selectList)
     (std::vector<std::string>, _tableRefList)
-    (boost::optional<mongo::Query>, _whereClause));
+    (std::vector<mongoodbc::SQLElementJoin>, _joins)
+    (boost::optional<mongo::Query>, _whereClause)
+    (std::vector<mongoodbc::SQLElementExpression>, _groupBy)
+    (std::vector<mongoodbc::SQLElementSortSpec>, _orderBy)
+    (boost::optional<unsigned long>, _limit));
 
 inline std::ostream& mongoodbc::operator<<(std::ostream& stream,
                                            const mongoodbc::SQLSelectStatement& rhs)
@@ -120,6 +148,20 @@ inline std::ostream& mongoodbc::operator<<(std::ostream& stream,
             tables << ",";
         }
     }
+    for (size_t i = 0; i < rhs._joins.size(); ++i) {
+        tables << " " << rhs._joins[i];
+    }
+
+    std::stringstream orderBy;
+    for (size_t i = 0; i < rhs._groupBy.size(); ++i) {
+        orderBy << (i ? "," : " GROUP BY ") << rhs._groupBy[i];
+    }
+    for (size_t i = 0; i < rhs._orderBy.size(); ++i) {
+        orderBy << (i ? "," : " ORDER BY ") << rhs._orderBy[i];
+    }
+    if (rhs._limit) {
+        orderBy << " LIMIT " << *rhs._limit;
+    }
 
     stream << "SELECT "
            << (rhs._all ? "ALL " : "")
@@ -127,7 +169,8 @@ inline std::ostream& mongoodbc::operator<<(std::ostream& stream,
            << columns.str()
            << " FROM " << tables.str()
            << (rhs._whereClause ? " WHERE " : "")
-           << (rhs._whereClause ? rhs._whereClause->toString() : "");
+           << (rhs._whereClause ? rhs._whereClause->toString() : "")
+           << orderBy.str();
 
    return stream;        
 }
@@ -201,6 +201,116 @@ TEST(SQLSelectStatement, SelectStarWhere)
     }
 }
 
+TEST(SQLSelectStatement, SelectStarJoin)
+{
+    mongoodbc::SQLSelectStatementParser<std::string::const_iterator> parser;
+    mongoodbc::SQLSelectStatement stmt;
+    std::string query("SELECT * FROM db.orders JOIN db.customers ON orders.cust = customers.id"
+                      " AND orders.region = customers.region WHERE total > 5");
+    std::string::const_iterator iter = query.begin();
+    std::string::const_iterator end = query.end();
+    try
+    {
+        EXPECT_TRUE(
+            boost::spirit::qi::phrase_parse(iter, end, parser, boost::spirit::ascii::space, stmt));
+        EXPECT_TRUE(iter == end);
+        ASSERT_EQ(1, stmt._tableRefList.size());
+        ASSERT_EQ(1, stmt._joins.size());
+        EXPECT_EQ("db.customers", stmt._joins[0]._table);
+        ASSERT_EQ(2, stmt._joins[0]._on.size());
+        EXPECT_EQ("this.orders", *stmt._joins[0]._on[0]._left._tableName);
+        EXPECT_EQ("this.id", stmt._joins[0]._on[0]._right._columnName);
+        EXPECT_TRUE(stmt._whereClause.is_initialized());
+        std::cout << "SELECT Stmt: " << stmt << std::endl;
+    }
+    catch (const boost::spirit::qi::expectation_failure<std::string::const_iterator>& ex)
+    {
+        std::string fragment(ex.first, ex.last);
+        std::cerr << ex.what() << "'" << fragment << "'" << std::endl;
+    }
+}
+
+TEST(SQLSelectStatement, SelectStarOrderByLimit)
+{
+    mongoodbc::SQLSelectStatementParser<std::string::const_iterator> parser;
+    mongoodbc::SQLSelectStatement stmt;
+    std::string query("SELECT * FROM db.people WHERE age > 5 ORDER BY age DESC, name LIMIT 50");
+    std::string::const_iterator iter = query.begin();
+    std::string::const_iterator end = query.end();
+    try
+    {
+        EXPECT_TRUE(
+            boost::spirit::qi::phrase_parse(iter, end, parser, boost::spirit::ascii::space, stmt));
+        EXPECT_TRUE(iter == end);
+        ASSERT_EQ(2, stmt._orderBy.size());
+        EXPECT_TRUE(stmt._orderBy[0]._descending);
+        EXPECT_FALSE(stmt._orderBy[1]._descending);
+        ASSERT_TRUE(stmt._limit.is_initialized());
+        EXPECT_EQ(50u, *stmt._limit);
+        std::cout << "SELECT Stmt: " << stmt << std::endl;
+    }
+    catch (const boost::spirit::qi::expectation_failure<std::string::const_iterator>& ex)
+    {
+        std::string fragment(ex.first, ex.last);
+        std::cerr << ex.what() << "'" << fragment << "'" << std::endl;
+    }
+}
+
+TEST(SQLSelectStatement, GroupBy)
+{
+    mongoodbc::SQLSelectStatementParser<std::string::const_iterator> parser;
+    mongoodbc::SQLSelectStatement stmt;
+    std::string query("SELECT age, count(*), MIN(name) FROM db.people GROUP BY age ORDER BY age");
+    std::string::const_iterator iter = query.begin();
+    std::string::const_iterator end = query.end();
+    try
+    {
+        EXPECT_TRUE(
+            boost::spirit::qi::phrase_parse(iter, end, parser, boost::spirit::ascii::space, stmt));
+        EXPECT_TRUE(iter == end);
+        ASSERT_EQ(3, stmt._selectList.size());
+        ASSERT_TRUE(stmt._selectList[1]._term._factor._primary._function.is_initialized());
+        EXPECT_EQ("COUNT", *stmt._selectList[1]._term._factor._primary._function);
+        EXPECT_TRUE(stmt._selectList[1]._term._factor._primary._expr.empty());
+        EXPECT_EQ(1, stmt._selectList[2]._term._factor._primary._expr.size());
+        EXPECT_EQ(1, stmt._groupBy.size());
+        EXPECT_EQ(1, stmt._orderBy.size());
+        std::cout << "SELECT Stmt: " << stmt << std::endl;
+    }
+    catch (const boost::spirit::qi::expectation_failure<std::string::const_iterator>& ex)
+    {
+        std::string fragment(ex.first, ex.last);
+        std::cerr << ex.what() << "'" << fragment << "'" << std::endl;
+    }
+}
+
+TEST(SQLSelectStatement, ResolvePaths)
+{
+    mongoodbc::SQLSelectStatementParser<std::string::const_iterator> parser;
+    mongoodbc::SQLSelectStatement stmt;
+    std::string query("SELECT coll.a, address.city FROM db.coll "
+                      "WHERE coll.b > 1 AND address.zip.code = 2 ORDER BY address.city");
+    std::string::const_iterator iter = query.begin();
+    std::string::const_iterator end = query.end();
+    ASSERT_TRUE(
+        boost::spirit::qi::phrase_parse(iter, end, parser, boost::spirit::ascii::space, stmt));
+    stmt.resolvePaths();
+
+    ASSERT_EQ(2, stmt._selectList.size());
+    const mongoodbc::SQLElementColumnName& a = *stmt._selectList[0]._term._factor._primary._columnName;
+    EXPECT_FALSE(a._tableName);
+    EXPECT_EQ("this.a", a._columnName);
+    const mongoodbc::SQLElementColumnName& city =
+        *stmt._selectList[1]._term._factor._primary._columnName;
+    EXPECT_FALSE(city._tableName);
+    EXPECT_EQ("this.address.city", city._columnName);
+    EXPECT_FALSE(stmt._orderBy[0]._expr._term._factor._primary._columnName->_tableName);
+
+    std::string where = stmt._whereClause->obj.toString();
+    EXPECT_NE(std::string::npos, where.find("this.b > 1")) << where;
+    EXPECT_NE(std::string::npos, where.find("this.address.zip.code == 2")) << where;
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
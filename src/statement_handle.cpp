@@ -16,13 +16,120 @@
 //  limitations under the License.
 
 #include "statement_handle.h"
+#include "aggregate_plan.h"
+#include "aggregation.h"
+#include "array_table.h"
+#include "catalog_cache.h"
 #include "connection_handle.h"
+#include "external_sort.h"
+#include "hash_aggregate.h"
+#include "join_plan.h"
+#include "native_filter.h"
+#include "odbcintf.h"
+#include "parallel_scan.h"
+#include "plan_cache.h"
+#include "projection.h"
+#include "query_explain.h"
+#include "query_hints.h"
+#include "query_plan.h"
+#include "residual_filter.h"
+#include "sql_fast_parser.h"
+#include "stream_aggregate.h"
+#include "top_n.h"
 
 #include <boost/variant/get.hpp>
 #include <boost/spirit/include/qi.hpp>
 
+#include <limits.h>
 #include <string.h>
 
+#include <algorithm>
+#include <sstream>
+
+namespace {
+
+/*
+* Row source without rows, read in place of the server's when a statement
+* is only explained.
+*/
+class EmptyRowSource : public mongoodbc::RowSource {
+  public:
+    virtual bool more() { return false; }
+
+    virtual mongo::BSONObj next() { return mongo::BSONObj(); }
+};
+
+/*
+* Returns the argument 'str' of length 'len' or SQL_NTS, empty if null.
+*/
+std::string argument(SQLCHAR *str, SQLSMALLINT len)
+{
+    if (NULL == str) {
+        return std::string();
+    }
+    if (SQL_NTS == len) {
+        return std::string((char *)str);
+    }
+    return std::string((char *)str, (int)len);
+}
+
+/*
+* Orders the indexes of a collection by position in 'SQLStatistics': unique
+* ones first, then by type and name.
+*/
+class StatisticsOrder {
+    const std::vector<mongo::BSONObj>& _indexes;
+
+    int rank(const mongo::BSONObj& index) const
+    {
+        return (mongoodbc::CollectionInfo::uniqueIndex(index) ? 0 : 2)
+             + (mongoodbc::CollectionInfo::hashedIndex(index) ? 0 : 1);
+    }
+
+  public:
+    StatisticsOrder(const std::vector<mongo::BSONObj>& indexes)
+        : _indexes(indexes)
+    {
+    }
+
+    bool operator()(size_t lhs, size_t rhs) const
+    {
+        int lhsRank = rank(_indexes[lhs]);
+        int rhsRank = rank(_indexes[rhs]);
+        if (lhsRank != rhsRank) {
+            return lhsRank < rhsRank;
+        }
+        return strcmp(_indexes[lhs].getStringField("name"),
+                      _indexes[rhs].getStringField("name")) < 0;
+    }
+};
+
+/*
+* Returns 'value' as an SQLINTEGER, saturated.
+*/
+SQLINTEGER saturate(long long value)
+{
+    return value > INT_MAX ? (SQLINTEGER)INT_MAX : (SQLINTEGER)value;
+}
+
+int parseFast(const std::string& sql, mongoodbc::SQLStatement *stmt)
+{
+    return mongoodbc::SQLFastParser::parse(sql, stmt, 0);
+}
+
+int parseSpirit(const std::string& sql, mongoodbc::SQLStatement *stmt)
+{
+    std::string::const_iterator begin = sql.begin();
+    std::string::const_iterator end = sql.end();
+    return boost::spirit::qi::phrase_parse(begin,
+                                           end,
+                                           mongoodbc::sharedSQLParser(),
+                                           boost::spirit::ascii::space,
+                                           *stmt) ? 0 : -1;
+}
+
+} // close unnamed namespace
+
 namespace mongoodbc {
 
 SQLSMALLINT StatementHandle::mapMongoToODBCDataType(mongo::BSONType type)
@@ -73,7 +180,51 @@ SQLSMALLINT StatementHandle::numPercRadix(SQLSMALLINT type)
 
 StatementHandle::StatementHandle(ConnectionHandle *connHandle)
     : _connHandle(connHandle)
+    , _rowPending(false)
+    , _rowArraySize(1)
+    , _parallelScan(0)
+    , _sortSpilledBytes(0)
+{
+}
+
+StatementHandle::~StatementHandle()
+{
+    closeCursor();
+}
+
+void StatementHandle::closeCursor()
+{
+    _cursorColumns.clear();
+    _columnPaths = FieldPaths();
+    _columnValues.clear();
+    // the cursor must be closed before its connection is given back
+    _cursor.reset();
+    _cursorConn.reset();
+    _rowPending = false;
+    _rowCount = RowCount();
+    _resultSet.clear();
+    _rowIdx = -1;
+    // nothing refers to the arena any more; its blocks are kept for reuse
+    _arena.reset();
+}
+
+void StatementHandle::addCursorColumns(const mongo::BSONObj& obj, const std::string& prefix)
 {
+    mongo::BSONObj::iterator fieldIt = obj.begin();
+    while(fieldIt.more()) {
+        mongo::BSONElement elem = fieldIt.next();
+        std::string name = prefix + elem.fieldName();
+        if (mongo::Object == elem.type() && !elem.embeddedObject().isEmpty()) {
+            addCursorColumns(elem.embeddedObject(), name + ".");
+            continue;
+        }
+        size_t numPaths = _columnPaths.size();
+        if (_columnPaths.add(name) < numPaths) {
+            // e.g. a field 'a.b' besides 'a: { b: ... }'
+            continue;
+        }
+        _cursorColumns.push_back(std::make_pair(_arena.copy(name), elem.type()));
+    }
 }
 
 SQLSMALLINT StatementHandle::mapODBCDataTypeToSQLDataType(SQLSMALLINT type)
@@ -103,10 +254,7 @@ SQLRETURN StatementHandle::sqlTables(SQLCHAR *catalogName,
                                      SQLCHAR *tableType,
                                      SQLSMALLINT tableTypeLen)
 {
-    _cursorColumns.clear();
-    _cursor.reset();
-    _resultSet.clear();
-    _rowIdx = -1;
+    closeCursor();
     if (NULL != tableType) {
         std::string tableTypeStr;
         if (tableTypeLen == SQL_NTS) {
@@ -161,10 +309,23 @@ SQLRETURN StatementHandle::sqlTables(SQLCHAR *catalogName,
             _resultSet.push_back(std::list<Result>());
             std::list<Result>& results = _resultSet.back();
             results.push_back("NULL");
-            results.push_back(*it);
-            results.push_back(tableName);
+            results.push_back(_arena.copy(*it));
+            results.push_back(_arena.copy(tableName));
             results.push_back("TABLE");
             results.push_back("NULL");
+
+            // the arrays of the collection's documents are tables too
+            std::vector<std::string> arrayPaths;
+            ArrayTable::arrayPaths(firstDocument(*tableIt), &arrayPaths);
+            for (size_t i = 0; i < arrayPaths.size(); ++i) {
+                _resultSet.push_back(std::list<Result>());
+                std::list<Result>& results = _resultSet.back();
+                results.push_back("NULL");
+                results.push_back(_arena.copy(*it));
+                results.push_back(_arena.copy(ArrayTable::tableName(tableName, arrayPaths[i])));
+                results.push_back("TABLE");
+                results.push_back("NULL");
+            }
         }
     }
     if (NULL != tableName) {
@@ -190,10 +351,7 @@ SQLRETURN StatementHandle::sqlColumns(SQLCHAR *catalogName,
                                       SQLCHAR *columnName,
                                       SQLSMALLINT columnNameLen)
 {
-    _cursorColumns.clear();
-    _cursor.reset();
-    _resultSet.clear();
-    _rowIdx = -1;
+    closeCursor();
 
     std::list<std::string> schemas;
     int rc = _connHandle->getDbNames(&schemas);
@@ -242,104 +400,745 @@ SQLRETURN StatementHandle::sqlColumns(SQLCHAR *catalogName,
                 // skip mongodb internal tables
                 continue;
             }
-            if (tableNameStr.size() && tableName != tableNameStr) {
-                continue;
+            mongo::BSONObj doc = firstDocument(*tableIt);
+            if (!tableNameStr.size() || tableName == tableNameStr) {
+                int columnNum = 1;
+                mongo::BSONObj::iterator fieldIt = doc.begin();
+                while (fieldIt.more()) {
+                    mongo::BSONElement elem = fieldIt.next();
+                    addColumnRow(*it, tableName, elem.fieldName(), elem.type(), columnNum++);
+                }
             }
 
-            std::auto_ptr<mongo::DBClientCursor> cursor =
-                _connHandle->query(*tableIt);
-
-            int columnNum = 1;
-            while (cursor->more()) {
-                mongo::BSONObj::iterator fieldIt = cursor->next().begin();
-                while(fieldIt.more()) {
-                    mongo::BSONElement elem = fieldIt.next();
-                    SQLSMALLINT dataType = mapMongoToODBCDataType(elem.type());
-                    _resultSet.push_back(std::list<Result>());
-                    std::list<Result>& results = _resultSet.back();
-                    results.push_back("NULL");
-                    results.push_back(*it);
-                    results.push_back(tableName);
-                    results.push_back(elem.fieldName());
-                    results.push_back(dataType);
-                    results.push_back(dataTypeName(dataType));
-                    results.push_back(columnSize(dataType));
-                    results.push_back(bufferLength(dataType));
-                    results.push_back(decimalDigits(dataType));
-                    results.push_back(numPercRadix(dataType));
-                    results.push_back((SQLSMALLINT)SQL_NULLABLE);
-                    results.push_back("");
-                    results.push_back("NULL");
-                    results.push_back(mapODBCDataTypeToSQLDataType(dataType));
-                    results.push_back(getDatetimeSubcode(dataType));
-                    results.push_back(maxCharLen(dataType));
-                    results.push_back(columnNum++);
-                    results.push_back("\"YES\"");
+            // an array table has the document's '_id', the element's index
+            // and the element, or the fields of an embedded document
+            std::vector<std::string> arrayPaths;
+            ArrayTable::arrayPaths(doc, &arrayPaths);
+            for (size_t i = 0; i < arrayPaths.size(); ++i) {
+                std::string arrayTableName = ArrayTable::tableName(tableName, arrayPaths[i]);
+                if (tableNameStr.size() && arrayTableName != tableNameStr) {
+                    continue;
+                }
+                ArrayTable arrayTable(*tableIt, arrayPaths[i]);
+                int columnNum = 1;
+                addColumnRow(*it, arrayTableName, "_id", doc["_id"].type(), columnNum++);
+                addColumnRow(*it, arrayTableName, arrayTable.indexColumn(),
+                             mongo::NumberInt, columnNum++);
+                mongo::BSONElement first = doc.getFieldDotted(arrayPaths[i])
+                                              .embeddedObject().firstElement();
+                if (mongo::Object == first.type()) {
+                    mongo::BSONObj::iterator fieldIt = first.embeddedObject().begin();
+                    while (fieldIt.more()) {
+                        mongo::BSONElement elem = fieldIt.next();
+                        addColumnRow(*it, arrayTableName,
+                                     arrayPaths[i] + "." + elem.fieldName(),
+                                     elem.type(), columnNum++);
+                    }
+                } else {
+                    // an empty array's elements are taken to be strings
+                    addColumnRow(*it, arrayTableName, arrayPaths[i],
+                                 first.eoo() ? mongo::String : first.type(), columnNum++);
                 }
-                break;
             }
         }
     }
     return SQL_SUCCESS;
 }
 
+void StatementHandle::addColumnRow(const std::string& schema,
+                                   const std::string& table,
+                                   const std::string& column,
+                                   mongo::BSONType type,
+                                   int columnNum)
+{
+    SQLSMALLINT dataType = mapMongoToODBCDataType(type);
+    _resultSet.push_back(std::list<Result>());
+    std::list<Result>& results = _resultSet.back();
+    results.push_back("NULL");
+    results.push_back(_arena.copy(schema));
+    results.push_back(_arena.copy(table));
+    results.push_back(_arena.copy(column));
+    results.push_back(dataType);
+    results.push_back(dataTypeName(dataType));
+    results.push_back(columnSize(dataType));
+    results.push_back(bufferLength(dataType));
+    results.push_back(decimalDigits(dataType));
+    results.push_back(numPercRadix(dataType));
+    results.push_back((SQLSMALLINT)SQL_NULLABLE);
+    results.push_back("");
+    results.push_back("NULL");
+    results.push_back(mapODBCDataTypeToSQLDataType(dataType));
+    results.push_back(getDatetimeSubcode(dataType));
+    results.push_back(maxCharLen(dataType));
+    results.push_back(columnNum);
+    results.push_back("\"YES\"");
+}
+
+mongo::BSONObj StatementHandle::firstDocument(const std::string& collection)
+{
+    ScopedConnection conn(_connHandle);
+    std::auto_ptr<mongo::DBClientCursor> cursor =
+        _connHandle->query(conn.get(), collection, mongo::Query(), 1);
+    if (!cursor.get() || !cursor->more()) {
+        return mongo::BSONObj();
+    }
+    return cursor->next().getOwned();
+}
+
+SQLRETURN StatementHandle::sqlStatistics(SQLCHAR *catalogName,
+                                         SQLSMALLINT catalogNameLen,
+                                         SQLCHAR *schemaName,
+                                         SQLSMALLINT schemaNameLen,
+                                         SQLCHAR *tableName,
+                                         SQLSMALLINT tableNameLen,
+                                         SQLUSMALLINT unique,
+                                         SQLUSMALLINT reserved)
+{
+    closeCursor();
+    if (NULL == tableName) {
+        return SQL_ERROR;
+    }
+    std::string schemaNameStr = argument(schemaName, schemaNameLen);
+    std::string tableNameStr = argument(tableName, tableNameLen);
+    std::string ns = schemaNameStr.empty() ? tableNameStr
+                                           : schemaNameStr + "." + tableNameStr;
+    ArrayTable arrayTable;
+    if (0 == _connHandle->arrayTable(ns, &arrayTable)) {
+        // array tables have no indexes or statistics of their own
+        return SQL_SUCCESS;
+    }
+    CollectionInfo info;
+    if (0 != _connHandle->collectionInfo(ns, SQL_ENSURE == reserved, &info)) {
+        return SQL_ERROR;
+    }
+
+    _resultSet.push_back(std::list<Result>());
+    std::list<Result>& stats = _resultSet.back();
+    stats.push_back("NULL");
+    stats.push_back(_arena.copy(schemaNameStr));
+    stats.push_back(_arena.copy(tableNameStr));
+    stats.push_back("NULL");
+    stats.push_back("NULL");
+    stats.push_back("NULL");
+    stats.push_back((SQLSMALLINT)SQL_TABLE_STAT);
+    stats.push_back("NULL");
+    stats.push_back("NULL");
+    stats.push_back("NULL");
+    stats.push_back(saturate(info._count));
+    stats.push_back(saturate(info.pages()));
+    stats.push_back("NULL");
+
+    std::vector<size_t> order;
+    for (size_t i = 0; i < info._indexes.size(); ++i) {
+        if (SQL_INDEX_ALL == unique || CollectionInfo::uniqueIndex(info._indexes[i])) {
+            order.push_back(i);
+        }
+    }
+    std::sort(order.begin(), order.end(), StatisticsOrder(info._indexes));
+    for (size_t i = 0; i < order.size(); ++i) {
+        const mongo::BSONObj& index = info._indexes[order[i]];
+        std::string indexName = index.getStringField("name");
+        bool isUnique = CollectionInfo::uniqueIndex(index);
+        long long pages = info.indexPages(indexName);
+        mongo::BSONObj partialFilter = index.getObjectField("partialFilterExpression");
+        SQLSMALLINT position = 1;
+        mongo::BSONObjIterator keyIt(index.getObjectField("key"));
+        while (keyIt.more()) {
+            mongo::BSONElement key = keyIt.next();
+            _resultSet.push_back(std::list<Result>());
+            std::list<Result>& results = _resultSet.back();
+            results.push_back("NULL");
+            results.push_back(_arena.copy(schemaNameStr));
+            results.push_back(_arena.copy(tableNameStr));
+            results.push_back((SQLSMALLINT)(isUnique ? SQL_FALSE : SQL_TRUE));
+            results.push_back(_arena.copy(schemaNameStr));
+            results.push_back(_arena.copy(indexName));
+            results.push_back((SQLSMALLINT)(CollectionInfo::hashedIndex(index) ? SQL_INDEX_HASHED
+                                                                               : SQL_INDEX_OTHER));
+            results.push_back(position++);
+            results.push_back(_arena.copy(key.fieldName()));
+            // text, geospatial and hashed keys have no order
+            if (key.isNumber()) {
+                results.push_back(key.number() < 0 ? "D" : "A");
+            } else {
+                results.push_back("NULL");
+            }
+            if (isUnique) {
+                results.push_back(saturate(info._count));
+            } else {
+                results.push_back("NULL");
+            }
+            if (pages >= 0) {
+                results.push_back(saturate(pages));
+            } else {
+                results.push_back("NULL");
+            }
+            if (partialFilter.isEmpty()) {
+                results.push_back("NULL");
+            } else {
+                results.push_back(_arena.copy(partialFilter.jsonString()));
+            }
+        }
+    }
+    return SQL_SUCCESS;
+}
+
+SQLRETURN StatementHandle::sqlPrimaryKeys(SQLCHAR *catalogName,
+                                          SQLSMALLINT catalogNameLen,
+                                          SQLCHAR *schemaName,
+                                          SQLSMALLINT schemaNameLen,
+                                          SQLCHAR *tableName,
+                                          SQLSMALLINT tableNameLen)
+{
+    closeCursor();
+    if (NULL == tableName) {
+        return SQL_ERROR;
+    }
+    std::string schemaNameStr = argument(schemaName, schemaNameLen);
+    std::string tableNameStr = argument(tableName, tableNameLen);
+    std::string ns = schemaNameStr.empty() ? tableNameStr
+                                           : schemaNameStr + "." + tableNameStr;
+
+    // a collection is keyed by '_id', an array table by its document's
+    // '_id' and the element's index
+    std::vector<std::string> columns(1, "_id");
+    ArrayTable arrayTable;
+    bool isArrayTable = 0 == _connHandle->arrayTable(ns, &arrayTable);
+    if (isArrayTable) {
+        columns.push_back(arrayTable.indexColumn());
+    }
+    for (size_t i = 0; i < columns.size(); ++i) {
+        _resultSet.push_back(std::list<Result>());
+        std::list<Result>& results = _resultSet.back();
+        results.push_back("NULL");
+        results.push_back(_arena.copy(schemaNameStr));
+        results.push_back(_arena.copy(tableNameStr));
+        results.push_back(_arena.copy(columns[i]));
+        results.push_back((SQLSMALLINT)(i + 1));
+        results.push_back(isArrayTable ? "NULL" : "_id_");
+    }
+    return SQL_SUCCESS;
+}
+
+SQLRETURN StatementHandle::sqlSetStmtAttr(SQLINTEGER attribute,
+                                          SQLPOINTER valuePtr,
+                                          SQLINTEGER stringLen)
+{
+    switch(attribute) {
+      case SQL_ATTR_ROW_ARRAY_SIZE: {
+        SQLULEN size = (SQLULEN)valuePtr;
+        if (0 == size) {
+            return SQL_ERROR;
+        }
+        _rowArraySize = size;
+      } break;
+      case SQL_ATTR_MONGOODBC_PARALLEL_SCAN: {
+        _parallelScan = (SQLULEN)valuePtr;
+      } break;
+      default: {
+        return SQL_ERROR;
+      } break;
+    }
+
+    return SQL_SUCCESS;
+}
+
+SQLRETURN StatementHandle::sqlGetStmtAttr(SQLINTEGER attribute,
+                                          SQLPOINTER valuePtr,
+                                          SQLINTEGER bufferLength,
+                                          SQLINTEGER *stringLenPtr)
+{
+    switch(attribute) {
+      case SQL_ATTR_ROW_ARRAY_SIZE: {
+        *(SQLULEN *)valuePtr = _rowArraySize;
+      } break;
+      case SQL_ATTR_MONGOODBC_PARALLEL_SCAN: {
+        *(SQLULEN *)valuePtr = _parallelScan;
+      } break;
+      case SQL_ATTR_MONGOODBC_SORT_SPILLED_BYTES: {
+        *(SQLULEN *)valuePtr = _sortSpilledBytes;
+      } break;
+      default: {
+        return SQL_ERROR;
+      } break;
+    }
+
+    return SQL_SUCCESS;
+}
+
 SQLRETURN StatementHandle::sqlExec(SQLCHAR *query,
                                    SQLINTEGER queryLen)
 {
-    _resultSet.clear();
-    _rowIdx = -1;
-    SQLStatement stmt;
+    closeCursor();
+    std::string queryStr;
+    if (queryLen == SQL_NTS) {
+        queryStr.assign((char *)query);
+    } else {
+        queryStr.assign((char *)query, (int)queryLen);
+    }
+    // hints are comments, so statements differing only in hints share a
+    // plan too
+    QueryHints hints;
+    std::string stripped;
+    QueryHints::extract(queryStr, &stripped, &hints);
+
+    // 'EXPLAIN <statement>' returns rows describing the statement's
+    // execution instead of its result
+    std::string explained;
+    if (0 != QueryExplain::explained(stripped, &explained)) {
+        return execute(stripped, hints, 0);
+    }
+    QueryExplain explain;
+    SQLRETURN rc = execute(explained, hints, &explain);
+    if (SQL_SUCCESS != rc) {
+        return rc;
+    }
+    explain.explainOnServer(_connHandle);
+    const std::vector<QueryExplain::Step>& steps = explain.steps();
+    for (size_t i = 0; i < steps.size(); ++i) {
+        _resultSet.push_back(std::list<Result>());
+        std::list<Result>& results = _resultSet.back();
+        results.push_back(_arena.copy(steps[i]._step));
+        results.push_back(_arena.copy(steps[i]._location));
+        results.push_back(_arena.copy(steps[i]._detail));
+    }
+    return SQL_SUCCESS;
+}
+
+SQLRETURN StatementHandle::sqlNativeSql(SQLCHAR *query,
+                                        SQLINTEGER queryLen,
+                                        SQLCHAR *nativeQuery,
+                                        SQLINTEGER nativeQueryMax,
+                                        SQLINTEGER *nativeQueryLen)
+{
+    closeCursor();
     std::string queryStr;
     if (queryLen == SQL_NTS) {
         queryStr.assign((char *)query);
     } else {
         queryStr.assign((char *)query, (int)queryLen);
     }
-    std::string::const_iterator queryBegin = queryStr.begin();
-    std::string::const_iterator queryEnd = queryStr.end();
-    bool parseRc = boost::spirit::qi::phrase_parse(queryBegin,
-                                                   queryEnd,
-                                                   _parser,
-                                                   boost::spirit::ascii::space,
-                                                   stmt);
-    if (!parseRc) {
+    QueryHints hints;
+    std::string stripped;
+    QueryHints::extract(queryStr, &stripped, &hints);
+    std::string explained;
+    if (0 == QueryExplain::explained(stripped, &explained)) {
+        stripped.swap(explained);
+    }
+
+    QueryExplain explain;
+    if (SQL_SUCCESS != execute(stripped, hints, &explain)) {
         return SQL_ERROR;
     }
+    const std::string& native = explain.nativeText();
+    if (NULL != nativeQueryLen) {
+        *nativeQueryLen = (SQLINTEGER)native.size();
+    }
+    if (NULL == nativeQuery || nativeQueryMax <= 0) {
+        return native.empty() ? SQL_SUCCESS : SQL_SUCCESS_WITH_INFO;
+    }
+    size_t copyLen = std::min(native.size(), (size_t)nativeQueryMax - 1);
+    memcpy(nativeQuery, native.data(), copyLen);
+    nativeQuery[copyLen] = '\0';
+    return copyLen < native.size() ? SQL_SUCCESS_WITH_INFO : SQL_SUCCESS;
+}
+
+SQLRETURN StatementHandle::execute(const std::string& queryStr,
+                                   const QueryHints& hints,
+                                   QueryExplain *explain)
+{
+    SQLStatement stmt;
+    // statements differing only in literals share a plan; parsers accept
+    // different statements, so each has its own plans
+    bool fastParser = _connHandle->fastParser();
+    SQLParseFunction parse = fastParser ? parseFast : parseSpirit;
+    PlanCache *planCache = _connHandle->planCache();
+    std::string planKey(fastParser ? "fast:" : "spirit:");
+    std::string normalized;
+    std::vector<SQLToken> literals;
+    bool cacheable = 0 == PlanCache::normalize(queryStr, &normalized, &literals);
+    planKey.append(normalized);
+    boost::shared_ptr<const QueryPlan> plan;
+    if (cacheable) {
+        plan = planCache->lookup(planKey);
+        if (!plan && planCache->maxBytes()) {
+            // on a miss the statement is bound from the new plan rather
+            // than parsed a second time
+            plan = QueryPlan::compile(queryStr, literals, parse);
+            if (plan) {
+                planCache->insert(planKey, plan);
+            }
+        }
+    }
+
+    if (!plan || 0 != plan->bind(literals, &stmt)) {
+        if (0 != parse(queryStr, &stmt)) {
+            return SQL_ERROR;
+        }
+    }
 
     SQLSelectStatement& selectStmt = stmt;
+    if (explain) {
+        explain->sql(cacheable ? normalized : queryStr);
+    }
 
     if (!selectStmt._whereClause) {
         // set to a blank query
         selectStmt._whereClause = mongo::Query();
     }
+    // a single table's columns may be paths into embedded documents
+    selectStmt.resolvePaths();
 
-    try {
-    _cursor = _connHandle->query(selectStmt._tableRefList[0],
-                                 *selectStmt._whereClause);
-    } catch (mongo::AssertionException& ex) {
-        return SQL_ERROR;
-    }
+    // an application fetching whole row arrays wants at least that many
+    // documents per round trip
+    BatchSizer batchSizer(hints._batchSize ? hints._batchSize : _connHandle->batchSize(),
+                          _connHandle->batchMemoryLimit(),
+                          _rowArraySize > 1 ? (int)_rowArraySize : 0);
 
-    if (!_cursor.get()) {
-        return SQL_ERROR;
+    // GROUP BY and aggregate functions are computed by the driver, so
+    // ORDER BY and LIMIT then apply to its result rows
+    AggregatePlan aggregatePlan;
+    bool aggregate = AggregatePlan::isAggregate(selectStmt);
+    // set if the rows come ordered by the GROUP BY columns
+    bool groupsInOrder = false;
+    // set if the server computes the select list
+    bool projected = false;
+    if (aggregate) {
+        std::string errmsg;
+        if (0 != aggregatePlan.init(selectStmt, &errmsg)) {
+            return SQL_ERROR;
+        }
     }
 
-    std::vector<mongo::BSONObj> firstRows;
-    _cursor->peek(firstRows, 1);
-    if (!firstRows.size()) {
-        // 0 results
-        return SQL_SUCCESS;
+    // ORDER BY and LIMIT left to the driver are applied to the rows with a
+    // 'TopNRowSource' or, for many rows, an 'ExternalSortRowSource'
+    _sortSpilledBytes = 0;
+    bool clientOrder = !selectStmt._orderBy.empty();
+    bool clientLimit = selectStmt._limit.is_initialized();
+    // columns of joined rows are qualified
+    std::string defaultQualifier;
+    // WHERE conjuncts the server cannot evaluate natively, applied to the
+    // rows before grouping and sorting
+    ResidualFilter residual;
+    mongo::BSONObj residualCond;
+    bool join = selectStmt._tableRefList.size() > 1 || !selectStmt._joins.empty();
+    // a single table's reads are given the hinted index and time limit
+    std::string ns = selectStmt._tableRefList[0];
+    int parallelScan = hints._parallel ? hints._parallel : (int)_parallelScan;
+    bool indexHint = hints.indexApplies(ns, true);
+    mongo::BSONObjBuilder aggregateOptions;
+    if (hints._maxTimeMS) {
+        aggregateOptions.append("maxTimeMS", hints._maxTimeMS);
     }
-    mongo::BSONObj::iterator fieldIt = firstRows[0].begin();
-    while(fieldIt.more()) {
-        mongo::BSONElement elem = fieldIt.next();
-        mongo::BSONType dataType = elem.type();
-        _cursorColumns.push_back(std::make_pair(elem.fieldName(), dataType));
+    if (indexHint) {
+        aggregateOptions.append("hint", hints._index);
+    }
+    mongo::BSONObj commandOptions = aggregateOptions.obj();
+    // set if the single table is the arrays of a collection
+    ArrayTable arrayTable;
+    if (!join) {
+        mongo::BSONObj pushed;
+        splitResidual(selectStmt._whereClause->obj, &pushed, &residualCond);
+        std::string errmsg;
+        // the pushed conjuncts are in their native form where they have one
+        if (residualCond.isEmpty() || 0 == residual.compile(residualCond, "", &errmsg)) {
+            selectStmt._whereClause = mongo::Query(pushed);
+        }
     }
 
+    try {
+        if (join) {
+            JoinPlan joinPlan;
+            std::string errmsg;
+            if (0 != joinPlan.init(selectStmt, &errmsg)) {
+                return SQL_ERROR;
+            }
+            defaultQualifier = joinPlan.tables()[0]._name;
+            residualCond = joinPlan.residual();
+            if (0 != residual.compile(residualCond, defaultQualifier, &errmsg)) {
+                return SQL_ERROR;
+            }
+            if (explain) {
+                explainJoin(joinPlan, explain);
+                _cursor.reset(new EmptyRowSource());
+            } else {
+                long long memoryLimit = _connHandle->joinMemoryLimit();
+                _cursor = joinPlan.execute(_connHandle,
+                                           batchSizer,
+                                           memoryLimit > 0 ? (size_t)memoryLimit
+                                                           : (size_t)JoinPlan::DEFAULT_MEMORY_LIMIT);
+            }
+        } else if (0 == _connHandle->arrayTable(selectStmt._tableRefList[0], &arrayTable)) {
+            // the server unwinds the arrays; '$where' cannot run in a
+            // pipeline, so the pushed conditions must translate
+            mongo::BSONObj filter;
+            mongo::BSONObj pipeline;
+            if (0 != nativeFilter(selectStmt._whereClause->obj, &filter)) {
+                return SQL_ERROR;
+            }
+            arrayTable.pipeline(filter, &pipeline);
+            if (explain) {
+                explain->aggregate(arrayTable.ns(), pipeline, commandOptions);
+                _cursor.reset(new EmptyRowSource());
+            } else {
+                _cursor.reset(new AggregationRowSource(_connHandle,
+                                                       arrayTable.ns(),
+                                                       pipeline,
+                                                       batchSizer,
+                                                       commandOptions));
+            }
+        } else if (parallelScan > 1) {
+            // partitions are interleaved, so only used when asked for
+            _rowCount.setCount(ns,
+                               selectStmt._whereClause->obj,
+                               std::string(),
+                               selectStmt._limit ? (long long)*selectStmt._limit : 0);
+            if (explain) {
+                std::ostringstream detail;
+                detail << parallelScan << " cursors over _id ranges, rows interleaved";
+                explain->find(ns, selectStmt._whereClause->obj, 0);
+                explain->driver("parallel scan", detail.str());
+                _cursor.reset(new EmptyRowSource());
+            } else {
+                _cursor.reset(new ParallelScanRowSource(_connHandle,
+                                                        ns,
+                                                        selectStmt._whereClause->obj,
+                                                        parallelScan,
+                                                        batchSizer.initialBatchSize()));
+            }
+        } else {
+            // the server sorts on plain columns and applies a limit it can
+            // represent; a limit of 0 would mean none
+            mongo::Query query = *selectStmt._whereClause;
+            if (hints._maxTimeMS) {
+                query.maxTimeMs(hints._maxTimeMS);
+            }
+            _rowCount.setCount(ns,
+                               selectStmt._whereClause->obj,
+                               indexHint ? hints._index : std::string(),
+                               selectStmt._limit ? (long long)*selectStmt._limit : 0);
+            mongo::BSONObj sortPattern;
+            if (clientOrder && !aggregate
+                && 0 == SortKey::sortPattern(selectStmt._orderBy, &sortPattern)) {
+                query.sort(sortPattern);
+                clientOrder = false;
+            }
+            int numToReturn = 0;
+            if (clientLimit && !clientOrder && !aggregate && residual.empty()
+                && *selectStmt._limit > 0 && *selectStmt._limit <= INT_MAX) {
+                numToReturn = (int)*selectStmt._limit;
+                clientLimit = false;
+            }
+
+            // the server computes the select list when it runs the whole
+            // query, and only sends the computed columns; a WHERE clause
+            // without a native form keeps the query a find
+            mongo::BSONObj pipeline;
+            if (!aggregate && !clientOrder && residual.empty()
+                && 0 == projectPipeline(selectStmt._whereClause->obj,
+                                        sortPattern,
+                                        numToReturn,
+                                        selectStmt._selectList,
+                                        &pipeline)) {
+                if (explain) {
+                    explain->aggregate(ns, pipeline, commandOptions);
+                    _cursor.reset(new EmptyRowSource());
+                    projected = true;
+                } else {
+                    try {
+                        _cursor.reset(new AggregationRowSource(_connHandle,
+                                                               ns,
+                                                               pipeline,
+                                                               batchSizer,
+                                                               commandOptions));
+                        projected = true;
+                    } catch (const std::exception& ex) {
+                        // e.g. servers before 3.4 lack '$type'; the driver
+                        // computes the columns instead
+                    }
+                }
+            }
+
+            if (!projected) {
+                int batchSize = batchSizer.initialBatchSize();
+                _cursorConn.reset(new ScopedConnection(_connHandle));
+                if (indexHint) {
+                    query.hint(hints._index);
+                } else if (aggregate && !aggregatePlan.keys().empty() && _cursorConn->get()) {
+                    // read through an index on the GROUP BY columns, groups are
+                    // aggregated one at a time as their rows arrive
+                    std::vector<mongo::BSONObj> indexKeys;
+                    CollectionInfo info;
+                    if (0 == _connHandle->collectionInfo(ns, false, &info)) {
+                        for (size_t i = 0; i < info._indexes.size(); ++i) {
+                            indexKeys.push_back(info._indexes[i].getObjectField("key"));
+                        }
+                    }
+                    mongo::BSONObj groupOrder;
+                    mongo::BSONObj hint;
+                    if (0 == aggregatePlan.indexOrder(indexKeys, &groupOrder, &hint)) {
+                        query.sort(groupOrder);
+                        query.hint(hint);
+                        groupsInOrder = true;
+                    }
+                }
+                if (explain) {
+                    explain->find(ns, query, numToReturn);
+                    _cursor.reset(new EmptyRowSource());
+                } else {
+                    std::auto_ptr<mongo::DBClientCursor> cursor =
+                        _connHandle->query(_cursorConn->get(),
+                                           ns,
+                                           query,
+                                           numToReturn,
+                                           0,
+                                           0,
+                                           0,
+                                           batchSize);
+                    if (!cursor.get()) {
+                        _cursorConn.reset();
+                        return SQL_ERROR;
+                    }
+                    _cursor.reset(new CursorRowSource(cursor, batchSizer));
+                }
+            }
+        }
+
+        if (!residual.empty()) {
+            if (explain) {
+                explain->driver("filter", residualCond.toString());
+            }
+            _cursor.reset(new FilterRowSource(_cursor, residual));
+        }
+
+        if (aggregate) {
+            // one row for the whole result, else one per group
+            if (aggregatePlan.keys().empty()) {
+                _rowCount.setRows(1);
+            } else {
+                _rowCount = RowCount();
+            }
+        }
+        if (explain && aggregate) {
+            explain->driver("group", groupsInOrder ? "one group at a time, rows in index order"
+                                                   : "hash table, spilling to temporary files");
+        }
+        if (aggregate && groupsInOrder) {
+            _cursor.reset(new StreamAggregateRowSource(_cursor, aggregatePlan, defaultQualifier));
+        } else if (aggregate) {
+            long long memoryLimit = _connHandle->aggregateMemoryLimit();
+            _cursor.reset(new HashAggregateRowSource(
+                _cursor,
+                aggregatePlan,
+                defaultQualifier,
+                memoryLimit > 0 ? (size_t)memoryLimit
+                                : (size_t)HashAggregateRowSource::DEFAULT_MEMORY_LIMIT,
+                _connHandle->tempDirectory(),
+                &_sortSpilledBytes));
+        }
+
+        if (clientOrder || clientLimit) {
+            SortKey sortKey(clientOrder ? selectStmt._orderBy : std::vector<SQLElementSortSpec>(),
+                            defaultQualifier);
+            size_t limit = TopNRowSource::UNLIMITED;
+            if (clientLimit && *selectStmt._limit < limit) {
+                limit = (size_t)*selectStmt._limit;
+            }
+            if (explain) {
+                std::ostringstream detail;
+                for (size_t i = 0; clientOrder && i < selectStmt._orderBy.size(); ++i) {
+                    detail << (i ? ", " : "ORDER BY ") << selectStmt._orderBy[i];
+                }
+                if (clientOrder && limit > TopNRowSource::MAX_HEAP_ROWS) {
+                    detail << ", merge sort through temporary files";
+                } else if (clientOrder) {
+                    detail << ", heap of the first " << limit << " rows";
+                }
+                if (TopNRowSource::UNLIMITED != limit) {
+                    detail << (clientOrder ? "; " : "") << "LIMIT " << limit;
+                }
+                explain->driver("sort", detail.str());
+            }
+            if (clientOrder && limit > TopNRowSource::MAX_HEAP_ROWS) {
+                // too many rows to hold, sort them through temporary files
+                long long memoryLimit = _connHandle->sortMemoryLimit();
+                _cursor.reset(new ExternalSortRowSource(
+                    _cursor,
+                    sortKey,
+                    memoryLimit > 0 ? (size_t)memoryLimit
+                                    : (size_t)ExternalSortRowSource::DEFAULT_MEMORY_LIMIT,
+                    _connHandle->tempDirectory(),
+                    &_sortSpilledBytes,
+                    limit));
+            } else {
+                _cursor.reset(new TopNRowSource(_cursor, sortKey, limit));
+            }
+        }
+
+        if (!aggregate && !projected && ProjectRowSource::isComputed(selectStmt._selectList)) {
+            // after sorting, which may use columns that are not selected
+            if (explain) {
+                std::string detail;
+                for (size_t i = 0; i < selectStmt._selectList.size(); ++i) {
+                    detail.append(i ? ", " : "").append(expressionLabel(selectStmt._selectList[i]));
+                }
+                explain->driver("project", detail);
+            }
+            _cursor.reset(new ProjectRowSource(_cursor, selectStmt._selectList, defaultQualifier));
+        }
+
+        if (explain) {
+            // nothing was read
+            _cursor.reset();
+            _cursorConn.reset();
+            return SQL_SUCCESS;
+        }
+
+        if (!_cursor->more()) {
+            // 0 results
+            return SQL_SUCCESS;
+        }
+        _row = _cursor->next();
+        _rowPending = true;
+    } catch (const std::exception& ex) {
+        closeCursor();
+        return SQL_ERROR;
+    }
+
+    addCursorColumns(_row, "");
+    _columnPaths.extract(_row, &_columnValues);
+
     return SQL_SUCCESS;
 }
     
+void StatementHandle::explainJoin(const JoinPlan& joinPlan, QueryExplain *explain)
+{
+    const std::vector<JoinPlan::Table>& tables = joinPlan.tables();
+    for (size_t i = 0; i < tables.size(); ++i) {
+        // the native filter each table is queried with, when it has one
+        explain->find(tables[i]._ns, tables[i].queryFilter(), 0);
+    }
+    std::string detail;
+    const std::vector<JoinPlan::Condition>& conditions = joinPlan.conditions();
+    for (size_t i = 0; i < conditions.size(); ++i) {
+        const JoinPlan::Condition& condition = conditions[i];
+        detail.append(i ? " AND " : "ON ")
+              .append(tables[condition._leftTable]._name).append(".")
+              .append(condition._leftField).append(" = ")
+              .append(tables[condition._rightTable]._name).append(".")
+              .append(condition._rightField);
+    }
+    // the strategy depends on how many documents each table matches
+    detail.append("; hash join, or index join probing a much larger indexed table");
+    mongo::BSONObj pipeline;
+    if (0 == joinPlan.lookupPipeline(&pipeline)) {
+        detail.append(", or on the server if the first table matches few documents: ")
+              .append(tables[0]._ns).append(".aggregate(")
+              .append(pipeline.jsonString(mongo::Strict, 0, true)).append(")");
+    }
+    explain->driver("join", detail);
+}
+
 SQLRETURN StatementHandle::sqlNumResultCols(SQLSMALLINT *numColumns)
 {
     if (_cursor.get()) {
@@ -356,10 +1155,19 @@ SQLRETURN StatementHandle::sqlNumResultCols(SQLSMALLINT *numColumns)
 SQLRETURN StatementHandle::sqlFetch()
 {
     if (_cursor.get()) {
-        if (!_cursor->more()) {
-            return SQL_NO_DATA;
+        if (_rowPending) {
+            _rowPending = false;
+            return SQL_SUCCESS;
         }
-        _row = _cursor->next();
+        try {
+            if (!_cursor->more()) {
+                return SQL_NO_DATA;
+            }
+            _row = _cursor->next();
+        } catch (const std::exception& ex) {
+            return SQL_ERROR;
+        }
+        _columnPaths.extract(_row, &_columnValues);
     } else {
         ++_rowIdx;
         if (_rowIdx >= _resultSet.size()) {
@@ -370,6 +1178,36 @@ SQLRETURN StatementHandle::sqlFetch()
     return SQL_SUCCESS;
 }
 
+SQLRETURN StatementHandle::sqlRowCount(SQLLEN *rowCount)
+{
+    if (_cursor.get()) {
+        *rowCount = (SQLLEN)_rowCount.rows(_connHandle, _connHandle->exactRowCount());
+    } else {
+        *rowCount = (SQLLEN)_resultSet.size();
+    }
+    return SQL_SUCCESS;
+}
+
+SQLRETURN StatementHandle::sqlGetDiagField(SQLSMALLINT diagId, SQLPOINTER info)
+{
+    switch(diagId) {
+      case SQL_DIAG_NUMBER: {
+        *(SQLINTEGER *)info = 0;
+      } break;
+      case SQL_DIAG_RETURNCODE: {
+        *(SQLRETURN *)info = SQL_SUCCESS;
+      } break;
+      case SQL_DIAG_CURSOR_ROW_COUNT:
+      case SQL_DIAG_ROW_COUNT: {
+        return sqlRowCount((SQLLEN *)info);
+      }
+      default: {
+        return SQL_ERROR;
+      } break;
+    }
+    return SQL_SUCCESS;
+}
+
 SQLRETURN StatementHandle::sqlGetData(SQLUSMALLINT columnNum,
                      SQLSMALLINT type,
                      SQLPOINTER valuePtr,
@@ -380,32 +1218,82 @@ SQLRETURN StatementHandle::sqlGetData(SQLUSMALLINT columnNum,
         if (columnNum > _cursorColumns.size()) {
             return SQL_ERROR;
         }
-        std::pair<std::string, mongo::BSONType>& field =
-            _cursorColumns[columnNum - 1];
+        const mongo::BSONElement& value = _columnValues[columnNum - 1];
         switch(type) {
           case SQL_C_CHAR: {
           } break;
           case SQL_C_ULONG: {
-              *((unsigned long int *)valuePtr) = _row.getIntField(field.first.c_str());
+              *((unsigned long int *)valuePtr) = value.isNumber() ? value.numberInt() : INT_MIN;
           } break;
           default: {
             return SQL_ERROR;
           } break;
         }
     } else {
+        if (_rowIdx < 0 || (size_t)_rowIdx >= _resultSet.size() || columnNum < 1
+            || columnNum > _resultSet[_rowIdx].size()) {
+            return SQL_ERROR;
+        }
         std::list<Result>::const_iterator it =
             _resultSet[_rowIdx].begin();
         for (int i = 1; i < columnNum; ++i) {
             ++it;
         }
 
+        // catalog results hold numbers, e.g. the TYPE and CARDINALITY of
+        // SQLStatistics, as well as strings, "NULL" standing for null
+        const StringRef *str = boost::get<StringRef>(&*it);
+        long long num = 0;
+        if (const SQLSMALLINT *smallNum = boost::get<SQLSMALLINT>(&*it)) {
+            num = *smallNum;
+        } else if (const SQLINTEGER *intNum = boost::get<SQLINTEGER>(&*it)) {
+            num = *intNum;
+        }
         switch(type) {
           case SQL_C_CHAR: {
-            const std::string& str = boost::get<std::string>(*it);
-            int copyLen = (len > (str.size() - 1) ? str.size() : len - 1);
-            strncpy((char *)valuePtr, str.c_str(), copyLen);
+            std::string numStr;
+            if (!str) {
+                std::ostringstream stream;
+                stream << num;
+                numStr = stream.str();
+            }
+            StringRef value = str ? *str : StringRef(numStr.data(), numStr.size());
+            if (len <= 0) {
+                return SQL_ERROR;
+            }
+            size_t copyLen = std::min(value.size(), (size_t)len - 1);
+            memcpy(valuePtr, value.data(), copyLen);
             ((char *)valuePtr)[copyLen] = '\0';
-            *lenPtr = copyLen + 1;
+            if (lenPtr) {
+                *lenPtr = copyLen + 1;
+            }
+          } break;
+          case SQL_C_SHORT:
+          case SQL_C_SSHORT:
+          case SQL_C_LONG:
+          case SQL_C_SLONG: {
+            bool isShort = SQL_C_SHORT == type || SQL_C_SSHORT == type;
+            if (str) {
+                if (*str != StringRef("NULL")) {
+                    return SQL_ERROR;
+                }
+                if (!lenPtr) {
+                    return SQL_ERROR;
+                }
+                *lenPtr = SQL_NULL_DATA;
+                break;
+            }
+            if (isShort) {
+                if (num < SHRT_MIN || num > SHRT_MAX) {
+                    return SQL_ERROR;
+                }
+                *(SQLSMALLINT *)valuePtr = (SQLSMALLINT)num;
+            } else {
+                *(SQLINTEGER *)valuePtr = (SQLINTEGER)num;
+            }
+            if (lenPtr) {
+                *lenPtr = isShort ? sizeof(SQLSMALLINT) : sizeof(SQLINTEGER);
+            }
           } break;
           default: {
             return SQL_ERROR;
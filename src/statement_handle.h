@@ -17,7 +17,12 @@
 #ifndef MONGOODBC_STATEMENT_HANDLE_H_
 #define MONGOODBC_STATEMENT_HANDLE_H_
 
+#include "arena.h"
+#include "field_paths.h"
+#include "row_count.h"
+#include "row_source.h"
 #include "sql_parser.h"
+#include "string_ref.h"
 
 #include <sql.h>
 #include <sqlext.h>
@@ -25,6 +30,8 @@
 #include <mongo/client/dbclient.h>
 #include <mongo/bson/bsonobj.h>
 
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/variant/variant.hpp>
 
 #include <list>
@@ -34,34 +41,91 @@
 namespace mongoodbc {
 
 class ConnectionHandle;
+class JoinPlan;
+class QueryExplain;
+class ScopedConnection;
+struct QueryHints;
 
 /*
 * Class implementing an ODBC statement handle.
+*
+* A statement may only be used by one thread at a time, the ODBC entry
+* points serialize calls through 'mutex'.
 */
-class StatementHandle {
+class StatementHandle : boost::noncopyable {
     // TYPES
-    // Result type for an column entry
-    typedef boost::variant<std::string, SQLSMALLINT, SQLINTEGER> Result;
+    // Result type for an column entry, strings are held by '_arena'
+    typedef boost::variant<StringRef, SQLSMALLINT, SQLINTEGER> Result;
 
     // INSTANCE DATA
     // The connection handle from which this handle was created,
     // held, not owned
     ConnectionHandle *_connHandle;
 
+    // holds the strings of the current result, released by 'closeCursor'
+    Arena _arena;
+
     // '_resultSet' is used to store results for operations that do not retrieve data by
     // mongoDB cursor (i.e. SQLTables, SQLColumns).
     std::vector<std::list<Result> > _resultSet;
     int _rowIdx;
 
-    // cursor used to store the result of a datbase query that is retrurned incrementally
-    std::auto_ptr<mongo::DBClientCursor> _cursor;
-    // vector of (name, type) pairs for the current cursor - based on the first element
-    std::vector<std::pair<std::string, mongo::BSONType> > _cursorColumns;
+    // connection '_cursor' reads from, checked out of '_connHandle' while
+    // the cursor is open
+    std::auto_ptr<ScopedConnection> _cursorConn;
+    // source of the result of a datbase query that is retrurned incrementally
+    std::auto_ptr<RowSource> _cursor;
+    // vector of (name, type) pairs for the current cursor - based on the first element,
+    // whose embedded documents' fields are columns '<field>.<embedded field>',
+    // names are held by '_arena'
+    std::vector<std::pair<StringRef, mongo::BSONType> > _cursorColumns;
+    // paths of '_cursorColumns' and their values in '_row', found in one
+    // walk over the row
+    FieldPaths _columnPaths;
+    std::vector<mongo::BSONElement> _columnValues;
     // the last row returned in SQLFetch
     mongo::BSONObj _row;
-
-    // parser for SQL statements
-    SQLParser<std::string::const_iterator> _parser;
+    // true if '_row' was read ahead by sqlExec and not yet returned by SQLFetch
+    bool _rowPending;
+    // rows of '_cursor', counted on the first SQLRowCount
+    RowCount _rowCount;
+
+    // SQL_ATTR_ROW_ARRAY_SIZE, used as a hint for the cursor batch size
+    SQLULEN _rowArraySize;
+    // SQL_ATTR_MONGOODBC_PARALLEL_SCAN, number of concurrent cursors
+    SQLULEN _parallelScan;
+    // SQL_ATTR_MONGOODBC_SORT_SPILLED_BYTES, updated by the cursor's sort
+    // and aggregation
+    size_t _sortSpilledBytes;
+
+    // serializes the ODBC calls on this statement
+    boost::mutex _mutex;
+
+    // Close the current cursor and discard any result
+    void closeCursor();
+
+    // Add the fields of 'obj' to '_cursorColumns', those of embedded
+    // documents as '<prefix><field>.<embedded field>'
+    void addCursorColumns(const mongo::BSONObj& obj, const std::string& prefix);
+
+    // Add a row describing a column to '_resultSet', as 'sqlColumns' returns
+    void addColumnRow(const std::string& schema,
+                      const std::string& table,
+                      const std::string& column,
+                      mongo::BSONType type,
+                      int columnNum);
+
+    // Return the first document of 'collection', empty if there is none
+    mongo::BSONObj firstDocument(const std::string& collection);
+
+    // Execute the statement 'query', without its comments, or with
+    // 'explain' not null only record in it how the statement executes
+    SQLRETURN execute(const std::string& query,
+                      const QueryHints& hints,
+                      QueryExplain *explain);
+
+    // Record in 'explain' the queries and joins of 'joinPlan'
+    void explainJoin(const JoinPlan& joinPlan, QueryExplain *explain);
 
     SQLSMALLINT mapMongoToODBCDataType(mongo::BSONType type);
     const char *dataTypeName(SQLSMALLINT type);
@@ -76,6 +140,10 @@ class StatementHandle {
   public:
     StatementHandle(ConnectionHandle *connHandle);
 
+    ~StatementHandle();
+
+    boost::mutex& mutex() { return _mutex; }
+
     SQLRETURN sqlTables(SQLCHAR *catalogName,
                         SQLSMALLINT catalogNameLen,
                         SQLCHAR *schemaName,
@@ -94,9 +162,54 @@ class StatementHandle {
                          SQLCHAR *columnName,
                          SQLSMALLINT columnNameLen);
 
+    /*
+    * Lists the statistics and indexes of the table, as reported by the
+    * catalog cache: a row for the table, then one per indexed column.
+    * Unique indexes are '_id_' and those created unique.  'reserved'
+    * SQL_ENSURE reads the statistics from the server again.
+    */
+    SQLRETURN sqlStatistics(SQLCHAR *catalogName,
+                            SQLSMALLINT catalogNameLen,
+                            SQLCHAR *schemaName,
+                            SQLSMALLINT schemaNameLen,
+                            SQLCHAR *tableName,
+                            SQLSMALLINT tableNameLen,
+                            SQLUSMALLINT unique,
+                            SQLUSMALLINT reserved);
+
+    /*
+    * Lists the primary key of the table: '_id' for a collection, '_id'
+    * and the element's index for an array table.
+    */
+    SQLRETURN sqlPrimaryKeys(SQLCHAR *catalogName,
+                             SQLSMALLINT catalogNameLen,
+                             SQLCHAR *schemaName,
+                             SQLSMALLINT schemaNameLen,
+                             SQLCHAR *tableName,
+                             SQLSMALLINT tableNameLen);
+
+    SQLRETURN sqlSetStmtAttr(SQLINTEGER attribute,
+                             SQLPOINTER valuePtr,
+                             SQLINTEGER stringLen);
+
+    SQLRETURN sqlGetStmtAttr(SQLINTEGER attribute,
+                             SQLPOINTER valuePtr,
+                             SQLINTEGER bufferLength,
+                             SQLINTEGER *stringLenPtr);
+
     SQLRETURN sqlExec(SQLCHAR *query,
                       SQLINTEGER queryLen);
 
+    /*
+    * Sets 'nativeQuery' to the queries and aggregations 'query' is
+    * translated to, one per line, without running them.
+    */
+    SQLRETURN sqlNativeSql(SQLCHAR *query,
+                           SQLINTEGER queryLen,
+                           SQLCHAR *nativeQuery,
+                           SQLINTEGER nativeQueryMax,
+                           SQLINTEGER *nativeQueryLen);
+
     SQLRETURN sqlNumResultCols(SQLSMALLINT *numColumns);
 
     SQLRETURN sqlFetch();
@@ -106,6 +219,21 @@ class StatementHandle {
 	                     SQLPOINTER valuePtr,
                          SQLLEN len,
                          SQLLEN *lenPtr);
+
+    /*
+    * Sets 'rowCount' to the number of rows of the result, -1 if unknown.
+    * The rows of a query are estimated without reading them, or counted
+    * by the server if the connection asks for exact counts, see
+    * 'RowCount'.
+    */
+    SQLRETURN sqlRowCount(SQLLEN *rowCount);
+
+    /*
+    * Sets 'info' to the header diagnostic field 'diagId'.  No diagnostic
+    * records are kept, SQL_DIAG_CURSOR_ROW_COUNT and SQL_DIAG_ROW_COUNT are
+    * as returned by 'sqlRowCount'.
+    */
+    SQLRETURN sqlGetDiagField(SQLSMALLINT diagId, SQLPOINTER info);
 };
 
 } // close mongoodbc namespace
@@ -0,0 +1,137 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "stream_aggregate.h"
+
+#include "sort_key.h"
+
+namespace mongoodbc {
+
+StreamAggregateRowSource::StreamAggregateRowSource(std::auto_ptr<RowSource> source,
+                                                   const AggregatePlan& plan,
+                                                   const std::string& defaultQualifier)
+    : _source(source)
+    , _plan(plan)
+    , _hasNextGroupRow(false)
+    , _numGroups(0)
+    , _hasNext(false)
+{
+    const std::vector<SQLElementExpression>& keys = _plan.keys();
+    for (size_t k = 0; k < keys.size(); ++k) {
+        _keyPrograms.push_back(ExpressionProgram(keys[k], defaultQualifier));
+    }
+    const std::vector<AggregateFunction>& aggregates = _plan.aggregates();
+    for (size_t a = 0; a < aggregates.size(); ++a) {
+        _argPrograms.push_back(aggregates[a]._hasArg
+                               ? ExpressionProgram(aggregates[a]._arg, defaultQualifier)
+                               : ExpressionProgram());
+    }
+}
+
+void StreamAggregateRowSource::encodeKey(const mongo::BSONObj& row, std::string *key) const
+{
+    const std::vector<SQLElementExpression>& keys = _plan.keys();
+    key->clear();
+    for (size_t k = 0; k < keys.size(); ++k) {
+        encodeValue(_keyPrograms[k].run(row), key);
+    }
+}
+
+void StreamAggregateRowSource::startGroup(const mongo::BSONObj& row, const std::string& key)
+{
+    const std::vector<SQLElementExpression>& keys = _plan.keys();
+    const std::vector<std::string>& keyNames = _plan.keyNames();
+    _key = key;
+    mongo::BSONObjBuilder keyValues;
+    for (size_t k = 0; k < keys.size(); ++k) {
+        _keyPrograms[k].run(row).append(keyNames[k], &keyValues);
+    }
+    _keyValues = keyValues.obj();
+    _states.assign(_plan.aggregates().size(), AggregateState());
+    _batch.push_back(row);
+}
+
+void StreamAggregateRowSource::flush()
+{
+    const std::vector<AggregateFunction>& aggregates = _plan.aggregates();
+    for (size_t a = 0; a < aggregates.size(); ++a) {
+        const AggregateFunction& fn = aggregates[a];
+        _values.clear();
+        if (fn._hasArg) {
+            for (size_t i = 0; i < _batch.size(); ++i) {
+                _values.push_back(_argPrograms[a].run(_batch[i]));
+            }
+        }
+        _batchStates.assign(_batch.size(), &_states[a]);
+        updateStates(fn, _values, _batchStates);
+    }
+    _values.clear();
+    _batch.clear();
+}
+
+bool StreamAggregateRowSource::more()
+{
+    if (_hasNext) {
+        return true;
+    }
+
+    if (!_hasNextGroupRow) {
+        if (!_source->more()) {
+            if (0 == _numGroups && _plan.keys().empty()) {
+                // an aggregate of no rows is still one row
+                ++_numGroups;
+                _states.assign(_plan.aggregates().size(), AggregateState());
+                _next = _plan.resultRow(mongo::BSONObj(), _states.empty() ? 0 : &_states[0]);
+                _hasNext = true;
+            }
+            return _hasNext;
+        }
+        _nextGroupRow = _source->next().getOwned();
+        encodeKey(_nextGroupRow, &_nextGroupKey);
+    }
+    startGroup(_nextGroupRow, _nextGroupKey);
+    _hasNextGroupRow = false;
+
+    std::string key;
+    while (_source->more()) {
+        mongo::BSONObj row = _source->next().getOwned();
+        encodeKey(row, &key);
+        if (key != _key) {
+            _nextGroupRow = row;
+            _nextGroupKey = key;
+            _hasNextGroupRow = true;
+            break;
+        }
+        _batch.push_back(row);
+        if (BATCH_SIZE == _batch.size()) {
+            flush();
+        }
+    }
+    flush();
+
+    ++_numGroups;
+    _next = _plan.resultRow(_keyValues, _states.empty() ? 0 : &_states[0]);
+    _hasNext = true;
+    return true;
+}
+
+mongo::BSONObj StreamAggregateRowSource::next()
+{
+    _hasNext = false;
+    return _next;
+}
+
+} // close mongoodbc namespace
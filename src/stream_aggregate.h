@@ -0,0 +1,91 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_STREAM_AGGREGATE_H_
+#define MONGOODBC_STREAM_AGGREGATE_H_
+
+#include "aggregate_function.h"
+#include "aggregate_plan.h"
+#include "expression_evaluator.h"
+#include "row_source.h"
+
+#include <mongo/bson/bsonobj.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mongoodbc {
+
+/*
+* Row source aggregating another source whose rows come ordered by the keys
+* of an 'AggregatePlan', e.g. read through an index on them: the rows of a
+* group are consecutive, so only the current group is held and its result
+* row is returned as soon as the next group starts.  Rows of a group are
+* folded into its states in batches of up to BATCH_SIZE with
+* 'updateStates'.
+*
+* A group whose rows are not consecutive is returned once per run of rows.
+* An aggregate without GROUP BY returns one row, even for no input.
+*/
+class StreamAggregateRowSource : public RowSource {
+  public:
+    enum {
+        BATCH_SIZE = 1024
+    };
+
+  private:
+    std::auto_ptr<RowSource> _source;
+    AggregatePlan _plan;
+    // key expressions and aggregate arguments, compiled
+    std::vector<ExpressionProgram> _keyPrograms;
+    std::vector<ExpressionProgram> _argPrograms;
+
+    // encoded key and key values of the current group
+    std::string _key;
+    mongo::BSONObj _keyValues;
+    std::vector<AggregateState> _states;
+    // rows of the current group not yet folded into '_states'
+    std::vector<mongo::BSONObj> _batch;
+    std::vector<ExpressionValue> _values;
+    std::vector<AggregateState *> _batchStates;
+
+    // first row of the next group, once read
+    mongo::BSONObj _nextGroupRow;
+    std::string _nextGroupKey;
+    bool _hasNextGroupRow;
+
+    size_t _numGroups;
+    mongo::BSONObj _next;
+    bool _hasNext;
+
+    void encodeKey(const mongo::BSONObj& row, std::string *key) const;
+    void startGroup(const mongo::BSONObj& row, const std::string& key);
+    void flush();
+
+  public:
+    StreamAggregateRowSource(std::auto_ptr<RowSource> source,
+                             const AggregatePlan& plan,
+                             const std::string& defaultQualifier);
+
+    virtual bool more();
+
+    virtual mongo::BSONObj next();
+};
+
+} // close mongoodbc namespace
+
+#endif
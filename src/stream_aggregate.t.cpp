@@ -0,0 +1,137 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#include "stream_aggregate.h"
+#include "sql_fast_parser.h"
+#include "vector_row_source.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using mongoodbc::AggregatePlan;
+using mongoodbc::RowSource;
+using mongoodbc::StreamAggregateRowSource;
+using mongoodbc::VectorRowSource;
+
+namespace {
+
+AggregatePlan planOf(const std::string& sql)
+{
+    mongoodbc::SQLStatement stmt;
+    std::string errmsg;
+    EXPECT_EQ(0, mongoodbc::SQLFastParser::parse(sql, &stmt, &errmsg)) << sql << ": " << errmsg;
+    AggregatePlan plan;
+    EXPECT_EQ(0, plan.init(stmt, &errmsg)) << sql << ": " << errmsg;
+    return plan;
+}
+
+std::vector<std::string> aggregate(const std::string& sql, const std::vector<mongo::BSONObj>& rows)
+{
+    size_t pos;
+    StreamAggregateRowSource source(std::auto_ptr<RowSource>(new VectorRowSource(rows, &pos)),
+                                    planOf(sql),
+                                    "");
+    std::vector<std::string> result;
+    while (source.more()) {
+        result.push_back(source.next().toString());
+    }
+    return result;
+}
+
+} // close unnamed namespace
+
+TEST(StreamAggregate, Incremental)
+{
+    std::vector<mongo::BSONObj> rows;
+    for (int i = 0; i < 3000; ++i) {
+        rows.push_back(BSON("g" << i / 1500 << "v" << i % 1500));
+    }
+    size_t pos;
+    StreamAggregateRowSource source(std::auto_ptr<RowSource>(new VectorRowSource(rows, &pos)),
+                                    planOf("SELECT g, COUNT(*), SUM(v), MAX(v) FROM db.t GROUP BY g"),
+                                    "");
+
+    // the first group is returned once the first row of the second is read
+    ASSERT_TRUE(source.more());
+    EXPECT_EQ(1501u, pos);
+    EXPECT_EQ(BSON("g" << 0 << "COUNT(*)" << 1500LL << "SUM(v)" << 1124250LL << "MAX(v)" << 1499)
+                  .toString(),
+              source.next().toString());
+    ASSERT_TRUE(source.more());
+    EXPECT_EQ(BSON("g" << 1 << "COUNT(*)" << 1500LL << "SUM(v)" << 1124250LL << "MAX(v)" << 1499)
+                  .toString(),
+              source.next().toString());
+    EXPECT_FALSE(source.more());
+}
+
+TEST(StreamAggregate, Runs)
+{
+    std::vector<mongo::BSONObj> rows;
+    rows.push_back(BSON("g" << 1));
+    rows.push_back(BSON("g" << 1.0));
+    rows.push_back(BSON("g" << 2));
+    rows.push_back(BSON("g" << 1));
+    std::vector<std::string> expected;
+    expected.push_back(BSON("g" << 1 << "COUNT(*)" << 2LL).toString());
+    expected.push_back(BSON("g" << 2 << "COUNT(*)" << 1LL).toString());
+    expected.push_back(BSON("g" << 1 << "COUNT(*)" << 1LL).toString());
+    EXPECT_EQ(expected, aggregate("SELECT g, COUNT(*) FROM db.t GROUP BY g", rows));
+}
+
+TEST(StreamAggregate, Empty)
+{
+    std::vector<mongo::BSONObj> rows;
+    EXPECT_TRUE(aggregate("SELECT g, COUNT(*) FROM db.t GROUP BY g", rows).empty());
+    EXPECT_EQ(std::vector<std::string>(1, BSON("COUNT(*)" << 0LL).toString()),
+              aggregate("SELECT COUNT(*) FROM db.t", rows));
+}
+
+TEST(StreamAggregate, IndexOrder)
+{
+    std::vector<mongo::BSONObj> indexKeys;
+    indexKeys.push_back(BSON("_id" << 1));
+    indexKeys.push_back(BSON("a" << 1 << "b" << 1 << "c" << 1));
+    indexKeys.push_back(BSON("b" << -1 << "a" << 1));
+    indexKeys.push_back(BSON("c" << "hashed"));
+
+    mongo::BSONObj sortPattern;
+    mongo::BSONObj hint;
+    ASSERT_EQ(0, planOf("SELECT a, COUNT(*) FROM db.t GROUP BY b, a")
+                     .indexOrder(indexKeys, &sortPattern, &hint));
+    EXPECT_EQ(BSON("b" << -1 << "a" << 1).toString(), sortPattern.toString());
+    EXPECT_EQ(indexKeys[2].toString(), hint.toString());
+
+    ASSERT_EQ(0, planOf("SELECT COUNT(*) FROM db.t GROUP BY a")
+                     .indexOrder(indexKeys, &sortPattern, &hint));
+    EXPECT_EQ(BSON("a" << 1).toString(), sortPattern.toString());
+    EXPECT_EQ(indexKeys[1].toString(), hint.toString());
+
+    EXPECT_NE(0, planOf("SELECT COUNT(*) FROM db.t GROUP BY c")
+                     .indexOrder(indexKeys, &sortPattern, &hint));
+    EXPECT_NE(0, planOf("SELECT COUNT(*) FROM db.t GROUP BY a, c")
+                     .indexOrder(indexKeys, &sortPattern, &hint));
+    EXPECT_NE(0, planOf("SELECT COUNT(*) FROM db.t GROUP BY a + 1")
+                     .indexOrder(indexKeys, &sortPattern, &hint));
+    EXPECT_NE(0, planOf("SELECT COUNT(*) FROM db.t")
+                     .indexOrder(indexKeys, &sortPattern, &hint));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
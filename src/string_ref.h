@@ -0,0 +1,69 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_STRING_REF_H_
+#define MONGOODBC_STRING_REF_H_
+
+#include <string>
+
+#include <string.h>
+
+namespace mongoodbc {
+
+/*
+* Non-owning view of a run of characters, e.g. a string held by an 'Arena'
+* or a literal.  The characters must outlive the view.
+*/
+class StringRef {
+    const char *_data;
+    size_t _size;
+
+  public:
+    StringRef()
+        : _data("")
+        , _size(0)
+    {
+    }
+
+    StringRef(const char *str)
+        : _data(str)
+        , _size(strlen(str))
+    {
+    }
+
+    StringRef(const char *data, size_t size)
+        : _data(data)
+        , _size(size)
+    {
+    }
+
+    const char *data() const { return _data; }
+    size_t size() const { return _size; }
+    bool empty() const { return 0 == _size; }
+
+    std::string str() const { return std::string(_data, _size); }
+
+    bool operator==(const StringRef& rhs) const
+    {
+        return _size == rhs._size && 0 == memcmp(_data, rhs._data, _size);
+    }
+
+    bool operator!=(const StringRef& rhs) const { return !(*this == rhs); }
+};
+
+} // close mongoodbc namespace
+
+#endif
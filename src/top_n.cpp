@@ -0,0 +1,118 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#include "top_n.h"
+
+#include <algorithm>
+
+#include <string.h>
+
+namespace mongoodbc {
+
+const size_t TopNRowSource::UNLIMITED;
+
+bool TopNRowSource::Less::operator()(size_t lhs, size_t rhs) const
+{
+    const Row& left = (*_rows)[lhs];
+    const Row& right = (*_rows)[rhs];
+    int cmp = memcmp(left._data.data(),
+                     right._data.data(),
+                     std::min(left._keySize, right._keySize));
+    if (0 != cmp) {
+        return cmp < 0;
+    }
+    if (left._keySize != right._keySize) {
+        return left._keySize < right._keySize;
+    }
+    return left._seq < right._seq;
+}
+
+TopNRowSource::TopNRowSource(std::auto_ptr<RowSource> source,
+                             const SortKey& sortKey,
+                             size_t limit)
+    : _source(source)
+    , _sortKey(sortKey)
+    , _limit(limit)
+    , _loaded(false)
+    , _next(0)
+{
+}
+
+void TopNRowSource::load()
+{
+    _loaded = true;
+    if (0 == _limit || _sortKey.empty()) {
+        return;
+    }
+
+    Less less(&_rows);
+    std::string key;
+    unsigned long long seq = 0;
+    while (_source->more()) {
+        mongo::BSONObj row = _source->next();
+        _sortKey.encode(row, &key);
+
+        size_t slot;
+        if (_rows.size() < _limit) {
+            slot = _rows.size();
+            _rows.push_back(Row());
+        } else {
+            // keep the row only if it sorts before the worst one held; the
+            // new row is later in the input, so it must be strictly less
+            const Row& worst = _rows[_order.front()];
+            int cmp = memcmp(key.data(), worst._data.data(), std::min(key.size(), worst._keySize));
+            if (cmp > 0 || (0 == cmp && key.size() >= worst._keySize)) {
+                ++seq;
+                continue;
+            }
+            std::pop_heap(_order.begin(), _order.end(), less);
+            slot = _order.back();
+            _order.pop_back();
+        }
+
+        Row& held = _rows[slot];
+        held._data.assign(key);
+        held._data.append(row.objdata(), row.objsize());
+        held._keySize = key.size();
+        held._seq = seq++;
+        _order.push_back(slot);
+        std::push_heap(_order.begin(), _order.end(), less);
+    }
+    std::sort_heap(_order.begin(), _order.end(), less);
+}
+
+bool TopNRowSource::more()
+{
+    if (_sortKey.empty()) {
+        // every row ties, so the first ones pass through as they come
+        return _next < _limit && _source->more();
+    }
+    if (!_loaded) {
+        load();
+    }
+    return _next < _order.size();
+}
+
+mongo::BSONObj TopNRowSource::next()
+{
+    if (_sortKey.empty()) {
+        ++_next;
+        return _source->next();
+    }
+    const Row& row = _rows[_order[_next++]];
+    return mongo::BSONObj(row._data.data() + row._keySize).getOwned();
+}
+
+} // close mongoodbc namespace
@@ -0,0 +1,101 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_TOP_N_H_
+#define MONGOODBC_TOP_N_H_
+
+#include "row_source.h"
+#include "sort_key.h"
+
+#include <mongo/bson/bsonobj.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mongoodbc {
+
+/*
+* Row source returning the first 'limit' rows of another source in the
+* order of a 'SortKey' without sorting the whole input: a heap holds the
+* best 'limit' rows seen so far, so memory is bounded by the limit rather
+* than by the input.  Rows with equal keys keep their input order.  With an
+* empty key nothing is held: the first 'limit' rows of the input pass
+* through as they are read.
+*
+* Otherwise the input is read on the first call to 'more'.  Each held row is a single
+* buffer with its encoded key followed by the row's BSON, and its slot is
+* reused by the row that evicts it.
+*/
+class TopNRowSource : public RowSource {
+  public:
+    // A limit sorting the whole input
+    static const size_t UNLIMITED = (size_t)-1;
+
+    enum {
+        // Largest limit worth holding in memory; larger sorts should spill
+        // with 'ExternalSortRowSource'
+        MAX_HEAP_ROWS = 100000
+    };
+
+  private:
+    struct Row {
+        // encoded key followed by the row
+        std::string _data;
+        size_t _keySize;
+        // position in the input, to keep the sort stable
+        unsigned long long _seq;
+    };
+
+    /*
+    * Orders indexes in '_rows' by key, then input position.
+    */
+    class Less {
+        const std::vector<Row> *_rows;
+
+      public:
+        explicit Less(const std::vector<Row> *rows)
+            : _rows(rows)
+        {
+        }
+
+        bool operator()(size_t lhs, size_t rhs) const;
+    };
+
+    std::auto_ptr<RowSource> _source;
+    SortKey _sortKey;
+    size_t _limit;
+
+    bool _loaded;
+    std::vector<Row> _rows;
+    // indexes in '_rows', a max heap while loading, then in output order
+    std::vector<size_t> _order;
+    // next index in '_order', or the rows passed through with an empty key
+    size_t _next;
+
+    void load();
+
+  public:
+    TopNRowSource(std::auto_ptr<RowSource> source, const SortKey& sortKey, size_t limit);
+
+    virtual bool more();
+
+    virtual mongo::BSONObj next();
+};
+
+} // close mongoodbc namespace
+
+#endif
@@ -0,0 +1,189 @@
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#include "top_n.h"
+#include "sql_fast_parser.h"
+#include "vector_row_source.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using mongoodbc::RowSource;
+using mongoodbc::SortKey;
+using mongoodbc::SQLElementSortSpec;
+using mongoodbc::TopNRowSource;
+using mongoodbc::VectorRowSource;
+
+namespace {
+
+std::vector<SQLElementSortSpec> orderBy(const std::string& clause)
+{
+    mongoodbc::SQLStatement stmt;
+    std::string errmsg;
+    EXPECT_EQ(0, mongoodbc::SQLFastParser::parse("SELECT * FROM db.t ORDER BY " + clause,
+                                                 &stmt,
+                                                 &errmsg)) << clause << ": " << errmsg;
+    return stmt._orderBy;
+}
+
+std::string encode(const SortKey& sortKey, const mongo::BSONObj& row)
+{
+    std::string key;
+    sortKey.encode(row, &key);
+    return key;
+}
+
+std::vector<int> topN(const std::vector<mongo::BSONObj>& rows,
+                      const SortKey& sortKey,
+                      size_t limit,
+                      size_t *numRead = 0)
+{
+    size_t read;
+    TopNRowSource top(std::auto_ptr<RowSource>(new VectorRowSource(rows, &read)), sortKey, limit);
+    std::vector<int> result;
+    while (top.more()) {
+        result.push_back(top.next().getIntField("id"));
+    }
+    if (numRead) {
+        *numRead = read;
+    }
+    return result;
+}
+
+} // close unnamed namespace
+
+TEST(SortKey, TypeOrder)
+{
+    std::vector<mongo::BSONObj> rows;
+    rows.push_back(mongo::BSONObj());
+    rows.push_back(BSON("a" << -5));
+    rows.push_back(BSON("a" << -0.5));
+    rows.push_back(BSON("a" << 0));
+    rows.push_back(BSON("a" << 2.5));
+    rows.push_back(BSON("a" << 10LL));
+    rows.push_back(BSON("a" << ""));
+    rows.push_back(BSON("a" << "a"));
+    rows.push_back(BSON("a" << "ab"));
+    rows.push_back(BSON("a" << "b"));
+
+    SortKey ascending(orderBy("a"));
+    SortKey descending(orderBy("a DESC"));
+    for (size_t i = 1; i < rows.size(); ++i) {
+        EXPECT_LT(encode(ascending, rows[i - 1]), encode(ascending, rows[i])) << rows[i];
+        EXPECT_GT(encode(descending, rows[i - 1]), encode(descending, rows[i])) << rows[i];
+    }
+    EXPECT_EQ(encode(ascending, BSON("a" << 2)), encode(ascending, BSON("a" << 2.0)));
+    EXPECT_EQ(encode(ascending, mongo::BSONObj()), encode(ascending, BSON("b" << 1)));
+}
+
+TEST(SortKey, Expressions)
+{
+    // later keys only break ties
+    SortKey sortKey(orderBy("a + b DESC, -c"));
+    EXPECT_LT(encode(sortKey, BSON("a" << 1 << "b" << 5 << "c" << 0)),
+              encode(sortKey, BSON("a" << 2 << "b" << 3 << "c" << 0)));
+    EXPECT_LT(encode(sortKey, BSON("a" << 1 << "b" << 1 << "c" << 7)),
+              encode(sortKey, BSON("a" << 1 << "b" << 1 << "c" << 3)));
+    // an operand without a value makes the whole expression NULL
+    EXPECT_GT(encode(sortKey, BSON("a" << 1 << "c" << 0)),
+              encode(sortKey, BSON("a" << 1 << "b" << 1 << "c" << 0)));
+
+    // unqualified columns of joined rows belong to the default table
+    SortKey joined(orderBy("x, c.y"), "o");
+    EXPECT_EQ(encode(joined, BSON("x" << 1 << "y" << 2)),
+              encode(joined, BSON("o.x" << 1 << "c.y" << 2)));
+    EXPECT_LT(encode(joined, BSON("o.x" << 1 << "c.x" << 9 << "c.y" << 2)),
+              encode(joined, BSON("o.x" << 2 << "c.x" << 0 << "c.y" << 2)));
+}
+
+TEST(SortKey, SortPattern)
+{
+    mongo::BSONObj pattern;
+    ASSERT_EQ(0, SortKey::sortPattern(orderBy("a, t.b DESC"), &pattern));
+    EXPECT_EQ(BSON("a" << 1 << "b" << -1).toString(), pattern.toString());
+    EXPECT_EQ(-1, SortKey::sortPattern(orderBy("a + 1"), &pattern));
+    EXPECT_EQ(-1, SortKey::sortPattern(orderBy("a, -b"), &pattern));
+}
+
+TEST(TopNRowSource, Smallest)
+{
+    std::vector<mongo::BSONObj> rows;
+    int values[] = { 7, 3, 9, 1, 3, 8, 0, 5 };
+    for (int i = 0; i < (int)(sizeof(values) / sizeof(values[0])); ++i) {
+        rows.push_back(BSON("id" << i << "v" << values[i]));
+    }
+
+    int ascending[] = { 6, 3, 1, 4 };
+    EXPECT_EQ(std::vector<int>(ascending, ascending + 4), topN(rows, SortKey(orderBy("v")), 4));
+    int descending[] = { 2, 5, 0 };
+    EXPECT_EQ(std::vector<int>(descending, descending + 3),
+              topN(rows, SortKey(orderBy("v DESC")), 3));
+    // 0 / 0 is NULL and the other rows tie, keeping their input order
+    int ties[] = { 6, 0, 1 };
+    EXPECT_EQ(std::vector<int>(ties, ties + 3), topN(rows, SortKey(orderBy("v / v")), 3));
+
+    std::vector<int> all = topN(rows, SortKey(orderBy("v")), TopNRowSource::UNLIMITED);
+    int sorted[] = { 6, 3, 1, 4, 7, 0, 5, 2 };
+    EXPECT_EQ(std::vector<int>(sorted, sorted + 8), all);
+}
+
+TEST(TopNRowSource, StopsReading)
+{
+    std::vector<mongo::BSONObj> rows;
+    for (int i = 0; i < 10; ++i) {
+        rows.push_back(BSON("id" << i));
+    }
+
+    size_t numRead;
+    EXPECT_TRUE(topN(rows, SortKey(orderBy("id")), 0, &numRead).empty());
+    EXPECT_EQ(0u, numRead);
+
+    int first[] = { 0, 1, 2 };
+    EXPECT_EQ(std::vector<int>(first, first + 3),
+              topN(rows, SortKey(std::vector<SQLElementSortSpec>()), 3, &numRead));
+    EXPECT_EQ(3u, numRead);
+
+    EXPECT_EQ(3u, topN(rows, SortKey(orderBy("id DESC")), 3, &numRead).size());
+    EXPECT_EQ(10u, numRead);
+}
+
+TEST(TopNRowSource, PassesThrough)
+{
+    // with an empty key rows are read one at a time, not loaded up front
+    std::vector<mongo::BSONObj> rows;
+    for (int i = 0; i < 10; ++i) {
+        rows.push_back(BSON("id" << i));
+    }
+
+    size_t numRead;
+    TopNRowSource top(std::auto_ptr<RowSource>(new VectorRowSource(rows, &numRead)),
+                      SortKey(std::vector<SQLElementSortSpec>()),
+                      3);
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(top.more());
+        EXPECT_EQ((size_t)i, numRead);
+        EXPECT_EQ(i, top.next().getIntField("id"));
+    }
+    EXPECT_FALSE(top.more());
+    EXPECT_EQ(3u, numRead);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,65 @@
+#pragma once
+//  Copyright [2013] Kyle Galloway (kyle.s.galloway@gmail.com)
+//                   Pravish Sood (pravish.sood@gmail.com)
+//                   Dylan Kelemen (dckelemen@gmail.com)
+
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+
+//      http://www.apache.org/licenses/LICENSE-2.0
+
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+#ifndef MONGOODBC_VECTOR_ROW_SOURCE_H_
+#define MONGOODBC_VECTOR_ROW_SOURCE_H_
+
+#include "row_source.h"
+
+#include <mongo/bson/bsonobj.h>
+
+#include <vector>
+
+namespace mongoodbc {
+
+/*
+* Row source returning the rows of a vector, for the tests of the sources
+* built on top of it.  The number of rows read so far is kept in
+* '*numRead' if not null.
+*/
+class VectorRowSource : public RowSource {
+    std::vector<mongo::BSONObj> _rows;
+    size_t _pos;
+    size_t *_numRead;
+
+  public:
+    explicit VectorRowSource(const std::vector<mongo::BSONObj>& rows, size_t *numRead = 0)
+        : _rows(rows)
+        , _pos(0)
+        , _numRead(numRead)
+    {
+        if (_numRead) {
+            *_numRead = 0;
+        }
+    }
+
+    virtual bool more()
+    {
+        return _pos < _rows.size();
+    }
+
+    virtual mongo::BSONObj next()
+    {
+        if (_numRead) {
+            ++*_numRead;
+        }
+        return _rows[_pos++];
+    }
+};
+
+} // close mongoodbc namespace
+
+#endif